@@ -0,0 +1,200 @@
+#include "BenchSupport.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include "../src/DatasetGenerator.h"
+#include "../src/ExpenseManager.h"
+#include "../src/PackingManager.h"
+#include "../src/StorageManager.h"
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace travel_planner {
+
+    namespace {
+
+        const std::uint32_t kBenchSeed = 42;
+
+        const char* const kStoreVariables[] = {
+            "TRAVEL_PLANNER_ITINERARY_STORE",
+            "TRAVEL_PLANNER_PACKING_STORE",
+            "TRAVEL_PLANNER_EXPENSE_STORE"
+        };
+
+
+        void setVariable(const char* name, const std::string& value) {
+#ifdef _WIN32
+            _putenv_s(name, value.c_str());
+#else
+            setenv(name, value.c_str(), 1);
+#endif
+        }
+
+        void unsetVariable(const char* name) {
+#ifdef _WIN32
+            _putenv_s(name, "");
+#else
+            unsetenv(name);
+#endif
+        }
+
+        // Root of all scratch directories of this process; removed on exit
+        class ScratchRoot {
+        public:
+            ScratchRoot()
+                : path_(std::filesystem::temp_directory_path()
+                    / ("travel_planner_bench-" + std::to_string(getpid()))) {
+            }
+
+            ~ScratchRoot() {
+                std::error_code ec;
+                std::filesystem::remove_all(path_, ec);
+            }
+
+            const std::filesystem::path& path() const { return path_; }
+
+        private:
+            std::filesystem::path path_;
+        };
+
+    } // namespace
+
+    void applyRecordCounts(benchmark::internal::Benchmark* benchmark) {
+        benchmark->Arg(1000)->Arg(100000)->Arg(1000000);
+    }
+
+    OperationStats::OperationStats(benchmark::State& state, std::int64_t items_per_op)
+        : state_(state), items_per_op_(items_per_op) {
+        latencies_us_.reserve(static_cast<std::size_t>(std::min<benchmark::IterationCount>(
+            state.max_iterations, 1 << 20)));
+        allocations_at_start_ = allocationTotals();
+    }
+
+    OperationStats::Timer::Timer(OperationStats& stats)
+        : stats_(stats), start_(std::chrono::steady_clock::now()) {
+    }
+
+    OperationStats::Timer::~Timer() {
+        std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start_;
+        stats_.latencies_us_.push_back(elapsed.count());
+    }
+
+    void OperationStats::report() {
+        AllocationTotals allocations = allocationTotals();
+        double iterations = static_cast<double>(std::max<std::int64_t>(state_.iterations(), 1));
+
+        state_.SetItemsProcessed(state_.iterations() * items_per_op_);
+        state_.counters["allocs_per_op"] = benchmark::Counter(
+            static_cast<double>(allocations.count - allocations_at_start_.count) / iterations);
+        state_.counters["bytes_per_op"] = benchmark::Counter(
+            static_cast<double>(allocations.bytes - allocations_at_start_.bytes) / iterations);
+        // High-water mark of the whole process so far, so it only grows
+        // across the benchmarks of one run
+        state_.counters["peak_rss_mb"] = benchmark::Counter(
+            static_cast<double>(peakResidentBytes()) / (1024.0 * 1024.0));
+
+        if (latencies_us_.empty()) {
+            return;
+        }
+        std::sort(latencies_us_.begin(), latencies_us_.end());
+        auto percentile = [this](double p) {
+            std::size_t rank = static_cast<std::size_t>(p * static_cast<double>(latencies_us_.size() - 1) + 0.5);
+            return latencies_us_[rank];
+        };
+        state_.counters["p50_us"] = percentile(0.50);
+        state_.counters["p90_us"] = percentile(0.90);
+        state_.counters["p99_us"] = percentile(0.99);
+    }
+
+    std::string scratchDirectory(const std::string& name) {
+        static ScratchRoot root;
+        std::filesystem::path path = root.path() / name;
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+        std::filesystem::create_directories(path, ec);
+        return path.string();
+    }
+
+    const BenchDataset& benchDataset(std::size_t records) {
+        static std::map<std::size_t, BenchDataset> datasets;
+        auto it = datasets.find(records);
+        if (it != datasets.end()) {
+            return it->second;
+        }
+
+        // Same seed as makeItineraries(), so the itineraries match
+        DatasetOptions options;
+        options.itineraries = records;
+        options.packing_items_per_itinerary = records / kBenchItineraries;
+        options.expenses_per_itinerary = records / kBenchItineraries;
+        options.seed = kBenchSeed;
+        DatasetGenerator generator(options);
+        std::vector<Itinerary> itineraries = generator.itineraries();
+        std::vector<Itinerary> owners(itineraries.begin(),
+            itineraries.begin() + std::min(kBenchItineraries, itineraries.size()));
+        std::vector<PackingItem> items = generator.packingItems(owners);
+        std::vector<Expense> expenses = generator.expenses(owners);
+
+        BenchDataset dataset;
+        dataset.directory = scratchDirectory("dataset-" + std::to_string(records));
+        for (const auto& itinerary : owners) {
+            dataset.itinerary_ids.push_back(itinerary.id);
+        }
+        std::size_t stride = std::max<std::size_t>(1, items.size() / 1000);
+        for (std::size_t i = 0; i < items.size(); i += stride) {
+            dataset.item_ids.push_back(items[i].id);
+        }
+
+        QuietOutput quiet;
+        StorageManager(dataset.directory + "/itineraries.json").saveAll(itineraries);
+        ExpenseManager(dataset.directory + "/expenses.json").saveAll(expenses);
+        PackingManager(dataset.directory + "/packing_items.json").saveAll(items);
+        return datasets.emplace(records, std::move(dataset)).first->second;
+    }
+
+    std::string copyDataset(std::size_t records, const std::string& name) {
+        const std::string& source = benchDataset(records).directory;
+        std::string directory = scratchDirectory(name + "-" + std::to_string(records));
+        std::filesystem::copy(source, directory, std::filesystem::copy_options::recursive
+            | std::filesystem::copy_options::overwrite_existing);
+        return directory;
+    }
+
+    ScopedStores::ScopedStores(const std::string& directory) {
+        setVariable("TRAVEL_PLANNER_ITINERARY_STORE", directory + "/itineraries.json");
+        setVariable("TRAVEL_PLANNER_PACKING_STORE", directory + "/packing_items.json");
+        setVariable("TRAVEL_PLANNER_EXPENSE_STORE", directory + "/expenses.json");
+    }
+
+    ScopedStores::~ScopedStores() {
+        for (const char* name : kStoreVariables) {
+            unsetVariable(name);
+        }
+    }
+
+    QuietOutput::QuietOutput()
+        : saved_(std::cout.rdbuf(nullptr)) {
+    }
+
+    QuietOutput::~QuietOutput() {
+        std::cout.clear();
+        std::cout.rdbuf(saved_);
+    }
+
+    std::vector<Itinerary> makeItineraries(std::size_t count) {
+        DatasetOptions options;
+        options.itineraries = count;
+        options.seed = kBenchSeed;
+        return DatasetGenerator(options).itineraries();
+    }
+
+} // namespace travel_planner
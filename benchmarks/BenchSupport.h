@@ -0,0 +1,151 @@
+#ifndef TRAVEL_PLANNER_BENCH_SUPPORT_H
+#define TRAVEL_PLANNER_BENCH_SUPPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "../src/AllocationCounter.h"
+#include "../include/Itinerary.h"
+
+namespace travel_planner {
+
+    /**
+     * Store sizes every benchmark runs at
+     */
+    void applyRecordCounts(benchmark::internal::Benchmark* benchmark);
+
+    /**
+     * Number of itineraries the expense and packing records of a dataset
+     * are spread over, so per-itinerary operations touch
+     * records / kBenchItineraries records
+     */
+    constexpr std::size_t kBenchItineraries = 100;
+
+    /**
+     * Generated stores of one size (see benchDataset())
+     */
+    struct BenchDataset {
+        std::string directory;
+        std::vector<std::string> itinerary_ids;  // Itineraries owning the expense and packing records
+        std::vector<std::string> item_ids;       // Up to 1000 packing item IDs spread over them
+    };
+
+    /**
+     * Times each operation of a benchmark loop and reports, when finished,
+     * the latency percentiles (p50_us, p90_us, p99_us), the throughput, the
+     * heap allocations and bytes per operation (allocs_per_op, bytes_per_op)
+     * and the peak resident set size of the process (peak_rss_mb).
+     *
+     *     OperationStats stats(state, records_per_op);
+     *     for (auto _ : state) {
+     *         auto op = stats.time();
+     *         ...
+     *     }
+     *     stats.report();
+     */
+    class OperationStats {
+    public:
+        /**
+         * Constructor
+         * @param state Benchmark state
+         * @param items_per_op Records processed by one operation
+         */
+        OperationStats(benchmark::State& state, std::int64_t items_per_op);
+
+        /**
+         * Times one operation for as long as it is alive
+         */
+        class Timer {
+        public:
+            explicit Timer(OperationStats& stats);
+            ~Timer();
+
+            Timer(const Timer&) = delete;
+            Timer& operator=(const Timer&) = delete;
+
+        private:
+            OperationStats& stats_;
+            std::chrono::steady_clock::time_point start_;
+        };
+
+        Timer time() { return Timer(*this); }
+
+        /**
+         * Sets the counters of the benchmark
+         */
+        void report();
+
+    private:
+        benchmark::State& state_;
+        std::int64_t items_per_op_;
+        std::vector<double> latencies_us_;
+        AllocationTotals allocations_at_start_;
+    };
+
+    /**
+     * Fresh scratch directory under the system temp directory, removed
+     * when the benchmark process exits
+     * @param name Name of the directory
+     * @return Path of the (empty) directory
+     */
+    std::string scratchDirectory(const std::string& name);
+
+    /**
+     * Dataset of the given size, generated with DatasetGenerator on first
+     * use: "itineraries.json" with that many itineraries, and
+     * "expenses.json" and "packing_items.json" with that many records spread
+     * over the first kBenchItineraries of them. Benchmarks that change
+     * records work on a copy (see copyDataset()).
+     * @param records Records per store
+     * @return The dataset
+     */
+    const BenchDataset& benchDataset(std::size_t records);
+
+    /**
+     * Copies a dataset into a fresh scratch directory
+     * @param records Records per store
+     * @param name Name of the copy
+     * @return Path of the copy
+     */
+    std::string copyDataset(std::size_t records, const std::string& name);
+
+    /**
+     * Points the CLI's stores (TRAVEL_PLANNER_*_STORE) at a directory for
+     * as long as it is alive, for code that opens the stores itself such as
+     * ExportManager
+     */
+    class ScopedStores {
+    public:
+        explicit ScopedStores(const std::string& directory);
+        ~ScopedStores();
+
+        ScopedStores(const ScopedStores&) = delete;
+        ScopedStores& operator=(const ScopedStores&) = delete;
+    };
+
+    /**
+     * Discards everything written to std::cout for as long as it is alive,
+     * so status messages do not end up in the benchmark report
+     */
+    class QuietOutput {
+    public:
+        QuietOutput();
+        ~QuietOutput();
+
+        QuietOutput(const QuietOutput&) = delete;
+        QuietOutput& operator=(const QuietOutput&) = delete;
+
+    private:
+        std::streambuf* saved_;
+    };
+
+    /**
+     * @return The itineraries of benchDataset(count)
+     */
+    std::vector<Itinerary> makeItineraries(std::size_t count);
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_BENCH_SUPPORT_H
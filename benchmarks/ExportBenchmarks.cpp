@@ -0,0 +1,77 @@
+// Benchmarks of every ExportManager export, each exporting one itinerary
+// out of stores holding 1k, 100k and 1M records. ExportManager opens the
+// CLI's stores itself, so they are pointed at the dataset through the
+// TRAVEL_PLANNER_*_STORE variables.
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "../src/ExportManager.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        using ExportMethod = bool (ExportManager::*)(const std::string&, const std::string&);
+
+        void runExport(benchmark::State& state, ExportMethod method, std::int64_t items_per_op) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            const BenchDataset& dataset = benchDataset(records);
+            ScopedStores stores(dataset.directory);
+            std::string output = scratchDirectory("exports");
+            ExportManager exporter;
+            QuietOutput quiet;
+
+            // Rotates over the itineraries that own expense and packing records
+            const std::vector<std::string>& ids = dataset.itinerary_ids;
+            std::size_t next = 0;
+
+            OperationStats stats(state, items_per_op);
+            for (auto _ : state) {
+                auto op = stats.time();
+                if (!(exporter.*method)(ids[next], output)) {
+                    state.SkipWithError("export failed");
+                    break;
+                }
+                next = (next + 1) % ids.size();
+            }
+            stats.report();
+        }
+
+        void BM_ExportItineraryMarkdown(benchmark::State& state) {
+            runExport(state, &ExportManager::exportItineraryMarkdown, 1);
+        }
+
+        void BM_ExportItineraryCSV(benchmark::State& state) {
+            runExport(state, &ExportManager::exportItineraryCSV, 1);
+        }
+
+        void BM_ExportPackingMarkdown(benchmark::State& state) {
+            runExport(state, &ExportManager::exportPackingMarkdown,
+                state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+        }
+
+        void BM_ExportPackingCSV(benchmark::State& state) {
+            runExport(state, &ExportManager::exportPackingCSV,
+                state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+        }
+
+        void BM_ExportExpenseMarkdown(benchmark::State& state) {
+            runExport(state, &ExportManager::exportExpenseMarkdown,
+                state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+        }
+
+        void BM_ExportExpenseCSV(benchmark::State& state) {
+            runExport(state, &ExportManager::exportExpenseCSV,
+                state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+        }
+
+    } // namespace
+
+    BENCHMARK(BM_ExportItineraryMarkdown)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExportItineraryCSV)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExportPackingMarkdown)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExportPackingCSV)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExportExpenseMarkdown)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExportExpenseCSV)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+
+} // namespace travel_planner
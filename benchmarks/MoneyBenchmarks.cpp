@@ -0,0 +1,93 @@
+// Benchmarks of the money kernels behind expense rollups, scalar against
+// AVX2, over one column of 1M amounts split into 8 categories.
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "BenchSupport.h"
+#include "../src/MoneyKernels.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        const std::size_t kMoneyRows = 1000000;
+        const std::uint32_t kMoneyCategories = 8;
+
+        struct MoneyColumns {
+            std::vector<double> amounts;
+            std::vector<std::int64_t> cents;
+            std::vector<std::uint32_t> categories;
+        };
+
+        const MoneyColumns& moneyColumns() {
+            static const MoneyColumns columns = [] {
+                MoneyColumns generated;
+                std::mt19937_64 random(42);
+                std::uniform_int_distribution<std::int64_t> cents(1, 500000);
+                std::uniform_int_distribution<std::uint32_t> category(0, kMoneyCategories - 1);
+                for (std::size_t i = 0; i < kMoneyRows; ++i) {
+                    generated.cents.push_back(cents(random));
+                    generated.amounts.push_back(static_cast<double>(generated.cents.back()) / 100.0);
+                    generated.categories.push_back(category(random));
+                }
+                return generated;
+            }();
+            return columns;
+        }
+
+        // range(0) selects the kernel: 0 scalar, 1 AVX2
+        MoneyKernel benchKernel(benchmark::State& state) {
+            MoneyKernel kernel = state.range(0) == 0 ? MoneyKernel::Scalar : MoneyKernel::Avx2;
+            if (!moneyKernelAvailable(kernel)) {
+                state.SkipWithError("kernel not supported by this CPU");
+            }
+            return kernel;
+        }
+
+        void BM_MoneyAmountsToCents(benchmark::State& state) {
+            MoneyKernel kernel = benchKernel(state);
+            const MoneyColumns& columns = moneyColumns();
+            std::vector<std::int64_t> cents(kMoneyRows);
+
+            OperationStats stats(state, static_cast<std::int64_t>(kMoneyRows));
+            for (auto _ : state) {
+                auto op = stats.time();
+                amountsToCents(columns.amounts.data(), kMoneyRows, cents.data(), kernel);
+                benchmark::DoNotOptimize(cents.data());
+            }
+            stats.report();
+        }
+
+        void BM_MoneyStats(benchmark::State& state) {
+            MoneyKernel kernel = benchKernel(state);
+            const MoneyColumns& columns = moneyColumns();
+
+            OperationStats stats(state, static_cast<std::int64_t>(kMoneyRows));
+            for (auto _ : state) {
+                auto op = stats.time();
+                benchmark::DoNotOptimize(moneyStats(columns.cents.data(), kMoneyRows, kernel));
+            }
+            stats.report();
+        }
+
+        void BM_MoneyStatsByCategory(benchmark::State& state) {
+            MoneyKernel kernel = benchKernel(state);
+            const MoneyColumns& columns = moneyColumns();
+            std::vector<MoneyStats> groups(kMoneyCategories);
+
+            OperationStats stats(state, static_cast<std::int64_t>(kMoneyRows));
+            for (auto _ : state) {
+                auto op = stats.time();
+                moneyStatsByCode(columns.cents.data(), columns.categories.data(), kMoneyRows, groups, kernel);
+                benchmark::DoNotOptimize(groups.data());
+            }
+            stats.report();
+        }
+
+    } // namespace
+
+    BENCHMARK(BM_MoneyAmountsToCents)->ArgName("avx2")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_MoneyStats)->ArgName("avx2")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_MoneyStatsByCategory)->ArgName("avx2")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+} // namespace travel_planner
@@ -0,0 +1,211 @@
+// Benchmarks of the itinerary, expense and packing stores. Each runs at
+// 1k, 100k and 1M records per store; expense and packing records are
+// spread over kBenchItineraries itineraries, so per-itinerary operations
+// work on records / kBenchItineraries of them. Per-itinerary benchmarks
+// cycle through those itineraries so no single shard stays hot.
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "../src/ExpenseManager.h"
+#include "../src/PackingManager.h"
+#include "../src/RecordArena.h"
+#include "../src/StorageManager.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        void BM_StorageLoadAll(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            StorageManager storage(benchDataset(records).directory + "/itineraries.json");
+
+            OperationStats stats(state, state.range(0));
+            for (auto _ : state) {
+                auto op = stats.time();
+                std::vector<Itinerary> itineraries = storage.loadAll();
+                benchmark::DoNotOptimize(itineraries.data());
+            }
+            stats.report();
+        }
+
+        // Same load into a per-operation arena, as the CLI does per command
+        void BM_StorageLoadAllArena(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            StorageManager storage(benchDataset(records).directory + "/itineraries.json");
+
+            OperationStats stats(state, state.range(0));
+            for (auto _ : state) {
+                auto op = stats.time();
+                RecordArena arena;
+                auto itineraries = storage.loadAll(arena.resource());
+                benchmark::DoNotOptimize(itineraries.data());
+            }
+            stats.report();
+        }
+
+        void BM_StorageSaveAll(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            std::vector<Itinerary> itineraries = makeItineraries(records);
+            StorageManager storage(scratchDirectory("save-all") + "/itineraries.json");
+
+            OperationStats stats(state, state.range(0));
+            for (auto _ : state) {
+                auto op = stats.time();
+                storage.saveAll(itineraries);
+            }
+            stats.report();
+        }
+
+        // Puts every secondary index of a store in use, as queries do, so
+        // each save refreshes them
+        void useAllIndexes(const StorageManager& storage) {
+            QuietOutput quiet;
+            storage.activeOn(*Date::parse("2024-06-01"));
+            storage.search(SearchQuery::parse({ "beach" }));
+            storage.searchNames("par", [](std::string_view, std::string_view) {});
+            storage.listTagged(TagQuery{ { "vacation" }, {}, {}, false });
+            storage.searchFuzzy("pariss", 1, [](const FuzzyIndex::Match&) {});
+        }
+
+        // Save with the date, search, trigram, tag and fuzzy indexes in use:
+        // each is rebuilt from the saved itineraries, so this is the cost of
+        // the save path on top of BM_StorageSaveAll
+        void BM_StorageSaveAllIndexed(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            std::vector<Itinerary> itineraries = makeItineraries(records);
+            StorageManager storage(scratchDirectory("save-all-indexed") + "/itineraries.json");
+            storage.saveAll(itineraries);
+            useAllIndexes(storage);
+
+            OperationStats stats(state, state.range(0));
+            for (auto _ : state) {
+                auto op = stats.time();
+                storage.saveAll(itineraries);
+            }
+            stats.report();
+        }
+
+        // Tag added to or removed from one itinerary (tag add/remove) with
+        // the tag index in use, which is updated in place
+        void BM_StorageTagChange(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            std::vector<Itinerary> itineraries = makeItineraries(records);
+            StorageManager storage(scratchDirectory("tag-change") + "/itineraries.json");
+            storage.saveAll(itineraries);
+            {
+                QuietOutput quiet;
+                storage.listTagged(TagQuery{ { "vacation" }, {}, {}, false });
+            }
+            std::size_t next = 0;
+
+            OperationStats stats(state, 1);
+            for (auto _ : state) {
+                std::vector<std::string>& tags = itineraries[next].tags;
+                auto found = std::find(tags.begin(), tags.end(), "bench");
+                if (found == tags.end()) {
+                    tags.push_back("bench");
+                }
+                else {
+                    tags.erase(found);
+                }
+                auto op = stats.time();
+                storage.saveTagChange(itineraries, next);
+                next = (next + 7919) % itineraries.size();
+            }
+            stats.report();
+        }
+
+        void BM_ExpenseAdd(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            ExpenseManager expenses(copyDataset(records, "expense-add") + "/expenses.json");
+            const std::vector<std::string>& ids = benchDataset(records).itinerary_ids;
+            std::size_t next = 0;
+
+            OperationStats stats(state, 1);
+            for (auto _ : state) {
+                auto op = stats.time();
+                benchmark::DoNotOptimize(expenses.addExpense(ids[next], 12.5, "Food", "2024-06-01", "Lunch"));
+                next = (next + 1) % ids.size();
+            }
+            stats.report();
+        }
+
+        void BM_ExpenseSummary(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            const BenchDataset& dataset = benchDataset(records);
+            ExpenseManager expenses(dataset.directory + "/expenses.json");
+            const std::vector<std::string>& ids = dataset.itinerary_ids;
+            std::size_t next = 0;
+
+            OperationStats stats(state, state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+            for (auto _ : state) {
+                auto op = stats.time();
+                auto totals = expenses.summary(ids[next]);
+                benchmark::DoNotOptimize(totals);
+                next = (next + 1) % ids.size();
+            }
+            stats.report();
+        }
+
+        void BM_ExpenseList(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            const BenchDataset& dataset = benchDataset(records);
+            ExpenseManager expenses(dataset.directory + "/expenses.json");
+            const std::vector<std::string>& ids = dataset.itinerary_ids;
+            std::size_t next = 0;
+
+            OperationStats stats(state, state.range(0) / static_cast<std::int64_t>(kBenchItineraries));
+            for (auto _ : state) {
+                auto op = stats.time();
+                std::vector<Expense> list = expenses.listExpenses(ids[next]);
+                benchmark::DoNotOptimize(list.data());
+                next = (next + 1) % ids.size();
+            }
+            stats.report();
+        }
+
+        void BM_ExpenseLoadAllArena(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            ExpenseManager expenses(benchDataset(records).directory + "/expenses.json");
+
+            OperationStats stats(state, state.range(0));
+            for (auto _ : state) {
+                auto op = stats.time();
+                RecordArena arena;
+                auto list = expenses.loadAll(arena.resource());
+                benchmark::DoNotOptimize(list.data());
+            }
+            stats.report();
+        }
+
+        void BM_PackingMarkPacked(benchmark::State& state) {
+            std::size_t records = static_cast<std::size_t>(state.range(0));
+            PackingManager packing(copyDataset(records, "mark-packed") + "/packing_items.json");
+            const std::vector<std::string>& ids = benchDataset(records).item_ids;
+            packing.markPacked(ids[0]);  // Builds the item index outside the timed loop
+            std::size_t next = 0;
+
+            OperationStats stats(state, 1);
+            for (auto _ : state) {
+                auto op = stats.time();
+                benchmark::DoNotOptimize(packing.markPacked(ids[next]));
+                next = (next + 1) % ids.size();
+            }
+            stats.report();
+        }
+
+    } // namespace
+
+    BENCHMARK(BM_StorageLoadAll)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_StorageLoadAllArena)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_StorageSaveAll)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_StorageSaveAllIndexed)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_StorageTagChange)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_ExpenseAdd)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExpenseSummary)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExpenseList)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_ExpenseLoadAllArena)->Apply(applyRecordCounts)->Unit(benchmark::kMillisecond);
+    BENCHMARK(BM_PackingMarkPacked)->Apply(applyRecordCounts)->Unit(benchmark::kMicrosecond);
+
+} // namespace travel_planner
@@ -0,0 +1,110 @@
+// Benchmarks of the case-insensitive substring kernel behind name search,
+// reported in bytes per second: one pattern checked against the name and
+// description of each of 100k itineraries, against lowercasing copies of
+// both strings as search --name used to, and the same texts scanned as one
+// buffer.
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+#include "BenchSupport.h"
+#include "../src/TextKernels.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        const std::size_t kTextItineraries = 100000;
+
+        // Appears in no generated name, so every byte is scanned
+        const std::string kTextPattern = "zanzibar";
+
+        struct TextColumn {
+            std::vector<std::string> texts;
+            std::string joined;  // All texts, one per line
+            std::int64_t bytes = 0;
+        };
+
+        const TextColumn& textColumn() {
+            static const TextColumn column = [] {
+                TextColumn texts;
+                for (const auto& itinerary : makeItineraries(kTextItineraries)) {
+                    texts.texts.push_back(itinerary.name);
+                    texts.texts.push_back(itinerary.description);
+                    texts.bytes += static_cast<std::int64_t>(itinerary.name.size() + itinerary.description.size());
+                    texts.joined += itinerary.name + '\n' + itinerary.description + '\n';
+                }
+                return texts;
+            }();
+            return column;
+        }
+
+        // range(0) selects the kernel: 0 scalar, 1 SSE2, 2 AVX2
+        TextKernel benchKernel(benchmark::State& state) {
+            const TextKernel kernels[] = { TextKernel::Scalar, TextKernel::Sse2, TextKernel::Avx2 };
+            TextKernel kernel = kernels[state.range(0)];
+            if (!textKernelAvailable(kernel)) {
+                state.SkipWithError("kernel not supported by this CPU");
+            }
+            return kernel;
+        }
+
+        void BM_TextFindIgnoreCase(benchmark::State& state) {
+            TextKernel kernel = benchKernel(state);
+            const TextColumn& column = textColumn();
+
+            OperationStats stats(state, static_cast<std::int64_t>(column.texts.size()));
+            for (auto _ : state) {
+                auto op = stats.time();
+                std::size_t matches = 0;
+                for (const auto& text : column.texts) {
+                    matches += containsIgnoreCase(text, kTextPattern, kernel) ? 1 : 0;
+                }
+                benchmark::DoNotOptimize(matches);
+            }
+            stats.report();
+            state.SetBytesProcessed(state.iterations() * column.bytes);
+        }
+
+        void BM_TextFindIgnoreCaseBuffer(benchmark::State& state) {
+            TextKernel kernel = benchKernel(state);
+            const TextColumn& column = textColumn();
+
+            OperationStats stats(state, static_cast<std::int64_t>(column.texts.size()));
+            for (auto _ : state) {
+                auto op = stats.time();
+                benchmark::DoNotOptimize(findIgnoreCase(column.joined, kTextPattern, kernel));
+            }
+            stats.report();
+            state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(column.joined.size()));
+        }
+
+        void BM_TextLowercaseCopies(benchmark::State& state) {
+            const TextColumn& column = textColumn();
+
+            OperationStats stats(state, static_cast<std::int64_t>(column.texts.size()));
+            for (auto _ : state) {
+                auto op = stats.time();
+                std::size_t matches = 0;
+                std::string pattern = kTextPattern;
+                std::transform(pattern.begin(), pattern.end(), pattern.begin(),
+                    [](unsigned char c) { return std::tolower(c); });
+                for (const auto& text : column.texts) {
+                    std::string lowered = text;
+                    std::transform(lowered.begin(), lowered.end(), lowered.begin(),
+                        [](unsigned char c) { return std::tolower(c); });
+                    matches += lowered.find(pattern) != std::string::npos ? 1 : 0;
+                }
+                benchmark::DoNotOptimize(matches);
+            }
+            stats.report();
+            state.SetBytesProcessed(state.iterations() * column.bytes);
+        }
+
+    } // namespace
+
+    BENCHMARK(BM_TextFindIgnoreCase)->ArgName("kernel")->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_TextFindIgnoreCaseBuffer)->ArgName("kernel")->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMicrosecond);
+    BENCHMARK(BM_TextLowercaseCopies)->Unit(benchmark::kMicrosecond);
+
+} // namespace travel_planner
@@ -0,0 +1,112 @@
+#ifndef TRAVEL_PLANNER_DATE_H
+#define TRAVEL_PLANNER_DATE_H
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace travel_planner {
+
+    // Calendar date packed as days since 1970-01-01 (proleptic Gregorian),
+    // so dates compare and subtract as integers. Records keep their dates
+    // as YYYY-MM-DD strings; a Date is parsed from them once, when the
+    // record is written or indexed.
+    class Date {
+    public:
+        constexpr Date() = default;
+        constexpr explicit Date(std::int32_t days) : days_(days) {}
+
+        // Date of a year, month (1-12) and day (1-31), which must be valid
+        static constexpr Date fromCivil(int year, unsigned month, unsigned day) {
+            // Days from civil, counting years from March so the leap day is last
+            const int y = year - (month <= 2 ? 1 : 0);
+            const int era = (y >= 0 ? y : y - 399) / 400;
+            const unsigned year_of_era = static_cast<unsigned>(y - era * 400);
+            const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return Date(era * 146097 + static_cast<std::int32_t>(day_of_era) - 719468);
+        }
+
+        // Parses a YYYY-MM-DD date, rejecting any other form and days
+        // that do not exist (such as 2023-02-29)
+        static std::optional<Date> parse(std::string_view text) {
+            if (text.size() != 10 || text[4] != '-' || text[7] != '-') {
+                return std::nullopt;
+            }
+            int fields[3] = { 0, 0, 0 };
+            const std::size_t starts[3] = { 0, 5, 8 };
+            const std::size_t lengths[3] = { 4, 2, 2 };
+            for (int field = 0; field < 3; ++field) {
+                for (std::size_t i = starts[field]; i < starts[field] + lengths[field]; ++i) {
+                    if (text[i] < '0' || text[i] > '9') {
+                        return std::nullopt;
+                    }
+                    fields[field] = fields[field] * 10 + (text[i] - '0');
+                }
+            }
+            const int year = fields[0];
+            const unsigned month = static_cast<unsigned>(fields[1]);
+            const unsigned day = static_cast<unsigned>(fields[2]);
+            if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) {
+                return std::nullopt;
+            }
+            return fromCivil(year, month, day);
+        }
+
+        // Bounds of open-ended ranges, before and after any parsed date
+        static constexpr Date earliest() { return Date(std::numeric_limits<std::int32_t>::min()); }
+        static constexpr Date latest() { return Date(std::numeric_limits<std::int32_t>::max()); }
+
+        constexpr std::int32_t days() const { return days_; }
+
+        // Formats the date as YYYY-MM-DD
+        std::string toString() const {
+            // Civil from days, the inverse of fromCivil()
+            const std::int32_t z = days_ + 719468;
+            const std::int32_t era = (z >= 0 ? z : z - 146096) / 146097;
+            const unsigned day_of_era = static_cast<unsigned>(z - era * 146097);
+            const unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            const unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            const unsigned mp = (5 * day_of_year + 2) / 153;
+            const unsigned day = day_of_year - (153 * mp + 2) / 5 + 1;
+            const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+            const int year = static_cast<int>(year_of_era) + era * 400 + (month <= 2 ? 1 : 0);
+
+            char text[11];
+            const int parts[3] = { year, static_cast<int>(month), static_cast<int>(day) };
+            const int widths[3] = { 4, 2, 2 };
+            int pos = 0;
+            for (int part = 0; part < 3; ++part) {
+                int value = parts[part];
+                for (int i = widths[part] - 1; i >= 0; --i) {
+                    text[pos + i] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                }
+                pos += widths[part];
+                text[pos++] = '-';
+            }
+            return std::string(text, 10);
+        }
+
+        static constexpr unsigned daysInMonth(int year, unsigned month) {
+            constexpr unsigned days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+            const bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+            return month == 2 && leap ? 29 : days[month - 1];
+        }
+
+        friend constexpr bool operator==(Date a, Date b) { return a.days_ == b.days_; }
+        friend constexpr bool operator!=(Date a, Date b) { return a.days_ != b.days_; }
+        friend constexpr bool operator<(Date a, Date b) { return a.days_ < b.days_; }
+        friend constexpr bool operator>(Date a, Date b) { return a.days_ > b.days_; }
+        friend constexpr bool operator<=(Date a, Date b) { return a.days_ <= b.days_; }
+        friend constexpr bool operator>=(Date a, Date b) { return a.days_ >= b.days_; }
+
+    private:
+        std::int32_t days_ = 0;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_DATE_H
@@ -1,7 +1,9 @@
 #ifndef EXPENSE_H
 #define EXPENSE_H
 
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <nlohmann/json.hpp>
 
 namespace travel_planner {
@@ -28,6 +30,85 @@ namespace travel_planner {
         }
     };
 
+    namespace pmr {
+        struct Expense;
+    }
+
+    // Non-owning view of an expense, valid only for the duration of the
+    // callback it is passed to. Used to scan stores without materializing
+    // Expense objects.
+    struct ExpenseView {
+        std::string_view id;
+        std::string_view itinerary_id;
+        double amount = 0.0;
+        std::string_view category;
+        std::string_view date;
+        std::string_view description;
+
+        ExpenseView() = default;
+
+        explicit ExpenseView(const Expense& e)
+            : id(e.id), itinerary_id(e.itinerary_id), amount(e.amount),
+            category(e.category), date(e.date), description(e.description) {
+        }
+
+        explicit ExpenseView(const pmr::Expense& e);
+
+        Expense toExpense() const {
+            return Expense(std::string(id), std::string(itinerary_id), amount,
+                std::string(category), std::string(date), std::string(description));
+        }
+    };
+
+    namespace pmr {
+
+        // Expense whose strings come from a memory resource, for loading
+        // read-only record sets into an arena (see RecordArena.h). Inside a
+        // std::pmr::vector the vector's resource is passed down to it.
+        struct Expense {
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            std::pmr::string id;
+            std::pmr::string itinerary_id;
+            double amount = 0.0;
+            std::pmr::string category;
+            std::pmr::string date;
+            std::pmr::string description;
+
+            Expense() = default;
+
+            explicit Expense(const allocator_type& alloc)
+                : id(alloc), itinerary_id(alloc), category(alloc), date(alloc), description(alloc) {
+            }
+
+            Expense(const ExpenseView& e, const allocator_type& alloc = {})
+                : id(e.id, alloc), itinerary_id(e.itinerary_id, alloc), amount(e.amount),
+                category(e.category, alloc), date(e.date, alloc), description(e.description, alloc) {
+            }
+
+            Expense(const Expense& other, const allocator_type& alloc)
+                : Expense(ExpenseView(other), alloc) {
+            }
+
+            Expense(Expense&& other, const allocator_type& alloc)
+                : id(std::move(other.id), alloc), itinerary_id(std::move(other.itinerary_id), alloc),
+                amount(other.amount), category(std::move(other.category), alloc),
+                date(std::move(other.date), alloc), description(std::move(other.description), alloc) {
+            }
+
+            Expense(const Expense&) = default;
+            Expense(Expense&&) = default;
+            Expense& operator=(const Expense&) = default;
+            Expense& operator=(Expense&&) = default;
+        };
+
+    } // namespace pmr
+
+    inline ExpenseView::ExpenseView(const pmr::Expense& e)
+        : id(e.id), itinerary_id(e.itinerary_id), amount(e.amount),
+        category(e.category), date(e.date), description(e.description) {
+    }
+
     // JSON serialization functions
     inline void to_json(nlohmann::json& j, const Expense& e) {
         j = nlohmann::json{
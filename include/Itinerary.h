@@ -1,6 +1,7 @@
 #ifndef TRAVEL_PLANNER_ITINERARY_H
 #define TRAVEL_PLANNER_ITINERARY_H
 
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <nlohmann/json.hpp>
@@ -22,10 +23,58 @@ namespace travel_planner {
             const std::string& description,
             const std::vector<std::string>& tags = {})  // Updated constructor
             : id(id), name(name), start_date(start_date),
-            end_date(end_date), description(description), tags(tags), is_favorite(is_favorite) {
+            end_date(end_date), description(description), tags(tags) {
         }
     };
 
+    namespace pmr {
+
+        // Itinerary whose strings and tags come from a memory resource, for
+        // loading read-only record sets into an arena (see RecordArena.h)
+        struct Itinerary {
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            std::pmr::string id;
+            std::pmr::string name;
+            std::pmr::string start_date;
+            std::pmr::string end_date;
+            std::pmr::string description;
+            std::pmr::vector<std::pmr::string> tags;
+            bool is_favorite = false;
+
+            Itinerary() = default;
+
+            explicit Itinerary(const allocator_type& alloc)
+                : id(alloc), name(alloc), start_date(alloc), end_date(alloc), description(alloc), tags(alloc) {
+            }
+
+            Itinerary(const travel_planner::Itinerary& itinerary, const allocator_type& alloc = {})
+                : id(itinerary.id, alloc), name(itinerary.name, alloc), start_date(itinerary.start_date, alloc),
+                end_date(itinerary.end_date, alloc), description(itinerary.description, alloc),
+                tags(itinerary.tags.begin(), itinerary.tags.end(), alloc), is_favorite(itinerary.is_favorite) {
+            }
+
+            Itinerary(const Itinerary& other, const allocator_type& alloc)
+                : id(other.id, alloc), name(other.name, alloc), start_date(other.start_date, alloc),
+                end_date(other.end_date, alloc), description(other.description, alloc),
+                tags(other.tags, alloc), is_favorite(other.is_favorite) {
+            }
+
+            Itinerary(Itinerary&& other, const allocator_type& alloc)
+                : id(std::move(other.id), alloc), name(std::move(other.name), alloc),
+                start_date(std::move(other.start_date), alloc), end_date(std::move(other.end_date), alloc),
+                description(std::move(other.description), alloc), tags(std::move(other.tags), alloc),
+                is_favorite(other.is_favorite) {
+            }
+
+            Itinerary(const Itinerary&) = default;
+            Itinerary(Itinerary&&) = default;
+            Itinerary& operator=(const Itinerary&) = default;
+            Itinerary& operator=(Itinerary&&) = default;
+        };
+
+    } // namespace pmr
+
     // Updated JSON serialization
     inline void to_json(nlohmann::json& j, const Itinerary& itinerary) {
         j = nlohmann::json{
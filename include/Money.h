@@ -0,0 +1,67 @@
+#ifndef TRAVEL_PLANNER_MONEY_H
+#define TRAVEL_PLANNER_MONEY_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+
+namespace travel_planner {
+
+    // Amount of money in integer minor units (cents), so sums are exact
+    // whatever their order. Expense amounts are entered and stored as
+    // decimal numbers and converted to the nearest cent.
+    class Money {
+    public:
+        constexpr Money() = default;
+        constexpr explicit Money(std::int64_t cents) : cents_(cents) {}
+
+        // Nearest cent of a decimal amount (ties to even, like the
+        // vectorized conversion in MoneyKernels.h)
+        static Money fromAmount(double amount) {
+            return Money(static_cast<std::int64_t>(std::nearbyint(amount * 100.0)));
+        }
+
+        constexpr std::int64_t cents() const { return cents_; }
+
+        // Decimal amount, for code that still works in doubles
+        double amount() const { return static_cast<double>(cents_) / 100.0; }
+
+        // Formats the amount with two decimals, e.g. "-12.05"
+        std::string toString() const {
+            std::int64_t units = cents_ / 100;
+            std::int64_t fraction = std::llabs(cents_ % 100);
+            std::string text = cents_ < 0 && units == 0 ? "-" : "";
+            text += std::to_string(units);
+            text += '.';
+            text += static_cast<char>('0' + fraction / 10);
+            text += static_cast<char>('0' + fraction % 10);
+            return text;
+        }
+
+        Money& operator+=(Money other) { cents_ += other.cents_; return *this; }
+        Money& operator-=(Money other) { cents_ -= other.cents_; return *this; }
+
+        friend Money operator+(Money a, Money b) { return a += b; }
+        friend Money operator-(Money a, Money b) { return a -= b; }
+
+        friend bool operator==(Money a, Money b) { return a.cents_ == b.cents_; }
+        friend bool operator!=(Money a, Money b) { return a.cents_ != b.cents_; }
+        friend bool operator<(Money a, Money b) { return a.cents_ < b.cents_; }
+        friend bool operator>(Money a, Money b) { return a.cents_ > b.cents_; }
+        friend bool operator<=(Money a, Money b) { return a.cents_ <= b.cents_; }
+        friend bool operator>=(Money a, Money b) { return a.cents_ >= b.cents_; }
+
+        // Prints toString(); a stream width applies to the whole amount
+        friend std::ostream& operator<<(std::ostream& out, Money money) {
+            return out << money.toString();
+        }
+
+    private:
+        std::int64_t cents_ = 0;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_MONEY_H
@@ -1,6 +1,7 @@
 #ifndef PACKING_ITEM_H
 #define PACKING_ITEM_H
 
+#include <memory_resource>
 #include <string>
 #include <nlohmann/json.hpp>
 
@@ -23,6 +24,48 @@ namespace travel_planner {
         }
     };
 
+    namespace pmr {
+
+        // PackingItem whose strings come from a memory resource, for loading
+        // read-only record sets into an arena (see RecordArena.h)
+        struct PackingItem {
+            using allocator_type = std::pmr::polymorphic_allocator<char>;
+
+            std::pmr::string id;
+            std::pmr::string itinerary_id;
+            std::pmr::string name;
+            int quantity = 1;
+            bool packed = false;
+
+            PackingItem() = default;
+
+            explicit PackingItem(const allocator_type& alloc)
+                : id(alloc), itinerary_id(alloc), name(alloc) {
+            }
+
+            PackingItem(const travel_planner::PackingItem& item, const allocator_type& alloc = {})
+                : id(item.id, alloc), itinerary_id(item.itinerary_id, alloc), name(item.name, alloc),
+                quantity(item.quantity), packed(item.packed) {
+            }
+
+            PackingItem(const PackingItem& other, const allocator_type& alloc)
+                : id(other.id, alloc), itinerary_id(other.itinerary_id, alloc), name(other.name, alloc),
+                quantity(other.quantity), packed(other.packed) {
+            }
+
+            PackingItem(PackingItem&& other, const allocator_type& alloc)
+                : id(std::move(other.id), alloc), itinerary_id(std::move(other.itinerary_id), alloc),
+                name(std::move(other.name), alloc), quantity(other.quantity), packed(other.packed) {
+            }
+
+            PackingItem(const PackingItem&) = default;
+            PackingItem(PackingItem&&) = default;
+            PackingItem& operator=(const PackingItem&) = default;
+            PackingItem& operator=(PackingItem&&) = default;
+        };
+
+    } // namespace pmr
+
     // JSON serialization
     inline void to_json(nlohmann::json& j, const PackingItem& item) {
         j = nlohmann::json{
@@ -11,12 +11,27 @@ using namespace std;
 #include <random>
 #include <iomanip>
 #include <ctime>
+#include <cstdlib>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 #include "src/ExpenseManager.h"
 #include "include/version.h"
 #include "include/Itinerary.h"
 #include "src/StorageManager.h"
 #include "src/PackingManager.h"
 #include "src/ExportManager.h"
+#include "src/StorageConfig.h"
+#include "src/CommandServer.h"
+#include "src/RecordCache.h"
+#include "src/DatasetGenerator.h"
+#include "src/Trace.h"
+#include "src/Profiler.h"
+#include "src/RecordArena.h"
+#include "include/Money.h"
+#include "include/Date.h"
 
 
 // Function declarations
@@ -29,12 +44,15 @@ std::string findUnknownOption(int argc, char* argv[]);
 std::string generateUUID();
 void addItinerary();
 void listItineraries();
+void listActiveItineraries(const std::string& day);
+bool parseDateOption(const std::string& option, const std::string& value, travel_planner::Date& date);
 void viewItinerary(const std::string& id);
 bool deleteItinerary(const std::string& id);
 bool addTagToItinerary(const std::string& id, const std::string& tag, bool& alreadyExists);
 bool removeTagFromItinerary(const std::string& id, const std::string& tag, bool& tagExists);
 void listTagsForItinerary(const std::string& id);
 void searchItineraries(const std::string& namePattern);
+void searchItinerariesFuzzy(const std::string& term, std::uint32_t maxDistance);
 void addPackingItem(int argc, char* argv[]);
 void listPackingItems(int argc, char* argv[]);
 void packItem(int argc, char* argv[]);
@@ -43,6 +61,7 @@ std::string getCurrentDate();
 void addExpense(int argc, char* argv[]);
 void listExpenses(int argc, char* argv[]);
 void summarizeExpenses(int argc, char* argv[]);
+void summarizeExpenseGroups(const std::string& itinerary_id, const std::string& by);
 void removeExpense(int argc, char* argv[]);
 void exportItinerary(const std::vector<std::string>& args);
 void exportPacking(const std::vector<std::string>& args);
@@ -50,11 +69,90 @@ void exportExpense(const std::vector<std::string>& args);
 void favoriteItinerary(const std::string& id);
 void unfavoriteItinerary(const std::string& id);
 void listFavoriteItineraries();
-void searchItinerariesByKeyword(const std::string& keyword);
+void listTaggedItineraries(int argc, char* argv[]);
+void searchItinerariesByKeyword(const std::vector<std::string>& words);
+bool convertStorage(const std::string& formatName);
+bool generateDataset(int argc, char* argv[]);
+int runCommand(int argc, char* argv[]);
+int dispatchCommand(int argc, char* argv[]);
+bool isForwardable(int argc, char* argv[]);
+bool serveCommands();
+bool splitCommandLine(const std::string& line, std::vector<std::string>& args, std::string& error);
+bool runBatch(const std::string& source, std::size_t checkpoint);
 std::string promptInput(const std::string& prompt, bool allowEmpty = false);
 
 int main(int argc, char* argv[]) {
+    // --trace <file> and --profile show where the command spends its time,
+    // so the command runs here rather than on a server
+    std::vector<char*> args(argv, argv + argc);
+    std::string tracePath;
+    bool profile = false;
+    for (auto it = args.begin() + 1; it != args.end();) {
+        std::string arg = *it;
+        if (arg == "--trace") {
+            if (it + 1 == args.end()) {
+                std::cerr << "Error: Missing file for --trace." << std::endl;
+                return 1;
+            }
+            tracePath = *(it + 1);
+            it = args.erase(it, it + 2);
+        }
+        else if (arg == "--profile") {
+            profile = true;
+            it = args.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if (!tracePath.empty() || profile) {
+        if (!tracePath.empty()) {
+            travel_planner::startTrace(tracePath);
+        }
+        if (profile) {
+            travel_planner::startProfile();
+        }
+        args.push_back(nullptr);
+
+        int exitCode = runCommand(static_cast<int>(args.size() - 1), args.data());
+        travel_planner::printProfile(std::cout);
+        if (!travel_planner::finishTrace()) {
+            exitCode = 1;
+        }
+        return exitCode;
+    }
+
+    // Hand the command to a running server, if there is one
+    int exitCode = 0;
+    if (isForwardable(argc, argv)
+        && travel_planner::forwardCommand(travel_planner::serverSocketPath(), argc, argv, exitCode)) {
+        return exitCode;
+    }
+
+    return runCommand(argc, argv);
+}
+
+// Run a single command; also called by the server for forwarded commands
+int runCommand(int argc, char* argv[]) {
     displayBanner();
+    return dispatchCommand(argc, argv);
+}
+
+// Run the handler of a command; batch runs call this for every line
+int dispatchCommand(int argc, char* argv[]) {
+    std::string commandLine;
+    if (travel_planner::traceEnabled()) {
+        for (int i = 1; i < argc; ++i) {
+            commandLine += (i > 1 ? " " : "") + std::string(argv[i]);
+        }
+    }
+    travel_planner::TraceSpan span("dispatchCommand", commandLine);
+    travel_planner::ProfileScope profile(travel_planner::ProfilePhase::Other);
+
+    // Read-only record sets of this command are loaded into the arena and
+    // released together when it returns
+    travel_planner::RecordArena arena;
 
     // Check for unknown options
     std::string unknownOption = findUnknownOption(argc, argv);
@@ -82,6 +180,11 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
+    else if (argc == 4 && std::string(argv[1]) == "list" && std::string(argv[2]) == "--active-on") {
+        listActiveItineraries(argv[3]);
+        return 0;
+    }
+
     else if (hasOption(argc, argv, "list") && argc < 3) {
         listItineraries();
         return 0;
@@ -177,18 +280,47 @@ int main(int argc, char* argv[]) {
     else if (argc >= 2 && std::string(argv[1]) == "search") {
         bool hasNameOption = false;
         std::string namePattern;
+        bool hasFuzzyOption = false;
+        std::string fuzzyTerm;
+        std::string maxDistance = "2";
 
         for (int i = 2; i < argc - 1; i++) {
-            if (std::string(argv[i]) == "--name") {
+            std::string option = argv[i];
+            if (option == "--name" && !hasNameOption) {
                 hasNameOption = true;
                 namePattern = argv[i + 1];
-                break;
+            }
+            else if (option == "--fuzzy" && !hasFuzzyOption) {
+                hasFuzzyOption = true;
+                fuzzyTerm = argv[i + 1];
+            }
+            else if (option == "--max-dist") {
+                maxDistance = argv[i + 1];
             }
         }
 
+        if (hasFuzzyOption) {
+            std::uint32_t distance = 0;
+            try {
+                std::size_t used = 0;
+                unsigned long value = std::stoul(maxDistance, &used);
+                if (used != maxDistance.size() || value > 8) {
+                    throw std::out_of_range(maxDistance);
+                }
+                distance = static_cast<std::uint32_t>(value);
+            }
+            catch (const std::exception&) {
+                std::cerr << "Error: Invalid --max-dist '" << maxDistance << "'. Use a number from 0 to 8." << std::endl;
+                return 1;
+            }
+            searchItinerariesFuzzy(fuzzyTerm, distance);
+            return 0;
+        }
+
         if (!hasNameOption) {
-            std::cerr << "Error: Missing --name option." << std::endl;
+            std::cerr << "Error: Missing --name or --fuzzy option." << std::endl;
             std::cout << "Usage: travel_planner search --name <pattern>" << std::endl;
+            std::cout << "       travel_planner search --fuzzy <term> [--max-dist N]" << std::endl;
             return 1;
         }
 
@@ -274,6 +406,11 @@ int main(int argc, char* argv[]) {
         return 0;
 	}
 
+    else if (argc >= 3 && std::string(argv[1]) == "itinerary" && std::string(argv[2]) == "list") {
+        listTaggedItineraries(argc, argv);
+        return 0;
+	}
+
     else if (argc >= 2 && std::string(argv[1]) == "itinerary" && std::string(argv[2]) == "favorites") {
         listFavoriteItineraries();
         return 0;
@@ -282,10 +419,10 @@ int main(int argc, char* argv[]) {
     else if (argc >= 3 && std::string(argv[1]) == "itinerary" && std::string(argv[2]) == "search") {
         if (argc < 4) {
             std::cerr << "Error: Missing keyword for itinerary search." << std::endl;
-            std::cerr << "Usage: travel_planner itinerary search <keyword>" << std::endl;
+            std::cerr << "Usage: travel_planner itinerary search <keyword>... [OR <keyword>...]" << std::endl;
             return 1;
         }
-        searchItinerariesByKeyword(argv[3]);
+        searchItinerariesByKeyword(std::vector<std::string>(argv + 3, argv + argc));
         return 0;
 	}
 
@@ -309,6 +446,55 @@ int main(int argc, char* argv[]) {
             return 0;
             }
 
+    else if (argc >= 2 && std::string(argv[1]) == "convert") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing storage format for convert command." << std::endl;
+            std::cerr << "Usage: travel_planner convert <json|cbor|msgpack>" << std::endl;
+            return 1;
+        }
+        return convertStorage(argv[2]) ? 0 : 1;
+    }
+
+    else if (argc >= 2 && std::string(argv[1]) == "gen") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing itinerary count for gen command." << std::endl;
+            std::cerr << "Usage: travel_planner gen <itineraries> [--items M] [--expenses K] [--tags T] [--max-tags N]" << std::endl;
+            std::cerr << "       [--tag-skew S] [--category-skew S] [--seed N]" << std::endl;
+            return 1;
+        }
+        return generateDataset(argc, argv) ? 0 : 1;
+    }
+
+    else if (argc >= 2 && std::string(argv[1]) == "batch") {
+        if (argc < 3) {
+            std::cerr << "Error: Missing command file for batch command." << std::endl;
+            std::cerr << "Usage: travel_planner batch <file|-> [--checkpoint N]" << std::endl;
+            return 1;
+        }
+
+        std::size_t checkpoint = 0;
+        for (int i = 3; i + 1 < argc; ++i) {
+            if (std::string(argv[i]) == "--checkpoint") {
+                try {
+                    checkpoint = std::stoul(argv[i + 1]);
+                }
+                catch (const std::exception&) {
+                    std::cerr << "Error: Invalid checkpoint interval '" << argv[i + 1] << "'" << std::endl;
+                    return 1;
+                }
+            }
+        }
+        return runBatch(argv[2], checkpoint) ? 0 : 1;
+    }
+
+    else if (argc >= 2 && std::string(argv[1]) == "serve") {
+        if (argc >= 3 && std::string(argv[2]) == "stop") {
+            std::cerr << "Error: No server is running." << std::endl;
+            return 1;
+        }
+        return serveCommands() ? 0 : 1;
+    }
+
     // If no valid command is provided
     std::cerr << "Error: Invalid command" << std::endl;
     displayHelp();
@@ -333,26 +519,32 @@ void displayHelp() {
     std::cout << "Options:" << std::endl;
     std::cout << "  -h, --help     Display this help message" << std::endl;
     std::cout << "  --version      Display version information" << std::endl;
+    std::cout << "  --trace <file> Write a Chrome trace-event profile of the command (open in Perfetto)" << std::endl;
+    std::cout << "  --profile      Print time, hardware counters and allocations per phase (load, filter, serialize, write)" << std::endl;
     std::cout << std::endl;
     std::cout << "Commands:" << std::endl;
     std::cout << "  add                   Create a new travel itinerary" << std::endl;
     std::cout << "  list                  List all itineraries" << std::endl;
+    std::cout << "  list --active-on YYYY-MM-DD  List the itineraries under way on a day" << std::endl;
     std::cout << "  view <id>             View details of a specific itinerary" << std::endl;
     std::cout << "  delete <id>           Delete an itinerary" << std::endl;
     std::cout << "  tag add <id> <tag>    Add a tag to an itinerary" << std::endl;
     std::cout << "  tag remove <id> <tag> Remove a tag from an itinerary" << std::endl;
     std::cout << "  tag list <id>         List all tags for an itinerary" << std::endl;
     std::cout << "  search --name <pattern>  Search for itineraries by name" << std::endl;
+    std::cout << "  search --fuzzy <term> [--max-dist N]  Find itineraries whose name, a word of it or a tag" << std::endl;
+    std::cout << "      is within N typos of the term (default 2)" << std::endl;
     std::cout << "  packing add <itinerary_id> <item_name> [--qty N]  Add a packing item to an itinerary" << std::endl;
     std::cout << "  packing list <itinerary_id>         List all packing items for an itinerary" << std::endl;
     std::cout << "  packing pack <item_id>              Toggle packed status of an item" << std::endl;
     std::cout << "  packing remove <item_id>            Remove an item from the packing list" << std::endl;
     std::cout << "  expense add <itinerary_id> <amount> --category <category> [--date YYYY-MM-DD] [--desc \"<description>\"]" << std::endl;
     std::cout << "      Add a new expense for the specified itinerary" << std::endl;
-    std::cout << "  expense list <itinerary_id>" << std::endl;
-    std::cout << "      List all expenses for the specified itinerary" << std::endl;
-    std::cout << "  travel_planner expense summary <itinerary_id>" << std::endl;
+    std::cout << "  expense list <itinerary_id> [--from YYYY-MM-DD] [--to YYYY-MM-DD]" << std::endl;
+    std::cout << "      List all expenses for the specified itinerary, or those dated within the range" << std::endl;
+    std::cout << "  travel_planner expense summary <itinerary_id> [--by category|day|month]" << std::endl;
     std::cout << "      Display a summary of expenses by category for the specified itinerary" << std::endl;
+    std::cout << "      (--by adds count, min and max per category, day or month)" << std::endl;
     std::cout << "  travel_planner expense remove <expense_id>" << std::endl;
     std::cout << "      Remove an expense by its ID" << std::endl;
     std::cout << "  export itinerary <id> [--format md|csv] Export an itinerary in Markdown (default) or CSV format" << std::endl;
@@ -363,7 +555,17 @@ void displayHelp() {
     std::cout << "  itinerary unfavorite <id>       Remove favorite status from an itinerary" << std::endl;
     std::cout << "  itinerary unfav <id>                      Shortcut to remove favorite status from an itinerary" << std::endl;
     std::cout << "  itinerary favorites             List all favorite itineraries" << std::endl;
-    std::cout << "  itinerary search <keyword>      Search itineraries by keyword" << std::endl;
+    std::cout << "  itinerary list [--tag T]... [--any T]... [--not T]..." << std::endl;
+    std::cout << "      List the itineraries with every --tag, at least one --any and no --not tag" << std::endl;
+    std::cout << "  itinerary search <keyword>...   Search itineraries by keyword, best match first" << std::endl;
+    std::cout << "      (words must all match; OR between words, \"quoted phrase\")" << std::endl;
+    std::cout << "  convert <json|cbor|msgpack>     Convert all stored data to another storage format" << std::endl;
+    std::cout << "  gen <itineraries> [--items M] [--expenses K] [--tags T] [--max-tags N] [--tag-skew S]" << std::endl;
+    std::cout << "      [--category-skew S] [--seed N]  Add a synthetic dataset for scale testing" << std::endl;
+    std::cout << "  batch <file|-> [--checkpoint N] Run newline-delimited commands, saving each store once" << std::endl;
+    std::cout << "      (every N commands with --checkpoint)" << std::endl;
+    std::cout << "  serve                           Keep running and serve commands from other invocations" << std::endl;
+    std::cout << "  serve stop                      Stop the running server" << std::endl;
 
 }
 
@@ -384,7 +586,9 @@ bool hasOption(int argc, char* argv[], const std::string& option) {
 bool isKnownOption(const std::string& option) {
     static const std::vector<std::string> knownOptions = {
         "--help", "-h", "--version", "add", "list", "view", "edit", "delete", "--name", "--qty",
-        "--category", "--date", "--desc", "--format", "--tag", "fav", "unfav"
+        "--category", "--date", "--desc", "--format", "--tag", "fav", "unfav", "--checkpoint", "--trace", "--profile", "--by",
+        "--items", "--expenses", "--tags", "--max-tags", "--tag-skew", "--category-skew", "--seed",
+        "--from", "--to", "--active-on", "--any", "--not", "--fuzzy", "--max-dist"
     };
 
     return std::find(knownOptions.begin(), knownOptions.end(), option) != knownOptions.end();
@@ -455,6 +659,17 @@ void addItinerary() {
     std::string end_date = promptInput("Enter end date (YYYY-MM-DD): ");
     std::string description = promptInput("Enter description (press Enter when done): ", true);
 
+    // Dates are checked here so the date index can rely on them
+    travel_planner::Date start;
+    travel_planner::Date end;
+    if (!parseDateOption("start date", start_date, start) || !parseDateOption("end date", end_date, end)) {
+        return;
+    }
+    if (end < start) {
+        std::cerr << "Error: End date " << end_date << " is before start date " << start_date << "." << std::endl;
+        return;
+    }
+
     // Create the itinerary object
     travel_planner::Itinerary newItinerary(id, name, start_date, end_date, description);
 
@@ -466,14 +681,17 @@ void addItinerary() {
     itineraries.push_back(newItinerary);
 
     // Save all itineraries
-    storageManager.saveAll(itineraries);
+    if (!storageManager.saveAll(itineraries)) {
+        std::cerr << "Error: Itinerary was not saved." << std::endl;
+        return;
+    }
 
     std::cout << "Itinerary added successfully with ID: " << id << std::endl;
 }
 
 void listItineraries() {
-    travel_planner::StorageManager storageManager("data/itineraries.json");
-    std::vector<travel_planner::Itinerary> itineraries = storageManager.loadAll();
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+    auto itineraries = storageManager.loadAll(travel_planner::currentArena());
 
     if (itineraries.empty()) {
         std::cout << "No itineraries found." << std::endl;
@@ -519,26 +737,74 @@ void listItineraries() {
         << " found." << std::endl;
 }
 
-void viewItinerary(const std::string& id) {
-    // Create storage manager with explicit path
-    travel_planner::StorageManager storageManager("data/itineraries.json");
+// List the itineraries under way on a day (start date <= day <= end date)
+void listActiveItineraries(const std::string& day) {
+    travel_planner::Date date;
+    if (!parseDateOption("--active-on", day, date)) {
+        return;
+    }
 
-    // Load all itineraries
-    std::vector<travel_planner::Itinerary> itineraries = storageManager.loadAll();
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+    std::vector<travel_planner::Itinerary> itineraries = storageManager.activeOn(date);
 
-    // Find the itinerary with the specified ID
-    auto it = std::find_if(itineraries.begin(), itineraries.end(),
-        [&id](const travel_planner::Itinerary& itinerary) {
-            return itinerary.id == id;
-        });
+    if (itineraries.empty()) {
+        std::cout << "No itineraries active on " << day << "." << std::endl;
+        return;
+    }
 
-    if (it == itineraries.end()) {
+    size_t maxIdLength = 2; // "ID" header length
+    size_t maxNameLength = 4; // "Name" header length
+    for (const auto& itinerary : itineraries) {
+        maxIdLength = std::max(maxIdLength, itinerary.id.length());
+        maxNameLength = std::max(maxNameLength, itinerary.name.length());
+    }
+    maxIdLength += 2;
+    maxNameLength += 2;
+    const size_t dateWidth = 12;
+
+    std::cout << std::left
+        << std::setw(maxIdLength) << "ID"
+        << std::setw(maxNameLength) << "Name"
+        << std::setw(dateWidth) << "Start"
+        << std::setw(dateWidth) << "End" << std::endl;
+    std::cout << std::string(maxIdLength + maxNameLength + 2 * dateWidth, '-') << std::endl;
+
+    for (const auto& itinerary : itineraries) {
+        std::cout << std::left
+            << std::setw(maxIdLength) << itinerary.id
+            << std::setw(maxNameLength) << itinerary.name
+            << std::setw(dateWidth) << itinerary.start_date
+            << std::setw(dateWidth) << itinerary.end_date << std::endl;
+    }
+
+    std::cout << std::endl << itineraries.size()
+        << " " << (itineraries.size() == 1 ? "itinerary" : "itineraries")
+        << " active on " << day << "." << std::endl;
+}
+
+// Parse a YYYY-MM-DD command-line date, reporting an invalid one
+bool parseDateOption(const std::string& option, const std::string& value, travel_planner::Date& date) {
+    std::optional<travel_planner::Date> parsed = travel_planner::Date::parse(value);
+    if (!parsed) {
+        std::cerr << "Error: Invalid " << option << " '" << value << "'. Use YYYY-MM-DD." << std::endl;
+        return false;
+    }
+    date = *parsed;
+    return true;
+}
+
+void viewItinerary(const std::string& id) {
+    // Create storage manager with explicit path
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+
+    // Look up the itinerary with the specified ID
+    travel_planner::Itinerary itinerary;
+    if (!storageManager.find(id, itinerary)) {
         std::cerr << "Error: No itinerary found with ID '" << id << "'\n";
         return;
     }
 
     // Display the itinerary details in a formatted way
-    const travel_planner::Itinerary& itinerary = *it;
 
     // Calculate the width for consistent formatting
     size_t labelWidth = 12; // Width for the labels
@@ -562,7 +828,7 @@ void viewItinerary(const std::string& id) {
 
 bool deleteItinerary(const std::string& id) {
     // Create storage manager with explicit path
-    travel_planner::StorageManager storageManager("data/itineraries.json");
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
 
     // Load all itineraries
     std::vector<travel_planner::Itinerary> itineraries = storageManager.loadAll();
@@ -585,7 +851,10 @@ bool deleteItinerary(const std::string& id) {
     itineraries.erase(it);
 
     // Save the updated list back to storage
-    storageManager.saveAll(itineraries);
+    if (!storageManager.saveAll(itineraries)) {
+        std::cerr << "Error: Itinerary was not deleted." << std::endl;
+        return false;
+    }
 
     // Confirmation message
     std::cout << "Successfully deleted itinerary '" << name << "' (ID: " << id << ")\n";
@@ -594,7 +863,7 @@ bool deleteItinerary(const std::string& id) {
 
 bool addTagToItinerary(const std::string& id, const std::string& tag, bool& alreadyExists) {
     // Ensure consistent storage path
-    const std::string storagePath = "data/itineraries.json";
+    const std::string storagePath = travel_planner::itineraryStorePath();
 
     travel_planner::StorageManager storageManager(storagePath);
     auto itineraries = storageManager.loadAll();
@@ -620,14 +889,13 @@ bool addTagToItinerary(const std::string& id, const std::string& tag, bool& alre
     alreadyExists = false;
     tags.push_back(tag);
 
-    // Save changes
-    storageManager.saveAll(itineraries);
-    return true;
+    // Save changes; only this itinerary's tags changed
+    return storageManager.saveTagChange(itineraries, it - itineraries.begin());
 }
 
 bool removeTagFromItinerary(const std::string& id, const std::string& tag, bool& tagExists) {
     // Use EXACTLY the same storage path as in addTagToItinerary
-    const std::string storagePath = "data/itineraries.json";
+    const std::string storagePath = travel_planner::itineraryStorePath();
 
     travel_planner::StorageManager storageManager(storagePath);
     auto itineraries = storageManager.loadAll();
@@ -655,13 +923,12 @@ bool removeTagFromItinerary(const std::string& id, const std::string& tag, bool&
     tagExists = true;
     tags.erase(tagIt);
 
-    // Save changes
-    storageManager.saveAll(itineraries);
-    return true;
+    // Save changes; only this itinerary's tags changed
+    return storageManager.saveTagChange(itineraries, it - itineraries.begin());
 }
 
 void listTagsForItinerary(const std::string& id) {
-    travel_planner::StorageManager storageManager("data/itineraries.json");
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
     auto itineraries = storageManager.loadAll();
 
     auto it = std::find_if(itineraries.begin(), itineraries.end(),
@@ -689,24 +956,17 @@ void listTagsForItinerary(const std::string& id) {
 }
 
 void searchItineraries(const std::string& namePattern) {
-    travel_planner::StorageManager storageManager("data/itineraries.json");
-    auto itineraries = storageManager.loadAll();
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
 
-    // Filter itineraries by name pattern (case-insensitive substring match)
-    std::vector<travel_planner::Itinerary> matchingItineraries;
-    std::string patternLower = namePattern;
-    std::transform(patternLower.begin(), patternLower.end(), patternLower.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-
-    for (const auto& itinerary : itineraries) {
-        std::string nameLower = itinerary.name;
-        std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
-            [](unsigned char c) { return std::tolower(c); });
-
-        if (nameLower.find(patternLower) != std::string::npos) {
-            matchingItineraries.push_back(itinerary);
-        }
-    }
+    // Case-insensitive substring match, answered by the name trigram index
+    struct Match {
+        std::string id;
+        std::string name;
+    };
+    std::vector<Match> matchingItineraries;
+    storageManager.searchNames(namePattern, [&matchingItineraries](std::string_view id, std::string_view name) {
+        matchingItineraries.push_back({ std::string(id), std::string(name) });
+    });
 
     // Display results in table format (similar to listItineraries)
     if (matchingItineraries.empty()) {
@@ -744,6 +1004,66 @@ void searchItineraries(const std::string& namePattern) {
     std::cout << matchingItineraries.size() << " itinerary/ies found" << std::endl;
 }
 
+// Find the itineraries with a name, name word or tag within an edit
+// distance of a possibly mistyped term, closest first
+void searchItinerariesFuzzy(const std::string& term, std::uint32_t maxDistance) {
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+
+    struct Match {
+        std::string id;
+        std::string name;
+        std::string term;
+        std::uint32_t distance;
+    };
+    std::vector<Match> matchingItineraries;
+    storageManager.searchFuzzy(term, maxDistance, [&matchingItineraries](const travel_planner::FuzzyIndex::Match& match) {
+        matchingItineraries.push_back({ std::string(match.id), std::string(match.name), std::string(match.term), match.distance });
+    });
+
+    if (matchingItineraries.empty()) {
+        std::cout << "No itineraries found within distance " << maxDistance << " of '" << term << "'" << std::endl;
+        return;
+    }
+
+    // Calculate column widths
+    size_t idColWidth = 2;  // "ID" heading
+    size_t nameColWidth = 4;  // "Name" heading
+    size_t termColWidth = 7;  // "Matched" heading
+    const size_t distanceColWidth = 10;  // "Distance" heading
+
+    for (const auto& itinerary : matchingItineraries) {
+        idColWidth = std::max(idColWidth, itinerary.id.length());
+        nameColWidth = std::max(nameColWidth, itinerary.name.length());
+        termColWidth = std::max(termColWidth, itinerary.term.length());
+    }
+
+    // Add padding
+    idColWidth += 2;
+    nameColWidth += 2;
+    termColWidth += 2;
+    const size_t tableWidth = idColWidth + nameColWidth + termColWidth + distanceColWidth + 3;
+
+    // Print header
+    std::cout << std::string(tableWidth, '-') << std::endl;
+    std::cout << '|' << std::left << std::setw(idColWidth) << " ID"
+        << '|' << std::setw(nameColWidth) << " Name"
+        << '|' << std::setw(termColWidth) << " Matched"
+        << '|' << std::setw(distanceColWidth) << " Distance" << '|' << std::endl;
+    std::cout << std::string(tableWidth, '-') << std::endl;
+
+    // Print rows
+    for (const auto& itinerary : matchingItineraries) {
+        std::cout << '|' << std::setw(idColWidth) << " " + itinerary.id
+            << '|' << std::setw(nameColWidth) << " " + itinerary.name
+            << '|' << std::setw(termColWidth) << " " + itinerary.term
+            << '|' << std::setw(distanceColWidth) << " " + std::to_string(itinerary.distance) << '|' << std::endl;
+    }
+
+    // Print footer
+    std::cout << std::string(tableWidth, '-') << std::endl;
+    std::cout << matchingItineraries.size() << " itinerary/ies found" << std::endl;
+}
+
 void addPackingItem(int argc, char* argv[]) {
     // Check for required parameters
     if (argc < 5) {
@@ -776,8 +1096,12 @@ void addPackingItem(int argc, char* argv[]) {
     }
 
     // Create PackingManager and add the item
-    travel_planner::PackingManager packingManager("data/packing.json");
+    travel_planner::PackingManager packingManager(travel_planner::packingStorePath());
     std::string item_id = packingManager.addItem(itinerary_id, item_name, quantity);
+    if (item_id.empty()) {
+        std::cerr << "Error: Failed to save packing item." << std::endl;
+        return;
+    }
 
     std::cout << "Packing item added with ID: " << item_id << std::endl;
 }
@@ -792,17 +1116,9 @@ void listPackingItems(int argc, char* argv[]) {
 
     std::string itinerary_id = argv[3];
 
-    // Create PackingManager and load items
-    travel_planner::PackingManager packingManager("data/packing.json");
-    std::vector<travel_planner::PackingItem> allItems = packingManager.loadAll();
-
-    // Filter items for the specified itinerary
-    std::vector<travel_planner::PackingItem> filteredItems;
-    for (const auto& item : allItems) {
-        if (item.itinerary_id == itinerary_id) {
-            filteredItems.push_back(item);
-        }
-    }
+    // Create PackingManager and load the itinerary's items
+    travel_planner::PackingManager packingManager(travel_planner::packingStorePath());
+    std::vector<travel_planner::PackingItem> filteredItems = packingManager.listItems(itinerary_id);
 
     // Check if there are any items
     if (filteredItems.empty()) {
@@ -862,21 +1178,12 @@ void packItem(int argc, char* argv[]) {
     std::string item_id = argv[3];
 
     // Create PackingManager and toggle packed status
-    travel_planner::PackingManager packingManager("data/packing.json");
+    travel_planner::PackingManager packingManager(travel_planner::packingStorePath());
 
-    // Load all items to determine current status
-    std::vector<travel_planner::PackingItem> allItems = packingManager.loadAll();
-    bool currentStatus = false;
-    bool itemFound = false;
-
-    // Find current status of the item
-    for (const auto& item : allItems) {
-        if (item.id == item_id) {
-            currentStatus = item.packed;
-            itemFound = true;
-            break;
-        }
-    }
+    // Look up the item to determine current status
+    travel_planner::PackingItem item;
+    bool itemFound = packingManager.findItem(item_id, item);
+    bool currentStatus = item.packed;
 
     if (!itemFound) {
         std::cerr << "Error: No item found with ID: " << item_id << std::endl;
@@ -904,7 +1211,7 @@ void removePackingItem(int argc, char* argv[]) {
     std::string item_id = argv[3];
 
     // Create PackingManager and remove the item
-    travel_planner::PackingManager packingManager("data/packing.json");
+    travel_planner::PackingManager packingManager(travel_planner::packingStorePath());
 
     if (packingManager.removeItem(item_id)) {
         std::cout << "Item " << item_id << " successfully removed from packing list." << std::endl;
@@ -966,7 +1273,6 @@ void addExpense(int argc, char* argv[]) {
         }
         else if (arg == "--date" && i + 1 < argc) {
             date = argv[++i];
-            // Basic date validation could be added here
         }
         else if (arg == "--desc" && i + 1 < argc) {
             description = argv[++i];
@@ -978,8 +1284,13 @@ void addExpense(int argc, char* argv[]) {
         return;
     }
 
+    travel_planner::Date day;
+    if (!parseDateOption("--date", date, day)) {
+        return;
+    }
+
     // Add the expense
-    travel_planner::ExpenseManager expenseManager("data/expenses.json");
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
     if (expenseManager.addExpense(itinerary_id, amount, category, date, description)) {
         std::cout << "Expense added successfully." << std::endl;
     }
@@ -992,15 +1303,37 @@ void listExpenses(int argc, char* argv[]) {
     // Check for required parameters
     if (argc < 4) {
         std::cerr << "Error: Missing itinerary ID for expense list command." << std::endl;
-        std::cout << "Usage: travel_planner expense list <itinerary_id>" << std::endl;
+        std::cout << "Usage: travel_planner expense list <itinerary_id> [--from YYYY-MM-DD] [--to YYYY-MM-DD]" << std::endl;
         return;
     }
 
     std::string itinerary_id = argv[3];
 
+    // --from and --to keep the expenses dated within the range, in date order
+    travel_planner::Date from = travel_planner::Date::earliest();
+    travel_planner::Date to = travel_planner::Date::latest();
+    bool ranged = false;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--from" || arg == "--to") && i + 1 < argc) {
+            if (!parseDateOption(arg, argv[++i], arg == "--from" ? from : to)) {
+                return;
+            }
+            ranged = true;
+        }
+    }
+
     // Load expenses for the specified itinerary
-    travel_planner::ExpenseManager expenseManager("data/expenses.json");
-    std::vector<travel_planner::Expense> expenses = expenseManager.listExpenses(itinerary_id);
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
+    std::pmr::vector<travel_planner::pmr::Expense> expenses(travel_planner::currentArena());
+    if (ranged) {
+        for (const auto& expense : expenseManager.listExpenses(itinerary_id, from, to)) {
+            expenses.emplace_back(travel_planner::ExpenseView(expense));
+        }
+    }
+    else {
+        expenses = expenseManager.listExpenses(itinerary_id, travel_planner::currentArena());
+    }
 
     // Display the expenses
     std::cout << "Expenses for itinerary: " << itinerary_id << std::endl;
@@ -1037,7 +1370,7 @@ void listExpenses(int argc, char* argv[]) {
     std::cout << std::string(id_width + cat_width + date_width + desc_width + 30, '-') << std::endl;
 
     // Print each expense
-    double total = 0.0;
+    travel_planner::Money total;
     for (const auto& expense : expenses) {
         std::cout << std::left
             << std::setw(id_width + 2) << expense.id
@@ -1055,12 +1388,12 @@ void listExpenses(int argc, char* argv[]) {
 
         std::cout << std::endl;
 
-        // Sum up the total
-        total += expense.amount;
+        // Sum up the total in cents, so it matches the summary
+        total += travel_planner::Money::fromAmount(expense.amount);
     }
 
     std::cout << std::string(id_width + cat_width + date_width + desc_width + 30, '-') << std::endl;
-    std::cout << "Total: $" << std::fixed << std::setprecision(2) << total << std::endl;
+    std::cout << "Total: $" << total << std::endl;
     std::cout << expenses.size() << " expense(s) found." << std::endl;
 }
 
@@ -1068,14 +1401,22 @@ void summarizeExpenses(int argc, char* argv[]) {
     // Check for required parameters
     if (argc < 4) {
         std::cerr << "Error: Missing itinerary ID for expense summary command." << std::endl;
-        std::cout << "Usage: travel_planner expense summary <itinerary_id>" << std::endl;
+        std::cout << "Usage: travel_planner expense summary <itinerary_id> [--by category|day|month]" << std::endl;
         return;
     }
 
     std::string itinerary_id = argv[3];
 
+    // --by prints count, total, min and max per group
+    for (int i = 4; i < argc; i++) {
+        if (std::string(argv[i]) == "--by" && i + 1 < argc) {
+            summarizeExpenseGroups(itinerary_id, argv[i + 1]);
+            return;
+        }
+    }
+
     // Get expense summary by category
-    travel_planner::ExpenseManager expenseManager("data/expenses.json");
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
     std::map<std::string, double> categorySummary = expenseManager.summary(itinerary_id);
 
     // Display the summary
@@ -1101,25 +1442,77 @@ void summarizeExpenses(int argc, char* argv[]) {
     std::cout << std::string(categoryWidth + 20, '-') << std::endl;
 
     // Print each category with total
-    double overallTotal = 0.0;
+    travel_planner::Money overallTotal;
     for (const auto& entry : categorySummary) {
         std::cout << std::left
             << std::setw(categoryWidth + 5) << entry.first
             << "$" << std::fixed << std::setprecision(2) << entry.second << std::endl;
 
         // Add to overall total
-        overallTotal += entry.second;
+        overallTotal += travel_planner::Money::fromAmount(entry.second);
     }
 
     // Print overall total
     std::cout << std::string(categoryWidth + 20, '-') << std::endl;
     std::cout << std::left
         << std::setw(categoryWidth + 5) << "TOTAL"
-        << "$" << std::fixed << std::setprecision(2) << overallTotal << std::endl;
+        << "$" << overallTotal << std::endl;
 
     std::cout << std::endl << categorySummary.size() << " category/categories found." << std::endl;
 }
 
+void summarizeExpenseGroups(const std::string& itinerary_id, const std::string& by) {
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
+    travel_planner::ExpenseRollup rollup = expenseManager.rollup(itinerary_id);
+
+    const travel_planner::ExpenseRollup::Groups* groups = nullptr;
+    if (by == "category") {
+        groups = &rollup.categories();
+    }
+    else if (by == "day") {
+        groups = &rollup.days();
+    }
+    else if (by == "month") {
+        groups = &rollup.months();
+    }
+    else {
+        std::cerr << "Error: Invalid grouping '" << by << "'. Use 'category', 'day' or 'month'." << std::endl;
+        return;
+    }
+
+    std::cout << "Expense Summary for itinerary: " << itinerary_id << " (by " << by << ")" << std::endl;
+    std::cout << std::string(50, '-') << std::endl;
+
+    if (groups->empty()) {
+        std::cout << "No expenses found for this itinerary." << std::endl;
+        return;
+    }
+
+    size_t keyWidth = 10;  // Minimum width
+    for (const auto& entry : *groups) {
+        keyWidth = std::max(keyWidth, entry.first.length());
+    }
+
+    auto printRow = [keyWidth](const std::string& key, const travel_planner::RollupStats& stats) {
+        std::cout << std::left << std::setw(keyWidth + 2) << key
+            << std::right << std::setw(7) << stats.count
+            << std::setw(12) << stats.sum
+            << std::setw(10) << stats.min
+            << std::setw(10) << stats.max << std::endl;
+    };
+
+    std::cout << std::left << std::setw(keyWidth + 2) << (by == "category" ? "Category" : by == "day" ? "Day" : "Month")
+        << std::right << std::setw(7) << "Count" << std::setw(12) << "Total"
+        << std::setw(10) << "Min" << std::setw(10) << "Max" << std::endl;
+    std::cout << std::string(keyWidth + 41, '-') << std::endl;
+    for (const auto& [key, stats] : *groups) {
+        printRow(key, stats);
+    }
+    std::cout << std::string(keyWidth + 41, '-') << std::endl;
+    printRow("TOTAL", rollup.total());
+    std::cout << std::left << std::endl << groups->size() << " group(s) found." << std::endl;
+}
+
 void removeExpense(int argc, char* argv[]) {
     // Check for required parameters
     if (argc < 4) {
@@ -1131,7 +1524,7 @@ void removeExpense(int argc, char* argv[]) {
     std::string expense_id = argv[3];
 
     // Attempt to remove the expense
-    travel_planner::ExpenseManager expenseManager("data/expenses.json");
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
     bool success = expenseManager.removeExpense(expense_id);
 
     if (success) {
@@ -1301,7 +1694,7 @@ void favoriteItinerary(const std::string& id) {
         return;
     }
 
-    travel_planner::StorageManager storageManager("data/itineraries.json");
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
     std::vector<travel_planner::Itinerary> itineraries = storageManager.loadAll();
 
     auto it = std::find_if(itineraries.begin(), itineraries.end(),
@@ -1318,7 +1711,9 @@ void favoriteItinerary(const std::string& id) {
     it->is_favorite = true;
 
     // Save the updated list
-    storageManager.saveAll(itineraries);
+    if (!storageManager.saveTagChange(itineraries, it - itineraries.begin())) {
+        return;
+    }
     std::cout << "Itinerary '" << it->name << "' marked as favorite." << std::endl;
 }
 
@@ -1328,7 +1723,7 @@ void unfavoriteItinerary(const std::string& id) {
         return;
     }
 
-    travel_planner::StorageManager storageManager("data/itineraries.json");
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
     std::vector<travel_planner::Itinerary> itineraries = storageManager.loadAll();
 
     auto it = std::find_if(itineraries.begin(), itineraries.end(),
@@ -1345,19 +1740,19 @@ void unfavoriteItinerary(const std::string& id) {
     it->is_favorite = false;
 
     // Save the updated list
-    storageManager.saveAll(itineraries);
+    if (!storageManager.saveTagChange(itineraries, it - itineraries.begin())) {
+        return;
+    }
     std::cout << "Favorite status removed from itinerary '" << it->name << "'." << std::endl;
 }
 
 void listFavoriteItineraries() {
-    travel_planner::StorageManager storageManager("data/itineraries.json");
-    std::vector<travel_planner::Itinerary> allItineraries = storageManager.loadAll();
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
 
-    // Filter for favorite itineraries only
-    std::vector<travel_planner::Itinerary> favoriteItineraries;
-    std::copy_if(allItineraries.begin(), allItineraries.end(),
-        std::back_inserter(favoriteItineraries),
-        [](const travel_planner::Itinerary& itin) { return itin.is_favorite; });
+    // Favorites come from the favorites bitmap of the tag index
+    travel_planner::TagQuery query;
+    query.favorites = true;
+    std::vector<travel_planner::Itinerary> favoriteItineraries = storageManager.listTagged(query);
 
     if (favoriteItineraries.empty()) {
         std::cout << "No favorite itineraries found." << std::endl;
@@ -1396,40 +1791,95 @@ void listFavoriteItineraries() {
         << " found." << std::endl;
 }
 
-std::string toLower(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(),
-        [](unsigned char c) { return std::tolower(c); });
-    return result;
-}
+// List the itineraries matching tag options: every --tag, at least one
+// --any (if given) and no --not tag
+void listTaggedItineraries(int argc, char* argv[]) {
+    travel_planner::TagQuery query;
+    for (int i = 3; i < argc; ++i) {
+        std::string option = argv[i];
+        if (option != "--tag" && option != "--any" && option != "--not") {
+            std::cerr << "Error: Unexpected argument '" << option << "'." << std::endl;
+            std::cerr << "Usage: travel_planner itinerary list [--tag T]... [--any T]... [--not T]..." << std::endl;
+            return;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Error: Missing tag for " << option << "." << std::endl;
+            return;
+        }
+        std::string tag = argv[++i];
+        if (option == "--tag") {
+            query.all.push_back(tag);
+        }
+        else if (option == "--any") {
+            query.any.push_back(tag);
+        }
+        else {
+            query.none.push_back(tag);
+        }
+    }
 
-// Helper function for case-insensitive substring check
-bool caseInsensitiveContains(const std::string& str, const std::string& substr) {
-    std::string lowerStr = toLower(str);
-    std::string lowerSubstr = toLower(substr);
-    return lowerStr.find(lowerSubstr) != std::string::npos;
-}
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+    std::vector<travel_planner::Itinerary> matchingItineraries = storageManager.listTagged(query);
 
-// Function to search itineraries by keyword
-void searchItinerariesByKeyword(const std::string& keyword) {
-    if (keyword.empty()) {
-        std::cerr << "Error: Search keyword is required." << std::endl;
+    if (matchingItineraries.empty()) {
+        std::cout << "No itineraries found." << std::endl;
         return;
     }
 
-    travel_planner::StorageManager storageManager("data/itineraries.json");
-    std::vector<travel_planner::Itinerary> allItineraries = storageManager.loadAll();
+    // Find the longest ID and name for formatting
+    size_t maxIdLength = 2; // "ID" header length
+    size_t maxNameLength = 4; // "Name" header length
 
-    // Filter for matching itineraries
-    std::vector<travel_planner::Itinerary> matchingItineraries;
+    for (const auto& itinerary : matchingItineraries) {
+        maxIdLength = std::max(maxIdLength, itinerary.id.length());
+        maxNameLength = std::max(maxNameLength, itinerary.name.length());
+    }
 
-    for (const auto& itinerary : allItineraries) {
-        if (caseInsensitiveContains(itinerary.name, keyword) ||
-            caseInsensitiveContains(itinerary.description, keyword)) {
-            matchingItineraries.push_back(itinerary);
+    // Add some padding
+    maxIdLength += 2;
+    maxNameLength += 2;
+
+    // Print headers
+    std::cout << std::left << std::setw(maxIdLength) << "ID"
+        << std::setw(maxNameLength) << "Name" << "Tags" << std::endl;
+
+    // Print separator line
+    std::cout << std::string(maxIdLength + maxNameLength + 4, '-') << std::endl;
+
+    // Print itineraries
+    for (const auto& itinerary : matchingItineraries) {
+        std::string tags;
+        for (const auto& tag : itinerary.tags) {
+            tags += (tags.empty() ? "" : ", ") + tag;
         }
+        std::cout << std::left << std::setw(maxIdLength) << itinerary.id
+            << std::setw(maxNameLength) << itinerary.name << tags << std::endl;
+    }
+
+    // Print count
+    std::cout << std::endl << matchingItineraries.size()
+        << " " << (matchingItineraries.size() == 1 ? "itinerary" : "itineraries")
+        << " found." << std::endl;
+}
+
+// Function to search itineraries by keyword. Words must all match,
+// "OR" separates alternatives and quoted words form a phrase.
+void searchItinerariesByKeyword(const std::vector<std::string>& words) {
+    travel_planner::SearchQuery query = travel_planner::SearchQuery::parse(words);
+    if (query.empty()) {
+        std::cerr << "Error: Search keyword is required." << std::endl;
+        return;
+    }
+
+    std::string keyword;
+    for (const auto& word : words) {
+        keyword += (keyword.empty() ? "" : " ") + word;
     }
 
+    // Ranked matches from the inverted index, best first
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+    std::vector<travel_planner::Itinerary> matchingItineraries = storageManager.search(query);
+
     if (matchingItineraries.empty()) {
         std::cout << "No itineraries found matching '" << keyword << "'." << std::endl;
         return;
@@ -1465,4 +1915,360 @@ void searchItinerariesByKeyword(const std::string& keyword) {
     std::cout << std::endl << matchingItineraries.size()
         << " " << (matchingItineraries.size() == 1 ? "itinerary" : "itineraries")
         << " found matching '" << keyword << "'." << std::endl;
-}
\ No newline at end of file
+}
+
+// Rewrite every store in another format and make it the default
+bool convertStorage(const std::string& formatName) {
+    travel_planner::StorageFormat format;
+    if (!travel_planner::parseStorageFormat(formatName, format)) {
+        std::cerr << "Error: Unknown storage format '" << formatName << "'. Use json, cbor or msgpack." << std::endl;
+        return false;
+    }
+
+    // Same stores, new extension; opening them converts the old files
+    auto withFormat = [format](const std::string& path) {
+        return std::filesystem::path(path).replace_extension(
+            travel_planner::formatExtension(format)).string();
+    };
+
+    std::string itineraryPath = withFormat(travel_planner::itineraryStorePath());
+    std::string packingPath = withFormat(travel_planner::packingStorePath());
+    std::string expensePath = withFormat(travel_planner::expenseStorePath());
+
+    travel_planner::StorageManager storageManager(itineraryPath);
+    std::size_t itineraryCount = storageManager.loadAll(travel_planner::currentArena()).size();
+    std::cout << "Itineraries: " << itineraryCount << " -> " << itineraryPath << std::endl;
+
+    travel_planner::PackingManager packingManager(packingPath);
+    std::size_t packingCount = packingManager.loadAll(travel_planner::currentArena()).size();
+    std::cout << "Packing items: " << packingCount << " -> " << packingPath << std::endl;
+
+    travel_planner::ExpenseManager expenseManager(expensePath);
+    std::size_t expenseCount = expenseManager.loadAll(travel_planner::currentArena()).size();
+    std::cout << "Expenses: " << expenseCount << " -> " << expensePath << std::endl;
+
+    if (!travel_planner::setDefaultStorageFormat(format)) {
+        return false;
+    }
+
+    std::cout << "Storage format set to " << travel_planner::formatName(format) << "." << std::endl;
+    if (std::getenv("TRAVEL_PLANNER_STORAGE_FORMAT") != nullptr) {
+        std::cout << "Note: TRAVEL_PLANNER_STORAGE_FORMAT is set and still takes precedence." << std::endl;
+    }
+    return true;
+}
+
+// Generate synthetic itineraries, packing items and expenses and add them
+// to the stores, in the current storage format
+bool generateDataset(int argc, char* argv[]) {
+    travel_planner::DatasetOptions options;
+    try {
+        options.itineraries = std::stoul(argv[2]);
+        for (int i = 3; i + 1 < argc; ++i) {
+            std::string arg = argv[i];
+            std::string value = argv[i + 1];
+            if (arg == "--items") {
+                options.packing_items_per_itinerary = std::stoul(value);
+            }
+            else if (arg == "--expenses") {
+                options.expenses_per_itinerary = std::stoul(value);
+            }
+            else if (arg == "--tags") {
+                options.tag_vocabulary = std::stoul(value);
+            }
+            else if (arg == "--max-tags") {
+                options.max_tags = std::stoul(value);
+            }
+            else if (arg == "--tag-skew") {
+                options.tag_skew = std::stod(value);
+            }
+            else if (arg == "--category-skew") {
+                options.category_skew = std::stod(value);
+            }
+            else if (arg == "--seed") {
+                options.seed = static_cast<std::uint32_t>(std::stoul(value));
+            }
+            else {
+                continue;
+            }
+            ++i;
+        }
+    }
+    catch (const std::exception&) {
+        std::cerr << "Error: Invalid number in gen command." << std::endl;
+        return false;
+    }
+
+    if (options.tag_skew < 0 || options.category_skew < 0) {
+        std::cerr << "Error: Skews must not be negative." << std::endl;
+        return false;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+    auto perSecond = [](std::size_t records, double ms) {
+        return ms > 0 ? static_cast<std::size_t>(records * 1000.0 / ms) : records;
+    };
+
+    Clock::time_point start = Clock::now();
+    travel_planner::DatasetGenerator generator(options);
+    std::vector<travel_planner::Itinerary> itineraries = generator.itineraries();
+    std::vector<travel_planner::PackingItem> items = generator.packingItems(itineraries);
+    std::vector<travel_planner::Expense> expenses = generator.expenses(itineraries);
+    double generateMs = elapsedMs(start);
+    std::size_t records = itineraries.size() + items.size() + expenses.size();
+
+    std::cout << "Generated " << itineraries.size() << " itineraries, " << items.size() << " packing items and "
+        << expenses.size() << " expenses in " << std::fixed << std::setprecision(1) << generateMs << " ms ("
+        << perSecond(records, generateMs) << " records/s)" << std::endl;
+
+    // Existing records are kept; the generated ones are added to them
+    start = Clock::now();
+    travel_planner::StorageManager storageManager(travel_planner::itineraryStorePath());
+    std::vector<travel_planner::Itinerary> allItineraries = storageManager.loadAll();
+    allItineraries.insert(allItineraries.end(), std::make_move_iterator(itineraries.begin()),
+        std::make_move_iterator(itineraries.end()));
+    if (!storageManager.saveAll(allItineraries)) {
+        std::cerr << "Error: Failed to save itineraries." << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        return false;
+    }
+
+    travel_planner::PackingManager packingManager(travel_planner::packingStorePath());
+    std::vector<travel_planner::PackingItem> allItems = packingManager.loadAll();
+    allItems.insert(allItems.end(), std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+    if (!packingManager.saveAll(allItems)) {
+        std::cerr << "Error: Failed to save packing items." << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        return false;
+    }
+
+    travel_planner::ExpenseManager expenseManager(travel_planner::expenseStorePath());
+    std::vector<travel_planner::Expense> allExpenses = expenseManager.loadAll();
+    allExpenses.insert(allExpenses.end(), std::make_move_iterator(expenses.begin()),
+        std::make_move_iterator(expenses.end()));
+    if (!expenseManager.saveAll(allExpenses)) {
+        std::cerr << "Error: Failed to save expenses." << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+        return false;
+    }
+    double writeMs = elapsedMs(start);
+
+    std::cout << "Wrote " << allItineraries.size() + allItems.size() + allExpenses.size() << " records in "
+        << writeMs << " ms (" << perSecond(records, writeMs) << " generated records/s)" << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    return true;
+}
+
+// Check whether a command can run on the server; commands that prompt on
+// the terminal always run locally
+bool isForwardable(int argc, char* argv[]) {
+    if (argc < 2) {
+        return false;
+    }
+
+    std::string command = argv[1];
+    if (command == "add" || command == "delete") {
+        return false;
+    }
+    if (command == "serve") {
+        return argc >= 3 && std::string(argv[2]) == "stop";
+    }
+    if (command == "batch") {
+        return argc >= 3 && std::string(argv[2]) != "-";  // The server cannot read our stdin
+    }
+    return true;
+}
+
+// Serve commands from other invocations until stopped
+bool serveCommands() {
+    std::string socketPath = travel_planner::serverSocketPath();
+    travel_planner::CommandServer server(socketPath);
+    if (!server.listen()) {
+        return false;
+    }
+
+    // Stores stay parsed in memory between commands
+    travel_planner::setRecordCacheEnabled(true);
+
+    std::cout << "Serving commands on " << socketPath
+        << " (stop with Ctrl+C or 'travel_planner serve stop')" << std::endl;
+    server.run(runCommand);
+    return true;
+}
+
+// Split a batch line into arguments the way a shell would: whitespace
+// separates arguments, quotes group them, a backslash escapes the next
+// character and '#' starts a comment
+bool splitCommandLine(const std::string& line, std::vector<std::string>& args, std::string& error) {
+    args.clear();
+    std::string current;
+    bool inArgument = false;
+    char quote = 0;
+
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        char c = line[i];
+        if (quote == '\'') {
+            if (c == '\'') {
+                quote = 0;
+            }
+            else {
+                current += c;
+            }
+        }
+        else if (c == '\\' && (quote == 0 || (quote == '"' && i + 1 < line.size()
+            && (line[i + 1] == '"' || line[i + 1] == '\\')))) {
+            if (++i == line.size()) {
+                error = "trailing backslash";
+                return false;
+            }
+            current += line[i];
+            inArgument = true;
+        }
+        else if (quote == '"') {
+            if (c == '"') {
+                quote = 0;
+            }
+            else {
+                current += c;
+            }
+        }
+        else if (c == '"' || c == '\'') {
+            quote = c;
+            inArgument = true;
+        }
+        else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inArgument) {
+                args.push_back(current);
+                current.clear();
+                inArgument = false;
+            }
+        }
+        else if (c == '#' && !inArgument) {
+            break;  // Comment up to the end of the line
+        }
+        else {
+            current += c;
+            inArgument = true;
+        }
+    }
+
+    if (quote != 0) {
+        error = "unterminated quote";
+        return false;
+    }
+    if (inArgument) {
+        args.push_back(current);
+    }
+    return true;
+}
+
+// Run newline-delimited commands from a file (or stdin for "-"). Rewrites
+// of existing stores are held in memory and written once at the end, or
+// every checkpoint commands when checkpoint is not 0.
+bool runBatch(const std::string& source, std::size_t checkpoint) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (source != "-") {
+        file.open(source);
+        if (!file.is_open()) {
+            std::cerr << "Error: Unable to open batch file: " << source << std::endl;
+            return false;
+        }
+        in = &file;
+    }
+
+    // Commands that prompt or manage the data files themselves
+    static const std::vector<std::string> excluded = { "add", "delete", "batch", "serve", "convert", "gen" };
+
+    bool cacheWasEnabled = travel_planner::recordCacheEnabled();
+    travel_planner::setRecordCacheEnabled(true);
+    travel_planner::setDeferredWrites(true);
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point batchStart = Clock::now();
+    Clock::duration commandTime = Clock::duration::zero();
+    Clock::duration writeTime = Clock::duration::zero();
+    std::size_t commandCount = 0;
+    std::size_t failedCount = 0;
+    std::size_t filesWritten = 0;
+    std::size_t checkpointCount = 0;
+    std::size_t sinceCheckpoint = 0;
+    bool writesOk = true;
+
+    auto flush = [&]() {
+        Clock::time_point start = Clock::now();
+        std::size_t written = 0;
+        writesOk = travel_planner::flushDeferredWrites(written) && writesOk;
+        writeTime += Clock::now() - start;
+        filesWritten += written;
+        ++checkpointCount;
+        sinceCheckpoint = 0;
+    };
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(*in, line)) {
+        ++lineNumber;
+
+        std::vector<std::string> args;
+        std::string error;
+        if (!splitCommandLine(line, args, error)) {
+            std::cerr << "Error: Line " << lineNumber << ": " << error << std::endl;
+            ++failedCount;
+            continue;
+        }
+        if (args.empty()) {
+            continue;
+        }
+        if (std::find(excluded.begin(), excluded.end(), args[0]) != excluded.end()) {
+            std::cerr << "Error: Line " << lineNumber << ": '" << args[0] << "' cannot run in a batch" << std::endl;
+            ++failedCount;
+            continue;
+        }
+
+        args.insert(args.begin(), "travel_planner");
+        std::vector<char*> argv;
+        for (auto& arg : args) {
+            argv.push_back(&arg[0]);
+        }
+        argv.push_back(nullptr);
+
+        Clock::time_point start = Clock::now();
+        int result = dispatchCommand(static_cast<int>(args.size()), argv.data());
+        commandTime += Clock::now() - start;
+        ++commandCount;
+        if (result != 0) {
+            std::cerr << "Error: Line " << lineNumber << " failed" << std::endl;
+            ++failedCount;
+        }
+
+        if (checkpoint > 0 && ++sinceCheckpoint >= checkpoint) {
+            flush();
+        }
+    }
+    flush();
+
+    travel_planner::setDeferredWrites(false);
+    travel_planner::setRecordCacheEnabled(cacheWasEnabled);
+
+    auto milliseconds = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    };
+    double totalMs = milliseconds(Clock::now() - batchStart);
+
+    std::cout << std::endl << "Batch: " << commandCount << " command(s), " << failedCount << " failed, "
+        << filesWritten << " file(s) written at " << checkpointCount << " checkpoint(s)" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+        << "Time: " << totalMs << " ms total, " << milliseconds(commandTime) << " ms in commands, "
+        << milliseconds(writeTime) << " ms writing";
+    if (commandCount > 0) {
+        std::cout << ", " << totalMs * 1000.0 / commandCount << " us per command";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+
+    return failedCount == 0 && writesOk;
+}
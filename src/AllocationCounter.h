@@ -0,0 +1,32 @@
+#ifndef TRAVEL_PLANNER_ALLOCATION_COUNTER_H
+#define TRAVEL_PLANNER_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+namespace travel_planner {
+
+    /**
+     * Heap allocations made through operator new since the process started
+     */
+    struct AllocationTotals {
+        std::uint64_t count = 0;
+        std::uint64_t bytes = 0;  // Bytes requested, not counting frees
+    };
+
+    /**
+     * Linking travel_planner_core replaces the global operator new, which
+     * counts every allocation, aligned or not, with two relaxed atomic
+     * increments.
+     * @return Allocations made so far, by all threads
+     */
+    AllocationTotals allocationTotals();
+
+    /**
+     * @return Peak resident set size of the process in bytes, or 0 where
+     * the platform does not report it
+     */
+    std::uint64_t peakResidentBytes();
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_ALLOCATION_COUNTER_H
@@ -0,0 +1,391 @@
+#include "Bitmap.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+namespace travel_planner {
+
+    namespace {
+
+        // Above this many values a bitmap container is smaller than an array
+        const std::uint32_t kArrayLimit = 4096;
+        const std::size_t kBitmapWords = 65536 / 64;
+
+        enum ContainerKind : std::uint16_t { kArrayContainer = 0, kBitmapContainer = 1 };
+
+        struct StoredContainer {
+            std::uint16_t key;
+            std::uint16_t kind;
+            std::uint32_t cardinality;
+        };
+
+        bool testBit(const std::vector<std::uint64_t>& bits, std::uint16_t low) {
+            return (bits[low >> 6] >> (low & 63)) & 1;
+        }
+
+        std::uint32_t countBits(const std::vector<std::uint64_t>& bits) {
+            std::uint32_t count = 0;
+            for (std::uint64_t word : bits) {
+                count += static_cast<std::uint32_t>(std::popcount(word));
+            }
+            return count;
+        }
+
+        template <typename T>
+        void append(std::string& out, const T* values, std::size_t count) {
+            out.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+        }
+
+        template <typename T>
+        bool consume(std::string_view& in, T* values, std::size_t count) {
+            const std::size_t bytes = count * sizeof(T);
+            if (in.size() < bytes) {
+                return false;
+            }
+            std::memcpy(values, in.data(), bytes);
+            in.remove_prefix(bytes);
+            return true;
+        }
+
+    } // namespace
+
+    Bitmap Bitmap::range(std::uint32_t count) {
+        Bitmap bitmap;
+        for (std::uint64_t start = 0; start < count; start += 65536) {
+            Container container;
+            container.key = static_cast<std::uint16_t>(start >> 16);
+            container.cardinality = static_cast<std::uint32_t>(std::min<std::uint64_t>(65536, count - start));
+            container.bits.assign(kBitmapWords, 0);
+            const std::size_t full_words = container.cardinality / 64;
+            std::fill(container.bits.begin(), container.bits.begin() + full_words, ~std::uint64_t(0));
+            if (container.cardinality % 64 != 0) {
+                container.bits[full_words] = (std::uint64_t(1) << (container.cardinality % 64)) - 1;
+            }
+            normalize(container);
+            bitmap.containers_.push_back(std::move(container));
+        }
+        return bitmap;
+    }
+
+    Bitmap::Container* Bitmap::find(std::uint16_t key) {
+        auto it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, std::uint16_t value) {
+            return container.key < value;
+        });
+        return it != containers_.end() && it->key == key ? &*it : nullptr;
+    }
+
+    const Bitmap::Container* Bitmap::find(std::uint16_t key) const {
+        return const_cast<Bitmap*>(this)->find(key);
+    }
+
+    void Bitmap::add(std::uint32_t value) {
+        const std::uint16_t key = static_cast<std::uint16_t>(value >> 16);
+        const std::uint16_t low = static_cast<std::uint16_t>(value);
+        auto it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, std::uint16_t k) {
+            return container.key < k;
+        });
+        if (it == containers_.end() || it->key != key) {
+            Container container;
+            container.key = key;
+            it = containers_.insert(it, std::move(container));
+        }
+
+        Container& container = *it;
+        if (!container.bits.empty()) {
+            if (!testBit(container.bits, low)) {
+                container.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+                ++container.cardinality;
+            }
+            return;
+        }
+        auto at = std::lower_bound(container.values.begin(), container.values.end(), low);
+        if (at == container.values.end() || *at != low) {
+            container.values.insert(at, low);
+            ++container.cardinality;
+            normalize(container);
+        }
+    }
+
+    bool Bitmap::remove(std::uint32_t value) {
+        Container* container = find(static_cast<std::uint16_t>(value >> 16));
+        const std::uint16_t low = static_cast<std::uint16_t>(value);
+        if (!container) {
+            return false;
+        }
+        if (!container->bits.empty()) {
+            if (!testBit(container->bits, low)) {
+                return false;
+            }
+            container->bits[low >> 6] &= ~(std::uint64_t(1) << (low & 63));
+        }
+        else {
+            auto at = std::lower_bound(container->values.begin(), container->values.end(), low);
+            if (at == container->values.end() || *at != low) {
+                return false;
+            }
+            container->values.erase(at);
+        }
+        --container->cardinality;
+        normalize(*container);
+        if (container->cardinality == 0) {
+            containers_.erase(containers_.begin() + (container - containers_.data()));
+        }
+        return true;
+    }
+
+    bool Bitmap::contains(std::uint32_t value) const {
+        const Container* container = find(static_cast<std::uint16_t>(value >> 16));
+        const std::uint16_t low = static_cast<std::uint16_t>(value);
+        if (!container) {
+            return false;
+        }
+        if (!container->bits.empty()) {
+            return testBit(container->bits, low);
+        }
+        return std::binary_search(container->values.begin(), container->values.end(), low);
+    }
+
+    std::uint64_t Bitmap::cardinality() const {
+        std::uint64_t count = 0;
+        for (const Container& container : containers_) {
+            count += container.cardinality;
+        }
+        return count;
+    }
+
+    void Bitmap::normalize(Container& container) {
+        if (container.bits.empty() && container.cardinality > kArrayLimit) {
+            container.bits.assign(kBitmapWords, 0);
+            for (std::uint16_t low : container.values) {
+                container.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+            }
+            container.values = std::vector<std::uint16_t>();
+        }
+        else if (!container.bits.empty() && container.cardinality <= kArrayLimit) {
+            container.values.clear();
+            container.values.reserve(container.cardinality);
+            for (std::size_t word = 0; word < kBitmapWords; ++word) {
+                for (std::uint64_t bits = container.bits[word]; bits != 0; bits &= bits - 1) {
+                    container.values.push_back(static_cast<std::uint16_t>(word * 64 + std::countr_zero(bits)));
+                }
+            }
+            container.bits = std::vector<std::uint64_t>();
+        }
+    }
+
+    Bitmap::Container Bitmap::intersect(const Container& a, const Container& b) {
+        Container result;
+        result.key = a.key;
+        if (a.bits.empty() && b.bits.empty()) {
+            std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                std::back_inserter(result.values));
+        }
+        else if (a.bits.empty() || b.bits.empty()) {
+            // Keep the array's values whose bit is set in the bitmap
+            const Container& array = a.bits.empty() ? a : b;
+            const Container& bitmap = a.bits.empty() ? b : a;
+            for (std::uint16_t low : array.values) {
+                if (testBit(bitmap.bits, low)) {
+                    result.values.push_back(low);
+                }
+            }
+        }
+        else {
+            result.bits.resize(kBitmapWords);
+            for (std::size_t word = 0; word < kBitmapWords; ++word) {
+                result.bits[word] = a.bits[word] & b.bits[word];
+            }
+            result.cardinality = countBits(result.bits);
+            normalize(result);
+            return result;
+        }
+        result.cardinality = static_cast<std::uint32_t>(result.values.size());
+        return result;
+    }
+
+    Bitmap::Container Bitmap::unite(const Container& a, const Container& b) {
+        Container result;
+        result.key = a.key;
+        if (a.bits.empty() && b.bits.empty()) {
+            std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                std::back_inserter(result.values));
+            result.cardinality = static_cast<std::uint32_t>(result.values.size());
+            normalize(result);
+            return result;
+        }
+        // Start from the bitmap and set the other's values in it
+        const Container& bitmap = a.bits.empty() ? b : a;
+        const Container& other = a.bits.empty() ? a : b;
+        result.bits = bitmap.bits;
+        if (other.bits.empty()) {
+            for (std::uint16_t low : other.values) {
+                result.bits[low >> 6] |= std::uint64_t(1) << (low & 63);
+            }
+        }
+        else {
+            for (std::size_t word = 0; word < kBitmapWords; ++word) {
+                result.bits[word] |= other.bits[word];
+            }
+        }
+        result.cardinality = countBits(result.bits);
+        return result;
+    }
+
+    Bitmap::Container Bitmap::subtract(const Container& a, const Container& b) {
+        Container result;
+        result.key = a.key;
+        if (a.bits.empty()) {
+            if (b.bits.empty()) {
+                std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                    std::back_inserter(result.values));
+            }
+            else {
+                for (std::uint16_t low : a.values) {
+                    if (!testBit(b.bits, low)) {
+                        result.values.push_back(low);
+                    }
+                }
+            }
+            result.cardinality = static_cast<std::uint32_t>(result.values.size());
+            return result;
+        }
+        result.bits = a.bits;
+        if (b.bits.empty()) {
+            for (std::uint16_t low : b.values) {
+                result.bits[low >> 6] &= ~(std::uint64_t(1) << (low & 63));
+            }
+        }
+        else {
+            for (std::size_t word = 0; word < kBitmapWords; ++word) {
+                result.bits[word] &= ~b.bits[word];
+            }
+        }
+        result.cardinality = countBits(result.bits);
+        normalize(result);
+        return result;
+    }
+
+    Bitmap& Bitmap::operator&=(const Bitmap& other) {
+        std::vector<Container> result;
+        auto it = other.containers_.begin();
+        for (const Container& container : containers_) {
+            while (it != other.containers_.end() && it->key < container.key) {
+                ++it;
+            }
+            if (it == other.containers_.end()) {
+                break;
+            }
+            if (it->key == container.key) {
+                Container both = intersect(container, *it);
+                if (both.cardinality != 0) {
+                    result.push_back(std::move(both));
+                }
+            }
+        }
+        containers_ = std::move(result);
+        return *this;
+    }
+
+    Bitmap& Bitmap::operator|=(const Bitmap& other) {
+        if (this == &other) {
+            return *this;
+        }
+        std::vector<Container> result;
+        result.reserve(containers_.size() + other.containers_.size());
+        auto a = containers_.begin();
+        auto b = other.containers_.begin();
+        while (a != containers_.end() || b != other.containers_.end()) {
+            if (b == other.containers_.end() || (a != containers_.end() && a->key < b->key)) {
+                result.push_back(std::move(*a++));
+            }
+            else if (a == containers_.end() || b->key < a->key) {
+                result.push_back(*b++);
+            }
+            else {
+                result.push_back(unite(*a++, *b++));
+            }
+        }
+        containers_ = std::move(result);
+        return *this;
+    }
+
+    Bitmap& Bitmap::andNot(const Bitmap& other) {
+        if (this == &other) {
+            containers_.clear();
+            return *this;
+        }
+        std::vector<Container> result;
+        result.reserve(containers_.size());
+        auto it = other.containers_.begin();
+        for (Container& container : containers_) {
+            while (it != other.containers_.end() && it->key < container.key) {
+                ++it;
+            }
+            if (it == other.containers_.end() || it->key != container.key) {
+                result.push_back(std::move(container));
+                continue;
+            }
+            Container rest = subtract(container, *it);
+            if (rest.cardinality != 0) {
+                result.push_back(std::move(rest));
+            }
+        }
+        containers_ = std::move(result);
+        return *this;
+    }
+
+    void Bitmap::serialize(std::string& out) const {
+        const std::uint32_t count = static_cast<std::uint32_t>(containers_.size());
+        append(out, &count, 1);
+        for (const Container& container : containers_) {
+            StoredContainer stored{ container.key,
+                container.bits.empty() ? kArrayContainer : kBitmapContainer, container.cardinality };
+            append(out, &stored, 1);
+            if (container.bits.empty()) {
+                append(out, container.values.data(), container.values.size());
+            }
+            else {
+                append(out, container.bits.data(), container.bits.size());
+            }
+        }
+    }
+
+    bool Bitmap::deserialize(std::string_view& in) {
+        containers_.clear();
+        std::uint32_t count = 0;
+        if (!consume(in, &count, 1)) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < count; ++i) {
+            StoredContainer stored;
+            if (!consume(in, &stored, 1) || stored.cardinality == 0 || stored.cardinality > 65536
+                || (!containers_.empty() && stored.key <= containers_.back().key)) {
+                return false;
+            }
+            Container container;
+            container.key = stored.key;
+            container.cardinality = stored.cardinality;
+            if (stored.kind == kArrayContainer) {
+                container.values.resize(stored.cardinality);
+                if (stored.cardinality > kArrayLimit || !consume(in, container.values.data(), container.values.size())
+                    || std::adjacent_find(container.values.begin(), container.values.end(),
+                        std::greater_equal<std::uint16_t>()) != container.values.end()) {
+                    return false;
+                }
+            }
+            else {
+                container.bits.resize(kBitmapWords);
+                if (stored.kind != kBitmapContainer || stored.cardinality <= kArrayLimit
+                    || !consume(in, container.bits.data(), container.bits.size())
+                    || countBits(container.bits) != stored.cardinality) {
+                    return false;
+                }
+            }
+            containers_.push_back(std::move(container));
+        }
+        return true;
+    }
+
+} // namespace travel_planner
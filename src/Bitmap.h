@@ -0,0 +1,109 @@
+#ifndef TRAVEL_PLANNER_BITMAP_H
+#define TRAVEL_PLANNER_BITMAP_H
+
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace travel_planner {
+
+    /**
+     * Compressed set of 32-bit values (record ordinals), after Roaring
+     * bitmaps: values are split by their high 16 bits into containers, each
+     * holding the low 16 bits either as a sorted array (up to 4096 values,
+     * at most 8 KB) or as a 65536-bit bitmap (exactly 8 KB). Sparse sets
+     * stay small and dense ones are combined a word at a time; AND, OR and
+     * AND NOT pick the cheapest method for each pair of containers.
+     */
+    class Bitmap {
+    public:
+        /**
+         * @return The values 0 to count - 1
+         */
+        static Bitmap range(std::uint32_t count);
+
+        /**
+         * Adds a value
+         */
+        void add(std::uint32_t value);
+
+        /**
+         * Removes a value
+         * @return False if it was not in the set
+         */
+        bool remove(std::uint32_t value);
+
+        bool contains(std::uint32_t value) const;
+
+        /**
+         * @return Number of values in the set
+         */
+        std::uint64_t cardinality() const;
+
+        bool empty() const { return containers_.empty(); }
+
+        Bitmap& operator&=(const Bitmap& other);
+        Bitmap& operator|=(const Bitmap& other);
+
+        /**
+         * Removes the values of another set (AND NOT)
+         */
+        Bitmap& andNot(const Bitmap& other);
+
+        /**
+         * Calls visit(value) for each value, in increasing order
+         */
+        template <typename Visitor>
+        void forEach(Visitor visit) const {
+            for (const Container& container : containers_) {
+                const std::uint32_t high = std::uint32_t(container.key) << 16;
+                if (container.bits.empty()) {
+                    for (std::uint16_t low : container.values) {
+                        visit(high | low);
+                    }
+                    continue;
+                }
+                for (std::size_t word = 0; word < container.bits.size(); ++word) {
+                    for (std::uint64_t bits = container.bits[word]; bits != 0; bits &= bits - 1) {
+                        visit(high | std::uint32_t(word * 64 + std::countr_zero(bits)));
+                    }
+                }
+            }
+        }
+
+        /**
+         * Appends the set to a buffer, in native byte order
+         */
+        void serialize(std::string& out) const;
+
+        /**
+         * Reads a set written by serialize()
+         * @param in Buffer; advanced past the set
+         * @return False if the buffer does not hold a valid set
+         */
+        bool deserialize(std::string_view& in);
+
+    private:
+        struct Container {
+            std::uint16_t key = 0;                // High 16 bits of the values
+            std::uint32_t cardinality = 0;
+            std::vector<std::uint16_t> values;    // Sorted, when an array container
+            std::vector<std::uint64_t> bits;      // 1024 words, when a bitmap container
+        };
+
+        static void normalize(Container& container);
+        static Container intersect(const Container& a, const Container& b);
+        static Container unite(const Container& a, const Container& b);
+        static Container subtract(const Container& a, const Container& b);
+
+        Container* find(std::uint16_t key);
+        const Container* find(std::uint16_t key) const;
+
+        std::vector<Container> containers_;  // By key; none is empty
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_BITMAP_H
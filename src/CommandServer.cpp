@@ -0,0 +1,423 @@
+#include "CommandServer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace travel_planner {
+
+#ifdef _WIN32
+
+    CommandServer::CommandServer(const std::string& socket_path)
+        : socket_path_(socket_path) {
+    }
+
+    CommandServer::~CommandServer() = default;
+
+    bool CommandServer::listen() {
+        std::cerr << "Error: The command server is not supported on this platform" << std::endl;
+        return false;
+    }
+
+    void CommandServer::run(const CommandHandler&) {
+    }
+
+    bool CommandServer::serveConnection(int, const CommandHandler&) {
+        return false;
+    }
+
+    bool forwardCommand(const std::string&, int, char*[], int&) {
+        return false;
+    }
+
+#else
+
+    namespace {
+
+        // Prefix of the environment variables forwarded with a command
+        const char* const kEnvironmentPrefix = "TRAVEL_PLANNER_";
+
+        // Largest request the server accepts; anything bigger is dropped
+        // before memory is allocated for it
+        const std::uint32_t kMaxArguments = 4096;
+        const std::uint32_t kMaxEnvironment = 256;
+        const std::uint32_t kMaxRequestString = 1 << 20;
+
+        // A client that sends nothing for this long is dropped, so it cannot
+        // hold up the commands of others
+        const int kClientTimeoutSeconds = 10;
+
+        volatile std::sig_atomic_t stop_requested = 0;
+
+        void requestStop(int) {
+            stop_requested = 1;
+        }
+
+        // Wire format: native-endian u32 counts and lengths; strings are a
+        // length followed by the bytes
+
+        bool writeAll(int fd, const void* data, std::size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                ssize_t written = ::write(fd, bytes, size);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (written <= 0) {
+                    return false;
+                }
+                bytes += written;
+                size -= static_cast<std::size_t>(written);
+            }
+            return true;
+        }
+
+        bool readAll(int fd, void* data, std::size_t size) {
+            char* bytes = static_cast<char*>(data);
+            while (size > 0) {
+                ssize_t received = ::read(fd, bytes, size);
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    return false;
+                }
+                bytes += received;
+                size -= static_cast<std::size_t>(received);
+            }
+            return true;
+        }
+
+        void putU32(std::string& out, std::uint32_t value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        void putString(std::string& out, const std::string& value) {
+            putU32(out, static_cast<std::uint32_t>(value.size()));
+            out += value;
+        }
+
+        void putStrings(std::string& out, const std::vector<std::string>& values) {
+            putU32(out, static_cast<std::uint32_t>(values.size()));
+            for (const auto& value : values) {
+                putString(out, value);
+            }
+        }
+
+        bool readU32(int fd, std::uint32_t& value) {
+            return readAll(fd, &value, sizeof(value));
+        }
+
+        bool readString(int fd, std::string& value,
+            std::uint32_t max_size = std::numeric_limits<std::uint32_t>::max()) {
+            std::uint32_t size = 0;
+            if (!readU32(fd, size) || size > max_size) {
+                return false;
+            }
+            value.resize(size);
+            return size == 0 || readAll(fd, &value[0], size);
+        }
+
+        bool readStrings(int fd, std::vector<std::string>& values, std::uint32_t max_count,
+            std::uint32_t max_size) {
+            std::uint32_t count = 0;
+            if (!readU32(fd, count) || count > max_count) {
+                return false;
+            }
+            values.resize(count);
+            for (auto& value : values) {
+                if (!readString(fd, value, max_size)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // "NAME=value" entries of the forwarded environment variables
+        std::vector<std::string> forwardedEnvironment() {
+            std::vector<std::string> entries;
+            for (char** entry = environ; *entry != nullptr; ++entry) {
+                if (std::strncmp(*entry, kEnvironmentPrefix, std::strlen(kEnvironmentPrefix)) == 0) {
+                    entries.emplace_back(*entry);
+                }
+            }
+            return entries;
+        }
+
+        // Replaces the forwarded environment variables of this process
+        void replaceEnvironment(const std::vector<std::string>& entries) {
+            for (const auto& entry : forwardedEnvironment()) {
+                ::unsetenv(entry.substr(0, entry.find('=')).c_str());
+            }
+            for (const auto& entry : entries) {
+                std::size_t equals = entry.find('=');
+                if (equals != std::string::npos) {
+                    ::setenv(entry.substr(0, equals).c_str(), entry.c_str() + equals + 1, 1);
+                }
+            }
+        }
+
+        bool makeAddress(const std::string& socket_path, sockaddr_un& address) {
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (socket_path.size() >= sizeof(address.sun_path)) {
+                return false;
+            }
+            std::memcpy(address.sun_path, socket_path.c_str(), socket_path.size() + 1);
+            return true;
+        }
+
+        // Connects to a socket; -1 if nothing is listening on it
+        int connectTo(const std::string& socket_path) {
+            sockaddr_un address;
+            if (!makeAddress(socket_path, address)) {
+                return -1;
+            }
+
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0) {
+                return -1;
+            }
+            if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                ::close(fd);
+                return -1;
+            }
+            return fd;
+        }
+
+    } // namespace
+
+    CommandServer::CommandServer(const std::string& socket_path)
+        : socket_path_(socket_path) {
+    }
+
+    CommandServer::~CommandServer() {
+        if (socket_ >= 0) {
+            ::close(socket_);
+            std::error_code ec;
+            std::filesystem::remove(socket_path_, ec);
+        }
+    }
+
+    bool CommandServer::listen() {
+        sockaddr_un address;
+        if (!makeAddress(socket_path_, address)) {
+            std::cerr << "Error: Socket path is too long: " << socket_path_ << std::endl;
+            return false;
+        }
+
+        std::error_code ec;
+        if (std::filesystem::exists(socket_path_, ec)) {
+            int existing = connectTo(socket_path_);
+            if (existing >= 0) {
+                ::close(existing);
+                std::cerr << "Error: A server is already listening on " << socket_path_ << std::endl;
+                return false;
+            }
+            std::filesystem::remove(socket_path_, ec);  // Left behind by a server that died
+        }
+
+        std::filesystem::path parent = std::filesystem::path(socket_path_).parent_path();
+        if (!parent.empty()) {
+            std::filesystem::create_directories(parent, ec);
+        }
+
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+            || ::listen(fd, 16) != 0) {
+            std::cerr << "Error: Unable to listen on " << socket_path_ << ": " << std::strerror(errno) << std::endl;
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+
+        socket_ = fd;
+        return true;
+    }
+
+    void CommandServer::run(const CommandHandler& handler) {
+        if (socket_ < 0) {
+            return;
+        }
+
+        // Interrupt accept() on SIGINT/SIGTERM so the socket is cleaned up,
+        // and survive clients that disconnect before reading their reply
+        struct sigaction action;
+        std::memset(&action, 0, sizeof(action));
+        action.sa_handler = requestStop;
+        sigemptyset(&action.sa_mask);
+        ::sigaction(SIGINT, &action, nullptr);
+        ::sigaction(SIGTERM, &action, nullptr);
+        std::signal(SIGPIPE, SIG_IGN);
+
+        while (!stop_requested) {
+            int connection = ::accept(socket_, nullptr, nullptr);
+            if (connection < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "Error accepting a connection: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            timeval timeout = { kClientTimeoutSeconds, 0 };
+            ::setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            ::setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            bool keep_running = true;
+            try {
+                keep_running = serveConnection(connection, handler);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Error serving a connection: " << e.what() << std::endl;
+            }
+            ::close(connection);
+            if (!keep_running) {
+                break;
+            }
+        }
+    }
+
+    bool CommandServer::serveConnection(int connection, const CommandHandler& handler) {
+        std::vector<std::string> args;
+        std::vector<std::string> environment;
+        std::string directory;
+        if (!readStrings(connection, args, kMaxArguments, kMaxRequestString)
+            || !readStrings(connection, environment, kMaxEnvironment, kMaxRequestString)
+            || !readString(connection, directory, kMaxRequestString) || args.empty()) {
+            return true;  // Malformed request; drop it
+        }
+
+        std::ostringstream out;
+        std::ostringstream err;
+        std::int32_t exit_code = 1;
+        bool keep_running = true;
+
+        if (args.size() >= 2 && args[1] == "serve") {
+            if (args.size() >= 3 && args[2] == "stop") {
+                out << "Server stopped." << std::endl;
+                exit_code = 0;
+                keep_running = false;
+            }
+            else {
+                err << "Error: A server is already listening on " << socket_path_ << std::endl;
+            }
+        }
+        else {
+            // Run the command as if it were started by the client
+            std::vector<std::string> saved_environment = forwardedEnvironment();
+            std::error_code ec;
+            std::filesystem::path saved_directory = std::filesystem::current_path(ec);
+            replaceEnvironment(environment);
+            std::filesystem::current_path(directory, ec);
+
+            if (ec) {
+                err << "Error: Unable to enter " << directory << ": " << ec.message() << std::endl;
+            }
+            else {
+                std::vector<char*> argv;
+                for (auto& arg : args) {
+                    argv.push_back(&arg[0]);
+                }
+                argv.push_back(nullptr);
+
+                // Capture the command's output; it never reads from a terminal
+                std::istringstream in;
+                std::streambuf* saved_out = std::cout.rdbuf(out.rdbuf());
+                std::streambuf* saved_err = std::cerr.rdbuf(err.rdbuf());
+                std::streambuf* saved_in = std::cin.rdbuf(in.rdbuf());
+                try {
+                    exit_code = handler(static_cast<int>(args.size()), argv.data());
+                }
+                catch (const std::exception& e) {
+                    err << "Error: " << e.what() << std::endl;
+                }
+                std::cout.rdbuf(saved_out);
+                std::cerr.rdbuf(saved_err);
+                std::cin.rdbuf(saved_in);
+            }
+
+            std::filesystem::current_path(saved_directory, ec);
+            replaceEnvironment(saved_environment);
+        }
+
+        std::string reply;
+        putU32(reply, static_cast<std::uint32_t>(exit_code));
+        putString(reply, out.str());
+        putString(reply, err.str());
+        writeAll(connection, reply.data(), reply.size());
+        return keep_running;
+    }
+
+    bool forwardCommand(const std::string& socket_path, int argc, char* argv[], int& exit_code) {
+        std::error_code ec;
+        if (!std::filesystem::exists(socket_path, ec)) {
+            return false;  // Cheap check before trying to connect
+        }
+
+        // A request the server would drop runs locally instead
+        std::vector<std::string> args(argv, argv + argc);
+        std::vector<std::string> environment = forwardedEnvironment();
+        std::string directory = std::filesystem::current_path(ec).string();
+        auto fits = [](const std::vector<std::string>& values, std::uint32_t max_count) {
+            return values.size() <= max_count && std::all_of(values.begin(), values.end(),
+                [](const std::string& value) { return value.size() <= kMaxRequestString; });
+        };
+        if (!fits(args, kMaxArguments) || !fits(environment, kMaxEnvironment)
+            || directory.size() > kMaxRequestString) {
+            return false;
+        }
+
+        int fd = connectTo(socket_path);
+        if (fd < 0) {
+            return false;
+        }
+
+        std::string request;
+        putStrings(request, args);
+        putStrings(request, environment);
+        putString(request, directory);
+
+        // Once the request is sent the command may have run, so failures
+        // from here on are reported instead of running it again locally
+        std::uint32_t code = 1;
+        std::string out;
+        std::string err;
+        std::signal(SIGPIPE, SIG_IGN);
+        bool ok = writeAll(fd, request.data(), request.size())
+            && readU32(fd, code) && readString(fd, out) && readString(fd, err);
+        ::close(fd);
+
+        std::cout << out;
+        std::cerr << err;
+        if (!ok) {
+            std::cerr << "Error: Lost connection to the server on " << socket_path << std::endl;
+            exit_code = 1;
+            return true;
+        }
+
+        exit_code = static_cast<std::int32_t>(code);
+        return true;
+    }
+
+#endif
+
+} // namespace travel_planner
@@ -0,0 +1,81 @@
+#ifndef TRAVEL_PLANNER_COMMAND_SERVER_H
+#define TRAVEL_PLANNER_COMMAND_SERVER_H
+
+#include <functional>
+#include <string>
+
+namespace travel_planner {
+
+    /**
+     * Runs one CLI command given its full argument list (program name
+     * first) and returns its exit code
+     */
+    using CommandHandler = std::function<int(int argc, char* argv[])>;
+
+    /**
+     * Long-running command server. Other invocations of the CLI send their
+     * commands over a Unix domain socket instead of running them, which
+     * saves process startup and lets every command share the server's
+     * record cache (see RecordCache.h).
+     *
+     * A request carries the arguments, the working directory and the
+     * TRAVEL_PLANNER_* environment of the client, so a forwarded command
+     * behaves as if it ran in the client. The reply carries the exit code
+     * and everything the command printed. Commands run one at a time; a
+     * request larger than the server accepts is dropped unread, and so is
+     * a client that stops sending for a few seconds.
+     */
+    class CommandServer {
+    public:
+        /**
+         * Constructor
+         * @param socket_path Path of the socket to listen on
+         */
+        explicit CommandServer(const std::string& socket_path);
+
+        /**
+         * Stops listening and removes the socket
+         */
+        ~CommandServer();
+
+        CommandServer(const CommandServer&) = delete;
+        CommandServer& operator=(const CommandServer&) = delete;
+
+        /**
+         * Creates the socket. A socket left behind by a server that is no
+         * longer running is replaced.
+         * @return False if the socket cannot be created or another server
+         *         is already listening on it
+         */
+        bool listen();
+
+        /**
+         * Serves commands until the process is interrupted (SIGINT or
+         * SIGTERM) or a client sends "serve stop"
+         * @param handler Runs each command
+         */
+        void run(const CommandHandler& handler);
+
+    private:
+        // Serves one connection; returns false when the server should stop
+        bool serveConnection(int connection, const CommandHandler& handler);
+
+        std::string socket_path_;
+        int socket_ = -1;
+    };
+
+    /**
+     * Runs a command on the server listening on a socket, printing its
+     * output as if it ran here
+     * @param socket_path Socket of the server
+     * @param argc Argument count
+     * @param argv Arguments, program name first
+     * @param exit_code Receives the command's exit code
+     * @return False if no server is listening; the command was not run and
+     *         should run locally
+     */
+    bool forwardCommand(const std::string& socket_path, int argc, char* argv[], int& exit_code);
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_COMMAND_SERVER_H
@@ -0,0 +1,191 @@
+#include "DatasetGenerator.h"
+#include "../include/Date.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace travel_planner {
+
+    namespace {
+
+        // Most frequent first, so the Zipf skew favours the first entries
+        const char* const kTagWords[] = {
+            "vacation", "business", "family", "beach", "city", "weekend", "roadtrip", "hiking",
+            "ski", "food", "museum", "conference", "friends", "honeymoon", "camping", "cruise",
+            "festival", "island", "backpacking", "wine", "history", "nightlife", "spa", "wildlife"
+        };
+
+        const char* const kCategories[] = {
+            "Food", "Transport", "Lodging", "Activities", "Shopping", "Entertainment", "Health", "Other"
+        };
+
+        // Median amount of an expense in each category
+        const double kCategoryMedians[] = { 25.0, 40.0, 120.0, 60.0, 35.0, 45.0, 20.0, 15.0 };
+
+        const char* const kDestinations[] = {
+            "Lisbon", "Kyoto", "New York", "Cape Town", "Reykjavik", "Rome", "Bangkok", "Vancouver",
+            "Marrakesh", "Sydney", "Prague", "Lima", "Seoul", "Barcelona", "Istanbul", "Mexico City"
+        };
+
+        const char* const kTripKinds[] = {
+            "Getaway", "Trip", "Adventure", "Tour", "Retreat", "Visit", "Escape", "Journey"
+        };
+
+        // Indexed by (month % 12) / 3
+        const char* const kSeasons[] = { "Winter", "Spring", "Summer", "Autumn" };
+
+        const char* const kPackingNames[] = {
+            "Passport", "Phone charger", "Toothbrush", "Socks", "T-shirts", "Sunscreen", "Jacket",
+            "Headphones", "Laptop", "Medication", "Umbrella", "Camera", "Swimsuit", "Hiking boots",
+            "Power adapter", "Sunglasses", "Book", "Travel pillow", "First aid kit", "Water bottle"
+        };
+
+        const char* const kExpenseNotes[] = {
+            "Dinner", "Taxi", "Hotel night", "Museum tickets", "Souvenirs", "Lunch", "Train",
+            "Coffee", "Groceries", "Tour guide", "Pharmacy", "Concert", "Breakfast", "Parking"
+        };
+
+        // Relative number of trips starting in each month
+        const double kMonthWeights[] = { 5, 4, 6, 7, 8, 11, 14, 14, 8, 6, 5, 12 };
+
+        // Trips start between 2023-01-01 and 2026-12-31
+        const int kFirstYear = 2023;
+        const int kYears = 4;
+
+        std::vector<double> zipfWeights(std::size_t count, double skew) {
+            std::vector<double> weights(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                weights[i] = 1.0 / std::pow(static_cast<double>(i + 1), skew);
+            }
+            return weights;
+        }
+
+    } // namespace
+
+    DatasetGenerator::DatasetGenerator(const DatasetOptions& options)
+        : options_(options), gen_(options.seed) {
+        std::size_t words = std::size(kTagWords);
+        for (std::size_t i = 0; i < options_.tag_vocabulary; ++i) {
+            // Past the word list, tags repeat with a round suffix: "beach-2"
+            std::string tag = kTagWords[i % words];
+            if (i >= words) {
+                tag += '-';
+                tag += std::to_string(i / words + 1);
+            }
+            tags_.push_back(std::move(tag));
+        }
+
+        std::vector<double> tag_weights = zipfWeights(tags_.size(), options_.tag_skew);
+        tag_dist_ = std::discrete_distribution<std::size_t>(tag_weights.begin(), tag_weights.end());
+        std::vector<double> category_weights = zipfWeights(std::size(kCategories), options_.category_skew);
+        category_dist_ = std::discrete_distribution<std::size_t>(category_weights.begin(), category_weights.end());
+    }
+
+    std::string DatasetGenerator::randomString(const char* alphabet, std::size_t length) {
+        std::size_t size = std::char_traits<char>::length(alphabet);
+        std::string value(length, ' ');
+        for (char& c : value) {
+            c = alphabet[gen_() % size];
+        }
+        return value;
+    }
+
+    std::string DatasetGenerator::uuid() {
+        static const char* const hex_chars = "0123456789abcdef";
+        std::string value = "xxxxxxxx-xxxx-4xxx-yxxx-xxxxxxxxxxxx";
+        for (char& c : value) {
+            if (c == 'x') {
+                c = hex_chars[gen_() & 0xf];
+            }
+            else if (c == 'y') {
+                c = hex_chars[(gen_() & 0x3) | 0x8];
+            }
+        }
+        return value;
+    }
+
+    std::vector<Itinerary> DatasetGenerator::itineraries() {
+        std::vector<Itinerary> itineraries;
+        itineraries.reserve(options_.itineraries);
+
+        std::discrete_distribution<unsigned> month_dist(std::begin(kMonthWeights), std::end(kMonthWeights));
+        std::uniform_int_distribution<int> year_dist(kFirstYear, kFirstYear + kYears - 1);
+        std::geometric_distribution<int> extra_days(0.2);
+        std::uniform_int_distribution<std::size_t> tag_count(0, options_.max_tags);
+
+        for (std::size_t i = 0; i < options_.itineraries; ++i) {
+            int year = year_dist(gen_);
+            unsigned month = month_dist(gen_) + 1;
+            unsigned day = static_cast<unsigned>(gen_() % Date::daysInMonth(year, month)) + 1;
+            Date start = Date::fromCivil(year, month, day);
+            Date end(start.days() + std::min(extra_days(gen_), 20));
+
+            const char* destination = kDestinations[gen_() % std::size(kDestinations)];
+            std::string name = std::string(kSeasons[(month % 12) / 3]) + " " + destination + " "
+                + kTripKinds[gen_() % std::size(kTripKinds)];
+            std::string description = "Exploring " + std::string(destination) + " for "
+                + std::to_string(end.days() - start.days() + 1) + " days";
+
+            std::vector<std::string> tags;
+            std::size_t count = std::min(tag_count(gen_), tags_.size());
+            while (tags.size() < count) {
+                const std::string& tag = tags_[tag_dist_(gen_)];
+                if (std::find(tags.begin(), tags.end(), tag) == tags.end()) {
+                    tags.push_back(tag);
+                }
+            }
+
+            Itinerary itinerary(uuid(), name, start.toString(), end.toString(), description, tags);
+            itinerary.is_favorite = gen_() % 10 == 0;
+            itineraries.push_back(std::move(itinerary));
+        }
+        return itineraries;
+    }
+
+    std::vector<PackingItem> DatasetGenerator::packingItems(const std::vector<Itinerary>& itineraries) {
+        static const char* const id_chars = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        std::vector<double> name_weights = zipfWeights(std::size(kPackingNames), 0.8);
+        std::discrete_distribution<std::size_t> name_dist(name_weights.begin(), name_weights.end());
+
+        std::vector<PackingItem> items;
+        items.reserve(itineraries.size() * options_.packing_items_per_itinerary);
+        for (const auto& itinerary : itineraries) {
+            for (std::size_t i = 0; i < options_.packing_items_per_itinerary; ++i) {
+                std::string id = "pck_" + std::to_string(1700000000000 + next_id_++) + "_" + randomString(id_chars, 8);
+                int quantity = gen_() % 4 == 0 ? static_cast<int>(gen_() % 5) + 2 : 1;
+                bool packed = gen_() % 10 < 3;
+                items.emplace_back(id, itinerary.id, kPackingNames[name_dist(gen_)], quantity, packed);
+            }
+        }
+        return items;
+    }
+
+    std::vector<Expense> DatasetGenerator::expenses(const std::vector<Itinerary>& itineraries) {
+        static const char* const id_chars = "0123456789abcdefghijklmnopqrstuvwxyz";
+        std::normal_distribution<double> spread(0.0, 0.6);
+
+        std::vector<Expense> expenses;
+        expenses.reserve(itineraries.size() * options_.expenses_per_itinerary);
+        for (const auto& itinerary : itineraries) {
+            // Generated itineraries always have valid dates; any other trip
+            // is taken to be one day long, starting on the first generated day
+            const Date start = Date::parse(itinerary.start_date).value_or(Date::fromCivil(kFirstYear, 1, 1));
+            const Date end = Date::parse(itinerary.end_date).value_or(start);
+            long days = std::max(1L, static_cast<long>(end.days()) - start.days() + 1);
+
+            // Spending is front-loaded: day d of the trip has weight 1 / (d + 1)
+            std::vector<double> day_weights = zipfWeights(static_cast<std::size_t>(days), 1.0);
+            std::discrete_distribution<long> day_dist(day_weights.begin(), day_weights.end());
+
+            for (std::size_t i = 0; i < options_.expenses_per_itinerary; ++i) {
+                std::size_t category = category_dist_(gen_);
+                double amount = std::round(kCategoryMedians[category] * std::exp(spread(gen_)) * 100.0) / 100.0;
+                std::string id = std::to_string(1700000000000 + next_id_++) + "-" + randomString(id_chars, 6);
+                expenses.emplace_back(id, itinerary.id, amount, kCategories[category],
+                    Date(start.days() + static_cast<std::int32_t>(day_dist(gen_))).toString(), kExpenseNotes[gen_() % std::size(kExpenseNotes)]);
+            }
+        }
+        return expenses;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,83 @@
+#ifndef TRAVEL_PLANNER_DATASET_GENERATOR_H
+#define TRAVEL_PLANNER_DATASET_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/Expense.h"
+#include "../include/Itinerary.h"
+#include "../include/PackingItem.h"
+
+namespace travel_planner {
+
+    /**
+     * Shape of a generated dataset. Skews are Zipf exponents: 0 picks
+     * uniformly, larger values concentrate on the first few values.
+     */
+    struct DatasetOptions {
+        std::size_t itineraries = 1000;
+        std::size_t packing_items_per_itinerary = 10;
+        std::size_t expenses_per_itinerary = 20;
+        std::size_t tag_vocabulary = 50;   // Distinct tags to draw from
+        std::size_t max_tags = 4;          // Tags per itinerary, 0..max_tags
+        double tag_skew = 1.0;
+        double category_skew = 1.0;
+        std::uint32_t seed = 1;
+    };
+
+    /**
+     * Generates realistic-looking itineraries, packing items and expenses
+     * for scale testing, deterministically for a given seed.
+     *
+     * Trips start between 2023 and 2026, more often in summer and December,
+     * and last 1-21 days. Expenses fall within their trip, more often on its
+     * first days, with categories and tags drawn from Zipf distributions and
+     * amounts from a log-normal distribution per category. IDs have the same
+     * shape as the ones the CLI assigns.
+     */
+    class DatasetGenerator {
+    public:
+        /**
+         * Constructor
+         * @param options Shape of the dataset
+         */
+        explicit DatasetGenerator(const DatasetOptions& options);
+
+        /**
+         * @return options().itineraries new itineraries
+         */
+        std::vector<Itinerary> itineraries();
+
+        /**
+         * @param itineraries Itineraries to pack for
+         * @return options().packing_items_per_itinerary items per itinerary
+         */
+        std::vector<PackingItem> packingItems(const std::vector<Itinerary>& itineraries);
+
+        /**
+         * @param itineraries Itineraries the expenses belong to
+         * @return options().expenses_per_itinerary expenses per itinerary,
+         *         dated within each trip
+         */
+        std::vector<Expense> expenses(const std::vector<Itinerary>& itineraries);
+
+        const DatasetOptions& options() const { return options_; }
+
+    private:
+        // Random string of characters from an alphabet
+        std::string randomString(const char* alphabet, std::size_t length);
+        std::string uuid();
+
+        DatasetOptions options_;
+        std::mt19937_64 gen_;
+        std::vector<std::string> tags_;
+        std::discrete_distribution<std::size_t> tag_dist_;
+        std::discrete_distribution<std::size_t> category_dist_;
+        std::uint64_t next_id_ = 0;  // Keeps generated IDs unique
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_DATASET_GENERATOR_H
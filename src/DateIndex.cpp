@@ -0,0 +1,184 @@
+#include "DateIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[4] = { 'T', 'P', 'D', 'X' };
+        const std::uint32_t kVersion = 1;
+
+        struct FileHeader {
+            char magic[4];
+            std::uint32_t version;
+            std::uint32_t source_count;  // Stamps that follow the header
+            std::uint32_t entry_count;
+            std::uint32_t ids_bytes;
+            std::int32_t max_span;
+        };
+
+        struct StoredStamp {
+            std::uint64_t size;
+            std::int64_t mtime;
+        };
+
+        template <typename T>
+        bool readValues(std::istream& in, T* values, std::size_t count) {
+            return static_cast<bool>(in.read(reinterpret_cast<char*>(values),
+                static_cast<std::streamsize>(count * sizeof(T))));
+        }
+
+        template <typename T>
+        void writeValues(std::ostream& out, const T* values, std::size_t count) {
+            out.write(reinterpret_cast<const char*>(values), static_cast<std::streamsize>(count * sizeof(T)));
+        }
+
+    } // namespace
+
+    DateIndex::Entry DateIndex::makeEntry(std::string_view id, Date first, Date last) {
+        Entry entry{ first.days(), last.days(), static_cast<std::uint32_t>(ids_.size()),
+            static_cast<std::uint32_t>(id.size()) };
+        ids_.append(id);
+        max_span_ = std::max(max_span_, entry.last - entry.first);
+        return entry;
+    }
+
+    void DateIndex::add(std::string_view id, Date first, Date last) {
+        entries_.push_back(makeEntry(id, first, last));
+    }
+
+    void DateIndex::sort() {
+        std::sort(entries_.begin(), entries_.end(), [](const Entry& a, const Entry& b) {
+            return a.first != b.first ? a.first < b.first : a.last < b.last;
+        });
+    }
+
+    void DateIndex::insert(std::string_view id, Date first, Date last) {
+        Entry entry = makeEntry(id, first, last);
+        auto at = std::upper_bound(entries_.begin(), entries_.end(), entry, [](const Entry& a, const Entry& b) {
+            return a.first != b.first ? a.first < b.first : a.last < b.last;
+        });
+        entries_.insert(at, entry);
+    }
+
+    bool DateIndex::remove(std::string_view record_id) {
+        // The ID's bytes stay in ids_ until the next save
+        auto it = std::find_if(entries_.begin(), entries_.end(), [this, record_id](const Entry& entry) {
+            return id(entry) == record_id;
+        });
+        if (it == entries_.end()) {
+            return false;
+        }
+        entries_.erase(it);
+        return true;
+    }
+
+    std::vector<std::string_view> DateIndex::overlapping(Date from, Date to) const {
+        // A record starting before from - max_span_ ends before from, so
+        // only records starting in [from - max_span_, to] are candidates
+        const std::int64_t lowest = static_cast<std::int64_t>(from.days()) - max_span_;
+        auto begin = std::lower_bound(entries_.begin(), entries_.end(), lowest, [](const Entry& entry, std::int64_t day) {
+            return entry.first < day;
+        });
+        auto end = std::upper_bound(begin, entries_.end(), to.days(), [](std::int32_t day, const Entry& entry) {
+            return day < entry.first;
+        });
+
+        std::vector<std::string_view> ids;
+        for (auto it = begin; it != end; ++it) {
+            if (it->last >= from.days()) {
+                ids.push_back(id(*it));
+            }
+        }
+        return ids;
+    }
+
+    bool DateIndex::load(const std::string& path, const std::vector<FileStamp>& sources) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        FileHeader header;
+        if (!readValues(file, &header, 1) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+            || header.version != kVersion || header.source_count != sources.size()) {
+            return false;
+        }
+        std::vector<StoredStamp> stamps(header.source_count);
+        if (!readValues(file, stamps.data(), stamps.size())) {
+            return false;
+        }
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            if (stamps[i].size != sources[i].size || stamps[i].mtime != sources[i].mtime) {
+                return false;  // Written for other contents of the files
+            }
+        }
+
+        std::vector<Entry> entries(header.entry_count);
+        std::string ids(header.ids_bytes, '\0');
+        if (!readValues(file, entries.data(), entries.size()) || !readValues(file, ids.data(), ids.size())) {
+            return false;
+        }
+        for (const Entry& entry : entries) {
+            if (static_cast<std::uint64_t>(entry.id_offset) + entry.id_length > ids.size()) {
+                return false;
+            }
+        }
+
+        entries_ = std::move(entries);
+        ids_ = std::move(ids);
+        max_span_ = header.max_span;
+        return true;
+    }
+
+    bool DateIndex::save(const std::string& path, const std::vector<FileStamp>& sources) const {
+        // IDs are written back to back in entry order, dropping removed ones
+        std::vector<Entry> entries;
+        entries.reserve(entries_.size());
+        std::string ids;
+        std::int32_t max_span = 0;
+        for (const Entry& entry : entries_) {
+            std::string_view entry_id = id(entry);
+            entries.push_back({ entry.first, entry.last, static_cast<std::uint32_t>(ids.size()),
+                static_cast<std::uint32_t>(entry_id.size()) });
+            ids.append(entry_id);
+            max_span = std::max(max_span, entry.last - entry.first);
+        }
+
+        FileHeader header;
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.source_count = static_cast<std::uint32_t>(sources.size());
+        header.entry_count = static_cast<std::uint32_t>(entries.size());
+        header.ids_bytes = static_cast<std::uint32_t>(ids.size());
+        header.max_span = max_span;
+
+        // Replace atomically so a reader never sees half an index
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Warning: Could not write date index " << path << std::endl;
+                return false;
+            }
+            writeValues(file, &header, 1);
+            for (const FileStamp& source : sources) {
+                StoredStamp stamp{ source.size, source.mtime };
+                writeValues(file, &stamp, 1);
+            }
+            writeValues(file, entries.data(), entries.size());
+            writeValues(file, ids.data(), ids.size());
+            if (!file) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        return !ec;
+    }
+
+} // namespace travel_planner
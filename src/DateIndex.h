@@ -0,0 +1,104 @@
+#ifndef TRAVEL_PLANNER_DATE_INDEX_H
+#define TRAVEL_PLANNER_DATE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/Date.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    /**
+     * Record IDs sorted by date, for range queries that binary-search
+     * instead of parsing the date of every record. Each record covers a
+     * range of days (a single day for an expense, start to end for an
+     * itinerary); records whose dates do not parse are not indexed.
+     *
+     * Persisted as "<file>.dates" next to the file(s) it indexes and
+     * tagged with their stamps, so an index that missed a change is
+     * detected and rebuilt. The file is written in native byte order.
+     */
+    class DateIndex {
+    public:
+        /**
+         * @return Index file of a record file
+         */
+        static std::string pathFor(const std::string& path) { return path + ".dates"; }
+
+        /**
+         * Appends a record without keeping the order; call sort() once the
+         * records are added
+         * @param id Record ID
+         * @param first First day the record covers
+         * @param last Last day the record covers
+         */
+        void add(std::string_view id, Date first, Date last);
+
+        /**
+         * Sorts the records added with add()
+         */
+        void sort();
+
+        /**
+         * Adds one record at its place in the order
+         */
+        void insert(std::string_view id, Date first, Date last);
+
+        /**
+         * Removes a record
+         * @return False if the ID is not indexed
+         */
+        bool remove(std::string_view id);
+
+        /**
+         * Finds the records covering any day from one date to another
+         * @param from First day, inclusive
+         * @param to Last day, inclusive
+         * @return Their IDs, by first day; valid until the index changes
+         */
+        std::vector<std::string_view> overlapping(Date from, Date to) const;
+
+        /**
+         * @return Number of indexed records
+         */
+        std::size_t size() const { return entries_.size(); }
+
+        /**
+         * Reads an index file
+         * @param path Index file
+         * @param sources Current stamps of the indexed files
+         * @return False if the file is missing, unreadable or was written
+         *         for other versions of the indexed files
+         */
+        bool load(const std::string& path, const std::vector<FileStamp>& sources);
+
+        /**
+         * Writes the index, tagged with the stamps of the files it reflects
+         * @return True on success
+         */
+        bool save(const std::string& path, const std::vector<FileStamp>& sources) const;
+
+    private:
+        struct Entry {
+            std::int32_t first;
+            std::int32_t last;
+            std::uint32_t id_offset;  // Into ids_
+            std::uint32_t id_length;
+        };
+
+        std::string_view id(const Entry& entry) const {
+            return std::string_view(ids_).substr(entry.id_offset, entry.id_length);
+        }
+
+        Entry makeEntry(std::string_view id, Date first, Date last);
+
+        std::vector<Entry> entries_;   // By first day, then last day
+        std::string ids_;              // IDs back to back
+        std::int32_t max_span_ = 0;    // Longest last - first, bounds the search
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_DATE_INDEX_H
@@ -0,0 +1,268 @@
+#include "ExpenseColumnStore.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[8] = { 'T', 'P', 'E', 'X', 'C', 'O', 'L', '1' };
+        const std::uint32_t kFormatVersion = 1;
+        const std::uint32_t kRawDateFlag = 0x80000000u;
+
+        struct Header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t row_count;
+            std::uint32_t dict_count;
+            std::uint32_t reserved;
+            std::uint64_t amount_offset;
+            std::uint64_t category_offset;
+            std::uint64_t itinerary_offset;
+            std::uint64_t date_offset;
+            std::uint64_t id_offsets_offset;
+            std::uint64_t description_offsets_offset;
+            std::uint64_t dict_offsets_offset;
+            std::uint64_t heap_offset;
+            std::uint64_t heap_size;
+        };
+
+        std::uint64_t alignUp(std::uint64_t value) {
+            return (value + 7) & ~std::uint64_t(7);
+        }
+
+        // Pack a canonical YYYY-MM-DD date; returns false for anything else
+        bool packDate(const std::string& date, std::uint32_t& packed) {
+            if (date.size() != 10 || date[4] != '-' || date[7] != '-') {
+                return false;
+            }
+            for (int i : { 0, 1, 2, 3, 5, 6, 8, 9 }) {
+                if (date[i] < '0' || date[i] > '9') {
+                    return false;
+                }
+            }
+
+            std::uint32_t year = (date[0] - '0') * 1000 + (date[1] - '0') * 100 + (date[2] - '0') * 10 + (date[3] - '0');
+            std::uint32_t month = (date[5] - '0') * 10 + (date[6] - '0');
+            std::uint32_t day = (date[8] - '0') * 10 + (date[9] - '0');
+            if (month < 1 || month > 12 || day < 1 || day > 31) {
+                return false;
+            }
+
+            packed = (year << 9) | (month << 5) | day;
+            return true;
+        }
+
+        template <typename T>
+        void writeSection(std::ofstream& out, const std::vector<T>& values, std::uint64_t offset) {
+            out.seekp(static_cast<std::streamoff>(offset));
+            out.write(reinterpret_cast<const char*>(values.data()),
+                static_cast<std::streamsize>(values.size() * sizeof(T)));
+        }
+
+    } // namespace
+
+    bool ExpenseColumnStore::write(const std::string& path, const std::vector<Expense>& expenses) {
+        if (expenses.size() > std::numeric_limits<std::uint32_t>::max()) {
+            std::cerr << "Error: Too many expenses for a columnar file" << std::endl;
+            return false;
+        }
+
+        const std::size_t n = expenses.size();
+        std::vector<double> amounts(n);
+        std::vector<std::uint32_t> categories(n);
+        std::vector<std::uint32_t> itineraries(n);
+        std::vector<std::uint32_t> dates(n);
+        std::vector<std::uint32_t> id_offsets(n + 1);
+        std::vector<std::uint32_t> description_offsets(n + 1);
+        std::vector<std::uint32_t> dict_offsets;
+        std::string heap;
+
+        std::unordered_map<std::string, std::uint32_t> dictionary;
+        std::vector<const std::string*> dict_order;
+        auto intern = [&](const std::string& value) {
+            auto [it, inserted] = dictionary.emplace(value, static_cast<std::uint32_t>(dict_order.size()));
+            if (inserted) {
+                dict_order.push_back(&it->first);
+            }
+            return it->second;
+        };
+
+        // Ids first, then descriptions, then the dictionary, all in one heap
+        for (std::size_t i = 0; i < n; ++i) {
+            id_offsets[i] = static_cast<std::uint32_t>(heap.size());
+            heap += expenses[i].id;
+        }
+        id_offsets[n] = static_cast<std::uint32_t>(heap.size());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const Expense& e = expenses[i];
+            description_offsets[i] = static_cast<std::uint32_t>(heap.size());
+            heap += e.description;
+
+            amounts[i] = e.amount;
+            categories[i] = intern(e.category);
+            itineraries[i] = intern(e.itinerary_id);
+
+            std::uint32_t packed = 0;
+            dates[i] = packDate(e.date, packed) ? packed : (kRawDateFlag | intern(e.date));
+        }
+        description_offsets[n] = static_cast<std::uint32_t>(heap.size());
+
+        dict_offsets.reserve(dict_order.size() + 1);
+        for (const std::string* entry : dict_order) {
+            dict_offsets.push_back(static_cast<std::uint32_t>(heap.size()));
+            heap += *entry;
+        }
+        dict_offsets.push_back(static_cast<std::uint32_t>(heap.size()));
+
+        if (heap.size() > std::numeric_limits<std::uint32_t>::max()) {
+            std::cerr << "Error: Expense strings exceed the columnar file limit" << std::endl;
+            return false;
+        }
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kFormatVersion;
+        header.row_count = static_cast<std::uint32_t>(n);
+        header.dict_count = static_cast<std::uint32_t>(dict_order.size());
+        header.amount_offset = alignUp(sizeof(Header));
+        header.category_offset = alignUp(header.amount_offset + n * sizeof(double));
+        header.itinerary_offset = alignUp(header.category_offset + n * sizeof(std::uint32_t));
+        header.date_offset = alignUp(header.itinerary_offset + n * sizeof(std::uint32_t));
+        header.id_offsets_offset = alignUp(header.date_offset + n * sizeof(std::uint32_t));
+        header.description_offsets_offset = alignUp(header.id_offsets_offset + (n + 1) * sizeof(std::uint32_t));
+        header.dict_offsets_offset = alignUp(header.description_offsets_offset + (n + 1) * sizeof(std::uint32_t));
+        header.heap_offset = alignUp(header.dict_offsets_offset + dict_offsets.size() * sizeof(std::uint32_t));
+        header.heap_size = heap.size();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Error opening columnar expense file for writing: " << path << std::endl;
+            return false;
+        }
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeSection(out, amounts, header.amount_offset);
+        writeSection(out, categories, header.category_offset);
+        writeSection(out, itineraries, header.itinerary_offset);
+        writeSection(out, dates, header.date_offset);
+        writeSection(out, id_offsets, header.id_offsets_offset);
+        writeSection(out, description_offsets, header.description_offsets_offset);
+        writeSection(out, dict_offsets, header.dict_offsets_offset);
+        out.seekp(static_cast<std::streamoff>(header.heap_offset));
+        out.write(heap.data(), static_cast<std::streamsize>(heap.size()));
+
+        return static_cast<bool>(out);
+    }
+
+    bool ExpenseColumnStore::open(const std::string& path) {
+        if (!file_.open(path)) {
+            return false;
+        }
+
+        Header header;
+        if (file_.size() < sizeof(Header)) {
+            std::cerr << "Error: Columnar expense file is truncated: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(&header, file_.data(), sizeof(Header));
+
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion) {
+            std::cerr << "Error: Not a columnar expense file: " << path << std::endl;
+            return false;
+        }
+
+        const std::uint64_t n = header.row_count;
+        const std::uint64_t file_size = file_.size();
+        auto fits = [file_size](std::uint64_t offset, std::uint64_t bytes) {
+            return offset <= file_size && bytes <= file_size - offset && offset % 8 == 0;
+        };
+
+        if (!fits(header.amount_offset, n * sizeof(double)) ||
+            !fits(header.category_offset, n * sizeof(std::uint32_t)) ||
+            !fits(header.itinerary_offset, n * sizeof(std::uint32_t)) ||
+            !fits(header.date_offset, n * sizeof(std::uint32_t)) ||
+            !fits(header.id_offsets_offset, (n + 1) * sizeof(std::uint32_t)) ||
+            !fits(header.description_offsets_offset, (n + 1) * sizeof(std::uint32_t)) ||
+            !fits(header.dict_offsets_offset, (header.dict_count + std::uint64_t(1)) * sizeof(std::uint32_t)) ||
+            // An empty heap may start past the end of the file
+            (header.heap_size != 0 && !fits(header.heap_offset, header.heap_size))) {
+            std::cerr << "Error: Columnar expense file is corrupt: " << path << std::endl;
+            return false;
+        }
+
+        const unsigned char* base = file_.data();
+        row_count_ = static_cast<std::size_t>(n);
+        dict_count_ = header.dict_count;
+        amounts_ = reinterpret_cast<const double*>(base + header.amount_offset);
+        categories_ = reinterpret_cast<const std::uint32_t*>(base + header.category_offset);
+        itineraries_ = reinterpret_cast<const std::uint32_t*>(base + header.itinerary_offset);
+        dates_ = reinterpret_cast<const std::uint32_t*>(base + header.date_offset);
+        id_offsets_ = reinterpret_cast<const std::uint32_t*>(base + header.id_offsets_offset);
+        description_offsets_ = reinterpret_cast<const std::uint32_t*>(base + header.description_offsets_offset);
+        dict_offsets_ = reinterpret_cast<const std::uint32_t*>(base + header.dict_offsets_offset);
+        heap_ = reinterpret_cast<const char*>(base + header.heap_offset);
+        heap_size_ = static_cast<std::size_t>(header.heap_size);
+        return true;
+    }
+
+    std::string_view ExpenseColumnStore::heapString(const std::uint32_t* offsets, std::size_t index) const {
+        std::uint32_t begin = offsets[index];
+        std::uint32_t end = offsets[index + 1];
+        if (begin > end || end > heap_size_) {
+            return {};  // Corrupt offsets; never read outside the heap
+        }
+        return std::string_view(heap_ + begin, end - begin);
+    }
+
+    std::string_view ExpenseColumnStore::dictionaryEntry(std::uint32_t code) const {
+        return code < dict_count_ ? heapString(dict_offsets_, code) : std::string_view();
+    }
+
+    std::string_view ExpenseColumnStore::id(std::size_t row) const {
+        return heapString(id_offsets_, row);
+    }
+
+    std::string_view ExpenseColumnStore::description(std::size_t row) const {
+        return heapString(description_offsets_, row);
+    }
+
+    std::string_view ExpenseColumnStore::date(std::size_t row, DateBuffer& buffer) const {
+        std::uint32_t packed = dates_[row];
+        if (packed & kRawDateFlag) {
+            return dictionaryEntry(packed & ~kRawDateFlag);
+        }
+
+        std::uint32_t year = packed >> 9;
+        std::uint32_t month = (packed >> 5) & 0x0F;
+        std::uint32_t day = packed & 0x1F;
+        buffer[0] = static_cast<char>('0' + year / 1000 % 10);
+        buffer[1] = static_cast<char>('0' + year / 100 % 10);
+        buffer[2] = static_cast<char>('0' + year / 10 % 10);
+        buffer[3] = static_cast<char>('0' + year % 10);
+        buffer[4] = '-';
+        buffer[5] = static_cast<char>('0' + month / 10);
+        buffer[6] = static_cast<char>('0' + month % 10);
+        buffer[7] = '-';
+        buffer[8] = static_cast<char>('0' + day / 10);
+        buffer[9] = static_cast<char>('0' + day % 10);
+        buffer[10] = '\0';
+        return std::string_view(buffer, 10);
+    }
+
+    ExpenseView ExpenseColumnStore::view(std::size_t row, DateBuffer& buffer) const {
+        ExpenseView v;
+        v.id = id(row);
+        v.itinerary_id = dictionaryEntry(itineraries_[row]);
+        v.amount = amounts_[row];
+        v.category = dictionaryEntry(categories_[row]);
+        v.date = date(row, buffer);
+        v.description = description(row);
+        return v;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,88 @@
+#ifndef TRAVEL_PLANNER_EXPENSE_COLUMN_STORE_H
+#define TRAVEL_PLANNER_EXPENSE_COLUMN_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/Expense.h"
+#include "MappedFile.h"
+
+namespace travel_planner {
+
+    /**
+     * Memory-mapped columnar expense file.
+     *
+     * Layout (native byte order, every section 8-byte aligned):
+     *   header | amount: double[n] | category: u32[n] | itinerary_id: u32[n]
+     *   | date: u32[n] | id offsets: u32[n+1] | description offsets: u32[n+1]
+     *   | dictionary offsets: u32[d+1] | string heap
+     *
+     * Category and itinerary_id are codes into a shared string dictionary.
+     * Dates in canonical YYYY-MM-DD form are packed into 23 bits; any other
+     * date string is kept verbatim as a dictionary code with the top bit set.
+     */
+    class ExpenseColumnStore {
+    public:
+        /**
+         * Scratch space for formatting a packed date as YYYY-MM-DD
+         */
+        using DateBuffer = char[11];
+
+        /**
+         * Writes expenses to a columnar file
+         * @param path Destination file
+         * @param expenses Rows to write
+         * @return True on success
+         */
+        static bool write(const std::string& path, const std::vector<Expense>& expenses);
+
+        /**
+         * Maps a columnar file and validates its header
+         * @param path Source file
+         * @return True if the file is a valid columnar store
+         */
+        bool open(const std::string& path);
+
+        std::size_t size() const { return row_count_; }
+
+        double amount(std::size_t row) const { return amounts_[row]; }
+        std::uint32_t categoryCode(std::size_t row) const { return categories_[row]; }
+        std::uint32_t itineraryCode(std::size_t row) const { return itineraries_[row]; }
+
+        /**
+         * @return Number of distinct strings in the dictionary
+         */
+        std::size_t dictionarySize() const { return dict_count_; }
+
+        std::string_view dictionaryEntry(std::uint32_t code) const;
+        std::string_view id(std::size_t row) const;
+        std::string_view description(std::size_t row) const;
+        std::string_view date(std::size_t row, DateBuffer& buffer) const;
+
+        /**
+         * Builds a view of one row; string views point into the mapping
+         * (and into buffer for packed dates)
+         */
+        ExpenseView view(std::size_t row, DateBuffer& buffer) const;
+
+    private:
+        std::string_view heapString(const std::uint32_t* offsets, std::size_t index) const;
+
+        MappedFile file_;
+        std::size_t row_count_ = 0;
+        std::size_t dict_count_ = 0;
+        const double* amounts_ = nullptr;
+        const std::uint32_t* categories_ = nullptr;
+        const std::uint32_t* itineraries_ = nullptr;
+        const std::uint32_t* dates_ = nullptr;
+        const std::uint32_t* id_offsets_ = nullptr;
+        const std::uint32_t* description_offsets_ = nullptr;
+        const std::uint32_t* dict_offsets_ = nullptr;
+        const char* heap_ = nullptr;
+        std::size_t heap_size_ = 0;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_EXPENSE_COLUMN_STORE_H
@@ -1,55 +1,333 @@
 #include "ExpenseManager.h"
+#include "RecordCache.h"
+#include "ExpenseColumnStore.h"
+#include "Profiler.h"
+#include "RecordReader.h"
+#include "RecordWriter.h"
+#include "StorageConfig.h"
+#include "Trace.h"
 #include <fstream>
 #include <filesystem>
 #include <algorithm>
 #include <random>
 #include <chrono>
 #include <iostream>
+#include <optional>
+#include <unordered_set>
 
 namespace travel_planner {
 
-    ExpenseManager::ExpenseManager(const std::string& storage_path)
-        : data_file_path(storage_path) {
+    // Default journal size (1 MiB) after which it is folded into the snapshot
+    static const std::uintmax_t kDefaultCompactionThreshold = 1024 * 1024;
+
+    // Shard file extension of the columnar format
+    static const char* const kColumnarExtension = ".col";
+
+    static bool isColumnarPath(const std::string& path) {
+        return std::filesystem::path(path).extension() == kColumnarExtension;
     }
 
-    std::vector<Expense> ExpenseManager::loadAll() {
+    ExpenseManager::ExpenseManager(const std::string& storage_path, bool use_journal)
+        : layout(storage_path),
+        columnar(isColumnarPath(storage_path)),
+        migration_checked(false),
+        journal_enabled(use_journal),
+        compaction_threshold(kDefaultCompactionThreshold),
+        json_indent(jsonIndent(4)),
+        index((std::filesystem::path(layout.directory()) / ".index").string()),
+        index_checked(false) {
+    }
+
+    void ExpenseManager::setCompactionThreshold(std::uintmax_t bytes) {
+        compaction_threshold = bytes;
+    }
+
+    void ExpenseManager::setJsonIndent(int indent) {
+        json_indent = indent;
+    }
+
+    void ExpenseManager::migrateIfNeeded() {
+        if (migration_checked) {
+            return;
+        }
+        migration_checked = true;
+
+        // Convert shards written in another format (e.g. JSON -> columnar)
+        std::string recorded = layout.recordedExtension();
+        if (!recorded.empty() && recorded != layout.extension()) {
+            for (const auto& old_path : layout.shardPathsWithExtension(recorded)) {
+                std::vector<Expense> expenses = loadShard(old_path);
+                if (expenses.empty()) {
+                    continue;  // Nothing worth keeping
+                }
+                if (!saveShard(layout.shardPath(expenses.front().itinerary_id), expenses)) {
+                    std::cerr << "Error converting expense shard " << old_path << std::endl;
+                    migration_checked = false;
+                    return;  // Keep the old shards; conversion is retried next time
+                }
+            }
+            for (const auto& old_path : layout.shardPathsWithExtension(recorded)) {
+                removeShardFiles(old_path);
+            }
+            layout.recordExtension();
+        }
+
+        const std::string legacy_journal = layout.legacyPath() + ".journal";
+        if (!layout.needsMigration() && !std::filesystem::exists(legacy_journal)) {
+            return;
+        }
+
+        // Split the single-file store (and any journal left on it) into shards
+        std::map<std::string, std::vector<Expense>> by_itinerary;
+        for (auto& expense : loadShard(layout.legacyPath())) {
+            by_itinerary[expense.itinerary_id].push_back(std::move(expense));
+        }
+
+        for (const auto& [itinerary_id, expenses] : by_itinerary) {
+            if (!saveShard(layout.shardPath(itinerary_id), expenses)) {
+                std::cerr << "Error migrating expenses to " << layout.directory() << std::endl;
+                migration_checked = false;
+                return;  // Keep the legacy store; migration is retried next time
+            }
+        }
+
+        layout.retireLegacyStore();
+        std::error_code ec;
+        std::filesystem::remove(legacy_journal, ec);
+    }
+
+    std::vector<Expense> ExpenseManager::loadSnapshot(const std::string& shard_path, bool* loaded) {
+        TraceSpan span("ExpenseManager::loadSnapshot", shard_path);
+        ProfileScope profile(ProfilePhase::Load);
         std::vector<Expense> expenses;
+        if (loaded != nullptr) {
+            *loaded = true;
+        }
 
-        if (!std::filesystem::exists(data_file_path)) {
+        if (!std::filesystem::exists(shard_path)) {
             return expenses;  // Return empty list if file doesn't exist
         }
 
+        if (isColumnarPath(shard_path)) {
+            // A file that does not open must not be saved over, as with
+            // readRecordFile()
+            ExpenseColumnStore store;
+            bool opened = store.open(shard_path);
+            setUnreadable(shard_path, !opened);
+            if (!opened) {
+                std::cerr << "Error loading expenses from " << shard_path << std::endl;
+                if (loaded != nullptr) {
+                    *loaded = false;
+                }
+                return expenses;
+            }
+            ExpenseColumnStore::DateBuffer date_buffer;
+            expenses.reserve(store.size());
+            for (std::size_t row = 0; row < store.size(); ++row) {
+                expenses.push_back(store.view(row, date_buffer).toExpense());
+            }
+            return expenses;
+        }
+
         try {
-            std::ifstream file(data_file_path);
-            if (file.is_open()) {
-                nlohmann::json data = nlohmann::json::parse(file);
-                expenses = data.get<std::vector<Expense>>();
-                file.close();
+            std::string error;
+            auto collect = [&expenses](const Expense& expense) {
+                expenses.push_back(expense);
+                return true;
+            };
+            if (!readRecordFile<Expense>(shard_path, collect, error, formatForPath(shard_path)) || !error.empty()) {
+                std::cerr << "Error loading expenses from " << shard_path << ": " << error << std::endl;
+                if (loaded != nullptr) {
+                    *loaded = false;
+                }
             }
         }
         catch (const std::exception& e) {
-            std::cerr << "Error loading expenses: " << e.what() << std::endl;
-            // Return empty list on error
+            std::cerr << "Error loading expenses from " << shard_path << ": " << e.what() << std::endl;
+            // Return what was read before the error
+            if (loaded != nullptr) {
+                *loaded = false;
+            }
         }
 
         return expenses;
     }
 
-    bool ExpenseManager::saveAll(const std::vector<Expense>& expenses) {
+    std::unordered_map<std::string, ExpenseManager::CachedJournal>& ExpenseManager::journalCache() {
+        static std::unordered_map<std::string, CachedJournal> cache;
+        return cache;
+    }
+
+    void ExpenseManager::applyJournalRecord(JournalDelta& delta, const nlohmann::json& record) {
+        const std::string op = record.at("op").get<std::string>();
+
+        if (op == "add") {
+            Expense expense = record.at("expense").get<Expense>();
+            if (delta.added_ids.insert(expense.id).second) {
+                delta.added.push_back(std::move(expense));
+            }
+        }
+        else if (op == "remove") {
+            const std::string id = record.at("id").get<std::string>();
+            if (delta.added_ids.erase(id) > 0) {
+                delta.added.erase(std::find_if(delta.added.begin(), delta.added.end(),
+                    [&id](const Expense& e) { return e.id == id; }));
+            }
+            delta.removed.insert(id);
+        }
+    }
+
+    ExpenseManager::JournalDelta ExpenseManager::readJournal(const std::string& shard_path) {
+        TraceSpan span("ExpenseManager::readJournal", shard_path);
+        ProfileScope profile(ProfilePhase::Load);
+        JournalDelta delta;
+        const std::string journal_path = shard_path + ".journal";
+
+        if (!journal_enabled || !std::filesystem::exists(journal_path)) {
+            return delta;
+        }
+
+        FileStamp stamp;
+        std::string key;
+        if (recordCacheEnabled()) {
+            stamp = fileStamp(journal_path);
+            key = cacheKey(journal_path);
+            auto cached = journalCache().find(key);
+            if (cached != journalCache().end() && cached->second.stamp == stamp) {
+                return cached->second.delta;
+            }
+        }
+
+        std::ifstream journal(journal_path);
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(journal, line)) {
+            ++line_number;
+            if (line.empty()) {
+                continue;
+            }
+
+            try {
+                applyJournalRecord(delta, nlohmann::json::parse(line));
+            }
+            catch (const std::exception& e) {
+                // A torn final line from an interrupted append is expected; skip it
+                std::cerr << "Warning: Skipping invalid expense journal entry at "
+                    << journal_path << ":" << line_number << ": " << e.what() << std::endl;
+            }
+        }
+
+        if (recordCacheEnabled()) {
+            journalCache()[key] = { stamp, delta };
+        }
+        return delta;
+    }
+
+    std::vector<Expense> ExpenseManager::loadShard(const std::string& shard_path, bool* loaded) {
+        std::vector<Expense> expenses = loadSnapshot(shard_path, loaded);
+        JournalDelta delta = readJournal(shard_path);
+
+        if (delta.added.empty() && delta.removed.empty()) {
+            return expenses;
+        }
+
+        // Replay the journal over the snapshot. Adds are skipped when the ID is
+        // already present so a journal left behind by an interrupted compaction
+        // replays harmlessly.
+        std::unordered_set<std::string> ids;
+        expenses.erase(std::remove_if(expenses.begin(), expenses.end(),
+            [&delta, &ids](const Expense& e) {
+                if (delta.removed.count(e.id) > 0) {
+                    return true;
+                }
+                ids.insert(e.id);
+                return false;
+            }), expenses.end());
+
+        for (auto& expense : delta.added) {
+            if (ids.insert(expense.id).second) {
+                expenses.push_back(std::move(expense));
+            }
+        }
+
+        return expenses;
+    }
+
+    bool ExpenseManager::saveShard(const std::string& shard_path, const std::vector<Expense>& expenses) {
+        TraceSpan span("ExpenseManager::saveShard", shard_path);
         try {
             // Create directories if they don't exist
-            std::filesystem::path path(data_file_path);
+            std::filesystem::path path(shard_path);
             if (path.has_parent_path() && !std::filesystem::exists(path.parent_path())) {
                 std::filesystem::create_directories(path.parent_path());
+                layout.recordExtension();
             }
 
-            std::ofstream file(data_file_path);
-            if (file.is_open()) {
-                nlohmann::json data = expenses;
-                file << data.dump(4);  // Pretty print with 4-space indent
-                file.close();
-                return true;
+            // Check the index before the shard changes, or it looks stale
+            bool indexed = ensureIndex();
+
+            // Write to a temporary file first so an interrupted save never
+            // leaves a truncated snapshot next to a live journal
+            std::vector<RecordSpan> spans;
+            if (isColumnarPath(shard_path)) {
+                // Same guard as OutputBuffer::open() on the record formats
+                if (isUnreadable(shard_path)) {
+                    std::cerr << "Error: " << shard_path << " could not be read; not overwriting it" << std::endl;
+                    return false;
+                }
+                std::string temp_path = shard_path + ".tmp";
+                if (!ExpenseColumnStore::write(temp_path, expenses)) {
+                    return false;
+                }
+                std::filesystem::rename(temp_path, shard_path);
+
+                // Columnar records are located by row
+                spans.resize(expenses.size());
+                for (std::size_t row = 0; row < spans.size(); ++row) {
+                    spans[row].offset = row;
+                }
+            }
+            else if (!writeRecords(shard_path, expenses, formatForPath(shard_path), json_indent, &spans)) {
+                // writeRecords goes through "<shard>.tmp" and renames on success
+                return false;
+            }
+            else {
+                cacheRecords(shard_path, expenses);
             }
+
+            // The snapshot is now authoritative
+            const std::string journal_path = shard_path + ".journal";
+            std::filesystem::remove(journal_path);
+
+            // A rollup kept for this shard is refreshed from the records at
+            // hand; shards without one get it on their first summary
+            const std::string rollup_path = ExpenseRollup::pathFor(shard_path);
+            if (std::filesystem::exists(rollup_path)) {
+                ExpenseRollup::Builder builder;
+                for (const auto& expense : expenses) {
+                    builder.add(ExpenseView(expense));
+                }
+                builder.finish().save(rollup_path, fileStamp(shard_path), fileStamp(journal_path));
+            }
+
+            const std::string dates_path = DateIndex::pathFor(shard_path);
+            if (std::filesystem::exists(dates_path)) {
+                DateIndex dates;
+                for (const auto& expense : expenses) {
+                    if (std::optional<Date> day = Date::parse(expense.date)) {
+                        dates.add(expense.id, *day, *day);
+                    }
+                }
+                dates.sort();
+                dates.save(dates_path, { fileStamp(shard_path), fileStamp(journal_path) });
+            }
+
+            if (indexed || ensureIndex()) {
+                index.replaceFile(shard_path, expenses, spans);
+                index.dropFile(journal_path);
+                index.stampFile(journal_path);
+            }
+            return true;
         }
         catch (const std::exception& e) {
             std::cerr << "Error saving expenses: " << e.what() << std::endl;
@@ -58,6 +336,374 @@ namespace travel_planner {
         return false;
     }
 
+    std::vector<Expense> ExpenseManager::loadAll() {
+        TraceSpan span("ExpenseManager::loadAll");
+        migrateIfNeeded();
+
+        std::vector<Expense> expenses;
+        for (const auto& shard_path : layout.shardPaths()) {
+            auto shard = loadShard(shard_path);
+            expenses.insert(expenses.end(),
+                std::make_move_iterator(shard.begin()), std::make_move_iterator(shard.end()));
+        }
+
+        return expenses;
+    }
+
+    std::pmr::vector<pmr::Expense> ExpenseManager::loadAll(std::pmr::memory_resource* resource) {
+        TraceSpan span("ExpenseManager::loadAll");
+        migrateIfNeeded();
+
+        std::pmr::vector<pmr::Expense> expenses(resource);
+        for (const auto& shard_path : layout.shardPaths()) {
+            scanShard(shard_path, [&expenses](const ExpenseView& expense) {
+                expenses.emplace_back(expense);
+                return true;
+            });
+        }
+
+        return expenses;
+    }
+
+    bool ExpenseManager::saveAll(const std::vector<Expense>& expenses) {
+        TraceSpan span("ExpenseManager::saveAll");
+        migrateIfNeeded();
+
+        // Group by itinerary ID, shards in order of first appearance. The map
+        // views the IDs in expenses, so it lives only as long as this call.
+        std::unordered_map<std::string_view, std::size_t> shard_of;
+        std::vector<std::string_view> shard_ids;
+        std::vector<std::vector<Expense>> by_itinerary;
+        for (const auto& expense : expenses) {
+            auto [it, inserted] = shard_of.try_emplace(expense.itinerary_id, by_itinerary.size());
+            if (inserted) {
+                shard_ids.push_back(expense.itinerary_id);
+                by_itinerary.emplace_back();
+            }
+            by_itinerary[it->second].push_back(expense);
+        }
+
+        bool success = true;
+        std::unordered_set<std::string> written;
+        for (std::size_t shard = 0; shard < by_itinerary.size(); ++shard) {
+            std::string shard_path = layout.shardPath(std::string(shard_ids[shard]));
+            success = saveShard(shard_path, by_itinerary[shard]) && success;
+            written.insert(shard_path);
+        }
+
+        // Drop shards of itineraries that no longer have any expenses
+        for (const auto& shard_path : layout.shardPaths()) {
+            if (written.count(shard_path) == 0) {
+                removeShardFiles(shard_path);
+                if (ensureIndex()) {
+                    for (const std::string& path : { shard_path, shard_path + ".journal" }) {
+                        index.dropFile(path);
+                        index.stampFile(path);
+                    }
+                }
+            }
+        }
+
+        return success;
+    }
+
+    bool ExpenseManager::compact() {
+        TraceSpan span("ExpenseManager::compact");
+        migrateIfNeeded();
+
+        bool success = true;
+        for (const auto& shard_path : layout.shardPaths()) {
+            if (std::filesystem::exists(shard_path + ".journal")) {
+                success = compactShard(shard_path) && success;
+            }
+        }
+        return success;
+    }
+
+    bool ExpenseManager::appendJournal(const std::string& shard_path, const nlohmann::json& record) {
+        TraceSpan span("ExpenseManager::appendJournal", shard_path);
+        ProfileScope profile(ProfilePhase::Write);
+        const std::string journal_path = shard_path + ".journal";
+        try {
+            // A new shard starts out with an empty snapshot so it is listed
+            // alongside the others
+            if (!std::filesystem::exists(shard_path) && !saveShard(shard_path, {})) {
+                return false;
+            }
+
+            bool indexed = ensureIndex();
+
+            // A cached parse of the journal stays usable if it is current
+            // now; it is brought up to date below instead of re-parsed
+            auto cached = journalCache().end();
+            if (recordCacheEnabled()) {
+                cached = journalCache().find(cacheKey(journal_path));
+                if (cached != journalCache().end() && cached->second.stamp != fileStamp(journal_path)) {
+                    journalCache().erase(cached);
+                    cached = journalCache().end();
+                }
+            }
+
+            // Binary mode keeps line offsets exact for the index
+            std::ofstream journal(journal_path, std::ios::app | std::ios::binary);
+            if (!journal.is_open()) {
+                std::cerr << "Error opening expense journal: " << journal_path << std::endl;
+                return false;
+            }
+
+            std::error_code ec;
+            std::uintmax_t offset = std::filesystem::file_size(journal_path, ec);
+            const std::string line = record.dump();
+            journal << line << '\n';
+            journal.flush();
+            if (!journal) {
+                return false;
+            }
+            journal.close();
+
+            if (cached != journalCache().end()) {
+                applyJournalRecord(cached->second.delta, record);
+                cached->second.stamp = fileStamp(journal_path);
+            }
+
+            // Adds are located by their journal line until the next compaction
+            if (indexed) {
+                if (record.at("op") == "add") {
+                    index.put(record.at("expense").at("id").get<std::string>(), journal_path,
+                        ec ? 0 : offset, static_cast<std::uint32_t>(line.size()));
+                }
+                else {
+                    index.erase(record.at("id").get<std::string>());
+                }
+                index.stampFile(journal_path);
+            }
+            return true;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Error writing expense journal: " << e.what() << std::endl;
+        }
+
+        return false;
+    }
+
+    void ExpenseManager::updateRollup(const std::string& shard_path, const FileStamp& snapshot_before,
+        const FileStamp& journal_before, const std::function<bool(ExpenseRollup&)>& change) {
+        const std::string rollup_path = ExpenseRollup::pathFor(shard_path);
+        ExpenseRollup rollup;
+        if (!rollup.load(rollup_path, snapshot_before, journal_before)) {
+            return;  // Missing or already out of date; rebuilt on next use
+        }
+        if (!change(rollup)) {
+            std::error_code ec;
+            std::filesystem::remove(rollup_path, ec);
+            return;
+        }
+        rollup.save(rollup_path, fileStamp(shard_path), fileStamp(shard_path + ".journal"));
+    }
+
+    void ExpenseManager::updateDateIndex(const std::string& shard_path, const FileStamp& snapshot_before,
+        const FileStamp& journal_before, const std::function<bool(DateIndex&)>& change) {
+        const std::string dates_path = DateIndex::pathFor(shard_path);
+        DateIndex dates;
+        if (!dates.load(dates_path, { snapshot_before, journal_before })) {
+            return;  // Missing or already out of date; rebuilt on next use
+        }
+        if (!change(dates)) {
+            std::error_code ec;
+            std::filesystem::remove(dates_path, ec);
+            return;
+        }
+        dates.save(dates_path, { fileStamp(shard_path), fileStamp(shard_path + ".journal") });
+    }
+
+    DateIndex ExpenseManager::loadDateIndex(const std::string& shard_path) {
+        const std::string dates_path = DateIndex::pathFor(shard_path);
+        const std::vector<FileStamp> sources = { fileStamp(shard_path), fileStamp(shard_path + ".journal") };
+
+        DateIndex dates;
+        {
+            ProfileScope profile(ProfilePhase::Load);
+            if (dates.load(dates_path, sources)) {
+                return dates;
+            }
+        }
+
+        // Missing or out of date: rebuild from the shard
+        scanShard(shard_path, [&dates](const ExpenseView& expense) {
+            if (std::optional<Date> day = Date::parse(expense.date)) {
+                dates.add(expense.id, *day, *day);
+            }
+            return true;
+        });
+        dates.sort();
+
+        if (sources.front() != FileStamp()) {
+            dates.save(dates_path, sources);
+        }
+        return dates;
+    }
+
+    void ExpenseManager::removeShardFiles(const std::string& shard_path) {
+        std::error_code ec;
+        std::filesystem::remove(shard_path, ec);
+        std::filesystem::remove(shard_path + ".journal", ec);
+        std::filesystem::remove(ExpenseRollup::pathFor(shard_path), ec);
+        std::filesystem::remove(DateIndex::pathFor(shard_path), ec);
+    }
+
+    bool ExpenseManager::compactIfNeeded(const std::string& shard_path) {
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(shard_path + ".journal", ec);
+        if (ec || size < compaction_threshold) {
+            return true;
+        }
+        if (!compactShard(shard_path)) {
+            // The change is in the journal either way; compaction is retried
+            // on the next one
+            std::cerr << "Warning: Could not compact " << shard_path << "; keeping its journal" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool ExpenseManager::compactShard(const std::string& shard_path) {
+        bool loaded = true;
+        std::vector<Expense> expenses = loadShard(shard_path, &loaded);
+        if (!loaded) {
+            return false;  // The journal stays until the snapshot reads again
+        }
+        return saveShard(shard_path, expenses);
+    }
+
+    std::vector<std::string> ExpenseManager::indexedFiles() const {
+        std::vector<std::string> files = layout.shardPaths();
+        if (journal_enabled) {
+            std::size_t shard_count = files.size();
+            for (std::size_t i = 0; i < shard_count; ++i) {
+                std::string journal_path = files[i] + ".journal";
+                if (std::filesystem::exists(journal_path)) {
+                    files.push_back(journal_path);
+                }
+            }
+        }
+        return files;
+    }
+
+    bool ExpenseManager::ensureIndex() {
+        if (index_checked) {
+            return index.isOpen();
+        }
+
+        // Nothing to index before the first shard is written
+        std::error_code ec;
+        if (!std::filesystem::is_directory(layout.directory(), ec)) {
+            return false;
+        }
+        index_checked = true;
+
+        if (index.open() && index.matches(indexedFiles())) {
+            return true;
+        }
+        return rebuildIndex();
+    }
+
+    bool ExpenseManager::rebuildIndex() {
+        TraceSpan span("ExpenseManager::rebuildIndex");
+        std::vector<std::string> shard_paths = layout.shardPaths();
+        if (!index.create(shard_paths.size() * 32)) {
+            return false;
+        }
+
+        for (const auto& shard_path : shard_paths) {
+            // Snapshot first
+            bool ok = true;
+            std::string error;
+            if (isColumnarPath(shard_path)) {
+                ExpenseColumnStore store;
+                if (store.open(shard_path)) {
+                    for (std::size_t row = 0; row < store.size() && ok; ++row) {
+                        ok = index.put(store.id(row), shard_path, row, 0);
+                    }
+                }
+            }
+            else {
+                MappedFile file;
+                ok = file.open(shard_path);
+                const char* data = reinterpret_cast<const char*>(file.data());
+                ok = ok && (file.size() == 0 || scanRecordSpans<Expense>(data, file.size(), formatForPath(shard_path),
+                    [this, &shard_path](const Expense& expense, const RecordSpan& span) {
+                        return index.put(expense.id, shard_path, span.offset, span.length);
+                    }, error));
+            }
+            if (!ok) {
+                std::cerr << "Error indexing expenses file " << shard_path << ": " << error << std::endl;
+                index.close();
+                return false;
+            }
+            index.stampFile(shard_path);
+
+            // Then replay the journal in order; torn lines are skipped as on load
+            const std::string journal_path = shard_path + ".journal";
+            if (!journal_enabled || !std::filesystem::exists(journal_path)) {
+                continue;
+            }
+
+            std::ifstream journal(journal_path, std::ios::binary);
+            std::string line;
+            std::uint64_t offset = 0;
+            while (std::getline(journal, line)) {
+                std::uint64_t line_offset = offset;
+                offset += line.size() + 1;
+                try {
+                    nlohmann::json record = nlohmann::json::parse(line);
+                    if (record.at("op") == "add") {
+                        index.put(record.at("expense").at("id").get<std::string>(), journal_path,
+                            line_offset, static_cast<std::uint32_t>(line.size()));
+                    }
+                    else if (record.at("op") == "remove") {
+                        index.erase(record.at("id").get<std::string>());
+                    }
+                }
+                catch (const std::exception&) {
+                    continue;
+                }
+            }
+            index.stampFile(journal_path);
+        }
+
+        return true;
+    }
+
+    bool ExpenseManager::readIndexed(const RecordLocation& location, Expense& expense) const {
+        ProfileScope profile(ProfilePhase::Load);
+        try {
+            if (isColumnarPath(location.file)) {
+                ExpenseColumnStore store;
+                if (!store.open(location.file) || location.offset >= store.size()) {
+                    return false;
+                }
+                ExpenseColumnStore::DateBuffer date_buffer;
+                expense = store.view(location.offset, date_buffer).toExpense();
+                return true;
+            }
+
+            if (std::filesystem::path(location.file).extension() == ".journal") {
+                std::ifstream journal(location.file, std::ios::binary);
+                std::string line(location.length, '\0');
+                if (!journal.seekg(location.offset) || !journal.read(&line[0], line.size())) {
+                    return false;
+                }
+                expense = nlohmann::json::parse(line).at("expense").get<Expense>();
+                return true;
+            }
+
+            return readRecordAt(location.file, { location.offset, location.length }, expense);
+        }
+        catch (const std::exception&) {
+            return false;  // Stale location
+        }
+    }
+
     bool ExpenseManager::addExpense(
         const std::string& itinerary_id,
         double amount,
@@ -65,6 +711,15 @@ namespace travel_planner {
         const std::string& date,
         const std::string& description
     ) {
+        TraceSpan span("ExpenseManager::addExpense", itinerary_id);
+
+        // Parsed once here; readers use the packed dates of the date index
+        std::optional<Date> day = Date::parse(date);
+        if (!day) {
+            std::cerr << "Error: Invalid expense date '" << date << "'. Use YYYY-MM-DD." << std::endl;
+            return false;
+        }
+
         // Generate a unique ID for the new expense
         auto now = std::chrono::system_clock::now();
         auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -86,67 +741,300 @@ namespace travel_planner {
         // Create the expense object
         Expense expense(id, itinerary_id, amount, category, date, description);
 
-        // Load existing expenses
-        std::vector<Expense> expenses = loadAll();
+        migrateIfNeeded();
+        std::string shard_path = layout.shardPath(itinerary_id);
+
+        if (journal_enabled) {
+            // Append only; the shard snapshot is rewritten on compaction
+            FileStamp snapshot_before = fileStamp(shard_path);
+            FileStamp journal_before = fileStamp(shard_path + ".journal");
+            if (!appendJournal(shard_path, { {"op", "add"}, {"expense", expense} })) {
+                return false;
+            }
+            updateRollup(shard_path, snapshot_before, journal_before, [&expense](ExpenseRollup& rollup) {
+                rollup.add(ExpenseView(expense));
+                return true;
+            });
+            updateDateIndex(shard_path, snapshot_before, journal_before, [&expense, &day](DateIndex& dates) {
+                dates.insert(expense.id, *day, *day);
+                return true;
+            });
+            compactIfNeeded(shard_path);
+            return true;
+        }
+
+        // Load existing expenses of this itinerary
+        std::vector<Expense> expenses = loadShard(shard_path);
 
         // Add the new expense
         expenses.push_back(expense);
 
         // Save updated expenses list
-        return saveAll(expenses);
+        return saveShard(shard_path, expenses);
     }
 
     std::vector<Expense> ExpenseManager::listExpenses(const std::string& itinerary_id) {
-        std::vector<Expense> all_expenses = loadAll();
-        std::vector<Expense> filtered_expenses;
-
-        // Filter expenses by itinerary_id
-        std::copy_if(all_expenses.begin(), all_expenses.end(),
-            std::back_inserter(filtered_expenses),
-            [&itinerary_id](const Expense& e) {
-                return e.itinerary_id == itinerary_id;
-            });
+        TraceSpan span("ExpenseManager::listExpenses", itinerary_id);
+        migrateIfNeeded();
+
+        // Only this itinerary's shard is read
+        return loadShard(layout.shardPath(itinerary_id));
+    }
+
+    std::vector<Expense> ExpenseManager::listExpenses(const std::string& itinerary_id, Date from, Date to) {
+        TraceSpan span("ExpenseManager::listExpenses", itinerary_id);
+        migrateIfNeeded();
+
+        const std::string shard_path = layout.shardPath(itinerary_id);
+        DateIndex dates = loadDateIndex(shard_path);
+        std::vector<std::string_view> ids = dates.overlapping(from, to);
+        if (ids.empty()) {
+            return {};
+        }
+
+        ProfileScope profile(ProfilePhase::Load);
+        std::vector<Expense> expenses;
+        expenses.reserve(ids.size());
+
+        // A narrow range reads just its records through the ID index; a
+        // wide one costs about as much as reading the whole shard
+        if (ids.size() <= dates.size() / 8 && ensureIndex()) {
+            for (std::string_view id : ids) {
+                Expense expense;
+                RecordLocation location;
+                if (!findIndexed(index, std::string(id), expense, location,
+                    [this](const RecordLocation& at, Expense& record) { return readIndexed(at, record); },
+                    [this]() { return rebuildIndex(); })) {
+                    break;
+                }
+                expenses.push_back(std::move(expense));
+            }
+            if (expenses.size() == ids.size()) {
+                return expenses;
+            }
+            expenses.clear();
+        }
+
+        // Pick the dated expenses out of one pass over the shard
+        std::unordered_map<std::string_view, std::size_t> positions;
+        positions.reserve(ids.size());
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            positions.emplace(ids[i], i);
+        }
+        std::vector<Expense> by_date(ids.size());
+        scanShard(shard_path, [&positions, &by_date](const ExpenseView& expense) {
+            auto it = positions.find(expense.id);
+            if (it != positions.end()) {
+                by_date[it->second] = expense.toExpense();
+            }
+            return true;
+        });
+        for (auto& expense : by_date) {
+            if (!expense.id.empty()) {
+                expenses.push_back(std::move(expense));
+            }
+        }
+        return expenses;
+    }
+
+    std::pmr::vector<pmr::Expense> ExpenseManager::listExpenses(const std::string& itinerary_id,
+        std::pmr::memory_resource* resource) {
+        TraceSpan span("ExpenseManager::listExpenses", itinerary_id);
+        migrateIfNeeded();
+
+        std::pmr::vector<pmr::Expense> expenses(resource);
+        scanShard(layout.shardPath(itinerary_id), [&expenses](const ExpenseView& expense) {
+            expenses.emplace_back(expense);
+            return true;
+        });
+        return expenses;
+    }
+
+    bool ExpenseManager::scanShard(const std::string& shard_path,
+        const std::function<bool(const ExpenseView&)>& visitor) {
+        ProfileScope profile(ProfilePhase::Load);
+        JournalDelta delta = readJournal(shard_path);
+
+        // Snapshot rows first (minus journaled removes), then journaled adds
+        bool completed = true;
+        std::unordered_set<std::string> shadowed;  // Journaled adds already in the snapshot
+        auto emit = [&delta, &visitor, &completed, &shadowed](const ExpenseView& view) {
+            if (delta.removed.empty() && delta.added_ids.empty()) {
+                completed = visitor(view);
+                return completed;
+            }
+            std::string id(view.id);
+            if (delta.removed.count(id) > 0) {
+                return true;
+            }
+            if (delta.added_ids.count(id) > 0) {
+                // Left behind by an interrupted compaction; the snapshot row wins
+                shadowed.insert(std::move(id));
+            }
+            completed = visitor(view);
+            return completed;
+        };
 
-        return filtered_expenses;
+        if (std::filesystem::exists(shard_path)) {
+            if (isColumnarPath(shard_path)) {
+                // Scan straight off the mapping
+                ExpenseColumnStore store;
+                if (store.open(shard_path)) {
+                    ExpenseColumnStore::DateBuffer date_buffer;
+                    for (std::size_t row = 0; row < store.size() && completed; ++row) {
+                        emit(store.view(row, date_buffer));
+                    }
+                }
+            }
+            else {
+                std::string error;
+                auto stream_visitor = [&emit](const Expense& expense) {
+                    return emit(ExpenseView(expense));
+                };
+                if (!readRecordFile<Expense>(shard_path, stream_visitor, error, formatForPath(shard_path)) || !error.empty()) {
+                    std::cerr << "Error loading expenses from " << shard_path << ": " << error << std::endl;
+                }
+            }
+        }
+
+        for (const auto& expense : delta.added) {
+            if (!completed) {
+                break;
+            }
+            if (shadowed.empty() || shadowed.count(expense.id) == 0) {
+                completed = visitor(ExpenseView(expense));
+            }
+        }
+
+        return completed;
+    }
+
+    void ExpenseManager::forEachExpense(const std::string& itinerary_id,
+        const std::function<void(const ExpenseView&)>& visitor) {
+        migrateIfNeeded();
+
+        // Only this itinerary's shard is read
+        scanShard(layout.shardPath(itinerary_id), [&visitor](const ExpenseView& expense) {
+            visitor(expense);
+            return true;
+        });
     }
 
     std::map<std::string, double> ExpenseManager::summary(const std::string& itinerary_id) {
-        std::vector<Expense> expenses = listExpenses(itinerary_id);
+        TraceSpan span("ExpenseManager::summary", itinerary_id);
+        // Read off the rollup; no expense is scanned while it is current
+        // Keep the rollup alive: a range-for over a member of a temporary
+        // would iterate freed groups
+        const ExpenseRollup totals = rollup(itinerary_id);
         std::map<std::string, double> category_totals;
+        for (const auto& [category, stats] : totals.categories()) {
+            category_totals.emplace(category, stats.sum.amount());
+        }
+        return category_totals;
+    }
 
-        // Sum expenses by category
-        for (const auto& expense : expenses) {
-            category_totals[expense.category] += expense.amount;
+    ExpenseRollup ExpenseManager::rollup(const std::string& itinerary_id) {
+        TraceSpan span("ExpenseManager::rollup", itinerary_id);
+        migrateIfNeeded();
+
+        const std::string shard_path = layout.shardPath(itinerary_id);
+        const std::string rollup_path = ExpenseRollup::pathFor(shard_path);
+        FileStamp snapshot = fileStamp(shard_path);
+        FileStamp journal = fileStamp(shard_path + ".journal");
+
+        ExpenseRollup rollup;
+        {
+            ProfileScope profile(ProfilePhase::Load);
+            if (rollup.load(rollup_path, snapshot, journal)) {
+                return rollup;
+            }
         }
 
-        return category_totals;
+        // Missing or out of date: rebuild from the shard
+        ExpenseRollup::Builder builder;
+        scanShard(shard_path, [&builder](const ExpenseView& expense) {
+            builder.add(expense);
+            return true;
+        });
+        rollup = builder.finish();
+
+        if (snapshot != FileStamp()) {
+            rollup.save(rollup_path, snapshot, journal);
+        }
+        return rollup;
     }
 
     bool ExpenseManager::removeExpense(const std::string& expense_id) {
-        // Load all expenses
-        std::vector<Expense> expenses = loadAll();
+        TraceSpan span("ExpenseManager::removeExpense", expense_id);
+        migrateIfNeeded();
 
-        // Check if the list is empty
-        if (expenses.empty()) {
-            return false;  // Nothing to remove
+        // Expense IDs don't carry their itinerary; the index knows the shard
+        std::vector<std::string> candidates;
+        if (ensureIndex()) {
+            Expense expense;
+            RecordLocation location;
+            bool found = findIndexed(index, expense_id, expense, location,
+                [this](const RecordLocation& at, Expense& record) { return readIndexed(at, record); },
+                [this]() { return rebuildIndex(); });
+            if (found) {
+                // Journal lines belong to the snapshot next to them
+                std::filesystem::path path(location.file);
+                if (path.extension() == ".journal") {
+                    path.replace_extension();
+                }
+                candidates.push_back(path.string());
+            }
+            else if (index.isOpen()) {
+                return false;  // Expense not found
+            }
+        }
+        if (candidates.empty()) {
+            // No usable index, so every shard is a candidate
+            candidates = layout.shardPaths();
         }
 
-        // Find the expense to remove
-        auto it = std::find_if(expenses.begin(), expenses.end(),
-            [&expense_id](const Expense& e) {
-                return e.id == expense_id;
+        // Stream through the candidate shards without keeping any expenses
+        // until the right one is found
+        for (const auto& shard_path : candidates) {
+            Expense removed;
+            bool found = !scanShard(shard_path, [&expense_id, &removed](const ExpenseView& e) {
+                if (e.id != expense_id) {
+                    return true;
+                }
+                removed = e.toExpense();  // Kept for the rollup
+                return false;
             });
 
-        // Check if the expense was found
-        if (it == expenses.end()) {
-            return false;  // Expense not found
-        }
+            if (!found) {
+                continue;  // Not in this shard
+            }
+
+            if (journal_enabled) {
+                FileStamp snapshot_before = fileStamp(shard_path);
+                FileStamp journal_before = fileStamp(shard_path + ".journal");
+                if (!appendJournal(shard_path, { {"op", "remove"}, {"id", expense_id} })) {
+                    return false;
+                }
+                updateRollup(shard_path, snapshot_before, journal_before, [&removed](ExpenseRollup& rollup) {
+                    return rollup.remove(ExpenseView(removed));
+                });
+                updateDateIndex(shard_path, snapshot_before, journal_before, [&expense_id](DateIndex& dates) {
+                    return dates.remove(expense_id);
+                });
+                compactIfNeeded(shard_path);
+                return true;
+            }
 
-        // Remove the expense
-        expenses.erase(it);
+            // Remove the expense
+            std::vector<Expense> expenses = loadShard(shard_path);
+            expenses.erase(std::remove_if(expenses.begin(), expenses.end(),
+                [&expense_id](const Expense& e) { return e.id == expense_id; }), expenses.end());
+
+            // Save the updated shard
+            return saveShard(shard_path, expenses);
+        }
 
-        // Save the updated list
-        return saveAll(expenses);
+        return false;  // Expense not found
     }
 
 } // namespace travel_planner
\ No newline at end of file
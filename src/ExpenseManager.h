@@ -4,22 +4,53 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+#include <unordered_set>
+#include "../include/Date.h"
 #include "../include/Expense.h"
+#include "DateIndex.h"
+#include "ExpenseRollup.h"
+#include "RecordCache.h"
+#include "RecordIndex.h"
+#include "ShardLayout.h"
 
 namespace travel_planner {
 
     class ExpenseManager {
     public:
-        // Constructor with optional path parameter
-        ExpenseManager(const std::string& storage_path = "data/expenses.json");
+        // Constructor with optional path parameter. Expenses are sharded per
+        // itinerary under the directory named after the store file (e.g.
+        // "data/expenses/"); an existing single-file store is migrated once.
+        // When use_journal is set, adds and removes are appended to
+        // "<shard>.journal" instead of rewriting the shard on every change.
+        // A ".col" storage path stores the shards as memory-mapped columnar
+        // files (see ExpenseColumnStore), ".cbor" and ".msgpack" as binary
+        // record arrays; shards in another format are converted on first use.
+        ExpenseManager(const std::string& storage_path = "data/expenses.json", bool use_journal = true);
 
-        // Load all expenses from storage
+        // Load all expenses from storage (every shard, journals replayed on top)
         std::vector<Expense> loadAll();
 
-        // Save expenses to storage
+        // Load all expenses into a memory resource, usually the command's
+        // arena (currentArena()), for read-only use
+        std::pmr::vector<pmr::Expense> loadAll(std::pmr::memory_resource* resource);
+
+        // Save expenses to storage, replacing all shards and clearing the journals
         bool saveAll(const std::vector<Expense>& expenses);
 
-        // Add a new expense
+        // Fold every shard's journal back into its snapshot
+        bool compact();
+
+        // Journal size in bytes after which an append triggers a compaction of that shard
+        void setCompactionThreshold(std::uintmax_t bytes);
+
+        // Indentation of JSON snapshots; 0 writes compact JSON
+        void setJsonIndent(int indent);
+
+        // Add a new expense; the date must be a valid YYYY-MM-DD date
         bool addExpense(
             const std::string& itinerary_id,
             double amount,
@@ -31,14 +62,125 @@ namespace travel_planner {
         // Get all expenses for a specific itinerary
         std::vector<Expense> listExpenses(const std::string& itinerary_id);
 
+        // Get all expenses for a specific itinerary, allocated from a memory resource
+        std::pmr::vector<pmr::Expense> listExpenses(const std::string& itinerary_id,
+            std::pmr::memory_resource* resource);
+
+        // Get the expenses of an itinerary dated from..to (inclusive), by
+        // date, found through the shard's date index ("<shard>.dates")
+        std::vector<Expense> listExpenses(const std::string& itinerary_id, Date from, Date to);
+
+        // Visit the expenses of an itinerary without materializing them.
+        // Columnar shards are scanned straight off the mapping.
+        void forEachExpense(const std::string& itinerary_id,
+            const std::function<void(const ExpenseView&)>& visitor);
+
         // Generate category-wise expense summary for an itinerary
         std::map<std::string, double> summary(const std::string& itinerary_id);
 
+        // Pre-aggregated totals of an itinerary (see ExpenseRollup), read
+        // from "<shard>.rollup" and rebuilt from the shard when out of date
+        ExpenseRollup rollup(const std::string& itinerary_id);
+
         // Remove an expense by ID
         bool removeExpense(const std::string& expense_id);
 
     private:
-        std::string data_file_path;
+        // Net effect of a shard's journal on its snapshot
+        struct JournalDelta {
+            std::vector<Expense> added;             // In journal order
+            std::unordered_set<std::string> added_ids;
+            std::unordered_set<std::string> removed;
+        };
+
+        // A parsed journal as of the stamp its file had
+        struct CachedJournal {
+            FileStamp stamp;
+            JournalDelta delta;
+        };
+
+        // Parsed journals kept between commands while the record cache is
+        // enabled, by cacheKey() of the journal
+        static std::unordered_map<std::string, CachedJournal>& journalCache();
+
+        // Apply one journal record to a delta
+        static void applyJournalRecord(JournalDelta& delta, const nlohmann::json& record);
+
+        // Split the legacy single-file store into shards and convert shards
+        // stored in another format (one-time)
+        void migrateIfNeeded();
+
+        // Load one snapshot file (JSON or columnar, by extension). loaded,
+        // if given, is set to false when the file exists but did not read,
+        // so what came back is not the whole snapshot.
+        std::vector<Expense> loadSnapshot(const std::string& shard_path, bool* loaded = nullptr);
+
+        // Read a shard's journal
+        JournalDelta readJournal(const std::string& shard_path);
+
+        // Load one snapshot file with its journal replayed on top; loaded
+        // as for loadSnapshot()
+        std::vector<Expense> loadShard(const std::string& shard_path, bool* loaded = nullptr);
+
+        // Stream one shard (snapshot plus journal) to a visitor; returns
+        // false if the visitor stopped early
+        bool scanShard(const std::string& shard_path,
+            const std::function<bool(const ExpenseView&)>& visitor);
+
+        // Replace one snapshot file and clear its journal
+        bool saveShard(const std::string& shard_path, const std::vector<Expense>& expenses);
+
+        // Append a single JSON record line to a shard's journal
+        bool appendJournal(const std::string& shard_path, const nlohmann::json& record);
+
+        // Compact a shard if its journal has grown past the threshold.
+        // Returns false if the snapshot did not load or could not be
+        // saved; the journal is then kept.
+        bool compactIfNeeded(const std::string& shard_path);
+
+        // Fold a shard's journal into its snapshot, unless the snapshot
+        // did not load
+        bool compactShard(const std::string& shard_path);
+
+        // Apply one change to a shard's rollup. The rollup must match the
+        // shard files as they were before the change (snapshot_before,
+        // journal_before); otherwise it is left to be rebuilt on next use.
+        // A change that returns false discards the rollup.
+        void updateRollup(const std::string& shard_path, const FileStamp& snapshot_before,
+            const FileStamp& journal_before, const std::function<bool(ExpenseRollup&)>& change);
+
+        // Apply one change to a shard's date index, like updateRollup()
+        void updateDateIndex(const std::string& shard_path, const FileStamp& snapshot_before,
+            const FileStamp& journal_before, const std::function<bool(DateIndex&)>& change);
+
+        // Read a shard's date index, rebuilding it when out of date
+        DateIndex loadDateIndex(const std::string& shard_path);
+
+        // Remove a shard's journal, rollup and date index along with it
+        static void removeShardFiles(const std::string& shard_path);
+
+        // Open the expense ID index, rebuilding it if it is missing or out
+        // of date; returns false if no index is available
+        bool ensureIndex();
+
+        // Rebuild the expense ID index from the snapshots and their journals
+        bool rebuildIndex();
+
+        // Files the index covers: every snapshot plus the live journals
+        std::vector<std::string> indexedFiles() const;
+
+        // Read the expense at an indexed location (snapshot record,
+        // columnar row or journal line)
+        bool readIndexed(const RecordLocation& location, Expense& expense) const;
+
+        ShardLayout layout;
+        bool columnar;
+        bool migration_checked;
+        bool journal_enabled;
+        std::uintmax_t compaction_threshold;
+        int json_indent;
+        RecordIndex index;  // Expense ID -> snapshot position or journal line ("<dir>/.index")
+        bool index_checked;
     };
 
 } // namespace travel_planner
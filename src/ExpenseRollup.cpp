@@ -0,0 +1,199 @@
+#include "ExpenseRollup.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "MoneyKernels.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        std::string_view monthOf(std::string_view date) {
+            return date.substr(0, 7);
+        }
+
+        void addTo(ExpenseRollup::Groups& groups, std::string_view key, Money amount) {
+            auto it = groups.find(key);
+            if (it == groups.end()) {
+                it = groups.emplace(std::string(key), RollupStats()).first;
+            }
+            it->second.add(amount);
+        }
+
+        bool removeFrom(ExpenseRollup::Groups& groups, std::string_view key, Money amount) {
+            auto it = groups.find(key);
+            if (it == groups.end()) {
+                return false;
+            }
+            bool exact = it->second.remove(amount);
+            if (it->second.count == 0) {
+                groups.erase(it);
+            }
+            return exact;
+        }
+
+        nlohmann::json statsToJson(const RollupStats& stats) {
+            return {
+                {"sum_cents", stats.sum.cents()}, {"count", stats.count},
+                {"min_cents", stats.min.cents()}, {"max_cents", stats.max.cents()}
+            };
+        }
+
+        RollupStats statsFromJson(const nlohmann::json& j) {
+            RollupStats stats;
+            // Rollups written before amounts were kept in cents lack these
+            // keys; they fail to load and are rebuilt
+            stats.sum = Money(j.at("sum_cents").get<std::int64_t>());
+            j.at("count").get_to(stats.count);
+            stats.min = Money(j.at("min_cents").get<std::int64_t>());
+            stats.max = Money(j.at("max_cents").get<std::int64_t>());
+            return stats;
+        }
+
+        nlohmann::json groupsToJson(const ExpenseRollup::Groups& groups) {
+            nlohmann::json j = nlohmann::json::object();
+            for (const auto& [key, stats] : groups) {
+                j[key] = statsToJson(stats);
+            }
+            return j;
+        }
+
+        void groupsFromJson(const nlohmann::json& j, ExpenseRollup::Groups& groups) {
+            for (const auto& [key, stats] : j.items()) {
+                groups.emplace(key, statsFromJson(stats));
+            }
+        }
+
+        RollupStats fromKernel(const MoneyStats& stats) {
+            if (stats.count == 0) {
+                return RollupStats();
+            }
+            return { Money(stats.sum), stats.count, Money(stats.min), Money(stats.max) };
+        }
+
+        void fillGroups(ExpenseRollup::Groups& groups, const std::vector<std::int64_t>& cents,
+            const std::vector<std::uint32_t>& codes, const StringDictionary& names) {
+            std::vector<MoneyStats> stats(names.size());
+            moneyStatsByCode(cents.data(), codes.data(), cents.size(), stats);
+            for (std::size_t code = 0; code < stats.size(); ++code) {
+                groups.emplace(std::string(names.name(static_cast<Symbol>(code))), fromKernel(stats[code]));
+            }
+        }
+
+        nlohmann::json stampToJson(const FileStamp& stamp) {
+            return { {"size", stamp.size}, {"mtime", stamp.mtime} };
+        }
+
+        bool stampMatches(const nlohmann::json& j, const FileStamp& stamp) {
+            return j.at("size").get<std::uint64_t>() == stamp.size && j.at("mtime").get<std::int64_t>() == stamp.mtime;
+        }
+
+    } // namespace
+
+    void RollupStats::add(Money amount) {
+        min = count == 0 ? amount : std::min(min, amount);
+        max = count == 0 ? amount : std::max(max, amount);
+        sum += amount;
+        ++count;
+    }
+
+    bool RollupStats::remove(Money amount) {
+        if (count <= 1) {
+            *this = RollupStats();
+            return true;
+        }
+        sum -= amount;
+        --count;
+        return amount > min && amount < max;
+    }
+
+    void ExpenseRollup::add(const ExpenseView& expense) {
+        const Money amount = Money::fromAmount(expense.amount);
+        total_.add(amount);
+        addTo(categories_, expense.category, amount);
+        addTo(days_, expense.date, amount);
+        addTo(months_, monthOf(expense.date), amount);
+    }
+
+    bool ExpenseRollup::remove(const ExpenseView& expense) {
+        // Every group is updated even after one turns inexact
+        const Money amount = Money::fromAmount(expense.amount);
+        bool exact = total_.remove(amount);
+        exact = removeFrom(categories_, expense.category, amount) && exact;
+        exact = removeFrom(days_, expense.date, amount) && exact;
+        exact = removeFrom(months_, monthOf(expense.date), amount) && exact;
+        return exact;
+    }
+
+    void ExpenseRollup::Builder::add(const ExpenseView& expense) {
+        amounts_.push_back(expense.amount);
+        categories_.push_back(category_names_.intern(expense.category));
+        days_.push_back(day_names_.intern(expense.date));
+        months_.push_back(month_names_.intern(monthOf(expense.date)));
+    }
+
+    ExpenseRollup ExpenseRollup::Builder::finish() const {
+        std::vector<std::int64_t> cents(amounts_.size());
+        amountsToCents(amounts_.data(), amounts_.size(), cents.data());
+
+        ExpenseRollup rollup;
+        rollup.total_ = fromKernel(moneyStats(cents.data(), cents.size()));
+        fillGroups(rollup.categories_, cents, categories_, category_names_);
+        fillGroups(rollup.days_, cents, days_, day_names_);
+        fillGroups(rollup.months_, cents, months_, month_names_);
+        return rollup;
+    }
+
+    bool ExpenseRollup::load(const std::string& path, const FileStamp& snapshot, const FileStamp& journal) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        try {
+            nlohmann::json j = nlohmann::json::parse(file);
+            if (!stampMatches(j.at("snapshot"), snapshot) || !stampMatches(j.at("journal"), journal)) {
+                return false;  // Written for other contents of the shard
+            }
+            *this = ExpenseRollup();
+            total_ = statsFromJson(j.at("total"));
+            groupsFromJson(j.at("categories"), categories_);
+            groupsFromJson(j.at("days"), days_);
+            groupsFromJson(j.at("months"), months_);
+            return true;
+        }
+        catch (const std::exception&) {
+            return false;  // Rebuilt by the caller
+        }
+    }
+
+    bool ExpenseRollup::save(const std::string& path, const FileStamp& snapshot, const FileStamp& journal) const {
+        nlohmann::json j = {
+            {"snapshot", stampToJson(snapshot)},
+            {"journal", stampToJson(journal)},
+            {"total", statsToJson(total_)},
+            {"categories", groupsToJson(categories_)},
+            {"days", groupsToJson(days_)},
+            {"months", groupsToJson(months_)}
+        };
+
+        // Replace atomically so a reader never sees half a rollup
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Warning: Could not write expense rollup " << path << std::endl;
+                return false;
+            }
+            file << j.dump();
+            if (!file) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        return !ec;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,117 @@
+#ifndef TRAVEL_PLANNER_EXPENSE_ROLLUP_H
+#define TRAVEL_PLANNER_EXPENSE_ROLLUP_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/Expense.h"
+#include "../include/Money.h"
+#include "RecordCache.h"
+#include "StringDictionary.h"
+
+namespace travel_planner {
+
+    /**
+     * Sum, count, min and max of a group of expense amounts, in cents
+     */
+    struct RollupStats {
+        Money sum;
+        std::uint64_t count = 0;
+        Money min;
+        Money max;
+
+        void add(Money amount);
+
+        /**
+         * Takes an amount back out of the group
+         * @return False if the amount was the group's min or max, which
+         *         leaves them unknown until the group is rebuilt
+         */
+        bool remove(Money amount);
+    };
+
+    /**
+     * Pre-aggregated totals of one expense shard (one itinerary): overall
+     * and by category, by day (the date as stored) and by month (its
+     * first seven characters, YYYY-MM). Persisted as "<shard>.rollup" and
+     * tagged with the stamps of the snapshot and journal it reflects, so a
+     * rollup that missed a change is detected and rebuilt.
+     */
+    class ExpenseRollup {
+    public:
+        using Groups = std::map<std::string, RollupStats, std::less<>>;
+
+        class Builder;
+
+        /**
+         * @return Rollup file of a shard
+         */
+        static std::string pathFor(const std::string& shard_path) { return shard_path + ".rollup"; }
+
+        void add(const ExpenseView& expense);
+
+        /**
+         * @return False if min/max of an affected group became unknown;
+         *         the rollup should then be rebuilt from the shard
+         */
+        bool remove(const ExpenseView& expense);
+
+        const RollupStats& total() const { return total_; }
+        const Groups& categories() const { return categories_; }
+        const Groups& days() const { return days_; }
+        const Groups& months() const { return months_; }
+
+        /**
+         * Reads a rollup file
+         * @param path Rollup file
+         * @param snapshot Current stamp of the shard snapshot
+         * @param journal Current stamp of the shard journal
+         * @return False if the file is missing, unreadable or was written
+         *         for other versions of the shard files
+         */
+        bool load(const std::string& path, const FileStamp& snapshot, const FileStamp& journal);
+
+        /**
+         * Writes the rollup, tagged with the stamps of the shard files it
+         * reflects
+         * @return True on success
+         */
+        bool save(const std::string& path, const FileStamp& snapshot, const FileStamp& journal) const;
+
+    private:
+        RollupStats total_;
+        Groups categories_;
+        Groups days_;
+        Groups months_;
+    };
+
+    /**
+     * Builds a rollup from a whole shard at once: amounts and group codes
+     * are collected into columns and aggregated with the vectorized kernels
+     * of MoneyKernels.h, instead of updating four maps per expense.
+     */
+    class ExpenseRollup::Builder {
+    public:
+        void add(const ExpenseView& expense);
+
+        /**
+         * @return Rollup of the expenses added so far
+         */
+        ExpenseRollup finish() const;
+
+    private:
+        std::vector<double> amounts_;
+        std::vector<std::uint32_t> categories_;
+        std::vector<std::uint32_t> days_;
+        std::vector<std::uint32_t> months_;
+        StringDictionary category_names_;
+        StringDictionary day_names_;
+        StringDictionary month_names_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_EXPENSE_ROLLUP_H
@@ -1,10 +1,14 @@
 #include "ExportManager.h"
 #include "PackingManager.h"
+#include "Profiler.h"
+#include "StorageConfig.h"
+#include "Trace.h"
 #include <iostream>
 #include <filesystem>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
 
 namespace fs = std::filesystem;
 namespace travel_planner {
@@ -19,14 +23,11 @@ namespace travel_planner {
     }
 
     bool ExportManager::exportItineraryMarkdown(const std::string& id, const std::string& path) {
+        TraceSpan span("ExportManager::exportItineraryMarkdown", id);
         // Find the itinerary by ID
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&id](const Itinerary& itin) { return itin.id == id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(id, itinerary)) {
             std::cerr << "Itinerary with ID '" << id << "' not found." << std::endl;
             return false;
         }
@@ -38,9 +39,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_itinerary.md";
+        std::string filename = getSafeFilename(itinerary.name) + "_itinerary.md";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -48,27 +51,27 @@ namespace travel_planner {
         }
 
         // Write itinerary in Markdown format
-        outFile << "# " << it->name << std::endl << std::endl;
-        outFile << "**Itinerary ID:** " << it->id << std::endl;
-        outFile << "**Start Date:** " << it->start_date << std::endl;
-        outFile << "**End Date:** " << it->end_date << std::endl << std::endl;
+        outFile << "# " << itinerary.name << std::endl << std::endl;
+        outFile << "**Itinerary ID:** " << itinerary.id << std::endl;
+        outFile << "**Start Date:** " << itinerary.start_date << std::endl;
+        outFile << "**End Date:** " << itinerary.end_date << std::endl << std::endl;
         outFile << "## Description" << std::endl << std::endl;
-        outFile << it->description << std::endl;
+        outFile << itinerary.description << std::endl;
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Itinerary exported to " << filepath << std::endl;
         return true;
     }
 
     bool ExportManager::exportItineraryCSV(const std::string& id, const std::string& path) {
+        TraceSpan span("ExportManager::exportItineraryCSV", id);
         // Find the itinerary by ID
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&id](const Itinerary& itin) { return itin.id == id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(id, itinerary)) {
             std::cerr << "Itinerary with ID '" << id << "' not found." << std::endl;
             return false;
         }
@@ -80,9 +83,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_itinerary.csv";
+        std::string filename = getSafeFilename(itinerary.name) + "_itinerary.csv";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -91,41 +96,33 @@ namespace travel_planner {
 
         // Write itinerary in CSV format
         outFile << "Item,Value" << std::endl;
-        outFile << "ID," << quoteField(it->id) << std::endl;
-        outFile << "Name," << quoteField(it->name) << std::endl;
-        outFile << "Start Date," << quoteField(it->start_date) << std::endl;
-        outFile << "End Date," << quoteField(it->end_date) << std::endl;
-        outFile << "Description," << quoteField(it->description) << std::endl;
+        outFile << "ID," << quoteField(itinerary.id) << std::endl;
+        outFile << "Name," << quoteField(itinerary.name) << std::endl;
+        outFile << "Start Date," << quoteField(itinerary.start_date) << std::endl;
+        outFile << "End Date," << quoteField(itinerary.end_date) << std::endl;
+        outFile << "Description," << quoteField(itinerary.description) << std::endl;
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Itinerary exported to " << filepath << std::endl;
         return true;
     }
 
     bool ExportManager::exportPackingMarkdown(const std::string& itin_id, const std::string& path) {
+        TraceSpan span("ExportManager::exportPackingMarkdown", itin_id);
         // Find the itinerary by ID (for name)
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&itin_id](const Itinerary& itin) { return itin.id == itin_id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(itin_id, itinerary)) {
             std::cerr << "Itinerary with ID '" << itin_id << "' not found." << std::endl;
             return false;
         }
 
-        // Get packing items for the itinerary
-        PackingManager packingManager;
-        auto allItems = packingManager.loadAll();
-
-        // Filter items for the specific itinerary
-        std::vector<PackingItem> packingItems;
-        for (const auto& item : allItems) {
-            if (item.itinerary_id == itin_id) {
-                packingItems.push_back(item);
-            }
-        }
+        // Get packing items for the itinerary (same store as the packing commands)
+        PackingManager packingManager(packingStorePath());
+        std::vector<PackingItem> packingItems = packingManager.listItems(itin_id);
 
         // Create export directory if needed
         std::string exportDir = path.empty() ? "exports" : path;
@@ -134,9 +131,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_packing.md";
+        std::string filename = getSafeFilename(itinerary.name) + "_packing.md";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -144,7 +143,7 @@ namespace travel_planner {
         }
 
         // Write packing list in Markdown format
-        outFile << "# Packing List for " << it->name << std::endl << std::endl;
+        outFile << "# Packing List for " << itinerary.name << std::endl << std::endl;
 
         if (packingItems.empty()) {
             outFile << "No packing items found for this itinerary." << std::endl;
@@ -195,35 +194,27 @@ namespace travel_planner {
             outFile << "**Progress:** " << (packingItems.empty() ? 0 : (packedItems.size() * 100 / packingItems.size())) << "%" << std::endl;
         }
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Packing list exported to " << filepath << std::endl;
         return true;
     }
 
     bool ExportManager::exportPackingCSV(const std::string& itin_id, const std::string& path) {
+        TraceSpan span("ExportManager::exportPackingCSV", itin_id);
         // Find the itinerary by ID (for name)
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&itin_id](const Itinerary& itin) { return itin.id == itin_id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(itin_id, itinerary)) {
             std::cerr << "Itinerary with ID '" << itin_id << "' not found." << std::endl;
             return false;
         }
 
-        // Get packing items for the itinerary
-        PackingManager packingManager;
-        auto allItems = packingManager.loadAll();
-
-        // Filter items for the specific itinerary
-        std::vector<PackingItem> packingItems;
-        for (const auto& item : allItems) {
-            if (item.itinerary_id == itin_id) {
-                packingItems.push_back(item);
-            }
-        }
+        // Get packing items for the itinerary (same store as the packing commands)
+        PackingManager packingManager(packingStorePath());
+        std::vector<PackingItem> packingItems = packingManager.listItems(itin_id);
 
         // Create export directory if needed
         std::string exportDir = path.empty() ? "exports" : path;
@@ -232,9 +223,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_packing.csv";
+        std::string filename = getSafeFilename(itinerary.name) + "_packing.csv";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -251,27 +244,28 @@ namespace travel_planner {
                 << (item.packed ? "Yes" : "No") << std::endl;
         }
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Packing list exported to " << filepath << std::endl;
         return true;
     }
 
     bool ExportManager::exportExpenseMarkdown(const std::string& itin_id, const std::string& path) {
+        TraceSpan span("ExportManager::exportExpenseMarkdown", itin_id);
         // Find the itinerary by ID
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&itin_id](const Itinerary& itin) { return itin.id == itin_id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(itin_id, itinerary)) {
             std::cerr << "Itinerary with ID '" << itin_id << "' not found." << std::endl;
             return false;
         }
 
-        // Get expenses
-        ExpenseManager expenseManager;
+        // Get expenses, with their totals pre-aggregated
+        ExpenseManager expenseManager(expenseStorePath());
         auto expenses = expenseManager.listExpenses(itin_id);
+        ExpenseRollup rollup = expenseManager.rollup(itin_id);
 
         // Create export directory if needed
         std::string exportDir = path.empty() ? "exports" : path;
@@ -280,9 +274,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_expenses.md";
+        std::string filename = getSafeFilename(itinerary.name) + "_expenses.md";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -290,65 +286,67 @@ namespace travel_planner {
         }
 
         // Write expenses in Markdown format
-        outFile << "# Expenses for " << it->name << std::endl << std::endl;
+        outFile << "# Expenses for " << itinerary.name << std::endl << std::endl;
 
         if (expenses.empty()) {
             outFile << "No expenses recorded for this itinerary." << std::endl;
         }
         else {
-            // Group expenses by category
-            std::map<std::string, std::vector<Expense>> categorizedExpenses;
-            double totalAmount = 0.0;
-
+            // Group expenses by category, sections in name order
+            std::unordered_map<std::string_view, std::vector<const Expense*>> categorizedExpenses;
             for (const auto& expense : expenses) {
-                categorizedExpenses[expense.category].push_back(expense);
-                totalAmount += expense.amount;
+                categorizedExpenses[expense.category].push_back(&expense);
+            }
+            std::vector<std::string_view> sections;
+            sections.reserve(categorizedExpenses.size());
+            for (const auto& entry : categorizedExpenses) {
+                sections.push_back(entry.first);
             }
+            std::sort(sections.begin(), sections.end());
 
-            for (const auto& [category, catExpenses] : categorizedExpenses) {
-                double categoryTotal = 0.0;
-                for (const auto& expense : catExpenses) {
-                    categoryTotal += expense.amount;
-                }
+            for (std::string_view category : sections) {
+                const std::vector<const Expense*>& catExpenses = categorizedExpenses[category];
+                auto stats = rollup.categories().find(category);
+                Money categoryTotal = stats != rollup.categories().end() ? stats->second.sum : Money();
 
-                outFile << "## " << category << " ($" << std::fixed << std::setprecision(2) << categoryTotal << ")" << std::endl << std::endl;
+                outFile << "## " << category << " ($" << categoryTotal << ")" << std::endl << std::endl;
 
                 outFile << "| Date | Description | Amount |" << std::endl;
                 outFile << "|------|-------------|--------|" << std::endl;
 
-                for (const auto& expense : catExpenses) {
-                    outFile << "| " << expense.date << " | " << expense.description
-                        << " | $" << std::fixed << std::setprecision(2) << expense.amount << " |" << std::endl;
+                for (const Expense* expense : catExpenses) {
+                    outFile << "| " << expense->date << " | " << expense->description
+                        << " | $" << std::fixed << std::setprecision(2) << expense->amount << " |" << std::endl;
                 }
 
                 outFile << std::endl;
             }
 
             outFile << "## Summary" << std::endl << std::endl;
-            outFile << "**Total Expenses:** $" << std::fixed << std::setprecision(2) << totalAmount << std::endl;
+            outFile << "**Total Expenses:** $" << rollup.total().sum << std::endl;
             outFile << "**Number of Expenses:** " << expenses.size() << std::endl;
         }
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Expenses exported to " << filepath << std::endl;
         return true;
     }
 
     bool ExportManager::exportExpenseCSV(const std::string& itin_id, const std::string& path) {
+        TraceSpan span("ExportManager::exportExpenseCSV", itin_id);
         // Find the itinerary by ID
-        StorageManager storageManager("data/itineraries.json");
-        auto itineraries = storageManager.loadAll();
-
-        auto it = std::find_if(itineraries.begin(), itineraries.end(),
-            [&itin_id](const Itinerary& itin) { return itin.id == itin_id; });
-
-        if (it == itineraries.end()) {
+        StorageManager storageManager(itineraryStorePath());
+        Itinerary itinerary;
+        if (!storageManager.find(itin_id, itinerary)) {
             std::cerr << "Itinerary with ID '" << itin_id << "' not found." << std::endl;
             return false;
         }
 
         // Get expenses
-        ExpenseManager expenseManager;
+        ExpenseManager expenseManager(expenseStorePath());
         auto expenses = expenseManager.listExpenses(itin_id);
 
         // Create export directory if needed
@@ -358,9 +356,11 @@ namespace travel_planner {
         }
 
         // Open output file
-        std::string filename = getSafeFilename(it->name) + "_expenses.csv";
+        std::string filename = getSafeFilename(itinerary.name) + "_expenses.csv";
         std::string filepath = exportDir + "/" + filename;
 
+        TraceSpan write_span("ExportManager::write", filepath);
+        ProfileScope serialize(ProfilePhase::Serialize);
         std::ofstream outFile(filepath);
         if (!outFile) {
             std::cerr << "Failed to create output file: " << filepath << std::endl;
@@ -378,7 +378,10 @@ namespace travel_planner {
                 << quoteField(expense.description) << std::endl;
         }
 
-        outFile.close();
+        {
+            ProfileScope write(ProfilePhase::Write);
+            outFile.close();
+        }
         std::cout << "Expenses exported to " << filepath << std::endl;
         return true;
     }
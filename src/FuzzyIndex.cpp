@@ -0,0 +1,329 @@
+#include "FuzzyIndex.h"
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[4] = { 'T', 'P', 'B', 'K' };
+        const std::uint32_t kVersion = 1;
+
+        std::string lowerAscii(std::string_view text) {
+            std::string lowered(text);
+            for (char& c : lowered) {
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c + ('a' - 'A'));
+                }
+            }
+            return lowered;
+        }
+
+        std::uint64_t align8(std::uint64_t offset) {
+            return (offset + 7) & ~std::uint64_t(7);
+        }
+
+    } // namespace
+
+    std::size_t editDistance(std::string_view a, std::string_view b) {
+        // One row of the distance table at a time, over the shorter string
+        if (a.size() < b.size()) {
+            std::swap(a, b);
+        }
+        std::size_t buffer[64];
+        std::vector<std::size_t> heap;
+        std::size_t* row = buffer;
+        if (b.size() + 1 > sizeof(buffer) / sizeof(buffer[0])) {
+            heap.resize(b.size() + 1);
+            row = heap.data();
+        }
+        for (std::size_t j = 0; j <= b.size(); ++j) {
+            row[j] = j;
+        }
+        for (std::size_t i = 1; i <= a.size(); ++i) {
+            std::size_t diagonal = row[0];
+            row[0] = i;
+            for (std::size_t j = 1; j <= b.size(); ++j) {
+                const std::size_t above = row[j];
+                row[j] = std::min({ above + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1) });
+                diagonal = above;
+            }
+        }
+        return row[b.size()];
+    }
+
+    struct FuzzyIndex::Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t source_size;
+        std::int64_t source_mtime;
+        std::uint32_t doc_count;
+        std::uint32_t node_count;
+        std::uint32_t edge_count;
+        std::uint32_t posting_count;
+        std::uint64_t docs_offset;      // DocEntry[doc_count]
+        std::uint64_t nodes_offset;     // NodeEntry[node_count], the root first
+        std::uint64_t edges_offset;     // EdgeEntry[edge_count], by node then distance
+        std::uint64_t postings_offset;  // uint32 document numbers[posting_count]
+        std::uint64_t strings_offset;   // IDs, names and terms
+        std::uint64_t strings_size;
+    };
+
+    struct FuzzyIndex::DocEntry {
+        std::uint32_t id_offset;
+        std::uint32_t id_length;
+        std::uint32_t name_offset;
+        std::uint32_t name_length;
+    };
+
+    struct FuzzyIndex::NodeEntry {
+        std::uint32_t term_offset;
+        std::uint32_t term_length;
+        std::uint32_t edges;          // First edge
+        std::uint32_t edge_count;
+        std::uint32_t postings;       // First document number
+        std::uint32_t posting_count;
+    };
+
+    struct FuzzyIndex::EdgeEntry {
+        std::uint32_t distance;       // Between the node's term and the child's
+        std::uint32_t child;          // Always after the node, so the tree has no cycles
+    };
+
+    const FuzzyIndex::Header* FuzzyIndex::header() const {
+        return reinterpret_cast<const Header*>(image_.data());
+    }
+
+    std::string_view FuzzyIndex::text(std::uint32_t offset, std::uint32_t length) const {
+        if (std::uint64_t(offset) + length > header()->strings_size) {
+            return {};  // Corrupt entry
+        }
+        return std::string_view(image_.data() + header()->strings_offset + offset, length);
+    }
+
+    bool FuzzyIndex::validate() const {
+        if (image_.size() < sizeof(Header)) {
+            return false;
+        }
+        const Header* h = header();
+        if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion) {
+            return false;
+        }
+        return h->docs_offset + std::uint64_t(h->doc_count) * sizeof(DocEntry) <= h->nodes_offset
+            && h->nodes_offset + std::uint64_t(h->node_count) * sizeof(NodeEntry) <= h->edges_offset
+            && h->edges_offset + std::uint64_t(h->edge_count) * sizeof(EdgeEntry) <= h->postings_offset
+            && h->postings_offset + std::uint64_t(h->posting_count) * sizeof(std::uint32_t) <= h->strings_offset
+            && h->strings_offset + h->strings_size <= image_.size()
+            && h->docs_offset % 8 == 0 && h->nodes_offset % 8 == 0 && h->edges_offset % 8 == 0
+            && h->postings_offset % 8 == 0;
+    }
+
+    bool FuzzyIndex::open(const std::string& path, const FileStamp& source) {
+        return image_.open(path, [this, &source]() {
+            return validate() && header()->source_size == source.size && header()->source_mtime == source.mtime;
+        });
+    }
+
+    void FuzzyIndex::assign(std::string bytes) {
+        image_.assign(std::move(bytes), [this]() { return validate(); });
+    }
+
+    std::size_t FuzzyIndex::terms() const {
+        return image_.data() ? header()->node_count : 0;
+    }
+
+    std::vector<FuzzyIndex::Match> FuzzyIndex::search(std::string_view query, std::uint32_t max_distance,
+        std::size_t* compared) const {
+        std::vector<Match> matches;
+        if (compared) {
+            *compared = 0;
+        }
+        if (!image_.data() || header()->node_count == 0) {
+            return matches;
+        }
+        const Header* h = header();
+        const DocEntry* docs = reinterpret_cast<const DocEntry*>(image_.data() + h->docs_offset);
+        const NodeEntry* nodes = reinterpret_cast<const NodeEntry*>(image_.data() + h->nodes_offset);
+        const EdgeEntry* edges = reinterpret_cast<const EdgeEntry*>(image_.data() + h->edges_offset);
+        const std::uint32_t* postings = reinterpret_cast<const std::uint32_t*>(image_.data() + h->postings_offset);
+        const std::string lowered = lowerAscii(query);
+
+        // Closest term of each document reached
+        std::unordered_map<std::uint32_t, Match> best;
+        std::vector<std::uint32_t> pending = { 0 };
+        while (!pending.empty()) {
+            const std::uint32_t node_number = pending.back();
+            pending.pop_back();
+            const NodeEntry& node = nodes[node_number];
+            if (std::uint64_t(node.edges) + node.edge_count > h->edge_count
+                || std::uint64_t(node.postings) + node.posting_count > h->posting_count) {
+                continue;  // Corrupt entry
+            }
+            const std::string_view term = text(node.term_offset, node.term_length);
+            const std::uint32_t distance = static_cast<std::uint32_t>(editDistance(lowered, term));
+            if (compared) {
+                ++*compared;
+            }
+
+            if (distance <= max_distance) {
+                for (std::uint32_t i = 0; i < node.posting_count; ++i) {
+                    const std::uint32_t doc = postings[node.postings + i];
+                    if (doc >= h->doc_count) {
+                        continue;
+                    }
+                    auto it = best.find(doc);
+                    if (it == best.end() || distance < it->second.distance) {
+                        const DocEntry& entry = docs[doc];
+                        best[doc] = { text(entry.id_offset, entry.id_length),
+                            text(entry.name_offset, entry.name_length), term, distance };
+                    }
+                }
+            }
+
+            // Only children keyed distance - max to distance + max can hold
+            // a term within max of the query
+            const EdgeEntry* first = edges + node.edges;
+            const EdgeEntry* last = first + node.edge_count;
+            const std::uint32_t low = distance > max_distance ? distance - max_distance : 0;
+            const std::uint32_t high = distance + max_distance;
+            auto it = std::lower_bound(first, last, low, [](const EdgeEntry& edge, std::uint32_t value) {
+                return edge.distance < value;
+            });
+            for (; it != last && it->distance <= high; ++it) {
+                if (it->child > node_number && it->child < h->node_count) {
+                    pending.push_back(it->child);
+                }
+            }
+        }
+
+        std::vector<std::pair<std::uint32_t, Match>> ranked(best.begin(), best.end());
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.second.distance != b.second.distance ? a.second.distance < b.second.distance : a.first < b.first;
+        });
+        matches.reserve(ranked.size());
+        for (const auto& entry : ranked) {
+            matches.push_back(entry.second);
+        }
+        return matches;
+    }
+
+    void FuzzyIndex::Builder::add(std::string_view id, std::string_view name, const std::vector<std::string>& tags) {
+        const std::uint32_t doc = static_cast<std::uint32_t>(ids_.size());
+        ids_.emplace_back(id);
+        names_.emplace_back(name);
+
+        std::vector<std::string> terms = searchTerms(name);
+        terms.push_back(lowerAscii(name));
+        for (const auto& tag : tags) {
+            terms.push_back(lowerAscii(tag));
+        }
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+        for (const auto& term : terms) {
+            if (!term.empty()) {
+                addTerm(term, doc);
+            }
+        }
+    }
+
+    void FuzzyIndex::Builder::addTerm(const std::string& term, std::uint32_t doc) {
+        auto known = terms_.find(term);
+        if (known != terms_.end()) {
+            nodes_[known->second].docs.push_back(doc);
+            return;
+        }
+
+        const std::uint32_t added = static_cast<std::uint32_t>(nodes_.size());
+        if (!nodes_.empty()) {
+            // Walk down the edges keyed by the distance to each node's term
+            // until the node has no child at that distance
+            std::uint32_t node = 0;
+            for (;;) {
+                const std::uint32_t distance = static_cast<std::uint32_t>(editDistance(term, nodes_[node].term));
+                auto& children = nodes_[node].children;
+                auto child = std::find_if(children.begin(), children.end(), [distance](const auto& edge) {
+                    return edge.first == distance;
+                });
+                if (child == children.end()) {
+                    children.emplace_back(distance, added);
+                    break;
+                }
+                node = child->second;
+            }
+        }
+        nodes_.push_back({ term, {}, { doc } });
+        terms_.emplace(term, added);
+    }
+
+    std::string FuzzyIndex::Builder::finish(const FileStamp& source) const {
+        std::string strings;
+        auto addString = [&strings](const std::string& value, std::uint32_t& offset, std::uint32_t& length) {
+            offset = static_cast<std::uint32_t>(strings.size());
+            length = static_cast<std::uint32_t>(value.size());
+            strings += value;
+        };
+
+        std::vector<DocEntry> doc_entries(ids_.size());
+        for (std::size_t doc = 0; doc < ids_.size(); ++doc) {
+            addString(ids_[doc], doc_entries[doc].id_offset, doc_entries[doc].id_length);
+            addString(names_[doc], doc_entries[doc].name_offset, doc_entries[doc].name_length);
+        }
+
+        std::vector<NodeEntry> node_entries(nodes_.size());
+        std::vector<EdgeEntry> edges;
+        std::vector<std::uint32_t> postings;
+        for (std::size_t i = 0; i < nodes_.size(); ++i) {
+            const Node& node = nodes_[i];
+            NodeEntry& entry = node_entries[i];
+            addString(node.term, entry.term_offset, entry.term_length);
+
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> children = node.children;
+            std::sort(children.begin(), children.end());
+            entry.edges = static_cast<std::uint32_t>(edges.size());
+            entry.edge_count = static_cast<std::uint32_t>(children.size());
+            for (const auto& child : children) {
+                edges.push_back({ child.first, child.second });
+            }
+            entry.postings = static_cast<std::uint32_t>(postings.size());
+            entry.posting_count = static_cast<std::uint32_t>(node.docs.size());
+            postings.insert(postings.end(), node.docs.begin(), node.docs.end());
+        }
+
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+        header.doc_count = static_cast<std::uint32_t>(doc_entries.size());
+        header.node_count = static_cast<std::uint32_t>(node_entries.size());
+        header.edge_count = static_cast<std::uint32_t>(edges.size());
+        header.posting_count = static_cast<std::uint32_t>(postings.size());
+        header.docs_offset = align8(sizeof(Header));
+        header.nodes_offset = align8(header.docs_offset + doc_entries.size() * sizeof(DocEntry));
+        header.edges_offset = align8(header.nodes_offset + node_entries.size() * sizeof(NodeEntry));
+        header.postings_offset = align8(header.edges_offset + edges.size() * sizeof(EdgeEntry));
+        header.strings_offset = header.postings_offset + postings.size() * sizeof(std::uint32_t);
+        header.strings_size = strings.size();
+
+        std::string bytes(header.strings_offset + strings.size(), '\0');
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + header.docs_offset, doc_entries.data(), doc_entries.size() * sizeof(DocEntry));
+        std::memcpy(bytes.data() + header.nodes_offset, node_entries.data(), node_entries.size() * sizeof(NodeEntry));
+        std::memcpy(bytes.data() + header.edges_offset, edges.data(), edges.size() * sizeof(EdgeEntry));
+        std::memcpy(bytes.data() + header.postings_offset, postings.data(), postings.size() * sizeof(std::uint32_t));
+        std::memcpy(bytes.data() + header.strings_offset, strings.data(), strings.size());
+        return bytes;
+    }
+
+    bool FuzzyIndex::Builder::save(const std::string& path, const std::string& bytes) {
+        if (!replaceFile(path, bytes)) {
+            std::cerr << "Warning: Could not write fuzzy index " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,136 @@
+#ifndef TRAVEL_PLANNER_FUZZY_INDEX_H
+#define TRAVEL_PLANNER_FUZZY_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    /**
+     * Levenshtein distance: the fewest single-byte insertions, deletions
+     * and substitutions turning one string into the other
+     */
+    std::size_t editDistance(std::string_view a, std::string_view b);
+
+    /**
+     * Approximate term lookup over documents (itineraries), for mistyped
+     * names. Each document contributes terms: its whole name, the words of
+     * its name and its tags, lowercased. The distinct terms form a BK-tree:
+     * a node's children are keyed by their edit distance to it, and by the
+     * triangle inequality a query within k of the term at distance d can
+     * only be under the children keyed d - k to d + k. A query compares
+     * against a small part of the terms instead of all of them.
+     *
+     * Persisted as one file, memory-mapped when searched and tagged with the
+     * stamp of the store it indexes. Document IDs and names are stored with
+     * the tree, so a search reads no records. The file is written in native
+     * byte order.
+     */
+    class FuzzyIndex {
+    public:
+        /**
+         * Document with a term close to the query; the views are valid
+         * while the index is open
+         */
+        struct Match {
+            std::string_view id;
+            std::string_view name;
+            std::string_view term;      // Closest term of the document
+            std::uint32_t distance = 0; // Its edit distance to the query
+        };
+
+        class Builder;
+
+        /**
+         * Maps an index file
+         * @param path Index file
+         * @param source Current stamp of the indexed store
+         * @return False if the file is missing, unreadable or was built from
+         *         another version of the store
+         */
+        bool open(const std::string& path, const FileStamp& source);
+
+        /**
+         * Uses an index built in memory (see Builder::finish())
+         */
+        void assign(std::string bytes);
+
+        /**
+         * Finds the documents with a term within an edit distance of a query
+         * (compared lowercased)
+         * @param query Term to look up
+         * @param max_distance Largest distance accepted
+         * @param compared If set, receives the number of terms compared
+         * @return Matches, closest first, then in the order the documents
+         *         were added
+         */
+        std::vector<Match> search(std::string_view query, std::uint32_t max_distance,
+            std::size_t* compared = nullptr) const;
+
+        /**
+         * @return Number of distinct terms
+         */
+        std::size_t terms() const;
+
+    private:
+        struct Header;
+        struct DocEntry;
+        struct NodeEntry;
+        struct EdgeEntry;
+
+        bool validate() const;
+        const Header* header() const;
+        std::string_view text(std::uint32_t offset, std::uint32_t length) const;
+
+        IndexImage image_;
+    };
+
+    /**
+     * Collects documents and encodes them into a FuzzyIndex
+     */
+    class FuzzyIndex::Builder {
+    public:
+        /**
+         * Adds a document
+         * @param id Document ID
+         * @param name Name, indexed whole and word by word
+         * @param tags Tags, indexed whole
+         */
+        void add(std::string_view id, std::string_view name, const std::vector<std::string>& tags);
+
+        /**
+         * Encodes the index
+         * @param source Stamp of the store the documents came from
+         * @return Index contents, for FuzzyIndex::assign() or save()
+         */
+        std::string finish(const FileStamp& source) const;
+
+        /**
+         * Writes encoded index contents to a file
+         * @return True on success
+         */
+        static bool save(const std::string& path, const std::string& bytes);
+
+    private:
+        struct Node {
+            std::string term;
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> children;  // Distance, node
+            std::vector<std::uint32_t> docs;
+        };
+
+        void addTerm(const std::string& term, std::uint32_t doc);
+
+        std::vector<std::string> ids_;
+        std::vector<std::string> names_;
+        std::vector<Node> nodes_;                               // nodes_[0] is the root
+        std::unordered_map<std::string, std::uint32_t> terms_;  // Term -> node
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_FUZZY_INDEX_H
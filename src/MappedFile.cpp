@@ -0,0 +1,173 @@
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace travel_planner {
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            open_ = std::exchange(other.open_, false);
+            writable_ = std::exchange(other.writable_, false);
+#ifdef _WIN32
+            file_handle_ = std::exchange(other.file_handle_, nullptr);
+            mapping_handle_ = std::exchange(other.mapping_handle_, nullptr);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool MappedFile::open(const std::string& path, bool writable) {
+        close();
+
+        DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+        HANDLE file = CreateFileA(path.c_str(), access, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size)) {
+            CloseHandle(file);
+            return false;
+        }
+
+        size_ = static_cast<std::size_t>(file_size.QuadPart);
+        open_ = true;
+        if (size_ == 0) {
+            CloseHandle(file);
+            return true;  // Nothing to map
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            CloseHandle(file);
+            open_ = false;
+            size_ = 0;
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            open_ = false;
+            size_ = 0;
+            return false;
+        }
+
+        file_handle_ = file;
+        mapping_handle_ = mapping;
+        data_ = static_cast<unsigned char*>(view);
+        writable_ = writable;
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_handle_ != nullptr) {
+            CloseHandle(mapping_handle_);
+        }
+        if (file_handle_ != nullptr) {
+            CloseHandle(file_handle_);
+        }
+        data_ = nullptr;
+        mapping_handle_ = nullptr;
+        file_handle_ = nullptr;
+        size_ = 0;
+        open_ = false;
+        writable_ = false;
+    }
+#else
+    bool MappedFile::open(const std::string& path, bool writable) {
+        close();
+
+        int fd = ::open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        size_ = static_cast<std::size_t>(st.st_size);
+        open_ = true;
+        if (size_ == 0) {
+            ::close(fd);
+            return true;  // Nothing to map
+        }
+
+        int protection = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* addr = mmap(nullptr, size_, protection, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+        ::close(fd);  // The mapping keeps its own reference to the file
+
+        if (addr == MAP_FAILED) {
+            open_ = false;
+            size_ = 0;
+            return false;
+        }
+
+        data_ = static_cast<unsigned char*>(addr);
+        writable_ = writable;
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        open_ = false;
+        writable_ = false;
+    }
+#endif
+
+    bool replaceFile(const std::string& path, std::string_view bytes) {
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!file) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        return !ec;
+    }
+
+} // namespace travel_planner
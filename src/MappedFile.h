@@ -0,0 +1,128 @@
+#ifndef TRAVEL_PLANNER_MAPPED_FILE_H
+#define TRAVEL_PLANNER_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace travel_planner {
+
+    /**
+     * Memory mapping of a whole file, read-only unless opened writable. The
+     * mapping is released when the object goes out of scope.
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /**
+         * Maps a file into memory
+         * @param path Path to the file
+         * @param writable Map the file shared and writable; changes made
+         *                 through mutableData() go straight to the file
+         * @return True on success; an empty file maps successfully with size 0
+         */
+        bool open(const std::string& path, bool writable = false);
+
+        /**
+         * Releases the mapping
+         */
+        void close();
+
+        const unsigned char* data() const { return data_; }
+        unsigned char* mutableData() const { return writable_ ? data_ : nullptr; }
+        std::size_t size() const { return size_; }
+        bool isOpen() const { return open_; }
+
+    private:
+        unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+        bool open_ = false;
+        bool writable_ = false;
+#ifdef _WIN32
+        void* file_handle_ = nullptr;
+        void* mapping_handle_ = nullptr;
+#endif
+    };
+
+    /**
+     * Bytes of a derived index: mapped from its file by open(), or held in
+     * memory by assign() when the index was just built and not (yet)
+     * saved. Either way they are read through data() and size().
+     */
+    class IndexImage {
+    public:
+        /**
+         * Maps an index file and checks it
+         * @param path Index file
+         * @param valid Called as bool() once data() and size() show the
+         *              file, e.g. to check its header and source stamp
+         * @return True if the file mapped and passed the check; otherwise
+         *         the image is left empty
+         */
+        template <typename Check>
+        bool open(const std::string& path, Check&& valid) {
+            memory_.clear();
+            if (!file_.open(path)) {
+                return false;
+            }
+            if (!valid()) {
+                file_.close();
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Takes index bytes built in memory, releasing any mapped file
+         * @param bytes Index contents
+         * @param valid Called as bool() like for open(); the image is left
+         *              empty if it fails
+         */
+        template <typename Check>
+        void assign(std::string bytes, Check&& valid) {
+            file_.close();
+            memory_ = std::move(bytes);
+            if (!valid()) {
+                memory_.clear();
+            }
+        }
+
+        /**
+         * @return Start of the bytes, or null when the image is empty
+         */
+        const char* data() const {
+            if (file_.isOpen()) {
+                return reinterpret_cast<const char*>(file_.data());
+            }
+            return memory_.empty() ? nullptr : memory_.data();
+        }
+
+        std::size_t size() const { return file_.isOpen() ? file_.size() : memory_.size(); }
+
+    private:
+        MappedFile file_;
+        std::string memory_;  // Contents when built in memory
+    };
+
+    /**
+     * Replaces a file with new contents by writing a temporary sibling and
+     * renaming it over the target, so readers see the old file or the new
+     * one, never half of it. A reader that still has the old file mapped
+     * keeps its mapping.
+     * @param path File to replace
+     * @param bytes Its new contents
+     * @return True on success
+     */
+    bool replaceFile(const std::string& path, std::string_view bytes);
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_MAPPED_FILE_H
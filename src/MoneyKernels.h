@@ -0,0 +1,75 @@
+#ifndef TRAVEL_PLANNER_MONEY_KERNELS_H
+#define TRAVEL_PLANNER_MONEY_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace travel_planner {
+
+    /**
+     * Sum, count, min and max of a set of amounts in cents. min and max of
+     * an empty set are the int64 extremes, so results merge by plain
+     * min/max.
+     */
+    struct MoneyStats {
+        std::int64_t sum = 0;
+        std::uint64_t count = 0;
+        std::int64_t min = std::numeric_limits<std::int64_t>::max();
+        std::int64_t max = std::numeric_limits<std::int64_t>::min();
+    };
+
+    /**
+     * Implementation of the money kernels. Auto picks AVX2 when the CPU
+     * has it (checked once at run time) and the scalar loops otherwise;
+     * forcing one is meant for benchmarks and comparisons.
+     */
+    enum class MoneyKernel { Auto, Scalar, Avx2 };
+
+    /**
+     * @return True if the kernel can run on this machine and build
+     */
+    bool moneyKernelAvailable(MoneyKernel kernel);
+
+    /**
+     * Converts decimal amounts to the nearest cent (ties to even), as
+     * Money::fromAmount() does. Amounts must stay below 2^51 cents.
+     * @param amounts Decimal amounts
+     * @param count Number of amounts
+     * @param cents Receives count values
+     */
+    void amountsToCents(const double* amounts, std::size_t count, std::int64_t* cents,
+        MoneyKernel kernel = MoneyKernel::Auto);
+
+    /**
+     * @return Stats of all amounts
+     */
+    MoneyStats moneyStats(const std::int64_t* cents, std::size_t count,
+        MoneyKernel kernel = MoneyKernel::Auto);
+
+    /**
+     * Stats of the amounts whose code matches, e.g. one category
+     * @param cents Amounts
+     * @param codes Group code of each amount
+     * @param count Number of amounts
+     * @param code Code to select
+     */
+    MoneyStats moneyStatsWhere(const std::int64_t* cents, const std::uint32_t* codes, std::size_t count,
+        std::uint32_t code, MoneyKernel kernel = MoneyKernel::Auto);
+
+    /**
+     * Stats of every group at once. One or two groups are computed with a
+     * vectorized filtered pass each; more groups with a single scalar pass
+     * over interleaved tables, which is then cheaper.
+     * @param cents Amounts
+     * @param codes Group code of each amount; all below stats.size()
+     * @param count Number of amounts
+     * @param stats One entry per code; receives the stats of each group
+     */
+    void moneyStatsByCode(const std::int64_t* cents, const std::uint32_t* codes, std::size_t count,
+        std::vector<MoneyStats>& stats, MoneyKernel kernel = MoneyKernel::Auto);
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_MONEY_KERNELS_H
@@ -1,15 +1,30 @@
 #include "PackingManager.h"
+#include "Profiler.h"
+#include "RecordCache.h"
+#include "RecordReader.h"
+#include "RecordWriter.h"
+#include "StorageConfig.h"
+#include "Trace.h"
 #include <fstream>
 #include <iostream>
 #include <filesystem>
 #include <chrono>
 #include <random>
 #include <algorithm>
+#include <map>
+#include <set>
+#include <unordered_map>
 
 namespace travel_planner {
 
     PackingManager::PackingManager(const std::string& storage_path)
-        : data_file_path(storage_path) {
+        : layout(storage_path),
+        json_indent(jsonIndent(4)),
+        index((std::filesystem::path(layout.directory()) / ".index").string()) {
+    }
+
+    void PackingManager::setJsonIndent(int indent) {
+        json_indent = indent;
     }
 
     // Generate a unique ID for a packing item
@@ -34,77 +49,318 @@ namespace travel_planner {
         return "pck_" + std::to_string(timestamp) + "_" + random_str;
     }
 
-    std::vector<PackingItem> PackingManager::loadAll() const {
-        std::vector<PackingItem> items;
+    void PackingManager::migrateIfNeeded() const {
+        // Convert shards written in another format (e.g. JSON -> CBOR)
+        std::string recorded = layout.recordedExtension();
+        if (!recorded.empty() && recorded != layout.extension()) {
+            for (const auto& old_path : layout.shardPathsWithExtension(recorded)) {
+                std::vector<PackingItem> items = loadShard(old_path);
+                if (items.empty()) {
+                    continue;  // Nothing worth keeping
+                }
+                if (!saveShard(layout.shardPath(items.front().itinerary_id), items)) {
+                    std::cerr << "Error converting packing shard " << old_path << std::endl;
+                    return;  // Keep the old shards; conversion is retried next time
+                }
+            }
+            for (const auto& old_path : layout.shardPathsWithExtension(recorded)) {
+                std::error_code ec;
+                std::filesystem::remove(old_path, ec);
+            }
+            layout.recordExtension();
+        }
 
-        // Create parent directory if it doesn't exist
-        std::filesystem::path path(data_file_path);
-        std::filesystem::create_directories(path.parent_path());
+        if (!layout.needsMigration()) {
+            return;
+        }
 
-        // Check if file exists
-        if (!std::filesystem::exists(path)) {
-            // Return empty vector if file doesn't exist yet
-            return items;
+        // Split the single-file store into one shard per itinerary
+        std::map<std::string, std::vector<PackingItem>> by_itinerary;
+        for (auto& item : loadShard(layout.legacyPath())) {
+            by_itinerary[item.itinerary_id].push_back(std::move(item));
         }
 
-        try {
-            std::ifstream file(data_file_path);
-            if (!file.is_open()) {
-                std::cerr << "Error: Unable to open packing items file for reading: "
-                    << data_file_path << std::endl;
-                return items;
+        for (const auto& [itinerary_id, items] : by_itinerary) {
+            if (!saveShard(layout.shardPath(itinerary_id), items)) {
+                std::cerr << "Error migrating packing items to " << layout.directory() << std::endl;
+                return;  // Keep the legacy store; migration is retried next time
             }
+        }
 
-            nlohmann::json j;
-            file >> j;
+        layout.retireLegacyStore();
+    }
 
-            if (j.is_array()) {
-                for (const auto& item_json : j) {
-                    PackingItem item;
-                    from_json(item_json, item);
-                    items.push_back(item);
-                }
-            }
+    std::vector<PackingItem> PackingManager::loadShard(const std::string& shard_path) const {
+        TraceSpan span("PackingManager::loadShard", shard_path);
+        std::vector<PackingItem> items;
+        scanShard(shard_path, [&items](const PackingItem& item) {
+            items.push_back(item);
+            return true;
+        });
+        return items;
+    }
+
+    bool PackingManager::scanShard(const std::string& shard_path,
+        const std::function<bool(const PackingItem&)>& visitor) const {
+        // Check if file exists
+        if (!std::filesystem::exists(shard_path)) {
+            // Nothing to visit if file doesn't exist yet
+            return true;
         }
-        catch (const nlohmann::json::exception& e) {
-            std::cerr << "Error parsing packing items JSON: " << e.what() << std::endl;
+
+        bool completed = true;
+        try {
+            std::string error;
+            auto tracking_visitor = [&visitor, &completed](const PackingItem& item) {
+                completed = visitor(item);
+                return completed;
+            };
+            if (!readRecordFile<PackingItem>(shard_path, tracking_visitor, error, formatForPath(shard_path))
+                || !error.empty()) {
+                std::cerr << "Error parsing packing items file " << shard_path << ": " << error << std::endl;
+            }
         }
         catch (const std::exception& e) {
             std::cerr << "Error loading packing items: " << e.what() << std::endl;
         }
 
-        return items;
+        return completed;
     }
 
-    void PackingManager::saveAll(const std::vector<PackingItem>& items) const {
+    bool PackingManager::saveShard(const std::string& shard_path, const std::vector<PackingItem>& items) const {
+        TraceSpan span("PackingManager::saveShard", shard_path);
         try {
-            // Create parent directory if it doesn't exist
-            std::filesystem::path path(data_file_path);
-            std::filesystem::create_directories(path.parent_path());
+            // Create the shard directory and record the format it holds
+            std::filesystem::path path(shard_path);
+            if (path.has_parent_path() && !std::filesystem::exists(path.parent_path())) {
+                std::filesystem::create_directories(path.parent_path());
+                layout.recordExtension();
+            }
 
-            std::ofstream file(data_file_path);
-            if (!file.is_open()) {
-                std::cerr << "Error: Unable to open packing items file for writing: "
-                    << data_file_path << std::endl;
-                return;
+            // Batch runs hold the rewrite in memory until their next checkpoint
+            if (deferWrite(shard_path, items, formatForPath(shard_path), json_indent)) {
+                return true;
             }
 
-            nlohmann::json j = nlohmann::json::array();
-            for (const auto& item : items) {
-                nlohmann::json item_json;
-                to_json(item_json, item);
-                j.push_back(item_json);
+            // Check the index before the shard changes, or it looks stale
+            bool indexed = ensureIndex();
+
+            // Serialize straight into the file, no intermediate JSON tree
+            std::vector<RecordSpan> spans;
+            if (!writeRecords(shard_path, items, formatForPath(shard_path), json_indent, &spans)) {
+                return false;
             }
+            cacheRecords(shard_path, items);
 
-            file << j.dump(4); // Pretty print with 4-space indentation
+            // Point the index at the new positions of the shard's items
+            if (indexed || ensureIndex()) {
+                index.replaceFile(shard_path, items, spans);
+            }
+            return true;
         }
         catch (const std::exception& e) {
             std::cerr << "Error saving packing items: " << e.what() << std::endl;
         }
+
+        return false;
+    }
+
+    std::vector<PackingItem> PackingManager::loadAll() const {
+        TraceSpan span("PackingManager::loadAll");
+        migrateIfNeeded();
+
+        std::vector<PackingItem> items;
+        for (const auto& shard_path : layout.shardPaths()) {
+            auto shard = loadShard(shard_path);
+            items.insert(items.end(),
+                std::make_move_iterator(shard.begin()), std::make_move_iterator(shard.end()));
+        }
+
+        return items;
+    }
+
+    std::pmr::vector<pmr::PackingItem> PackingManager::loadAll(std::pmr::memory_resource* resource) const {
+        std::pmr::vector<pmr::PackingItem> items(resource);
+        forEachItem([&items](const PackingItem& item) {
+            items.emplace_back(item);
+            return true;
+        });
+        return items;
+    }
+
+    bool PackingManager::saveAll(const std::vector<PackingItem>& items) const {
+        TraceSpan span("PackingManager::saveAll");
+        migrateIfNeeded();
+
+        // Group by itinerary ID, shards in order of first appearance. The map
+        // views the IDs in items, so it lives only as long as this call.
+        std::unordered_map<std::string_view, std::size_t> shard_of;
+        std::vector<std::string_view> shard_ids;
+        std::vector<std::vector<PackingItem>> by_itinerary;
+        for (const auto& item : items) {
+            auto [it, inserted] = shard_of.try_emplace(item.itinerary_id, by_itinerary.size());
+            if (inserted) {
+                shard_ids.push_back(item.itinerary_id);
+                by_itinerary.emplace_back();
+            }
+            by_itinerary[it->second].push_back(item);
+        }
+
+        bool success = true;
+        std::set<std::string> written;
+        for (std::size_t shard = 0; shard < by_itinerary.size(); ++shard) {
+            std::string shard_path = layout.shardPath(std::string(shard_ids[shard]));
+            success = saveShard(shard_path, by_itinerary[shard]) && success;
+            written.insert(shard_path);
+        }
+
+        // Drop shards of itineraries that no longer have any items
+        for (const auto& shard_path : layout.shardPaths()) {
+            if (written.count(shard_path) == 0) {
+                std::error_code ec;
+                std::filesystem::remove(shard_path, ec);
+                if (ensureIndex()) {
+                    index.dropFile(shard_path);
+                    index.stampFile(shard_path);
+                }
+            }
+        }
+        return success;
+    }
+
+    std::vector<PackingItem> PackingManager::listItems(const std::string& itinerary_id) const {
+        TraceSpan span("PackingManager::listItems", itinerary_id);
+        migrateIfNeeded();
+
+        // Only this itinerary's shard is read
+        return loadShard(layout.shardPath(itinerary_id));
+    }
+
+    void PackingManager::forEachItem(const std::function<bool(const PackingItem&)>& visitor) const {
+        TraceSpan span("PackingManager::forEachItem");
+        migrateIfNeeded();
+
+        for (const auto& shard_path : layout.shardPaths()) {
+            if (!scanShard(shard_path, visitor)) {
+                return;  // Visitor asked to stop
+            }
+        }
+    }
+
+    std::string PackingManager::locateItem(const std::string& item_id, PackingItem& item) const {
+        TraceSpan span("PackingManager::locateItem", item_id);
+        ProfileScope profile(ProfilePhase::Load);
+        migrateIfNeeded();
+
+        // Item IDs don't carry their itinerary; the index knows the shard
+        if (ensureIndex()) {
+            RecordLocation location;
+            bool found = findIndexed(index, item_id, item, location,
+                [](const RecordLocation& at, PackingItem& record) {
+                    return readRecordAt(at.file, { at.offset, at.length }, record);
+                },
+                [this]() { return rebuildIndex(); });
+            if (found) {
+                return location.file;
+            }
+            if (index.isOpen()) {
+                return "";
+            }
+        }
+
+        // No usable index, so stream through the shards without keeping
+        // any items until the right one is found
+        for (const auto& shard_path : layout.shardPaths()) {
+            bool found = !scanShard(shard_path, [&item_id, &item](const PackingItem& candidate) {
+                if (candidate.id != item_id) {
+                    return true;
+                }
+                item = candidate;
+                return false;
+            });
+            if (found) {
+                return shard_path;
+            }
+        }
+
+        return "";
+    }
+
+    std::string PackingManager::findItemShard(const std::string& item_id, std::vector<PackingItem>& items) const {
+        PackingItem item;
+        std::string shard_path = locateItem(item_id, item);
+        if (shard_path.empty()) {
+            items.clear();
+        }
+        else {
+            items = loadShard(shard_path);
+        }
+        return shard_path;
+    }
+
+    bool PackingManager::findItem(const std::string& item_id, PackingItem& item) const {
+        return !locateItem(item_id, item).empty();
+    }
+
+    bool PackingManager::ensureIndex() const {
+        if (deferredWrites()) {
+            return false;  // Positions on disk are out of date while rewrites are held
+        }
+        if (index_checked) {
+            return index.isOpen();
+        }
+        index_checked = true;
+
+        // Nothing to index before the first shard is written
+        std::error_code ec;
+        if (!std::filesystem::is_directory(layout.directory(), ec)) {
+            index_checked = false;
+            return false;
+        }
+
+        if (index.open() && index.matches(layout.shardPaths())) {
+            return true;
+        }
+        return rebuildIndex();
+    }
+
+    bool PackingManager::rebuildIndex() const {
+        TraceSpan span("PackingManager::rebuildIndex");
+        std::vector<std::string> shard_paths = layout.shardPaths();
+        if (!index.create(shard_paths.size() * 16)) {
+            return false;
+        }
+
+        for (const auto& shard_path : shard_paths) {
+            MappedFile file;
+            if (!file.open(shard_path)) {
+                index.close();
+                return false;
+            }
+
+            std::string error;
+            const char* data = reinterpret_cast<const char*>(file.data());
+            bool ok = file.size() == 0 || scanRecordSpans<PackingItem>(data, file.size(), formatForPath(shard_path),
+                [this, &shard_path](const PackingItem& item, const RecordSpan& span) {
+                    return index.put(item.id, shard_path, span.offset, span.length);
+                }, error);
+            if (!ok) {
+                std::cerr << "Error indexing packing items file " << shard_path << ": " << error << std::endl;
+                index.close();
+                return false;
+            }
+            index.stampFile(shard_path);
+        }
+
+        return true;
     }
 
     std::string PackingManager::addItem(const std::string& itinerary_id, const std::string& name, int quantity) {
-        auto items = loadAll();
+        TraceSpan span("PackingManager::addItem", itinerary_id);
+        migrateIfNeeded();
+
+        std::string shard_path = layout.shardPath(itinerary_id);
+        auto items = loadShard(shard_path);
 
         // Generate a unique ID for the new item
         std::string id = generateUniqueId();
@@ -113,16 +369,26 @@ namespace travel_planner {
         PackingItem new_item(id, itinerary_id, name, quantity, false);
         items.push_back(new_item);
 
-        // Save all items back to storage
-        saveAll(items);
+        // Save the itinerary's items back to storage
+        if (!saveShard(shard_path, items)) {
+            return "";
+        }
 
         return id;
     }
 
     bool PackingManager::markPacked(const std::string& item_id) {
-        auto items = loadAll();
+        TraceSpan span("PackingManager::markPacked", item_id);
+        std::vector<PackingItem> items;
+        std::string shard_path = findItemShard(item_id, items);
+
+        if (shard_path.empty()) {
+            std::cerr << "Error: Packing item with ID " << item_id << " not found." << std::endl;
+            return false;
+        }
 
-        // Find the item with the given ID
+        // Find the item with the given ID. The index located it, but the
+        // shard's contents come from a separate read and may disagree.
         auto it = std::find_if(items.begin(), items.end(),
             [&item_id](const PackingItem& item) { return item.id == item_id; });
 
@@ -134,31 +400,32 @@ namespace travel_planner {
         // Toggle the packed status
         it->packed = !it->packed;
 
-        // Save all items back to storage
-        saveAll(items);
-
-        return true;
+        // Save the shard back to storage
+        return saveShard(shard_path, items);
     }
 
     bool PackingManager::removeItem(const std::string& item_id) {
-        auto items = loadAll();
-
-        // Find the item with the given ID
-        auto it = std::find_if(items.begin(), items.end(),
-            [&item_id](const PackingItem& item) { return item.id == item_id; });
+        TraceSpan span("PackingManager::removeItem", item_id);
+        std::vector<PackingItem> items;
+        std::string shard_path = findItemShard(item_id, items);
 
-        if (it == items.end()) {
+        if (shard_path.empty()) {
             std::cerr << "Error: Packing item with ID " << item_id << " not found." << std::endl;
             return false;
         }
 
         // Remove the item
-        items.erase(it);
+        auto it = std::remove_if(items.begin(), items.end(),
+            [&item_id](const PackingItem& item) { return item.id == item_id; });
 
-        // Save all items back to storage
-        saveAll(items);
+        if (it == items.end()) {
+            std::cerr << "Error: Packing item with ID " << item_id << " not found." << std::endl;
+            return false;
+        }
+        items.erase(it, items.end());
 
-        return true;
+        // Save the shard back to storage
+        return saveShard(shard_path, items);
     }
 
 } // namespace travel_planner
\ No newline at end of file
@@ -2,6 +2,10 @@
 #define PACKING_MANAGER_H
 
 #include "../include/PackingItem.h"
+#include "RecordIndex.h"
+#include "ShardLayout.h"
+#include <functional>
+#include <memory_resource>
 #include <vector>
 #include <string>
 
@@ -9,16 +13,35 @@ namespace travel_planner {
 
     class PackingManager {
     public:
-        // Constructor with default storage path
+        // Constructor with default storage path. Items are sharded per
+        // itinerary under the directory named after the store file (e.g.
+        // "data/packing/"); an existing single-file store is migrated once.
+        // The store path's extension selects the shard format (".json",
+        // ".cbor" or ".msgpack").
         explicit PackingManager(const std::string& storage_path = "data/packing_items.json");
 
         // Load all packing items from storage
         std::vector<PackingItem> loadAll() const;
 
-        // Save all packing items to storage
-        void saveAll(const std::vector<PackingItem>& items) const;
+        // Load all packing items into a memory resource, usually the
+        // command's arena (currentArena()), for read-only use
+        std::pmr::vector<pmr::PackingItem> loadAll(std::pmr::memory_resource* resource) const;
 
-        // Add a new packing item
+        // Save all packing items to storage; false if any shard failed
+        bool saveAll(const std::vector<PackingItem>& items) const;
+
+        // Load the packing items of a single itinerary
+        std::vector<PackingItem> listItems(const std::string& itinerary_id) const;
+
+        // Stream every packing item to a visitor without loading them all;
+        // the visitor returns false to stop
+        void forEachItem(const std::function<bool(const PackingItem&)>& visitor) const;
+
+        // Look up a single item by ID through the item index
+        bool findItem(const std::string& item_id, PackingItem& item) const;
+
+        // Add a new packing item; returns its ID, or an empty string if it
+        // could not be saved
         std::string addItem(const std::string& itinerary_id, const std::string& name, int quantity = 1);
 
         // Mark an item as packed/unpacked (toggles state)
@@ -27,8 +50,43 @@ namespace travel_planner {
         // Remove a packing item
         bool removeItem(const std::string& item_id);
 
+        // Indentation of saved shard files; 0 writes compact JSON
+        void setJsonIndent(int indent);
+
     private:
-        std::string data_file_path;
+        // Split the legacy single-file store into shards (one-time) and
+        // convert shards stored in another format
+        void migrateIfNeeded() const;
+
+        // Load one shard file
+        std::vector<PackingItem> loadShard(const std::string& shard_path) const;
+
+        // Stream one shard file to a visitor; returns false if the visitor stopped early
+        bool scanShard(const std::string& shard_path,
+            const std::function<bool(const PackingItem&)>& visitor) const;
+
+        // Replace one shard file
+        bool saveShard(const std::string& shard_path, const std::vector<PackingItem>& items) const;
+
+        // Locate the shard holding an item and read the item. Returns an
+        // empty string if no shard contains the item.
+        std::string locateItem(const std::string& item_id, PackingItem& item) const;
+
+        // Locate the shard holding an item; loads that shard into items.
+        // Returns an empty string if no shard contains the item.
+        std::string findItemShard(const std::string& item_id, std::vector<PackingItem>& items) const;
+
+        // Open the item ID index, rebuilding it if it is missing or out of
+        // date; returns false if no index is available
+        bool ensureIndex() const;
+
+        // Rebuild the item ID index from the shard files
+        bool rebuildIndex() const;
+
+        ShardLayout layout;
+        int json_indent;
+        mutable RecordIndex index;          // Item ID -> position in its shard ("<dir>/.index")
+        mutable bool index_checked = false;
     };
 
 } // namespace travel_planner
@@ -0,0 +1,272 @@
+#include "Profiler.h"
+#include "AllocationCounter.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace travel_planner {
+
+    namespace {
+
+        // The perf_event_open counters come first, then the allocation counts
+        enum Counter { Cycles, Instructions, CacheMisses, PageFaults, Allocations, AllocatedBytes, kCounterCount };
+
+        const int kPerfCounterCount = Allocations;
+
+        const char* const kCounterNames[kCounterCount] = {
+            "cycles", "instructions", "cache misses", "page faults", "allocations", "allocated bytes"
+        };
+
+        const ProfilePhase kPhases[] = {
+            ProfilePhase::Load, ProfilePhase::Filter, ProfilePhase::Serialize, ProfilePhase::Write, ProfilePhase::Other
+        };
+
+        const char* phaseName(ProfilePhase phase) {
+            switch (phase) {
+            case ProfilePhase::Load: return "load";
+            case ProfilePhase::Filter: return "filter";
+            case ProfilePhase::Serialize: return "serialize";
+            case ProfilePhase::Write: return "write";
+            default: return "other";
+            }
+        }
+
+        using Values = std::array<std::uint64_t, kCounterCount>;
+
+        struct Sample {
+            std::chrono::steady_clock::time_point time;
+            Values values{};
+        };
+
+        struct PhaseTotals {
+            std::uint64_t calls = 0;
+            std::chrono::steady_clock::duration wall{};
+            Values values{};
+        };
+
+        struct ProfileState {
+            std::array<int, kPerfCounterCount> fds{ -1, -1, -1, -1 };
+            std::string unavailable_reason;
+            bool rusage_faults = false;  // Page faults from getrusage() instead of a counter
+            std::vector<ProfilePhase> stack;
+            std::array<PhaseTotals, std::size(kPhases)> totals{};
+            Sample last;
+        };
+
+        ProfileState& state() {
+            static ProfileState profile;
+            return profile;
+        }
+
+#ifdef __linux__
+        // Counts the calling thread in user space, which unprivileged
+        // processes are allowed to do by default
+        int openCounter(std::uint32_t type, std::uint64_t config, std::string& error) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+
+            int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+            if (fd < 0 && error.empty()) {
+                error = std::strerror(errno);
+            }
+            return fd;
+        }
+#endif
+
+        std::uint64_t rusageFaults() {
+#ifndef _WIN32
+            rusage usage;
+            if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+                return static_cast<std::uint64_t>(usage.ru_minflt + usage.ru_majflt);
+            }
+#endif
+            return 0;
+        }
+
+        Sample takeSample() {
+            ProfileState& profile = state();
+            Sample sample;
+#ifdef __linux__
+            for (int counter = 0; counter < kPerfCounterCount; ++counter) {
+                std::uint64_t value = 0;
+                if (profile.fds[counter] >= 0 && ::read(profile.fds[counter], &value, sizeof(value)) == sizeof(value)) {
+                    sample.values[counter] = value;
+                }
+            }
+#endif
+            if (profile.rusage_faults) {
+                sample.values[PageFaults] = rusageFaults();
+            }
+            AllocationTotals allocations = allocationTotals();
+            sample.values[Allocations] = allocations.count;
+            sample.values[AllocatedBytes] = allocations.bytes;
+            sample.time = std::chrono::steady_clock::now();
+            return sample;
+        }
+
+        // Charges the work since the last sample to the innermost phase
+        void charge(const Sample& now) {
+            ProfileState& profile = state();
+            if (!profile.stack.empty()) {
+                PhaseTotals& totals = profile.totals[static_cast<std::size_t>(profile.stack.back())];
+                totals.wall += now.time - profile.last.time;
+                for (int counter = 0; counter < kCounterCount; ++counter) {
+                    totals.values[counter] += now.values[counter] - profile.last.values[counter];
+                }
+            }
+            profile.last = now;
+        }
+
+        bool available(int counter) {
+            const ProfileState& profile = state();
+            if (counter >= kPerfCounterCount) {
+                return true;
+            }
+            return profile.fds[counter] >= 0 || (counter == PageFaults && profile.rusage_faults);
+        }
+
+        std::string cell(int counter, std::uint64_t value) {
+            return available(counter) ? std::to_string(value) : "-";
+        }
+
+    } // namespace
+
+    void startProfile() {
+        ProfileState& profile = state();
+        profile = ProfileState();
+        profile.stack.reserve(64);  // Keeps the profiler's own allocations out of the counts
+#ifdef __linux__
+        profile.fds[Cycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, profile.unavailable_reason);
+        profile.fds[Instructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, profile.unavailable_reason);
+        profile.fds[CacheMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, profile.unavailable_reason);
+        profile.fds[PageFaults] = openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, profile.unavailable_reason);
+#else
+        profile.unavailable_reason = "perf_event_open is Linux only";
+#endif
+        profile.rusage_faults = profile.fds[PageFaults] < 0;
+        profile.last = takeSample();
+        detail::profile_enabled = true;
+    }
+
+    bool ProfileScope::enter(ProfilePhase phase) {
+        ProfileState& profile = state();
+        charge(takeSample());
+        profile.stack.push_back(phase);
+        ++profile.totals[static_cast<std::size_t>(phase)].calls;
+        return true;
+    }
+
+    void ProfileScope::leave() {
+        ProfileState& profile = state();
+        if (profile.stack.empty()) {
+            return;  // Profiling was restarted inside the scope
+        }
+        charge(takeSample());
+        profile.stack.pop_back();
+    }
+
+    void printProfile(std::ostream& out) {
+        if (!detail::profile_enabled) {
+            return;
+        }
+        ProfileState& profile = state();
+        charge(takeSample());
+        detail::profile_enabled = false;
+
+        PhaseTotals total;
+        for (const auto& totals : profile.totals) {
+            total.calls += totals.calls;
+            total.wall += totals.wall;
+            for (int counter = 0; counter < kCounterCount; ++counter) {
+                total.values[counter] += totals.values[counter];
+            }
+        }
+
+        std::ios_base::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::endl << "Profile" << std::endl;
+        out << std::left << std::setw(11) << "Phase" << std::right << std::setw(7) << "Calls"
+            << std::setw(11) << "Wall ms" << std::setw(15) << "Cycles" << std::setw(15) << "Instructions"
+            << std::setw(7) << "IPC" << std::setw(14) << "Cache misses" << std::setw(13) << "Page faults"
+            << std::setw(10) << "Allocs" << std::setw(14) << "Alloc bytes" << std::endl;
+        out << std::string(117, '-') << std::endl;
+
+        auto row = [&](const char* name, const PhaseTotals& totals) {
+            double wall_ms = std::chrono::duration<double, std::milli>(totals.wall).count();
+            std::string ipc = "-";
+            if (totals.values[Cycles] > 0 && available(Instructions)) {
+                char buffer[16];
+                std::snprintf(buffer, sizeof(buffer), "%.2f",
+                    static_cast<double>(totals.values[Instructions]) / static_cast<double>(totals.values[Cycles]));
+                ipc = buffer;
+            }
+            out << std::left << std::setw(11) << name << std::right << std::setw(7) << totals.calls
+                << std::setw(11) << std::fixed << std::setprecision(3) << wall_ms
+                << std::setw(15) << cell(Cycles, totals.values[Cycles])
+                << std::setw(15) << cell(Instructions, totals.values[Instructions])
+                << std::setw(7) << ipc
+                << std::setw(14) << cell(CacheMisses, totals.values[CacheMisses])
+                << std::setw(13) << cell(PageFaults, totals.values[PageFaults])
+                << std::setw(10) << totals.values[Allocations]
+                << std::setw(14) << totals.values[AllocatedBytes] << std::endl;
+        };
+
+        for (ProfilePhase phase : kPhases) {
+            row(phaseName(phase), profile.totals[static_cast<std::size_t>(phase)]);
+        }
+        out << std::string(117, '-') << std::endl;
+        row("total", total);
+
+        if (std::uint64_t peak = peakResidentBytes()) {
+            out << "Peak RSS: " << std::fixed << std::setprecision(1)
+                << static_cast<double>(peak) / (1024.0 * 1024.0) << " MiB" << std::endl;
+        }
+
+        std::string missing;
+        for (int counter = 0; counter < kCounterCount; ++counter) {
+            if (!available(counter)) {
+                missing += (missing.empty() ? "" : ", ") + std::string(kCounterNames[counter]);
+            }
+        }
+        if (!missing.empty()) {
+            out << "Unavailable: " << missing << " (" << profile.unavailable_reason << ")" << std::endl;
+        }
+        if (profile.rusage_faults) {
+            out << "Page faults from getrusage()" << std::endl;
+        }
+
+        out.flags(flags);
+        out.precision(precision);
+
+#ifdef __linux__
+        for (int& fd : profile.fds) {
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+        }
+#endif
+    }
+
+} // namespace travel_planner
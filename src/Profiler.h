@@ -0,0 +1,77 @@
+#ifndef TRAVEL_PLANNER_PROFILER_H
+#define TRAVEL_PLANNER_PROFILER_H
+
+#include <ostream>
+
+namespace travel_planner {
+
+    /**
+     * Phases a command's work is attributed to
+     */
+    enum class ProfilePhase {
+        Load,       // Reading and parsing stored records
+        Filter,     // Selecting, grouping and aggregating loaded records
+        Serialize,  // Encoding records and formatting exports
+        Write,      // Handing encoded bytes to the file system
+        Other       // Everything else the command does
+    };
+
+    namespace detail {
+        // Checked inline by every scope, so disabled profiling costs one branch
+        inline bool profile_enabled = false;
+    }
+
+    /**
+     * Starts attributing time, hardware counters and heap allocations to
+     * phases. Uses Linux perf_event_open counters (cycles, instructions,
+     * cache misses, page faults) where the kernel allows them; counters that
+     * cannot be opened are reported as unavailable and only wall time is
+     * measured. Allocations come from the operator new hook in
+     * AllocationCounter.h.
+     */
+    void startProfile();
+
+    /**
+     * Stops profiling and prints one row per phase, followed by the peak
+     * resident set size of the process
+     * @param out Stream to print the table to
+     */
+    void printProfile(std::ostream& out);
+
+    /**
+     * @return True while profiling
+     */
+    inline bool profileEnabled() { return detail::profile_enabled; }
+
+    /**
+     * Attributes the work done during its lifetime to a phase. Scopes nest:
+     * a nested scope's work is charged to the nested phase only, so the
+     * rows of the table add up to the total.
+     */
+    class ProfileScope {
+    public:
+        explicit ProfileScope(ProfilePhase phase) {
+            if (detail::profile_enabled) {
+                active_ = enter(phase);
+            }
+        }
+
+        ~ProfileScope() {
+            if (active_) {
+                leave();
+            }
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        static bool enter(ProfilePhase phase);
+        static void leave();
+
+        bool active_ = false;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_PROFILER_H
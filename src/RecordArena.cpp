@@ -0,0 +1,24 @@
+#include "RecordArena.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        thread_local RecordArena* current_arena = nullptr;
+
+    } // namespace
+
+    RecordArena::RecordArena(std::size_t initial_size)
+        : arena_(initial_size), previous_(current_arena) {
+        current_arena = this;
+    }
+
+    RecordArena::~RecordArena() {
+        current_arena = previous_;
+    }
+
+    std::pmr::memory_resource* currentArena() {
+        return current_arena ? current_arena->resource() : std::pmr::new_delete_resource();
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,49 @@
+#ifndef TRAVEL_PLANNER_RECORD_ARENA_H
+#define TRAVEL_PLANNER_RECORD_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace travel_planner {
+
+    /**
+     * Monotonic arena for the record sets one command loads. Memory is
+     * taken from the heap in geometrically growing blocks and released all
+     * at once when the arena is destroyed, so loading a million records
+     * costs a few dozen allocations and freeing them costs nothing.
+     *
+     * While alive the arena is the current one of its thread (see
+     * currentArena()); arenas nest. The CLI opens one per dispatched
+     * command, which covers every server request and batch line.
+     */
+    class RecordArena {
+    public:
+        /**
+         * Constructor
+         * @param initial_size Size of the first block taken from the heap
+         */
+        explicit RecordArena(std::size_t initial_size = 64 * 1024);
+        ~RecordArena();
+
+        RecordArena(const RecordArena&) = delete;
+        RecordArena& operator=(const RecordArena&) = delete;
+
+        /**
+         * @return The arena as a memory resource
+         */
+        std::pmr::memory_resource* resource() { return &arena_; }
+
+    private:
+        std::pmr::monotonic_buffer_resource arena_;
+        RecordArena* previous_;
+    };
+
+    /**
+     * @return The innermost live arena of the calling thread, or the
+     *         new/delete resource if there is none
+     */
+    std::pmr::memory_resource* currentArena();
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_RECORD_ARENA_H
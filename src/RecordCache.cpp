@@ -0,0 +1,75 @@
+#include "RecordCache.h"
+#include <filesystem>
+
+namespace travel_planner {
+
+    namespace {
+
+        bool cache_enabled = false;
+        bool writes_deferred = false;
+
+        std::vector<std::function<bool(std::size_t&)>>& deferredFlushes() {
+            static std::vector<std::function<bool(std::size_t&)>> flushes;
+            return flushes;
+        }
+
+    } // namespace
+
+    FileStamp fileStamp(const std::string& path) {
+        FileStamp stamp;
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return stamp;
+        }
+        auto mtime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return stamp;
+        }
+        stamp.size = size;
+        stamp.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+        return stamp;
+    }
+
+    std::string cacheKey(const std::string& path) {
+        // Absolute first: weakly_canonical leaves a relative path relative
+        // when none of it exists yet
+        std::error_code ec;
+        std::filesystem::path key = std::filesystem::absolute(path, ec);
+        if (ec) {
+            return path;
+        }
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(key, ec);
+        return ec ? key.string() : canonical.string();
+    }
+
+    void setRecordCacheEnabled(bool enabled) {
+        cache_enabled = enabled;
+    }
+
+    bool recordCacheEnabled() {
+        return cache_enabled;
+    }
+
+    void setDeferredWrites(bool deferred) {
+        writes_deferred = deferred;
+    }
+
+    bool deferredWrites() {
+        return writes_deferred;
+    }
+
+    bool flushDeferredWrites(std::size_t& files_written) {
+        files_written = 0;
+        bool ok = true;
+        for (const auto& flush : deferredFlushes()) {
+            ok = flush(files_written) && ok;
+        }
+        return ok;
+    }
+
+    void registerDeferredFlush(std::function<bool(std::size_t&)> flush) {
+        deferredFlushes().push_back(std::move(flush));
+    }
+
+} // namespace travel_planner
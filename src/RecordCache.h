@@ -0,0 +1,269 @@
+#ifndef TRAVEL_PLANNER_RECORD_CACHE_H
+#define TRAVEL_PLANNER_RECORD_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RecordReader.h"
+#include "Profiler.h"
+#include "RecordWriter.h"
+#include "Trace.h"
+
+namespace travel_planner {
+
+    /**
+     * Size and modification time of a file, used to tell whether a file
+     * changed since it was last read
+     */
+    struct FileStamp {
+        std::uint64_t size = std::numeric_limits<std::uint64_t>::max();  // Max for a missing file
+        std::int64_t mtime = 0;
+
+        bool operator==(const FileStamp& other) const { return size == other.size && mtime == other.mtime; }
+        bool operator!=(const FileStamp& other) const { return !(*this == other); }
+    };
+
+    /**
+     * Takes the current stamp of a file
+     * @param path File to stamp
+     * @return Stamp of the file; the default stamp if it does not exist
+     */
+    FileStamp fileStamp(const std::string& path);
+
+    /**
+     * Key of a file in the process-wide caches: its canonical absolute
+     * path. A server runs each command in its client's directory, so the
+     * same relative path names different files from one command to the
+     * next.
+     * @param path File path, relative or absolute
+     * @return Canonical path; the path made absolute if that fails
+     */
+    std::string cacheKey(const std::string& path);
+
+    /**
+     * Turns the process-wide cache of parsed record files on or off. A
+     * long-running server turns it on so repeated commands do not re-parse
+     * unchanged stores; one-shot CLI runs leave it off.
+     */
+    void setRecordCacheEnabled(bool enabled);
+
+    /**
+     * @return True if parsed record files are cached
+     */
+    bool recordCacheEnabled();
+
+    /**
+     * Holds rewrites of existing record files in the record cache instead
+     * of writing them, until flushDeferredWrites(). Used by batch runs so a
+     * store touched by many commands is written once. Reads see the held
+     * contents; files that do not exist yet are still written right away
+     * so they show up in directory listings. Requires the record cache.
+     */
+    void setDeferredWrites(bool deferred);
+
+    /**
+     * @return True if rewrites are being held
+     */
+    bool deferredWrites();
+
+    /**
+     * Writes every held file that still exists (a file deleted in the
+     * meantime stays deleted)
+     * @param files_written Receives the number of files written
+     * @return False if a file could not be written
+     */
+    bool flushDeferredWrites(std::size_t& files_written);
+
+    /**
+     * Registers a flush function for one record type; called once by each
+     * RecordCache instance
+     */
+    void registerDeferredFlush(std::function<bool(std::size_t&)> flush);
+
+    /**
+     * Parsed contents of record files, keyed by cacheKey(). An entry is only used
+     * while its file still has the stamp it was cached with, so files
+     * changed by another process are parsed again.
+     */
+    template <typename Record>
+    class RecordCache {
+    public:
+        static RecordCache& instance() {
+            static RecordCache cache;
+            return cache;
+        }
+
+        /**
+         * @return Cached records of a file, or null if it is not cached or
+         *         changed since; held rewrites are always returned
+         */
+        std::shared_ptr<const std::vector<Record>> find(const std::string& path) const {
+            auto it = entries_.find(cacheKey(path));
+            if (it == entries_.end() || (!it->second.held && it->second.stamp != fileStamp(path))) {
+                return nullptr;
+            }
+            return it->second.records;
+        }
+
+        /**
+         * Caches the records of a file as it is now
+         * @return The cached records
+         */
+        std::shared_ptr<const std::vector<Record>> store(const std::string& path, std::vector<Record> records) {
+            Entry& entry = entries_[cacheKey(path)];
+            entry.stamp = fileStamp(path);
+            entry.held = false;
+            entry.records = std::make_shared<const std::vector<Record>>(std::move(records));
+            return entry.records;
+        }
+
+        /**
+         * Holds new contents of a file until the next flush
+         */
+        void hold(const std::string& path, const std::vector<Record>& records, StorageFormat format, int indent) {
+            Entry& entry = entries_[cacheKey(path)];
+            entry.held = true;
+            entry.format = format;
+            entry.indent = indent;
+            entry.records = std::make_shared<const std::vector<Record>>(records);
+        }
+
+    private:
+        struct Entry {
+            FileStamp stamp;
+            std::shared_ptr<const std::vector<Record>> records;
+            bool held = false;  // Newer than the file; written on flush
+            StorageFormat format = StorageFormat::Json;
+            int indent = 0;
+        };
+
+        RecordCache() {
+            registerDeferredFlush([this](std::size_t& files_written) { return flush(files_written); });
+        }
+
+        bool flush(std::size_t& files_written) {
+            bool ok = true;
+            for (auto& [path, entry] : entries_) {
+                if (!entry.held) {
+                    continue;
+                }
+                entry.held = false;
+
+                std::error_code ec;
+                if (!std::filesystem::exists(path, ec)) {
+                    entry.stamp = FileStamp();  // Deleted while held
+                    continue;
+                }
+                if (!writeRecords(path, *entry.records, entry.format, entry.indent)) {
+                    std::cerr << "Error writing " << path << std::endl;
+                    entry.stamp = FileStamp();
+                    ok = false;
+                    continue;
+                }
+                entry.stamp = fileStamp(path);
+                ++files_written;
+            }
+            return ok;
+        }
+
+        std::unordered_map<std::string, Entry> entries_;  // By cacheKey(), so flush() works from any directory
+    };
+
+    /**
+     * Streams the records of a file to a visitor, serving them from the
+     * record cache when it is enabled
+     * @param path Record file
+     * @param visitor Called as bool(const Record&); return false to stop
+     * @param error Receives a message on failure
+     * @param hint Expected format, usually formatForPath() of the file
+     * @return False if the file could not be opened or parsed; a file that
+     *         did not parse is then kept from being overwritten (see
+     *         setUnreadable())
+     */
+    template <typename Record, typename Visitor>
+    bool readRecordFile(const std::string& path, Visitor&& visitor, std::string& error, StorageFormat hint) {
+        std::shared_ptr<const std::vector<Record>> cached;
+        if (recordCacheEnabled()) {
+            cached = RecordCache<Record>::instance().find(path);
+        }
+
+        if (!cached) {
+            TraceSpan span("readRecords", path);
+            ProfileScope profile(ProfilePhase::Load);
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                error = "unable to open " + path;
+                return false;
+            }
+            if (!recordCacheEnabled()) {
+                // A file that does not parse must not be saved over
+                bool ok = readRecords<Record>(file, visitor, error, hint);
+                setUnreadable(path, !ok);
+                return ok;
+            }
+
+            // Parse the whole file once so later reads come from memory
+            std::vector<Record> records;
+            auto collect = [&records](const Record& record) {
+                records.push_back(record);
+                return true;
+            };
+            if (!readRecords<Record>(file, collect, error, hint)) {
+                setUnreadable(path, true);
+                return false;
+            }
+            setUnreadable(path, false);
+            cached = RecordCache<Record>::instance().store(path, std::move(records));
+        }
+
+        for (const Record& record : *cached) {
+            if (!visitor(record)) {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Keeps the records just written to a file in the record cache, if it
+     * is enabled, so the next read does not parse them again
+     * @param path File that was written
+     * @param records Records in file order
+     */
+    template <typename Record>
+    void cacheRecords(const std::string& path, const std::vector<Record>& records) {
+        if (recordCacheEnabled()) {
+            RecordCache<Record>::instance().store(path, records);
+        }
+    }
+
+    /**
+     * Holds the new contents of an existing record file while writes are
+     * deferred (see setDeferredWrites())
+     * @param path File to rewrite
+     * @param records Records in file order
+     * @param format Format to write the file in
+     * @param indent JSON indentation to write the file with
+     * @return True if the write was held; false if the caller should write
+     *         the file now
+     */
+    template <typename Record>
+    bool deferWrite(const std::string& path, const std::vector<Record>& records, StorageFormat format, int indent) {
+        std::error_code ec;
+        if (!deferredWrites() || !recordCacheEnabled() || !std::filesystem::exists(path, ec)) {
+            return false;
+        }
+        RecordCache<Record>::instance().hold(path, records, format, indent);
+        return true;
+    }
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_RECORD_CACHE_H
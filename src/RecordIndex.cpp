@@ -0,0 +1,530 @@
+#include "RecordIndex.h"
+#include "RecordCache.h"
+#include "RecordWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <unordered_set>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[8] = { 'T', 'P', 'I', 'D', 'X', '0', '0', '1' };
+        const std::uint32_t kVersion = 1;
+
+        // Stamp size of a file that does not exist
+        const std::uint64_t kMissing = std::numeric_limits<std::uint64_t>::max();
+
+        // Maximum share of used slots (live or retired) before the table grows
+        const double kMaxLoad = 0.7;
+
+        // FNV-1a; 0 marks an empty slot
+        std::uint64_t hashKey(std::string_view key) {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (unsigned char c : key) {
+                hash ^= c;
+                hash *= 1099511628211ull;
+            }
+            return hash != 0 ? hash : 1;
+        }
+
+        std::uint32_t slotCapacityFor(std::size_t records) {
+            std::uint32_t capacity = 16;
+            while (capacity * kMaxLoad < static_cast<double>(records + 1)) {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        std::uint64_t align8(std::uint64_t value) {
+            return (value + 7) & ~static_cast<std::uint64_t>(7);
+        }
+
+        std::string fileName(const std::string& path) {
+            return std::filesystem::path(path).filename().string();
+        }
+
+    } // namespace
+
+    struct RecordIndex::Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t slot_capacity;   // Power of two
+        std::uint32_t live_count;      // Records currently indexed
+        std::uint32_t used_count;      // Non-empty slots, live or retired
+        std::uint32_t file_count;
+        std::uint32_t file_capacity;
+        std::uint32_t heap_size;
+        std::uint32_t heap_capacity;
+        std::uint64_t files_offset;
+        std::uint64_t heap_offset;
+        std::uint64_t slots_offset;
+    };
+
+    struct RecordIndex::FileEntry {
+        std::uint32_t name_offset;     // Into the heap
+        std::uint32_t name_length;
+        std::uint32_t generation;      // Bumped whenever the file is rewritten; never 0
+        std::uint32_t live;            // Records indexed in this generation
+        std::uint64_t size;            // Stamp taken by stampFile()
+        std::int64_t mtime;
+    };
+
+    struct RecordIndex::Slot {
+        std::uint64_t hash;            // 0 for an empty slot
+        std::uint64_t offset;
+        std::uint32_t key_offset;      // Into the heap
+        std::uint32_t key_length;
+        std::uint32_t file_id;
+        std::uint32_t generation;      // Live while it equals the file's; 0 once erased
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    namespace {
+
+        // Contents of an index, used to write a fresh file
+        struct FileImage {
+            std::string name;
+            std::uint32_t generation = 1;
+            std::uint32_t live = 0;
+            std::uint64_t size = kMissing;
+            std::int64_t mtime = 0;
+        };
+
+        struct EntryImage {
+            std::string key;
+            std::uint32_t file_id = 0;
+            std::uint64_t offset = 0;
+            std::uint32_t length = 0;
+        };
+
+    } // namespace
+
+    RecordIndex::RecordIndex(const std::string& index_path)
+        : index_path_(index_path),
+          directory_(std::filesystem::path(index_path).parent_path().string()) {
+    }
+
+    RecordIndex::Header* RecordIndex::header() const {
+        return reinterpret_cast<Header*>(file_.mutableData());
+    }
+
+    RecordIndex::FileEntry* RecordIndex::files() const {
+        return reinterpret_cast<FileEntry*>(file_.mutableData() + header()->files_offset);
+    }
+
+    char* RecordIndex::heap() const {
+        return reinterpret_cast<char*>(file_.mutableData() + header()->heap_offset);
+    }
+
+    RecordIndex::Slot* RecordIndex::slots() const {
+        return reinterpret_cast<Slot*>(file_.mutableData() + header()->slots_offset);
+    }
+
+    namespace {
+
+        // Writes a complete index file from its contents
+        template <typename Header, typename FileEntry, typename Slot>
+        bool writeImage(const std::string& path, const std::vector<FileImage>& file_images,
+            const std::vector<EntryImage>& entries, std::uint32_t slot_capacity,
+            std::uint32_t file_capacity, std::uint32_t heap_capacity) {
+            Header head{};
+            std::memcpy(head.magic, kMagic, sizeof(kMagic));
+            head.version = kVersion;
+            head.slot_capacity = slot_capacity;
+            head.file_capacity = file_capacity;
+            head.heap_capacity = heap_capacity;
+            head.files_offset = sizeof(Header);
+            head.heap_offset = head.files_offset + static_cast<std::uint64_t>(file_capacity) * sizeof(FileEntry);
+            head.slots_offset = align8(head.heap_offset + heap_capacity);
+
+            std::vector<unsigned char> image(head.slots_offset + static_cast<std::uint64_t>(slot_capacity) * sizeof(Slot), 0);
+            auto* file_table = reinterpret_cast<FileEntry*>(image.data() + head.files_offset);
+            char* heap = reinterpret_cast<char*>(image.data() + head.heap_offset);
+            auto* slot_table = reinterpret_cast<Slot*>(image.data() + head.slots_offset);
+
+            auto store = [&head, heap](const std::string& bytes) {
+                std::uint32_t offset = head.heap_size;
+                std::memcpy(heap + offset, bytes.data(), bytes.size());
+                head.heap_size += static_cast<std::uint32_t>(bytes.size());
+                return offset;
+            };
+
+            for (const auto& file : file_images) {
+                FileEntry& entry = file_table[head.file_count++];
+                entry.name_offset = store(file.name);
+                entry.name_length = static_cast<std::uint32_t>(file.name.size());
+                entry.generation = file.generation;
+                entry.live = file.live;
+                entry.size = file.size;
+                entry.mtime = file.mtime;
+            }
+
+            std::uint64_t mask = slot_capacity - 1;
+            for (const auto& record : entries) {
+                std::uint64_t hash = hashKey(record.key);
+                std::uint64_t i = hash & mask;
+                while (slot_table[i].hash != 0) {
+                    i = (i + 1) & mask;
+                }
+                Slot& slot = slot_table[i];
+                slot.hash = hash;
+                slot.offset = record.offset;
+                slot.key_offset = store(record.key);
+                slot.key_length = static_cast<std::uint32_t>(record.key.size());
+                slot.file_id = record.file_id;
+                slot.generation = file_images[record.file_id].generation;
+                slot.length = record.length;
+                ++head.live_count;
+                ++head.used_count;
+            }
+
+            std::memcpy(image.data(), &head, sizeof(head));
+
+            OutputBuffer out;
+            if (!out.open(path)) {
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(image.data()), image.size());
+            return out.commit();
+        }
+
+    } // namespace
+
+    bool RecordIndex::open() {
+        file_ids_.clear();
+        if (!std::filesystem::exists(index_path_) || !file_.open(index_path_, true)) {
+            file_.close();
+            return false;
+        }
+
+        // Reject anything that is not a complete index of this version
+        if (file_.size() < sizeof(Header)) {
+            file_.close();
+            return false;
+        }
+        const Header* head = header();
+        bool valid = std::memcmp(head->magic, kMagic, sizeof(kMagic)) == 0
+            && head->version == kVersion
+            && head->slot_capacity != 0
+            && (head->slot_capacity & (head->slot_capacity - 1)) == 0
+            && head->files_offset == sizeof(Header)
+            && head->heap_offset == head->files_offset + static_cast<std::uint64_t>(head->file_capacity) * sizeof(FileEntry)
+            && head->slots_offset == align8(head->heap_offset + head->heap_capacity)
+            && file_.size() == head->slots_offset + static_cast<std::uint64_t>(head->slot_capacity) * sizeof(Slot)
+            && head->file_count <= head->file_capacity
+            && head->heap_size <= head->heap_capacity
+            && head->used_count < head->slot_capacity;
+        if (!valid) {
+            std::cerr << "Warning: ignoring invalid index " << index_path_ << std::endl;
+            file_.close();
+            return false;
+        }
+
+        for (std::uint32_t id = 0; id < head->file_count; ++id) {
+            const FileEntry& entry = files()[id];
+            file_ids_.emplace(std::string(heap() + entry.name_offset, entry.name_length), static_cast<int>(id));
+        }
+        return true;
+    }
+
+    bool RecordIndex::create(std::size_t expected_records) {
+        close();
+
+        std::uint32_t heap_capacity = static_cast<std::uint32_t>(
+            std::max<std::size_t>(4096, expected_records * 64));
+        if (!writeImage<Header, FileEntry, Slot>(index_path_, {}, {},
+            slotCapacityFor(expected_records), 16, heap_capacity)) {
+            return false;
+        }
+        return open();
+    }
+
+    void RecordIndex::close() {
+        file_.close();
+        file_ids_.clear();
+    }
+
+    std::size_t RecordIndex::size() const {
+        return isOpen() ? header()->live_count : 0;
+    }
+
+    bool RecordIndex::isLive(const Slot& slot) const {
+        return slot.hash != 0 && slot.generation != 0
+            && slot.generation == files()[slot.file_id].generation;
+    }
+
+    std::string_view RecordIndex::key(const Slot& slot) const {
+        return std::string_view(heap() + slot.key_offset, slot.key_length);
+    }
+
+    std::string RecordIndex::filePath(const FileEntry& entry) const {
+        std::string name(heap() + entry.name_offset, entry.name_length);
+        return (std::filesystem::path(directory_) / name).string();
+    }
+
+    bool RecordIndex::store(std::string_view bytes, std::uint32_t& offset) {
+        Header* head = header();
+        if (bytes.size() > head->heap_capacity - head->heap_size) {
+            return false;
+        }
+        offset = head->heap_size;
+        std::memcpy(heap() + offset, bytes.data(), bytes.size());
+        head->heap_size += static_cast<std::uint32_t>(bytes.size());
+        return true;
+    }
+
+    int RecordIndex::fileId(const std::string& name, bool add) {
+        auto it = file_ids_.find(name);
+        if (it != file_ids_.end()) {
+            return it->second;
+        }
+        if (!add) {
+            return -1;
+        }
+
+        Header* head = header();
+        std::uint32_t name_offset = 0;
+        if (head->file_count == head->file_capacity || !store(name, name_offset)) {
+            return -1;
+        }
+
+        std::uint32_t id = head->file_count++;
+        FileEntry& entry = files()[id];
+        entry.name_offset = name_offset;
+        entry.name_length = static_cast<std::uint32_t>(name.size());
+        entry.generation = 1;
+        entry.live = 0;
+        entry.size = kMissing;
+        entry.mtime = 0;
+        file_ids_.emplace(name, static_cast<int>(id));
+        return static_cast<int>(id);
+    }
+
+    bool RecordIndex::grow(std::size_t extra_bytes) {
+        // Collect what is still live, then write a roomier index
+        const Header* head = header();
+        std::vector<FileImage> file_images;
+        std::vector<int> remap(head->file_count, -1);
+        std::size_t heap_needed = extra_bytes;
+        for (std::uint32_t id = 0; id < head->file_count; ++id) {
+            const FileEntry& entry = files()[id];
+            if (entry.live == 0 && entry.size == kMissing) {
+                continue;  // Deleted file with nothing indexed
+            }
+            remap[id] = static_cast<int>(file_images.size());
+            FileImage image;
+            image.name.assign(heap() + entry.name_offset, entry.name_length);
+            image.generation = entry.generation;
+            image.live = entry.live;
+            image.size = entry.size;
+            image.mtime = entry.mtime;
+            heap_needed += image.name.size();
+            file_images.push_back(std::move(image));
+        }
+
+        std::vector<EntryImage> entries;
+        entries.reserve(head->live_count);
+        for (std::uint32_t i = 0; i < head->slot_capacity; ++i) {
+            const Slot& slot = slots()[i];
+            if (!isLive(slot)) {
+                continue;
+            }
+            EntryImage entry;
+            entry.key.assign(key(slot));
+            entry.file_id = static_cast<std::uint32_t>(remap[slot.file_id]);
+            entry.offset = slot.offset;
+            entry.length = slot.length;
+            heap_needed += entry.key.size();
+            entries.push_back(std::move(entry));
+        }
+
+        std::uint32_t slot_capacity = slotCapacityFor(entries.size() * 2 + 16);
+        std::uint32_t file_capacity = static_cast<std::uint32_t>(std::max<std::size_t>(16, file_images.size() * 2 + 1));
+        std::uint32_t heap_capacity = static_cast<std::uint32_t>(std::max<std::size_t>(4096, heap_needed * 2));
+
+        close();
+        if (!writeImage<Header, FileEntry, Slot>(index_path_, file_images, entries,
+            slot_capacity, file_capacity, heap_capacity)) {
+            open();  // Keep using the old index if it is still there
+            return false;
+        }
+        return open();
+    }
+
+    bool RecordIndex::find(std::string_view id, RecordLocation& location) const {
+        if (!isOpen()) {
+            return false;
+        }
+
+        std::uint64_t hash = hashKey(id);
+        std::uint64_t mask = header()->slot_capacity - 1;
+        for (std::uint64_t i = hash & mask; slots()[i].hash != 0; i = (i + 1) & mask) {
+            const Slot& slot = slots()[i];
+            if (slot.hash == hash && isLive(slot) && key(slot) == id) {
+                location.file = filePath(files()[slot.file_id]);
+                location.offset = slot.offset;
+                location.length = slot.length;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool RecordIndex::put(std::string_view id, const std::string& path, std::uint64_t offset, std::uint32_t length) {
+        if (!isOpen()) {
+            return false;
+        }
+
+        std::string name = fileName(path);
+        int file_id = fileId(name, true);
+        bool roomy = file_id >= 0
+            && header()->used_count + 1 <= header()->slot_capacity * kMaxLoad
+            && header()->heap_capacity - header()->heap_size >= id.size();
+        if (!roomy) {
+            if (!grow(id.size() + name.size())) {
+                return false;
+            }
+            file_id = fileId(name, true);
+            if (file_id < 0) {
+                return false;
+            }
+        }
+
+        Header* head = header();
+        FileEntry& file = files()[file_id];
+        std::uint64_t hash = hashKey(id);
+        std::uint64_t mask = head->slot_capacity - 1;
+        Slot* reusable = nullptr;
+
+        std::uint64_t i = hash & mask;
+        for (; slots()[i].hash != 0; i = (i + 1) & mask) {
+            Slot& slot = slots()[i];
+            if (slot.hash == hash && key(slot) == id) {
+                // Known ID, live or retired: point it at the new location
+                if (isLive(slot)) {
+                    --files()[slot.file_id].live;
+                    --head->live_count;
+                }
+                slot.file_id = static_cast<std::uint32_t>(file_id);
+                slot.generation = file.generation;
+                slot.offset = offset;
+                slot.length = length;
+                ++file.live;
+                ++head->live_count;
+                return true;
+            }
+            if (reusable == nullptr && !isLive(slot)) {
+                reusable = &slot;
+            }
+        }
+
+        Slot* slot = reusable;
+        if (slot == nullptr) {
+            slot = &slots()[i];
+            ++head->used_count;
+        }
+        if (!store(id, slot->key_offset)) {
+            return false;  // Cannot happen; room was checked above
+        }
+        slot->hash = hash;
+        slot->key_length = static_cast<std::uint32_t>(id.size());
+        slot->file_id = static_cast<std::uint32_t>(file_id);
+        slot->generation = file.generation;
+        slot->offset = offset;
+        slot->length = length;
+        ++file.live;
+        ++head->live_count;
+        return true;
+    }
+
+    void RecordIndex::erase(std::string_view id) {
+        if (!isOpen()) {
+            return;
+        }
+
+        std::uint64_t hash = hashKey(id);
+        std::uint64_t mask = header()->slot_capacity - 1;
+        for (std::uint64_t i = hash & mask; slots()[i].hash != 0; i = (i + 1) & mask) {
+            Slot& slot = slots()[i];
+            if (slot.hash == hash && isLive(slot) && key(slot) == id) {
+                --files()[slot.file_id].live;
+                --header()->live_count;
+                slot.generation = 0;  // Retired; the slot keeps the probe chain intact
+                return;
+            }
+        }
+    }
+
+    void RecordIndex::dropFile(const std::string& path) {
+        if (!isOpen()) {
+            return;
+        }
+
+        int file_id = fileId(fileName(path), false);
+        if (file_id < 0) {
+            return;
+        }
+
+        FileEntry& file = files()[file_id];
+        header()->live_count -= file.live;
+        file.live = 0;
+        if (++file.generation == 0) {
+            file.generation = 1;
+        }
+    }
+
+    void RecordIndex::stampFile(const std::string& path) {
+        if (!isOpen()) {
+            return;
+        }
+
+        std::string name = fileName(path);
+        int file_id = fileId(name, true);
+        if (file_id < 0) {
+            if (!grow(name.size()) || (file_id = fileId(name, true)) < 0) {
+                return;
+            }
+        }
+
+        FileStamp stamp = fileStamp(path);
+        FileEntry& file = files()[file_id];
+        file.size = stamp.size;
+        file.mtime = stamp.mtime;
+    }
+
+    bool RecordIndex::matches(const std::vector<std::string>& paths) const {
+        if (!isOpen()) {
+            return false;
+        }
+
+        std::unordered_set<std::string> names;
+        for (const auto& path : paths) {
+            std::string name = fileName(path);
+            auto it = file_ids_.find(name);
+            if (it == file_ids_.end()) {
+                return false;  // A file the index has never seen
+            }
+
+            const FileEntry& file = files()[it->second];
+            FileStamp stamp = fileStamp(path);
+            if (stamp.size != file.size || stamp.mtime != file.mtime) {
+                return false;  // Changed behind the index's back
+            }
+            names.insert(std::move(name));
+        }
+
+        // Records must not be indexed in files that left the store
+        for (const auto& [name, id] : file_ids_) {
+            if (files()[id].live > 0 && names.count(name) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,190 @@
+#ifndef TRAVEL_PLANNER_RECORD_INDEX_H
+#define TRAVEL_PLANNER_RECORD_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "StorageFormat.h"
+
+namespace travel_planner {
+
+    /**
+     * Where a record lives on disk
+     */
+    struct RecordLocation {
+        std::string file;          // Path of the file holding the record
+        std::uint64_t offset = 0;  // Byte offset, or row number for columnar files
+        std::uint32_t length = 0;  // Encoded size in bytes (0 for columnar rows)
+    };
+
+    /**
+     * Persistent ID -> record location index, kept as a memory-mapped
+     * open-addressing hash table (linear probing) next to a store.
+     *
+     * All files of a store live in one directory; the index keeps a table
+     * of those files with the size and modification time they had when it
+     * last saw them. Rewriting a file bumps its generation, which retires
+     * every entry pointing into the old contents at once. The index is a
+     * cache: callers check that a located record really has the requested
+     * ID and rebuild the index from the store when it does not, or when
+     * the file stamps no longer match (see matches()).
+     *
+     * The file is written in native byte order.
+     */
+    class RecordIndex {
+    public:
+        /**
+         * Constructor
+         * @param index_path Path of the index file
+         */
+        explicit RecordIndex(const std::string& index_path);
+
+        /**
+         * Maps the existing index file
+         * @return False if there is no usable index
+         */
+        bool open();
+
+        /**
+         * Replaces the index file with an empty index
+         * @param expected_records Number of records to size the table for
+         * @return True on success
+         */
+        bool create(std::size_t expected_records);
+
+        /**
+         * Unmaps the index
+         */
+        void close();
+
+        bool isOpen() const { return file_.isOpen(); }
+
+        /**
+         * Looks up a record
+         * @param id Record ID
+         * @param location Receives the location on success
+         * @return True if the ID is indexed
+         */
+        bool find(std::string_view id, RecordLocation& location) const;
+
+        /**
+         * Adds or moves a record
+         * @param id Record ID
+         * @param path File holding the record
+         * @param offset Byte offset or row number of the record
+         * @param length Encoded size of the record
+         * @return True on success
+         */
+        bool put(std::string_view id, const std::string& path, std::uint64_t offset, std::uint32_t length);
+
+        /**
+         * Removes a record
+         * @param id Record ID
+         */
+        void erase(std::string_view id);
+
+        /**
+         * Forgets every record stored in a file, e.g. before it is rewritten
+         * @param path File whose entries are retired
+         */
+        void dropFile(const std::string& path);
+
+        /**
+         * Records the current size and modification time of a file (or that
+         * it no longer exists) after the index was brought up to date with it
+         * @param path File to stamp
+         */
+        void stampFile(const std::string& path);
+
+        /**
+         * Replaces the entries of a file with the records just written to it
+         * @param path File that was written
+         * @param records Records in file order
+         * @param spans Position of each record, as reported by the writer
+         */
+        template <typename Record>
+        void replaceFile(const std::string& path, const std::vector<Record>& records,
+            const std::vector<RecordSpan>& spans) {
+            dropFile(path);
+            for (std::size_t i = 0; i < records.size() && i < spans.size(); ++i) {
+                put(records[i].id, path, spans[i].offset, spans[i].length);
+            }
+            stampFile(path);
+        }
+
+        /**
+         * Checks the index against the files currently making up the store
+         * @param paths Files of the store
+         * @return True if every file is known with its current stamp and no
+         *         other file the index knows about still exists
+         */
+        bool matches(const std::vector<std::string>& paths) const;
+
+        /**
+         * @return Number of indexed records
+         */
+        std::size_t size() const;
+
+    private:
+        struct Header;
+        struct FileEntry;
+        struct Slot;
+
+        Header* header() const;
+        FileEntry* files() const;
+        char* heap() const;
+        Slot* slots() const;
+
+        // File table lookup; adds the file if needed (-1 when full)
+        int fileId(const std::string& name, bool add);
+        bool isLive(const Slot& slot) const;
+        std::string_view key(const Slot& slot) const;
+        std::string filePath(const FileEntry& entry) const;
+
+        // Appends bytes to the heap; returns false when it is full
+        bool store(std::string_view bytes, std::uint32_t& offset);
+
+        // Rewrites the index with room for at least extra more records
+        bool grow(std::size_t extra_keys_bytes);
+
+        std::string index_path_;
+        std::string directory_;
+        MappedFile file_;
+        std::unordered_map<std::string, int> file_ids_;  // Cache of the file table
+    };
+
+    /**
+     * Looks up a record through an index and reads it back, rebuilding the
+     * index once if the located record turns out not to be the one asked for
+     * @param index Open index
+     * @param id Record ID
+     * @param record Receives the record
+     * @param location Receives where the record was found
+     * @param read Called as bool(const RecordLocation&, Record&)
+     * @param rebuild Called as bool() to rebuild the index from the store
+     * @return True if the record was found; when false and the index was
+     *         closed by a failed rebuild, the caller should scan instead
+     */
+    template <typename Record, typename Reader, typename Rebuild>
+    bool findIndexed(RecordIndex& index, const std::string& id, Record& record,
+        RecordLocation& location, Reader&& read, Rebuild&& rebuild) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (!index.find(id, location)) {
+                return false;
+            }
+            if (read(location, record) && record.id == id) {
+                return true;
+            }
+            if (attempt > 0 || !rebuild()) {
+                break;  // Stale and could not be repaired
+            }
+        }
+        return false;
+    }
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_RECORD_INDEX_H
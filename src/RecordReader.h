@@ -0,0 +1,550 @@
+#ifndef TRAVEL_PLANNER_RECORD_READER_H
+#define TRAVEL_PLANNER_RECORD_READER_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "../include/Itinerary.h"
+#include "../include/PackingItem.h"
+#include "../include/Expense.h"
+#include "StorageFormat.h"
+
+namespace travel_planner {
+
+    /**
+     * Field bindings used by the streaming reader. Each specialization maps
+     * JSON keys to field indices once per key and decodes values straight
+     * into the record, without building a DOM.
+     */
+    template <typename Record>
+    struct RecordFields;
+
+    template <>
+    struct RecordFields<Itinerary> {
+        enum Field { Id, Name, StartDate, EndDate, Description, Tags, IsFavorite };
+        static constexpr const char* kName = "itinerary";
+        static constexpr unsigned kRequired = (1u << Id) | (1u << Name) | (1u << StartDate)
+            | (1u << EndDate) | (1u << Description) | (1u << Tags);
+
+        static int field(std::string_view key) {
+            if (key == "id") return Id;
+            if (key == "name") return Name;
+            if (key == "start_date") return StartDate;
+            if (key == "end_date") return EndDate;
+            if (key == "description") return Description;
+            if (key == "tags") return Tags;
+            if (key == "is_favorite") return IsFavorite;
+            return -1;
+        }
+
+        static void reset(Itinerary& r) {
+            r.id.clear();
+            r.name.clear();
+            r.start_date.clear();
+            r.end_date.clear();
+            r.description.clear();
+            r.tags.clear();
+            r.is_favorite = false;  // Default value if not present
+        }
+
+        static bool setString(Itinerary& r, int field, const std::string& value) {
+            switch (field) {
+            case Id: r.id.assign(value); return true;
+            case Name: r.name.assign(value); return true;
+            case StartDate: r.start_date.assign(value); return true;
+            case EndDate: r.end_date.assign(value); return true;
+            case Description: r.description.assign(value); return true;
+            default: return false;
+            }
+        }
+
+        static bool appendString(Itinerary& r, int field, const std::string& value) {
+            if (field != Tags) {
+                return false;
+            }
+            r.tags.push_back(value);
+            return true;
+        }
+
+        static bool setNumber(Itinerary&, int, double) { return false; }
+
+        static bool setBool(Itinerary& r, int field, bool value) {
+            if (field != IsFavorite) {
+                return false;
+            }
+            r.is_favorite = value;
+            return true;
+        }
+    };
+
+    template <>
+    struct RecordFields<PackingItem> {
+        enum Field { Id, ItineraryId, Name, Quantity, Packed };
+        static constexpr const char* kName = "packing item";
+        static constexpr unsigned kRequired = (1u << Id) | (1u << ItineraryId) | (1u << Name)
+            | (1u << Quantity) | (1u << Packed);
+
+        static int field(std::string_view key) {
+            if (key == "id") return Id;
+            if (key == "itinerary_id") return ItineraryId;
+            if (key == "name") return Name;
+            if (key == "quantity") return Quantity;
+            if (key == "packed") return Packed;
+            return -1;
+        }
+
+        static void reset(PackingItem& r) {
+            r.id.clear();
+            r.itinerary_id.clear();
+            r.name.clear();
+            r.quantity = 1;
+            r.packed = false;
+        }
+
+        static bool setString(PackingItem& r, int field, const std::string& value) {
+            switch (field) {
+            case Id: r.id.assign(value); return true;
+            case ItineraryId: r.itinerary_id.assign(value); return true;
+            case Name: r.name.assign(value); return true;
+            default: return false;
+            }
+        }
+
+        static bool appendString(PackingItem&, int, const std::string&) { return false; }
+
+        static bool setNumber(PackingItem& r, int field, double value) {
+            if (field != Quantity) {
+                return false;
+            }
+            r.quantity = static_cast<int>(value);
+            return true;
+        }
+
+        static bool setBool(PackingItem& r, int field, bool value) {
+            if (field != Packed) {
+                return false;
+            }
+            r.packed = value;
+            return true;
+        }
+    };
+
+    template <>
+    struct RecordFields<Expense> {
+        enum Field { Id, ItineraryId, Amount, Category, Date, Description };
+        static constexpr const char* kName = "expense";
+        static constexpr unsigned kRequired = (1u << Id) | (1u << ItineraryId) | (1u << Amount)
+            | (1u << Category) | (1u << Date) | (1u << Description);
+
+        static int field(std::string_view key) {
+            if (key == "id") return Id;
+            if (key == "itinerary_id") return ItineraryId;
+            if (key == "amount") return Amount;
+            if (key == "category") return Category;
+            if (key == "date") return Date;
+            if (key == "description") return Description;
+            return -1;
+        }
+
+        static void reset(Expense& r) {
+            r.id.clear();
+            r.itinerary_id.clear();
+            r.amount = 0.0;
+            r.category.clear();
+            r.date.clear();
+            r.description.clear();
+        }
+
+        static bool setString(Expense& r, int field, const std::string& value) {
+            switch (field) {
+            case Id: r.id.assign(value); return true;
+            case ItineraryId: r.itinerary_id.assign(value); return true;
+            case Category: r.category.assign(value); return true;
+            case Date: r.date.assign(value); return true;
+            case Description: r.description.assign(value); return true;
+            default: return false;
+            }
+        }
+
+        static bool appendString(Expense&, int, const std::string&) { return false; }
+
+        static bool setNumber(Expense& r, int field, double value) {
+            if (field != Amount) {
+                return false;
+            }
+            r.amount = value;
+            return true;
+        }
+
+        static bool setBool(Expense&, int, bool) { return false; }
+    };
+
+    /**
+     * SAX handler that decodes a top-level array of records one at a time
+     * into a single reused scratch record and hands each one to a visitor.
+     *
+     * The visitor is called as bool(const Record&); returning false stops
+     * the scan. Records with missing or mistyped fields are reported and
+     * skipped, the rest of the array is still read.
+     *
+     * A handler created with depth 1 reads a single record object instead
+     * of an array.
+     */
+    template <typename Record, typename Visitor>
+    class RecordSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        using Fields = RecordFields<Record>;
+
+        explicit RecordSaxHandler(Visitor& visitor, int depth = 0) : visitor_(visitor), depth_(depth) {}
+
+        /**
+         * Tracks where each record starts and ends while parsing from memory
+         * @param cursor Updated by the input iterator to the next unread byte
+         * @param base Start of the file, offsets are relative to it
+         * @param text True for JSON input, false for CBOR and MessagePack
+         */
+        void trackPositions(const char* const* cursor, const char* base, bool text) {
+            cursor_ = cursor;
+            base_ = base;
+            text_ = text;
+        }
+
+        // Position of the record being handed to the visitor (when tracking)
+        RecordSpan span() const {
+            return { record_start_, static_cast<std::uint32_t>(record_end_ - record_start_) };
+        }
+
+        bool null() override { return value() && (skipping() || accept(false)); }
+        bool boolean(bool val) override { return value() && (skipping() || accept(Fields::setBool(record_, field_, val))); }
+        bool number_integer(number_integer_t val) override { return number(static_cast<double>(val)); }
+        bool number_unsigned(number_unsigned_t val) override { return number(static_cast<double>(val)); }
+        bool number_float(number_float_t val, const string_t&) override { return number(static_cast<double>(val)); }
+
+        bool string(string_t& val) override {
+            if (depth_ == 3 && in_list_) {
+                // Element of a list field such as Itinerary::tags
+                if (field_ >= 0 && !Fields::appendString(record_, field_, val)) {
+                    record_ok_ = false;
+                }
+                return true;
+            }
+            return value() && (skipping() || accept(Fields::setString(record_, field_, val)));
+        }
+
+        bool binary(binary_t&) override { return value() && (skipping() || accept(false)); }
+
+        bool start_object(std::size_t) override {
+            ++depth_;
+            if (depth_ == 1) {
+                return fail("expected array");
+            }
+            if (depth_ == 2) {
+                Fields::reset(record_);
+                seen_ = 0;
+                record_ok_ = true;
+                if (cursor_ != nullptr) {
+                    // JSON has consumed exactly the '{'; binary input starts
+                    // right where the previous element ended
+                    record_start_ = text_ ? position() - 1 : boundary_;
+                }
+            }
+            else if (depth_ == 3 && field_ >= 0) {
+                record_ok_ = false;  // Objects are never field values
+            }
+            return true;
+        }
+
+        bool end_object() override {
+            if (depth_-- == 2) {
+                if (cursor_ != nullptr) {
+                    record_end_ = position();
+                    boundary_ = record_end_;
+                }
+                if (record_ok_ && (seen_ & Fields::kRequired) == Fields::kRequired) {
+                    ++count_;
+                    return visitor_(static_cast<const Record&>(record_));
+                }
+                ++skipped_;
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t) override {
+            ++depth_;
+            if (depth_ == 1 && cursor_ != nullptr) {
+                boundary_ = position();
+            }
+            if (depth_ == 3) {
+                in_list_ = true;
+                markSeen();
+            }
+            return true;
+        }
+
+        bool end_array() override {
+            if (depth_-- == 3) {
+                in_list_ = false;
+            }
+            return true;
+        }
+
+        bool key(string_t& val) override {
+            if (depth_ == 2) {
+                field_ = Fields::field(val);
+            }
+            return true;
+        }
+
+        bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override {
+            error_ = ex.what();
+            error_position_ = position;
+            return false;
+        }
+
+        std::size_t count() const { return count_; }
+        std::size_t skipped() const { return skipped_; }
+        const std::string& error() const { return error_; }
+
+    private:
+        // Scalar at record level (depth 2); anything deeper belongs to a
+        // nested value that is not a field of this record
+        bool value() {
+            if (depth_ == 2) {
+                markSeen();
+            }
+            else if (depth_ < 2) {
+                return fail("expected array of objects");
+            }
+            return true;
+        }
+
+        bool number(double val) {
+            return value() && (skipping() || accept(Fields::setNumber(record_, field_, val)));
+        }
+
+        bool skipping() const { return depth_ != 2 || field_ < 0; }
+
+        bool accept(bool ok) {
+            record_ok_ = record_ok_ && ok;
+            return true;
+        }
+
+        void markSeen() {
+            if (field_ >= 0) {
+                seen_ |= 1u << field_;
+            }
+        }
+
+        bool fail(const char* message) {
+            error_ = message;
+            return false;
+        }
+
+        std::uint64_t position() const {
+            return static_cast<std::uint64_t>(*cursor_ - base_);
+        }
+
+        Visitor& visitor_;
+        Record record_;
+        int depth_ = 0;
+        int field_ = -1;
+        unsigned seen_ = 0;
+        bool record_ok_ = true;
+        bool in_list_ = false;
+        std::size_t count_ = 0;
+        std::size_t skipped_ = 0;
+        std::size_t error_position_ = 0;
+        std::string error_;
+        const char* const* cursor_ = nullptr;
+        const char* base_ = nullptr;
+        bool text_ = true;
+        std::uint64_t boundary_ = 0;
+        std::uint64_t record_start_ = 0;
+        std::uint64_t record_end_ = 0;
+    };
+
+    /**
+     * Input iterator over a memory buffer that publishes how far the parser
+     * has read, so a SAX handler can tell where records start and end
+     */
+    class TrackingIterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const char*;
+        using reference = const char&;
+
+        TrackingIterator(const char* position, const char** cursor) : position_(position), cursor_(cursor) {}
+
+        reference operator*() const { return *position_; }
+
+        TrackingIterator& operator++() {
+            *cursor_ = ++position_;
+            return *this;
+        }
+
+        TrackingIterator operator++(int) {
+            TrackingIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const TrackingIterator& other) const { return position_ == other.position_; }
+        bool operator!=(const TrackingIterator& other) const { return position_ != other.position_; }
+
+    private:
+        const char* position_;
+        const char** cursor_;
+    };
+
+    /**
+     * Streams an array of records to a visitor without building a DOM.
+     * JSON, CBOR and MessagePack input are told apart by their first bytes.
+     * @param in Input stream positioned at the start of the document; open
+     *           it in binary mode
+     * @param visitor Called as bool(const Record&); return false to stop
+     * @param error Receives a message on failure
+     * @param hint Expected format, usually formatForPath() of the file
+     * @return False on a syntax or structural error; stopping early through
+     *         the visitor is not an error
+     */
+    template <typename Record, typename Visitor>
+    bool readRecords(std::istream& in, Visitor&& visitor, std::string& error,
+        StorageFormat hint = StorageFormat::Json) {
+        RecordSaxHandler<Record, std::remove_reference_t<Visitor>> handler(visitor);
+
+        switch (sniffFormat(in, hint)) {
+        case StorageFormat::Cbor:
+            nlohmann::json::sax_parse(in, &handler, nlohmann::json::input_format_t::cbor);
+            break;
+        case StorageFormat::MsgPack:
+            nlohmann::json::sax_parse(in, &handler, nlohmann::json::input_format_t::msgpack);
+            break;
+        default:
+            nlohmann::json::sax_parse(in, &handler);
+            break;
+        }
+
+        if (!handler.error().empty()) {
+            error = handler.error();
+            return false;
+        }
+        if (handler.skipped() > 0) {
+            error = "skipped " + std::to_string(handler.skipped()) + " invalid "
+                + RecordFields<Record>::kName + " record(s)";
+        }
+        return true;
+    }
+
+    /**
+     * Streams the records of a file held in memory together with their
+     * positions, e.g. to rebuild an index over the file
+     * @param data File contents
+     * @param size Size of the contents
+     * @param hint Expected format, usually formatForPath() of the file
+     * @param visitor Called as bool(const Record&, RecordSpan); return
+     *                false to stop
+     * @param error Receives a message on failure
+     * @return False on a syntax or structural error
+     */
+    template <typename Record, typename Visitor>
+    bool scanRecordSpans(const char* data, std::size_t size, StorageFormat hint, Visitor&& visitor, std::string& error) {
+        std::size_t header = 0;
+        StorageFormat format = sniffFormat(data, size, hint, header);
+
+        const char* cursor = data + header;
+        RecordSaxHandler<Record, std::function<bool(const Record&)>>* active = nullptr;
+        std::function<bool(const Record&)> forward = [&visitor, &active](const Record& record) {
+            return visitor(record, active->span());
+        };
+        RecordSaxHandler<Record, std::function<bool(const Record&)>> handler(forward);
+        handler.trackPositions(&cursor, data, format == StorageFormat::Json);
+        active = &handler;
+
+        TrackingIterator first(data + header, &cursor);
+        TrackingIterator last(data + size, &cursor);
+        switch (format) {
+        case StorageFormat::Cbor:
+            nlohmann::json::sax_parse(first, last, &handler, nlohmann::json::input_format_t::cbor);
+            break;
+        case StorageFormat::MsgPack:
+            nlohmann::json::sax_parse(first, last, &handler, nlohmann::json::input_format_t::msgpack);
+            break;
+        default:
+            nlohmann::json::sax_parse(first, last, &handler);
+            break;
+        }
+
+        if (!handler.error().empty()) {
+            error = handler.error();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Decodes a single record object, as located by a RecordSpan. The
+     * encoding is recognized from the first byte.
+     * @param data Encoded record
+     * @param size Size of the encoded record
+     * @param record Receives the record
+     * @return True if a complete, valid record was decoded
+     */
+    template <typename Record>
+    bool readRecord(const char* data, std::size_t size, Record& record) {
+        if (size == 0) {
+            return false;
+        }
+
+        bool found = false;
+        auto visitor = [&record, &found](const Record& decoded) {
+            record = decoded;
+            found = true;
+            return true;
+        };
+        RecordSaxHandler<Record, decltype(visitor)> handler(visitor, 1);
+
+        // Maps: 0xA0-0xBF in CBOR, fixmap/map16/map32 in MessagePack
+        unsigned char first = static_cast<unsigned char>(data[0]);
+        if (first >= 0xA0 && first <= 0xBF) {
+            nlohmann::json::sax_parse(data, data + size, &handler, nlohmann::json::input_format_t::cbor);
+        }
+        else if ((first >= 0x80 && first <= 0x8F) || first == 0xDE || first == 0xDF) {
+            nlohmann::json::sax_parse(data, data + size, &handler, nlohmann::json::input_format_t::msgpack);
+        }
+        else {
+            nlohmann::json::sax_parse(data, data + size, &handler);
+        }
+        return found && handler.error().empty();
+    }
+
+    /**
+     * Reads a single record straight from its position in a file
+     * @param path File holding the record
+     * @param span Position of the record
+     * @param record Receives the record
+     * @return True if a valid record was found there
+     */
+    template <typename Record>
+    bool readRecordAt(const std::string& path, const RecordSpan& span, Record& record) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open() || !file.seekg(static_cast<std::streamoff>(span.offset))) {
+            return false;
+        }
+
+        std::string buffer(span.length, '\0');
+        if (!file.read(&buffer[0], static_cast<std::streamsize>(buffer.size()))) {
+            return false;
+        }
+        return readRecord(buffer.data(), buffer.size(), record);
+    }
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_RECORD_READER_H
@@ -0,0 +1,523 @@
+#include "RecordWriter.h"
+#include "Profiler.h"
+#include "RecordCache.h"
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace travel_planner {
+
+    namespace {
+
+        // Record files that failed to parse, by cacheKey(), with their
+        // stamp at the time
+        std::unordered_map<std::string, FileStamp>& unreadableFiles() {
+            static std::unordered_map<std::string, FileStamp> files;
+            return files;
+        }
+
+        // Length of the well-formed UTF-8 sequence starting at a byte of 0x80
+        // or above, or 0 if it is malformed (overlong, a surrogate, above
+        // U+10FFFF or cut short)
+        std::size_t utf8SequenceLength(std::string_view text, std::size_t at) {
+            const unsigned char lead = static_cast<unsigned char>(text[at]);
+            std::size_t length;
+            unsigned char low = 0x80;
+            unsigned char high = 0xBF;  // Range of the second byte
+            if (lead >= 0xC2 && lead <= 0xDF) {
+                length = 2;
+            }
+            else if (lead >= 0xE0 && lead <= 0xEF) {
+                length = 3;
+                if (lead == 0xE0) low = 0xA0;
+                if (lead == 0xED) high = 0x9F;
+            }
+            else if (lead >= 0xF0 && lead <= 0xF4) {
+                length = 4;
+                if (lead == 0xF0) low = 0x90;
+                if (lead == 0xF4) high = 0x8F;
+            }
+            else {
+                return 0;
+            }
+            if (text.size() - at < length) {
+                return 0;
+            }
+            for (std::size_t i = 1; i < length; ++i) {
+                const unsigned char c = static_cast<unsigned char>(text[at + i]);
+                if (c < (i == 1 ? low : 0x80) || c > (i == 1 ? high : 0xBF)) {
+                    return 0;
+                }
+            }
+            return length;
+        }
+
+    } // namespace
+
+    void setUnreadable(const std::string& path, bool unreadable) {
+        if (unreadable) {
+            unreadableFiles()[cacheKey(path)] = fileStamp(path);
+        }
+        else if (!unreadableFiles().empty()) {
+            unreadableFiles().erase(cacheKey(path));
+        }
+    }
+
+    bool isUnreadable(const std::string& path) {
+        auto& files = unreadableFiles();
+        if (files.empty()) {
+            return false;
+        }
+        auto it = files.find(cacheKey(path));
+        if (it == files.end()) {
+            return false;
+        }
+        if (fileStamp(path) != it->second) {
+            files.erase(it);  // Replaced or repaired since
+            return false;
+        }
+        return true;
+    }
+
+    OutputBuffer::OutputBuffer(std::size_t capacity)
+        : buffer_(capacity) {
+    }
+
+    OutputBuffer::~OutputBuffer() {
+        if (file_ != nullptr) {
+            // Never committed; drop the partial output
+            std::fclose(file_);
+            std::error_code ec;
+            std::filesystem::remove(temp_path_, ec);
+        }
+    }
+
+    bool OutputBuffer::open(const std::string& path) {
+        ProfileScope profile(ProfilePhase::Write);
+        if (isUnreadable(path)) {
+            std::cerr << "Error: " << path << " could not be read; not overwriting it" << std::endl;
+            return false;
+        }
+        path_ = path;
+        temp_path_ = path + ".tmp";
+        used_ = 0;
+        flushed_ = 0;
+        failed_ = false;
+
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        std::error_code ec;
+        if (!parent.empty() && !std::filesystem::exists(parent, ec)) {
+            std::filesystem::create_directories(parent, ec);
+        }
+
+        file_ = std::fopen(temp_path_.c_str(), "wb");
+        if (file_ == nullptr) {
+            std::cerr << "Error opening file for writing: " << temp_path_ << std::endl;
+            return false;
+        }
+
+        // We do our own buffering
+        std::setvbuf(file_, nullptr, _IONBF, 0);
+        return true;
+    }
+
+    void OutputBuffer::write(const char* data, std::size_t size) {
+        if (size > buffer_.size() - used_) {
+            flush();
+            if (size > buffer_.size()) {
+                // Larger than the whole buffer; write it through
+                ProfileScope profile(ProfilePhase::Write);
+                failed_ = failed_ || std::fwrite(data, 1, size, file_) != size;
+                flushed_ += size;
+                return;
+            }
+        }
+        std::memcpy(buffer_.data() + used_, data, size);
+        used_ += size;
+    }
+
+    void OutputBuffer::flush() {
+        ProfileScope profile(ProfilePhase::Write);
+        if (used_ > 0 && file_ != nullptr) {
+            failed_ = failed_ || std::fwrite(buffer_.data(), 1, used_, file_) != used_;
+        }
+        flushed_ += used_;
+        used_ = 0;
+    }
+
+    bool OutputBuffer::commit() {
+        if (file_ == nullptr) {
+            return false;
+        }
+        ProfileScope profile(ProfilePhase::Write);
+
+        flush();
+        failed_ = std::fclose(file_) != 0 || failed_;
+        file_ = nullptr;
+
+        std::error_code ec;
+        if (failed_) {
+            std::cerr << "Error writing " << temp_path_ << std::endl;
+            std::filesystem::remove(temp_path_, ec);
+            return false;
+        }
+
+        std::filesystem::rename(temp_path_, path_, ec);
+        if (ec) {
+            std::cerr << "Error replacing " << path_ << ": " << ec.message() << std::endl;
+            std::filesystem::remove(temp_path_, ec);
+            return false;
+        }
+        return true;
+    }
+
+    void OutputBuffer::discard(std::string_view error) {
+        std::cerr << "Error writing " << path_ << ": " << error << std::endl;
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            file_ = nullptr;
+            std::error_code ec;
+            std::filesystem::remove(temp_path_, ec);
+        }
+    }
+
+    void JsonWriter::newline(std::size_t depth) {
+        if (indent_ > 0) {
+            out_.put('\n');
+            for (std::size_t i = 0; i < depth * static_cast<std::size_t>(indent_); ++i) {
+                out_.put(' ');
+            }
+        }
+    }
+
+    void JsonWriter::beforeItem() {
+        if (pending_value_) {
+            pending_value_ = false;  // Value follows its key on the same line
+            return;
+        }
+        if (levels_.empty()) {
+            return;
+        }
+
+        Level& level = levels_.back();
+        if (!level.empty) {
+            out_.put(',');
+        }
+        level.empty = false;
+        newline(levels_.size());
+    }
+
+    void JsonWriter::beginArray(std::size_t) {
+        beforeItem();
+        out_.put('[');
+        levels_.push_back(Level());
+    }
+
+    void JsonWriter::endArray() {
+        bool empty = levels_.back().empty;
+        levels_.pop_back();
+        if (!empty) {
+            newline(levels_.size());
+        }
+        out_.put(']');
+    }
+
+    void JsonWriter::beginObject(std::size_t) {
+        beforeItem();
+        out_.put('{');
+        levels_.push_back(Level());
+    }
+
+    void JsonWriter::endObject() {
+        bool empty = levels_.back().empty;
+        levels_.pop_back();
+        if (!empty) {
+            newline(levels_.size());
+        }
+        out_.put('}');
+    }
+
+    void JsonWriter::key(std::string_view name) {
+        beforeItem();
+        writeEscaped(name);
+        out_.put(':');
+        if (indent_ > 0) {
+            out_.put(' ');
+        }
+        pending_value_ = true;
+    }
+
+    void JsonWriter::string(std::string_view value) {
+        beforeItem();
+        writeEscaped(value);
+    }
+
+    void JsonWriter::writeEscaped(std::string_view value) {
+        out_.put('"');
+
+        // Copy runs of plain characters in one go; escape the rest the same
+        // way nlohmann::json::dump does
+        static const char* hex_chars = "0123456789abcdef";
+        std::size_t run_start = 0;
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(value[i]);
+            if (c >= 0x80) {
+                // Multi-byte characters are copied as they are, once checked
+                std::size_t length = utf8SequenceLength(value, i);
+                if (length == 0) {
+                    if (error_.empty()) {
+                        error_ = "invalid UTF-8 byte at index " + std::to_string(i) + ": 0x"
+                            + hex_chars[c >> 4] + hex_chars[c & 0x0F];
+                    }
+                    length = 1;
+                }
+                i += length - 1;
+                continue;
+            }
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+
+            out_.write(value.data() + run_start, i - run_start);
+            run_start = i + 1;
+
+            switch (c) {
+            case '"': out_.write("\\\"", 2); break;
+            case '\\': out_.write("\\\\", 2); break;
+            case '\b': out_.write("\\b", 2); break;
+            case '\f': out_.write("\\f", 2); break;
+            case '\n': out_.write("\\n", 2); break;
+            case '\r': out_.write("\\r", 2); break;
+            case '\t': out_.write("\\t", 2); break;
+            default: {
+                char escaped[6] = { '\\', 'u', '0', '0', hex_chars[c >> 4], hex_chars[c & 0x0F] };
+                out_.write(escaped, sizeof(escaped));
+                break;
+            }
+            }
+        }
+        out_.write(value.data() + run_start, value.size() - run_start);
+
+        out_.put('"');
+    }
+
+    void JsonWriter::number(double value) {
+        beforeItem();
+        if (!std::isfinite(value)) {
+            out_.write("null", 4);  // As nlohmann does for NaN and infinity
+            return;
+        }
+
+        // Same Grisu2 conversion dump() uses, so the digits (and the ".0" on
+        // integral values) match the DOM serializer exactly
+        char buffer[64];
+        char* end = nlohmann::detail::to_chars(buffer, buffer + sizeof(buffer), value);
+        out_.write(buffer, static_cast<std::size_t>(end - buffer));
+    }
+
+    void JsonWriter::integer(std::int64_t value) {
+        beforeItem();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out_.write(buffer, static_cast<std::size_t>(result.ptr - buffer));
+    }
+
+    void JsonWriter::boolean(bool value) {
+        beforeItem();
+        if (value) {
+            out_.write("true", 4);
+        }
+        else {
+            out_.write("false", 5);
+        }
+    }
+
+    namespace {
+
+        // Big-endian encoding shared by CBOR and MessagePack
+        void putBigEndian(OutputBuffer& out, std::uint64_t value, int bytes) {
+            for (int shift = (bytes - 1) * 8; shift >= 0; shift -= 8) {
+                out.put(static_cast<char>((value >> shift) & 0xFF));
+            }
+        }
+
+        // True if a double survives a round trip through float
+        bool fitsFloat(double value) {
+            return !std::isfinite(value)
+                || (std::fabs(value) <= std::numeric_limits<float>::max()
+                    && static_cast<double>(static_cast<float>(value)) == value);
+        }
+
+        void putFloat(OutputBuffer& out, char marker, float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            out.put(marker);
+            putBigEndian(out, bits, 4);
+        }
+
+        void putDouble(OutputBuffer& out, char marker, double value) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            out.put(marker);
+            putBigEndian(out, bits, 8);
+        }
+
+    } // namespace
+
+    CborWriter::CborWriter(OutputBuffer& out)
+        : out_(out) {
+        out_.write("\xD9\xD9\xF7", 3);  // Self-describe tag 55799
+    }
+
+    void CborWriter::head(unsigned major, std::uint64_t value) {
+        char type = static_cast<char>(major << 5);
+        if (value < 24) {
+            out_.put(static_cast<char>(type | value));
+        }
+        else if (value <= 0xFF) {
+            out_.put(static_cast<char>(type | 24));
+            putBigEndian(out_, value, 1);
+        }
+        else if (value <= 0xFFFF) {
+            out_.put(static_cast<char>(type | 25));
+            putBigEndian(out_, value, 2);
+        }
+        else if (value <= 0xFFFFFFFFu) {
+            out_.put(static_cast<char>(type | 26));
+            putBigEndian(out_, value, 4);
+        }
+        else {
+            out_.put(static_cast<char>(type | 27));
+            putBigEndian(out_, value, 8);
+        }
+    }
+
+    void CborWriter::string(std::string_view value) {
+        head(3, value.size());
+        out_.write(value.data(), value.size());
+    }
+
+    void CborWriter::number(double value) {
+        if (fitsFloat(value)) {
+            putFloat(out_, '\xFA', static_cast<float>(value));
+        }
+        else {
+            putDouble(out_, '\xFB', value);
+        }
+    }
+
+    void CborWriter::integer(std::int64_t value) {
+        if (value >= 0) {
+            head(0, static_cast<std::uint64_t>(value));
+        }
+        else {
+            head(1, static_cast<std::uint64_t>(-(value + 1)));
+        }
+    }
+
+    void MsgPackWriter::beginArray(std::size_t size) {
+        if (size <= 15) {
+            out_.put(static_cast<char>(0x90 | size));
+        }
+        else if (size <= 0xFFFF) {
+            out_.put('\xDC');
+            putBigEndian(out_, size, 2);
+        }
+        else {
+            out_.put('\xDD');
+            putBigEndian(out_, size, 4);
+        }
+    }
+
+    void MsgPackWriter::beginObject(std::size_t size) {
+        if (size <= 15) {
+            out_.put(static_cast<char>(0x80 | size));
+        }
+        else if (size <= 0xFFFF) {
+            out_.put('\xDE');
+            putBigEndian(out_, size, 2);
+        }
+        else {
+            out_.put('\xDF');
+            putBigEndian(out_, size, 4);
+        }
+    }
+
+    void MsgPackWriter::string(std::string_view value) {
+        std::size_t size = value.size();
+        if (size <= 31) {
+            out_.put(static_cast<char>(0xA0 | size));
+        }
+        else if (size <= 0xFF) {
+            out_.put('\xD9');
+            putBigEndian(out_, size, 1);
+        }
+        else if (size <= 0xFFFF) {
+            out_.put('\xDA');
+            putBigEndian(out_, size, 2);
+        }
+        else {
+            out_.put('\xDB');
+            putBigEndian(out_, size, 4);
+        }
+        out_.write(value.data(), size);
+    }
+
+    void MsgPackWriter::number(double value) {
+        if (fitsFloat(value)) {
+            putFloat(out_, '\xCA', static_cast<float>(value));
+        }
+        else {
+            putDouble(out_, '\xCB', value);
+        }
+    }
+
+    void MsgPackWriter::integer(std::int64_t value) {
+        if (value >= 0) {
+            if (value <= 0x7F) {
+                out_.put(static_cast<char>(value));  // positive fixint
+            }
+            else if (value <= 0xFF) {
+                out_.put('\xCC');
+                putBigEndian(out_, static_cast<std::uint64_t>(value), 1);
+            }
+            else if (value <= 0xFFFF) {
+                out_.put('\xCD');
+                putBigEndian(out_, static_cast<std::uint64_t>(value), 2);
+            }
+            else if (value <= 0xFFFFFFFFll) {
+                out_.put('\xCE');
+                putBigEndian(out_, static_cast<std::uint64_t>(value), 4);
+            }
+            else {
+                out_.put('\xCF');
+                putBigEndian(out_, static_cast<std::uint64_t>(value), 8);
+            }
+        }
+        else if (value >= -32) {
+            out_.put(static_cast<char>(value));  // negative fixint
+        }
+        else if (value >= -128) {
+            out_.put('\xD0');
+            putBigEndian(out_, static_cast<std::uint64_t>(value), 1);
+        }
+        else if (value >= -32768) {
+            out_.put('\xD1');
+            putBigEndian(out_, static_cast<std::uint64_t>(value), 2);
+        }
+        else if (value >= -2147483648ll) {
+            out_.put('\xD2');
+            putBigEndian(out_, static_cast<std::uint64_t>(value), 4);
+        }
+        else {
+            out_.put('\xD3');
+            putBigEndian(out_, static_cast<std::uint64_t>(value), 8);
+        }
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,293 @@
+#ifndef TRAVEL_PLANNER_RECORD_WRITER_H
+#define TRAVEL_PLANNER_RECORD_WRITER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/Itinerary.h"
+#include "../include/PackingItem.h"
+#include "../include/Expense.h"
+#include "StorageFormat.h"
+#include "Profiler.h"
+#include "Trace.h"
+
+namespace travel_planner {
+
+    /**
+     * Large write buffer flushed straight to a file. Output goes to a
+     * temporary sibling file that replaces the target on commit(), so a
+     * failed save never leaves a truncated store behind.
+     */
+    class OutputBuffer {
+    public:
+        explicit OutputBuffer(std::size_t capacity = 1 << 20);
+        ~OutputBuffer();
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        /**
+         * Opens the temporary file for a target path. Refuses a target
+         * marked unreadable (see setUnreadable()).
+         * @param path File that commit() will replace
+         * @return True on success
+         */
+        bool open(const std::string& path);
+
+        /**
+         * Flushes, closes and moves the output over the target path
+         * @return True if every write succeeded
+         */
+        bool commit();
+
+        /**
+         * Drops the output, leaving the target as it was, and reports why
+         * @param error Reason the output is unusable
+         */
+        void discard(std::string_view error);
+
+        void put(char c) {
+            if (used_ == buffer_.size()) {
+                flush();
+            }
+            buffer_[used_++] = c;
+        }
+
+        void write(const char* data, std::size_t size);
+        void write(std::string_view text) { write(text.data(), text.size()); }
+
+        // Bytes written so far, including those still buffered
+        std::uint64_t offset() const { return flushed_ + used_; }
+
+    private:
+        void flush();
+
+        std::vector<char> buffer_;
+        std::size_t used_ = 0;
+        std::uint64_t flushed_ = 0;
+        std::FILE* file_ = nullptr;
+        std::string path_;
+        std::string temp_path_;
+        bool failed_ = false;
+    };
+
+    /**
+     * Records whether the last read of a record file failed to parse. A file
+     * marked unreadable is not replaced by writeRecords() until it changes
+     * on disk, so saving what a failed load returned never drops the records
+     * it could not see.
+     * @param path Record file
+     * @param unreadable True after a parse failure, false after a good read
+     */
+    void setUnreadable(const std::string& path, bool unreadable);
+
+    /**
+     * @return True if a record file failed to parse and has not changed since
+     */
+    bool isUnreadable(const std::string& path);
+
+    /**
+     * Streaming JSON writer. With an indent it reproduces the layout of
+     * nlohmann::json::dump(indent); with indent 0 the output is compact.
+     * Objects must be written with their keys in sorted order to match
+     * what nlohmann produces. Strings must be valid UTF-8; like dump(), the
+     * writer fails on anything else (see error()).
+     */
+    class JsonWriter {
+    public:
+        JsonWriter(OutputBuffer& out, int indent) : out_(out), indent_(indent) {}
+
+        void beginArray(std::size_t size);
+        void endArray();
+        void beginObject(std::size_t size);
+        void endObject();
+        void key(std::string_view name);
+        void string(std::string_view value);
+        void number(double value);
+        void integer(std::int64_t value);
+        void boolean(bool value);
+
+        // Writes the separator before the next array element now, so the
+        // element itself starts at the current output offset
+        void separate() {
+            beforeItem();
+            pending_value_ = true;
+        }
+
+        // First error met, e.g. a string that is not valid UTF-8; empty if
+        // the output is good
+        const std::string& error() const { return error_; }
+
+    private:
+        // Separator and indentation before a value or key
+        void beforeItem();
+        void newline(std::size_t depth);
+
+        // Quoted, escaped string without any separator
+        void writeEscaped(std::string_view value);
+
+        struct Level {
+            bool empty = true;
+        };
+
+        OutputBuffer& out_;
+        int indent_;
+        std::vector<Level> levels_;
+        bool pending_value_ = false;  // A key was just written
+        std::string error_;
+    };
+
+    /**
+     * Streaming CBOR writer with the same interface as JsonWriter. The
+     * stream starts with the CBOR self-describe tag so loaders can tell it
+     * apart from MessagePack. Doubles that are exact as floats are stored
+     * in 4 bytes.
+     */
+    class CborWriter {
+    public:
+        explicit CborWriter(OutputBuffer& out);
+
+        void beginArray(std::size_t size) { head(4, size); }
+        void endArray() {}
+        void beginObject(std::size_t size) { head(5, size); }
+        void endObject() {}
+        void key(std::string_view name) { string(name); }
+        void string(std::string_view value);
+        void number(double value);
+        void integer(std::int64_t value);
+        void boolean(bool value) { out_.put(value ? '\xF5' : '\xF4'); }
+        void separate() {}
+
+    private:
+        // Major type with its length or value argument
+        void head(unsigned major, std::uint64_t value);
+
+        OutputBuffer& out_;
+    };
+
+    /**
+     * Streaming MessagePack writer with the same interface as JsonWriter
+     */
+    class MsgPackWriter {
+    public:
+        explicit MsgPackWriter(OutputBuffer& out) : out_(out) {}
+
+        void beginArray(std::size_t size);
+        void endArray() {}
+        void beginObject(std::size_t size);
+        void endObject() {}
+        void key(std::string_view name) { string(name); }
+        void string(std::string_view value);
+        void number(double value);
+        void integer(std::int64_t value);
+        void boolean(bool value) { out_.put(value ? '\xC3' : '\xC2'); }
+        void separate() {}
+
+    private:
+        OutputBuffer& out_;
+    };
+
+    // Per-record encoders; keys are written in sorted order
+    template <typename Writer>
+    void writeRecord(Writer& w, const Itinerary& itinerary) {
+        w.beginObject(7);
+        w.key("description"); w.string(itinerary.description);
+        w.key("end_date"); w.string(itinerary.end_date);
+        w.key("id"); w.string(itinerary.id);
+        w.key("is_favorite"); w.boolean(itinerary.is_favorite);
+        w.key("name"); w.string(itinerary.name);
+        w.key("start_date"); w.string(itinerary.start_date);
+        w.key("tags");
+        w.beginArray(itinerary.tags.size());
+        for (const auto& tag : itinerary.tags) {
+            w.string(tag);
+        }
+        w.endArray();
+        w.endObject();
+    }
+
+    template <typename Writer>
+    void writeRecord(Writer& w, const PackingItem& item) {
+        w.beginObject(5);
+        w.key("id"); w.string(item.id);
+        w.key("itinerary_id"); w.string(item.itinerary_id);
+        w.key("name"); w.string(item.name);
+        w.key("packed"); w.boolean(item.packed);
+        w.key("quantity"); w.integer(item.quantity);
+        w.endObject();
+    }
+
+    template <typename Writer>
+    void writeRecord(Writer& w, const Expense& expense) {
+        w.beginObject(6);
+        w.key("amount"); w.number(expense.amount);
+        w.key("category"); w.string(expense.category);
+        w.key("date"); w.string(expense.date);
+        w.key("description"); w.string(expense.description);
+        w.key("id"); w.string(expense.id);
+        w.key("itinerary_id"); w.string(expense.itinerary_id);
+        w.endObject();
+    }
+
+    /**
+     * Serializes records as an array directly into a file
+     * @param path Destination file, replaced atomically
+     * @param records Records to write
+     * @param format Encoding of the file
+     * @param indent JSON indentation width; 0 writes compact output
+     * @param spans If given, receives the position of every record in the
+     *              file, in the order of records
+     * @return True on success
+     */
+    template <typename Record>
+    bool writeRecords(const std::string& path, const std::vector<Record>& records,
+        StorageFormat format, int indent, std::vector<RecordSpan>* spans = nullptr) {
+        TraceSpan span("writeRecords", path);
+        OutputBuffer out;
+        if (!out.open(path)) {
+            return false;
+        }
+
+        if (spans != nullptr) {
+            spans->clear();
+            spans->reserve(records.size());
+        }
+
+        ProfileScope profile(ProfilePhase::Serialize);
+        auto encode = [&records, &out, spans](auto& writer) {
+            writer.beginArray(records.size());
+            for (const auto& record : records) {
+                writer.separate();
+                std::uint64_t start = out.offset();
+                writeRecord(writer, record);
+                if (spans != nullptr) {
+                    spans->push_back({ start, static_cast<std::uint32_t>(out.offset() - start) });
+                }
+            }
+            writer.endArray();
+        };
+
+        if (format == StorageFormat::Cbor) {
+            CborWriter writer(out);
+            encode(writer);
+        }
+        else if (format == StorageFormat::MsgPack) {
+            MsgPackWriter writer(out);
+            encode(writer);
+        }
+        else {
+            JsonWriter writer(out, indent);
+            encode(writer);
+            if (!writer.error().empty()) {
+                out.discard(writer.error());
+                return false;
+            }
+        }
+        return out.commit();
+    }
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_RECORD_WRITER_H
@@ -0,0 +1,476 @@
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[4] = { 'T', 'P', 'S', 'X' };
+        const std::uint32_t kVersion = 1;
+
+        // BM25 parameters: term frequency saturation and length normalization
+        const double kK1 = 1.2;
+        const double kB = 0.75;
+
+        // A hit in the name counts as this many hits in the description
+        const std::uint32_t kNameWeight = 2;
+
+        bool isTermByte(unsigned char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c >= 0x80;
+        }
+
+        // Calls visit(term) for each term of the text; the view is only
+        // valid during the call
+        template <typename Visit>
+        void forEachTerm(std::string_view text, std::string& buffer, Visit&& visit) {
+            buffer.clear();
+            for (char c : text) {
+                unsigned char byte = static_cast<unsigned char>(c);
+                if (isTermByte(byte)) {
+                    buffer += (byte >= 'A' && byte <= 'Z') ? static_cast<char>(byte + ('a' - 'A')) : c;
+                }
+                else if (!buffer.empty()) {
+                    visit(std::string_view(buffer));
+                    buffer.clear();
+                }
+            }
+            if (!buffer.empty()) {
+                visit(std::string_view(buffer));
+                buffer.clear();
+            }
+        }
+
+        std::uint64_t align8(std::uint64_t offset) {
+            return (offset + 7) & ~std::uint64_t(7);
+        }
+
+        // Documents and scores of both inputs, scores added
+        void intersect(std::vector<std::uint32_t>& docs, std::vector<double>& scores,
+            const std::vector<std::uint32_t>& other_docs, const std::vector<double>& other_scores) {
+            std::size_t kept = 0;
+            std::size_t j = 0;
+            for (std::size_t i = 0; i < docs.size() && j < other_docs.size(); ++i) {
+                while (j < other_docs.size() && other_docs[j] < docs[i]) {
+                    ++j;
+                }
+                if (j < other_docs.size() && other_docs[j] == docs[i]) {
+                    docs[kept] = docs[i];
+                    scores[kept] = scores[i] + other_scores[j];
+                    ++kept;
+                }
+            }
+            docs.resize(kept);
+            scores.resize(kept);
+        }
+
+        // Documents of either input, scores added where both match
+        void unite(std::vector<std::uint32_t>& docs, std::vector<double>& scores,
+            const std::vector<std::uint32_t>& other_docs, const std::vector<double>& other_scores) {
+            std::vector<std::uint32_t> merged_docs;
+            std::vector<double> merged_scores;
+            merged_docs.reserve(docs.size() + other_docs.size());
+            merged_scores.reserve(docs.size() + other_docs.size());
+            std::size_t i = 0;
+            std::size_t j = 0;
+            while (i < docs.size() || j < other_docs.size()) {
+                if (j == other_docs.size() || (i < docs.size() && docs[i] < other_docs[j])) {
+                    merged_docs.push_back(docs[i]);
+                    merged_scores.push_back(scores[i++]);
+                }
+                else if (i == docs.size() || other_docs[j] < docs[i]) {
+                    merged_docs.push_back(other_docs[j]);
+                    merged_scores.push_back(other_scores[j++]);
+                }
+                else {
+                    merged_docs.push_back(docs[i]);
+                    merged_scores.push_back(scores[i++] + other_scores[j++]);
+                }
+            }
+            docs.swap(merged_docs);
+            scores.swap(merged_scores);
+        }
+
+    } // namespace
+
+    struct SearchIndex::Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t source_size;
+        std::int64_t source_mtime;
+        std::uint32_t doc_count;
+        std::uint32_t term_count;
+        std::uint64_t total_length;     // Terms over all documents
+        std::uint64_t docs_offset;      // DocEntry[doc_count]
+        std::uint64_t terms_offset;     // TermEntry[term_count], sorted by text
+        std::uint64_t postings_offset;  // uint32 values
+        std::uint64_t strings_offset;   // IDs and term texts
+        std::uint64_t strings_size;
+    };
+
+    struct SearchIndex::DocEntry {
+        std::uint32_t id_offset;
+        std::uint32_t id_length;
+        std::uint32_t length;
+        std::uint32_t name_length;
+    };
+
+    // Postings of a term start at postings_offset + 4 * postings: doc
+    // numbers [doc_count], then offsets of each document's positions
+    // [doc_count + 1], then the positions
+    struct SearchIndex::TermEntry {
+        std::uint32_t text_offset;
+        std::uint32_t text_length;
+        std::uint32_t doc_count;
+        std::uint32_t postings;
+    };
+
+    std::vector<std::string> searchTerms(std::string_view text) {
+        std::vector<std::string> terms;
+        std::string buffer;
+        forEachTerm(text, buffer, [&terms](std::string_view term) {
+            terms.emplace_back(term);
+        });
+        return terms;
+    }
+
+    SearchQuery SearchQuery::parse(const std::vector<std::string>& words) {
+        SearchQuery query;
+        query.alternatives.emplace_back();
+
+        auto addClause = [&query](std::string_view text) {
+            SearchQuery::Clause clause = searchTerms(text);
+            if (!clause.empty()) {
+                query.alternatives.back().push_back(std::move(clause));
+            }
+        };
+        auto addWord = [&query, &addClause](std::string_view word) {
+            if (word == "OR") {
+                if (!query.alternatives.back().empty()) {
+                    query.alternatives.emplace_back();
+                }
+            }
+            else if (word != "AND") {
+                addClause(word);
+            }
+        };
+
+        for (const std::string& word : words) {
+            if (word.find('"') == std::string::npos && word.find_first_of(" \t") != std::string::npos) {
+                addClause(word);  // Quoted on the command line
+                continue;
+            }
+
+            // Outside quotes, split on spaces; inside, the text is a phrase
+            bool quoted = false;
+            std::size_t start = 0;
+            for (std::size_t i = 0; i <= word.size(); ++i) {
+                bool end = i == word.size();
+                if (!end && word[i] == '"') {
+                    std::string_view part(word.data() + start, i - start);
+                    if (quoted) {
+                        addClause(part);
+                    }
+                    else {
+                        addWord(part);
+                    }
+                    quoted = !quoted;
+                    start = i + 1;
+                }
+                else if (end || (!quoted && (word[i] == ' ' || word[i] == '\t'))) {
+                    std::string_view part(word.data() + start, i - start);
+                    if (quoted) {
+                        addClause(part);  // Unterminated quote
+                    }
+                    else if (!part.empty()) {
+                        addWord(part);
+                    }
+                    start = i + 1;
+                }
+            }
+        }
+
+        if (query.alternatives.back().empty()) {
+            query.alternatives.pop_back();
+        }
+        return query;
+    }
+
+    const SearchIndex::Header* SearchIndex::header() const {
+        return reinterpret_cast<const Header*>(image_.data());
+    }
+
+    const SearchIndex::DocEntry* SearchIndex::docs() const {
+        return reinterpret_cast<const DocEntry*>(image_.data() + header()->docs_offset);
+    }
+
+    const SearchIndex::TermEntry* SearchIndex::terms() const {
+        return reinterpret_cast<const TermEntry*>(image_.data() + header()->terms_offset);
+    }
+
+    std::string_view SearchIndex::text(std::uint32_t offset, std::uint32_t length) const {
+        return std::string_view(image_.data() + header()->strings_offset + offset, length);
+    }
+
+    bool SearchIndex::validate() const {
+        if (image_.size() < sizeof(Header)) {
+            return false;
+        }
+        const Header* h = header();
+        if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion) {
+            return false;
+        }
+        return h->docs_offset + std::uint64_t(h->doc_count) * sizeof(DocEntry) <= h->terms_offset
+            && h->terms_offset + std::uint64_t(h->term_count) * sizeof(TermEntry) <= h->postings_offset
+            && h->postings_offset <= h->strings_offset
+            && h->strings_offset + h->strings_size <= image_.size()
+            && h->docs_offset % 8 == 0 && h->terms_offset % 8 == 0 && h->postings_offset % 8 == 0;
+    }
+
+    bool SearchIndex::open(const std::string& path, const FileStamp& source) {
+        return image_.open(path, [this, &source]() {
+            return validate() && header()->source_size == source.size && header()->source_mtime == source.mtime;
+        });
+    }
+
+    void SearchIndex::assign(std::string bytes) {
+        image_.assign(std::move(bytes), [this]() { return validate(); });
+    }
+
+    std::size_t SearchIndex::size() const {
+        return image_.data() ? header()->doc_count : 0;
+    }
+
+    bool SearchIndex::postings(std::string_view term, Postings& postings) const {
+        const Header* h = header();
+        const TermEntry* begin = terms();
+        const TermEntry* end = begin + h->term_count;
+        const TermEntry* it = std::lower_bound(begin, end, term, [this](const TermEntry& entry, std::string_view value) {
+            return text(entry.text_offset, entry.text_length) < value;
+        });
+        if (it == end || text(it->text_offset, it->text_length) != term) {
+            return false;
+        }
+
+        const std::uint64_t values = (h->strings_offset - h->postings_offset) / sizeof(std::uint32_t);
+        const std::uint32_t* base = reinterpret_cast<const std::uint32_t*>(image_.data() + h->postings_offset);
+        const std::uint64_t head = std::uint64_t(it->postings) + 2 * std::uint64_t(it->doc_count) + 1;
+        if (head > values) {
+            return false;
+        }
+        postings.docs = base + it->postings;
+        postings.starts = postings.docs + it->doc_count;
+        postings.positions = postings.starts + it->doc_count + 1;
+        postings.count = it->doc_count;
+        return head + postings.starts[postings.count] <= values;
+    }
+
+    void SearchIndex::matchClause(const SearchQuery::Clause& clause, std::vector<std::uint32_t>& matched,
+        std::vector<double>& scores) const {
+        matched.clear();
+        scores.clear();
+
+        std::vector<Postings> lists(clause.size());
+        for (std::size_t i = 0; i < clause.size(); ++i) {
+            if (!postings(clause[i], lists[i])) {
+                return;  // A missing term matches nothing
+            }
+        }
+
+        const Header* h = header();
+        const double doc_count = h->doc_count;
+        const double average_length = h->doc_count ? static_cast<double>(h->total_length) / doc_count : 1.0;
+        double idf = 0.0;
+        for (const Postings& list : lists) {
+            idf += std::log(1.0 + (doc_count - list.count + 0.5) / (list.count + 0.5));
+        }
+
+        // Walk the shortest list and look the others up
+        std::size_t driver = 0;
+        for (std::size_t i = 1; i < lists.size(); ++i) {
+            if (lists[i].count < lists[driver].count) {
+                driver = i;
+            }
+        }
+
+        std::vector<std::uint32_t> slots(lists.size());
+        for (std::uint32_t d = 0; d < lists[driver].count; ++d) {
+            const std::uint32_t doc = lists[driver].docs[d];
+            bool everywhere = true;
+            for (std::size_t i = 0; i < lists.size() && everywhere; ++i) {
+                const std::uint32_t* end = lists[i].docs + lists[i].count;
+                const std::uint32_t* at = std::lower_bound(lists[i].docs, end, doc);
+                everywhere = at != end && *at == doc;
+                slots[i] = static_cast<std::uint32_t>(at - lists[i].docs);
+            }
+            if (!everywhere || doc >= h->doc_count) {
+                continue;
+            }
+
+            // Occurrences: positions of the first term followed by the rest in order
+            const DocEntry& entry = docs()[doc];
+            std::uint32_t frequency = 0;
+            const Postings& first = lists.front();
+            for (std::uint32_t p = first.starts[slots[0]]; p < first.starts[slots[0] + 1]; ++p) {
+                const std::uint32_t position = first.positions[p];
+                bool phrase = true;
+                for (std::size_t i = 1; i < lists.size() && phrase; ++i) {
+                    const std::uint32_t* begin = lists[i].positions + lists[i].starts[slots[i]];
+                    const std::uint32_t* end = lists[i].positions + lists[i].starts[slots[i] + 1];
+                    phrase = std::binary_search(begin, end, position + static_cast<std::uint32_t>(i));
+                }
+                if (phrase) {
+                    frequency += position < entry.name_length ? kNameWeight : 1;
+                }
+            }
+            if (frequency == 0) {
+                continue;
+            }
+
+            const double tf = frequency;
+            const double norm = kK1 * (1.0 - kB + kB * entry.length / average_length);
+            matched.push_back(doc);
+            scores.push_back(idf * tf * (kK1 + 1.0) / (tf + norm));
+        }
+    }
+
+    std::vector<SearchIndex::Hit> SearchIndex::search(const SearchQuery& query) const {
+        std::vector<Hit> hits;
+        if (!image_.data()) {
+            return hits;
+        }
+
+        std::vector<std::uint32_t> result_docs;
+        std::vector<double> result_scores;
+        std::vector<std::uint32_t> clause_docs;
+        std::vector<double> clause_scores;
+        for (const auto& alternative : query.alternatives) {
+            std::vector<std::uint32_t> docs_matched;
+            std::vector<double> scores;
+            for (std::size_t c = 0; c < alternative.size(); ++c) {
+                matchClause(alternative[c], clause_docs, clause_scores);
+                if (c == 0) {
+                    docs_matched.swap(clause_docs);
+                    scores.swap(clause_scores);
+                }
+                else {
+                    intersect(docs_matched, scores, clause_docs, clause_scores);
+                }
+                if (docs_matched.empty()) {
+                    break;
+                }
+            }
+            unite(result_docs, result_scores, docs_matched, scores);
+        }
+
+        hits.reserve(result_docs.size());
+        for (std::size_t i = 0; i < result_docs.size(); ++i) {
+            const DocEntry& entry = docs()[result_docs[i]];
+            hits.push_back({ text(entry.id_offset, entry.id_length), result_scores[i] });
+        }
+        // Best first; equal scores keep store order
+        std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) {
+            return a.score > b.score;
+        });
+        return hits;
+    }
+
+    void SearchIndex::Builder::add(std::string_view id, std::string_view name, std::string_view description) {
+        const std::uint32_t doc = static_cast<std::uint32_t>(docs_.size());
+        Doc entry;
+        entry.id = std::string(id);
+
+        // Positions of each term; the description starts one past the name
+        // so a phrase never spans both fields
+        std::unordered_map<std::string, std::vector<std::uint32_t>> positions;
+        std::string buffer;
+        std::uint32_t position = 0;
+        forEachTerm(name, buffer, [&positions, &position](std::string_view term) {
+            positions[std::string(term)].push_back(position++);
+        });
+        entry.name_length = position;
+        ++position;
+        forEachTerm(description, buffer, [&positions, &position](std::string_view term) {
+            positions[std::string(term)].push_back(position++);
+        });
+        entry.length = position - 1;
+        docs_.push_back(std::move(entry));
+
+        for (auto& [term, list] : positions) {
+            TermPostings& postings = terms_[term];
+            postings.docs.push_back(doc);
+            postings.starts.push_back(static_cast<std::uint32_t>(postings.positions.size()));
+            postings.positions.insert(postings.positions.end(), list.begin(), list.end());
+        }
+    }
+
+    std::string SearchIndex::Builder::finish(const FileStamp& source) const {
+        std::vector<const std::pair<const std::string, TermPostings>*> sorted;
+        sorted.reserve(terms_.size());
+        for (const auto& term : terms_) {
+            sorted.push_back(&term);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) {
+            return a->first < b->first;
+        });
+
+        std::string strings;
+        std::vector<DocEntry> doc_entries;
+        doc_entries.reserve(docs_.size());
+        std::uint64_t total_length = 0;
+        for (const Doc& doc : docs_) {
+            doc_entries.push_back({ static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(doc.id.size()),
+                doc.length, doc.name_length });
+            strings += doc.id;
+            total_length += doc.length;
+        }
+
+        std::vector<TermEntry> term_entries;
+        term_entries.reserve(sorted.size());
+        std::vector<std::uint32_t> values;
+        for (const auto* term : sorted) {
+            const TermPostings& postings = term->second;
+            term_entries.push_back({ static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(term->first.size()),
+                static_cast<std::uint32_t>(postings.docs.size()), static_cast<std::uint32_t>(values.size()) });
+            strings += term->first;
+            values.insert(values.end(), postings.docs.begin(), postings.docs.end());
+            values.insert(values.end(), postings.starts.begin(), postings.starts.end());
+            values.push_back(static_cast<std::uint32_t>(postings.positions.size()));
+            values.insert(values.end(), postings.positions.begin(), postings.positions.end());
+        }
+
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+        header.doc_count = static_cast<std::uint32_t>(doc_entries.size());
+        header.term_count = static_cast<std::uint32_t>(term_entries.size());
+        header.total_length = total_length;
+        header.docs_offset = align8(sizeof(Header));
+        header.terms_offset = align8(header.docs_offset + doc_entries.size() * sizeof(DocEntry));
+        header.postings_offset = align8(header.terms_offset + term_entries.size() * sizeof(TermEntry));
+        header.strings_offset = header.postings_offset + values.size() * sizeof(std::uint32_t);
+        header.strings_size = strings.size();
+
+        std::string bytes(header.strings_offset + strings.size(), '\0');
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + header.docs_offset, doc_entries.data(), doc_entries.size() * sizeof(DocEntry));
+        std::memcpy(bytes.data() + header.terms_offset, term_entries.data(), term_entries.size() * sizeof(TermEntry));
+        std::memcpy(bytes.data() + header.postings_offset, values.data(), values.size() * sizeof(std::uint32_t));
+        std::memcpy(bytes.data() + header.strings_offset, strings.data(), strings.size());
+        return bytes;
+    }
+
+    bool SearchIndex::Builder::save(const std::string& path, const std::string& bytes) {
+        if (!replaceFile(path, bytes)) {
+            std::cerr << "Warning: Could not write search index " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,165 @@
+#ifndef TRAVEL_PLANNER_SEARCH_INDEX_H
+#define TRAVEL_PLANNER_SEARCH_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    /**
+     * Splits text into search terms: runs of ASCII letters and digits
+     * (and non-ASCII bytes, so accented words stay whole), lowercased
+     * @param text Text to split
+     * @return Terms in order
+     */
+    std::vector<std::string> searchTerms(std::string_view text);
+
+    /**
+     * Parsed keyword query: any one of several alternatives (OR), each a
+     * list of clauses that must all match (AND). A clause is a single term,
+     * or a phrase whose terms must appear next to each other in that order.
+     */
+    struct SearchQuery {
+        using Clause = std::vector<std::string>;
+        std::vector<std::vector<Clause>> alternatives;
+
+        /**
+         * Parses command-line words. Words are ANDed; "OR" between words
+         * starts another alternative ("AND" is accepted and ignored). Text in
+         * double quotes is a phrase, and so is an argument the shell kept
+         * together, e.g. itinerary search "city break" OR beach.
+         * @param words Query words
+         * @return The query; empty if it has no terms
+         */
+        static SearchQuery parse(const std::vector<std::string>& words);
+
+        bool empty() const { return alternatives.empty(); }
+    };
+
+    /**
+     * Inverted index over the name and description of documents: each
+     * term maps to the documents containing it with the term's positions,
+     * so multi-term queries intersect short posting lists and phrases are
+     * checked from positions alone. Matches are ranked with BM25, counting
+     * a hit in the name twice.
+     *
+     * Persisted as one file, memory-mapped when searched and tagged with the
+     * stamp of the store it indexes; a stale index is detected on open. Terms
+     * are sorted, so a query reads only its own terms' posting lists. The
+     * file is written in native byte order.
+     */
+    class SearchIndex {
+    public:
+        /**
+         * Document matching a query
+         */
+        struct Hit {
+            std::string_view id;  // Valid while the index is open
+            double score = 0.0;
+        };
+
+        class Builder;
+
+        /**
+         * Maps an index file
+         * @param path Index file
+         * @param source Current stamp of the indexed store
+         * @return False if the file is missing, unreadable or was built from
+         *         another version of the store
+         */
+        bool open(const std::string& path, const FileStamp& source);
+
+        /**
+         * Uses an index built in memory (see Builder::finish())
+         */
+        void assign(std::string bytes);
+
+        /**
+         * Finds the documents matching a query
+         * @return Matches, best first
+         */
+        std::vector<Hit> search(const SearchQuery& query) const;
+
+        /**
+         * @return Number of indexed documents
+         */
+        std::size_t size() const;
+
+    private:
+        struct Header;
+        struct DocEntry;
+        struct TermEntry;
+
+        // One term's postings: documents, and positions per document
+        struct Postings {
+            const std::uint32_t* docs = nullptr;
+            const std::uint32_t* starts = nullptr;  // count + 1 offsets into positions
+            const std::uint32_t* positions = nullptr;
+            std::uint32_t count = 0;
+        };
+
+        bool validate() const;
+        const Header* header() const;
+        const DocEntry* docs() const;
+        const TermEntry* terms() const;
+        std::string_view text(std::uint32_t offset, std::uint32_t length) const;
+        bool postings(std::string_view term, Postings& postings) const;
+
+        // Documents matching a clause with their BM25 score, by document
+        void matchClause(const SearchQuery::Clause& clause, std::vector<std::uint32_t>& docs,
+            std::vector<double>& scores) const;
+
+        IndexImage image_;
+    };
+
+    /**
+     * Collects documents and encodes them into a SearchIndex
+     */
+    class SearchIndex::Builder {
+    public:
+        /**
+         * Adds a document
+         * @param id Document ID
+         * @param name Name field, weighted double when ranking
+         * @param description Description field
+         */
+        void add(std::string_view id, std::string_view name, std::string_view description);
+
+        /**
+         * Encodes the index
+         * @param source Stamp of the store the documents came from
+         * @return Index contents, for SearchIndex::assign() or save()
+         */
+        std::string finish(const FileStamp& source) const;
+
+        /**
+         * Writes encoded index contents to a file
+         * @return True on success
+         */
+        static bool save(const std::string& path, const std::string& bytes);
+
+    private:
+        struct TermPostings {
+            std::vector<std::uint32_t> docs;
+            std::vector<std::uint32_t> starts;
+            std::vector<std::uint32_t> positions;
+        };
+
+        struct Doc {
+            std::string id;
+            std::uint32_t length = 0;       // Terms in both fields
+            std::uint32_t name_length = 0;  // Terms in the name, which come first
+        };
+
+        std::vector<Doc> docs_;
+        std::unordered_map<std::string, TermPostings> terms_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_SEARCH_INDEX_H
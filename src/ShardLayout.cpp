@@ -0,0 +1,105 @@
+#include "ShardLayout.h"
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cctype>
+
+namespace travel_planner {
+
+    // Encode an itinerary ID as a file name. Anything outside [A-Za-z0-9_-]
+    // is percent-encoded so distinct IDs never map onto the same file.
+    static std::string encodeShardName(const std::string& key) {
+        static const char* hex_chars = "0123456789ABCDEF";
+        std::string name;
+        name.reserve(key.size());
+
+        for (unsigned char c : key) {
+            if (std::isalnum(c) || c == '-' || c == '_') {
+                name += static_cast<char>(c);
+            }
+            else {
+                name += '%';
+                name += hex_chars[c >> 4];
+                name += hex_chars[c & 0x0F];
+            }
+        }
+
+        // An empty itinerary ID still needs a valid file name
+        return name.empty() ? "%" : name;
+    }
+
+    ShardLayout::ShardLayout(const std::string& storage_path)
+        : legacy_path_(storage_path) {
+        std::filesystem::path path(storage_path);
+        extension_ = path.has_extension() ? path.extension().string() : ".json";
+        directory_ = path.parent_path().empty()
+            ? path.stem().string()
+            : (path.parent_path() / path.stem()).string();
+    }
+
+    std::string ShardLayout::shardPath(const std::string& itinerary_id) const {
+        return (std::filesystem::path(directory_) / (encodeShardName(itinerary_id) + extension_)).string();
+    }
+
+    std::vector<std::string> ShardLayout::shardPaths() const {
+        return shardPathsWithExtension(extension_);
+    }
+
+    std::vector<std::string> ShardLayout::shardPathsWithExtension(const std::string& extension) const {
+        std::vector<std::string> paths;
+
+        std::error_code ec;
+        if (!std::filesystem::is_directory(directory_, ec)) {
+            return paths;
+        }
+
+        for (const auto& entry : std::filesystem::directory_iterator(directory_, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                paths.push_back(entry.path().string());
+            }
+        }
+
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    std::string ShardLayout::recordedExtension() const {
+        std::error_code ec;
+        if (!std::filesystem::is_directory(directory_, ec)) {
+            return "";
+        }
+
+        std::ifstream file(std::filesystem::path(directory_) / ".format");
+        std::string extension;
+        if (file >> extension) {
+            return extension;
+        }
+        return ".json";  // Shards written before the format was recorded
+    }
+
+    void ShardLayout::recordExtension() const {
+        std::error_code ec;
+        std::filesystem::create_directories(directory_, ec);
+
+        std::ofstream file(std::filesystem::path(directory_) / ".format");
+        file << extension_ << std::endl;
+        if (!file) {
+            std::cerr << "Warning: Could not record shard format in " << directory_ << std::endl;
+        }
+    }
+
+    bool ShardLayout::needsMigration() const {
+        return std::filesystem::exists(legacy_path_);
+    }
+
+    void ShardLayout::retireLegacyStore() const {
+        std::error_code ec;
+        std::filesystem::rename(legacy_path_, legacy_path_ + ".migrated", ec);
+        if (ec) {
+            std::cerr << "Warning: Could not retire legacy store " << legacy_path_
+                << ": " << ec.message() << std::endl;
+        }
+    }
+
+} // namespace travel_planner
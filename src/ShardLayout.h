@@ -0,0 +1,93 @@
+#ifndef TRAVEL_PLANNER_SHARD_LAYOUT_H
+#define TRAVEL_PLANNER_SHARD_LAYOUT_H
+
+#include <string>
+#include <vector>
+
+namespace travel_planner {
+
+    /**
+     * Maps a single-file store path onto a directory of per-itinerary shards.
+     *
+     * "data/expenses.json" becomes the directory "data/expenses/" holding one
+     * "<itinerary_id>.json" file per itinerary. The original single file is
+     * treated as the legacy store and is migrated once into shards.
+     *
+     * The shard path is derived from the itinerary ID alone, so the layout
+     * doubles as the itinerary_id -> child records index: reading one
+     * itinerary's records opens exactly one file, whatever the store size.
+     */
+    class ShardLayout {
+    public:
+        /**
+         * Constructor
+         * @param storage_path Path of the (legacy) single-file store
+         */
+        explicit ShardLayout(const std::string& storage_path);
+
+        /**
+         * @return Path of the legacy single-file store
+         */
+        const std::string& legacyPath() const { return legacy_path_; }
+
+        /**
+         * @return Directory holding the shard files
+         */
+        const std::string& directory() const { return directory_; }
+
+        /**
+         * Builds the shard file path for an itinerary
+         * @param itinerary_id Itinerary the shard belongs to
+         * @return Path of the shard file (it may not exist yet)
+         */
+        std::string shardPath(const std::string& itinerary_id) const;
+
+        /**
+         * Lists the shard files currently present on disk
+         * @return Paths of all shard files, sorted for a stable load order
+         */
+        std::vector<std::string> shardPaths() const;
+
+        /**
+         * @return True if the legacy file still needs to be split into shards
+         */
+        bool needsMigration() const;
+
+        /**
+         * Moves the legacy file out of the way once its records were sharded
+         */
+        void retireLegacyStore() const;
+
+        /**
+         * @return Shard file extension of this layout, including the dot
+         */
+        const std::string& extension() const { return extension_; }
+
+        /**
+         * Reads the shard extension recorded in the directory's ".format" file
+         * @return Recorded extension; ".json" for a directory written before
+         *         formats were recorded; empty if there is no shard directory
+         */
+        std::string recordedExtension() const;
+
+        /**
+         * Records this layout's extension as the one the shards are stored in
+         */
+        void recordExtension() const;
+
+        /**
+         * Lists shard files stored with the given extension
+         * @param extension Extension to look for, including the dot
+         * @return Paths of the matching shard files
+         */
+        std::vector<std::string> shardPathsWithExtension(const std::string& extension) const;
+
+    private:
+        std::string legacy_path_;  // Original single-file store
+        std::string directory_;    // Shard directory
+        std::string extension_;    // Shard file extension, including the dot
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_SHARD_LAYOUT_H
@@ -0,0 +1,81 @@
+#include "StorageConfig.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char* const kFormatMarker = "data/.storage-format";
+
+        // Value of an environment variable, empty if unset
+        std::string environment(const char* name) {
+            const char* value = std::getenv(name);
+            return value != nullptr ? value : "";
+        }
+
+        std::string storePath(const char* variable, const char* base) {
+            std::string path = environment(variable);
+            return path.empty() ? base + std::string(formatExtension(defaultStorageFormat())) : path;
+        }
+
+    } // namespace
+
+    StorageFormat defaultStorageFormat() {
+        StorageFormat format = StorageFormat::Json;
+
+        std::string name = environment("TRAVEL_PLANNER_STORAGE_FORMAT");
+        if (!name.empty()) {
+            if (!parseStorageFormat(name, format)) {
+                std::cerr << "Warning: unknown storage format '" << name << "', using json" << std::endl;
+            }
+            return format;
+        }
+
+        std::ifstream marker(kFormatMarker);
+        if (marker >> name) {
+            parseStorageFormat(name, format);
+        }
+        return format;
+    }
+
+    bool setDefaultStorageFormat(StorageFormat format) {
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(kFormatMarker).parent_path(), ec);
+
+        std::ofstream marker(kFormatMarker);
+        marker << formatName(format) << '\n';
+        marker.close();
+        if (!marker) {
+            std::cerr << "Error writing " << kFormatMarker << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string itineraryStorePath() {
+        return storePath("TRAVEL_PLANNER_ITINERARY_STORE", "data/itineraries");
+    }
+
+    std::string packingStorePath() {
+        return storePath("TRAVEL_PLANNER_PACKING_STORE", "data/packing");
+    }
+
+    std::string expenseStorePath() {
+        return storePath("TRAVEL_PLANNER_EXPENSE_STORE", "data/expenses");
+    }
+
+    int jsonIndent(int pretty_indent) {
+        std::string compact = environment("TRAVEL_PLANNER_COMPACT_JSON");
+        bool enabled = !compact.empty() && compact != "0";
+        return enabled ? 0 : pretty_indent;
+    }
+
+    std::string serverSocketPath() {
+        std::string path = environment("TRAVEL_PLANNER_SOCKET");
+        return path.empty() ? "data/.server.sock" : path;
+    }
+
+} // namespace travel_planner
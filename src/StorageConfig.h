@@ -0,0 +1,60 @@
+#ifndef TRAVEL_PLANNER_STORAGE_CONFIG_H
+#define TRAVEL_PLANNER_STORAGE_CONFIG_H
+
+#include <string>
+#include "StorageFormat.h"
+
+namespace travel_planner {
+
+    /**
+     * Format the CLI stores its data in. TRAVEL_PLANNER_STORAGE_FORMAT
+     * ("json", "cbor" or "msgpack") wins; otherwise the format recorded by
+     * the convert command in "data/.storage-format"; otherwise JSON.
+     */
+    StorageFormat defaultStorageFormat();
+
+    /**
+     * Records the format later runs of the CLI should use
+     * @param format Format to record
+     * @return True on success
+     */
+    bool setDefaultStorageFormat(StorageFormat format);
+
+    /**
+     * Path of the itinerary store used by the CLI, "data/itineraries" with
+     * the default format's extension. Set TRAVEL_PLANNER_ITINERARY_STORE to
+     * override it.
+     */
+    std::string itineraryStorePath();
+
+    /**
+     * Path of the packing store used by the CLI, "data/packing" with the
+     * default format's extension. Set TRAVEL_PLANNER_PACKING_STORE to
+     * override it.
+     */
+    std::string packingStorePath();
+
+    /**
+     * Path of the expense store used by the CLI, "data/expenses" with the
+     * default format's extension. Set TRAVEL_PLANNER_EXPENSE_STORE to
+     * override it, e.g. "data/expenses.col" for the columnar format.
+     */
+    std::string expenseStorePath();
+
+    /**
+     * Indentation used when writing JSON stores. Returns 0 (compact
+     * output) when TRAVEL_PLANNER_COMPACT_JSON is set to a non-empty value
+     * other than "0", otherwise the store's usual indentation.
+     * @param pretty_indent Indentation the store uses by default
+     */
+    int jsonIndent(int pretty_indent);
+
+    /**
+     * Path of the Unix domain socket the command server listens on,
+     * "data/.server.sock". Set TRAVEL_PLANNER_SOCKET to override it.
+     */
+    std::string serverSocketPath();
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_STORAGE_CONFIG_H
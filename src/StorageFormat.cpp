@@ -0,0 +1,108 @@
+#include "StorageFormat.h"
+#include <filesystem>
+
+namespace travel_planner {
+
+    StorageFormat formatForPath(const std::string& path) {
+        std::string extension = std::filesystem::path(path).extension().string();
+        if (extension == ".cbor") {
+            return StorageFormat::Cbor;
+        }
+        if (extension == ".msgpack") {
+            return StorageFormat::MsgPack;
+        }
+        return StorageFormat::Json;
+    }
+
+    const char* formatExtension(StorageFormat format) {
+        switch (format) {
+        case StorageFormat::Cbor: return ".cbor";
+        case StorageFormat::MsgPack: return ".msgpack";
+        default: return ".json";
+        }
+    }
+
+    const char* formatName(StorageFormat format) {
+        switch (format) {
+        case StorageFormat::Cbor: return "cbor";
+        case StorageFormat::MsgPack: return "msgpack";
+        default: return "json";
+        }
+    }
+
+    bool parseStorageFormat(const std::string& name, StorageFormat& format) {
+        for (StorageFormat candidate : { StorageFormat::Json, StorageFormat::Cbor, StorageFormat::MsgPack }) {
+            if (name == formatName(candidate)) {
+                format = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    namespace {
+
+        // Classifies the first byte of a record array; the CBOR tag (0xD9)
+        // is handled by the callers
+        StorageFormat classify(unsigned char c, StorageFormat hint) {
+            if (c == 0xDC || c == 0xDD) {
+                return StorageFormat::MsgPack;  // array16 / array32
+            }
+            if ((c >= 0x80 && c <= 0x8F) || (c >= 0x98 && c <= 0x9B) || c == 0x9F) {
+                // CBOR array; never a top-level array in MessagePack
+                return StorageFormat::Cbor;
+            }
+            if (c >= 0x9C && c <= 0x9E) {
+                return StorageFormat::MsgPack;  // fixarray; reserved in CBOR
+            }
+            if (c >= 0x90 && c <= 0x97) {
+                // Small array in either encoding
+                return hint == StorageFormat::Json ? StorageFormat::MsgPack : hint;
+            }
+            return StorageFormat::Json;
+        }
+
+        // CBOR self-describe tag (0xD9D9F7), written in front of every CBOR
+        // store so it cannot be mistaken for MessagePack
+        const unsigned char kCborTag[] = { 0xD9, 0xD9, 0xF7 };
+
+    } // namespace
+
+    StorageFormat sniffFormat(std::istream& in, StorageFormat hint) {
+        std::istream::int_type first = in.peek();
+        if (first == std::istream::traits_type::eof()) {
+            in.clear();
+            return hint;
+        }
+
+        unsigned char c = static_cast<unsigned char>(first);
+        if (c == kCborTag[0]) {
+            in.get();
+            if (in.get() == kCborTag[1] && in.get() == kCborTag[2]) {
+                return StorageFormat::Cbor;
+            }
+            in.clear();
+            in.seekg(0);
+            return hint;
+        }
+        return classify(c, hint);
+    }
+
+    StorageFormat sniffFormat(const char* data, std::size_t size, StorageFormat hint, std::size_t& header) {
+        header = 0;
+        if (size == 0) {
+            return hint;
+        }
+
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        if (bytes[0] == kCborTag[0]) {
+            if (size >= 3 && bytes[1] == kCborTag[1] && bytes[2] == kCborTag[2]) {
+                header = 3;
+                return StorageFormat::Cbor;
+            }
+            return hint;
+        }
+        return classify(bytes[0], hint);
+    }
+
+} // namespace travel_planner
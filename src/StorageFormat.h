@@ -0,0 +1,79 @@
+#ifndef TRAVEL_PLANNER_STORAGE_FORMAT_H
+#define TRAVEL_PLANNER_STORAGE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+namespace travel_planner {
+
+    /**
+     * Encodings a record store can be persisted in. The format of a store
+     * follows its file extension: ".json", ".cbor" or ".msgpack".
+     */
+    enum class StorageFormat {
+        Json,
+        Cbor,
+        MsgPack
+    };
+
+    /**
+     * Position of one encoded record inside a store file
+     */
+    struct RecordSpan {
+        std::uint64_t offset = 0;  // First byte of the record
+        std::uint32_t length = 0;  // Encoded size in bytes
+    };
+
+    /**
+     * Picks the format for a store path from its extension
+     * @param path Store or shard file path
+     * @return Matching format; JSON for unknown extensions
+     */
+    StorageFormat formatForPath(const std::string& path);
+
+    /**
+     * @return File extension of a format, including the dot
+     */
+    const char* formatExtension(StorageFormat format);
+
+    /**
+     * @return Short name of a format as used on the command line
+     */
+    const char* formatName(StorageFormat format);
+
+    /**
+     * Parses a format name ("json", "cbor" or "msgpack")
+     * @param name Name to parse
+     * @param format Receives the format on success
+     * @return True if the name is known
+     */
+    bool parseStorageFormat(const std::string& name, StorageFormat& format);
+
+    /**
+     * Detects the encoding of a record file from its first bytes, so a
+     * store still loads when its extension does not match its contents.
+     * A leading CBOR self-describe tag is consumed; otherwise the stream is
+     * left at the start of the document.
+     * @param in Stream positioned at the start of the file
+     * @param hint Format assumed when the first byte is ambiguous (small
+     *             arrays look the same in CBOR and MessagePack)
+     * @return Detected format
+     */
+    StorageFormat sniffFormat(std::istream& in, StorageFormat hint);
+
+    /**
+     * Same as above for a file already in memory
+     * @param data File contents
+     * @param size Size of the contents
+     * @param hint Format assumed when the first byte is ambiguous
+     * @param header Receives the number of leading bytes to skip (the CBOR
+     *               self-describe tag)
+     * @return Detected format
+     */
+    StorageFormat sniffFormat(const char* data, std::size_t size, StorageFormat hint, std::size_t& header);
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_STORAGE_FORMAT_H
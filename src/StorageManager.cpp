@@ -1,17 +1,141 @@
 #include "StorageManager.h"
+#include "RecordCache.h"
+#include "RecordReader.h"
+#include "RecordWriter.h"
+#include "StorageConfig.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "Trace.h"
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <optional>
+#include <unordered_map>
 
 namespace travel_planner {
 
+    namespace {
+
+        // Start and end date of an itinerary, if both parse and are in order
+        std::optional<std::pair<Date, Date>> itineraryDates(const Itinerary& itinerary) {
+            std::optional<Date> start = Date::parse(itinerary.start_date);
+            std::optional<Date> end = Date::parse(itinerary.end_date);
+            if (!start || !end || *end < *start) {
+                return std::nullopt;
+            }
+            return std::make_pair(*start, *end);
+        }
+
+        // How each secondary index is opened, built from the store and
+        // saved, so the stamp check and rebuild live in openIndex() and
+        // refreshIndexes() only. finish() saves when given a path.
+        struct DateIndexKind {
+            using Index = DateIndex;
+            using Builder = DateIndex;
+
+            static bool open(Index& index, const std::string& path, const FileStamp& source) {
+                return index.load(path, { source });
+            }
+            static void add(Builder& builder, const Itinerary& itinerary) {
+                if (auto range = itineraryDates(itinerary)) {
+                    builder.add(itinerary.id, range->first, range->second);
+                }
+            }
+            static void finish(Builder& builder, Index& index, const std::string& path, const FileStamp& source) {
+                builder.sort();
+                if (!path.empty()) {
+                    builder.save(path, { source });
+                }
+                index = std::move(builder);
+            }
+        };
+
+        struct TagIndexKind {
+            using Index = TagIndex;
+            using Builder = TagIndex;
+
+            static bool open(Index& index, const std::string& path, const FileStamp& source) {
+                return index.open(path, source);
+            }
+            static void add(Builder& builder, const Itinerary& itinerary) {
+                builder.add(itinerary.id, itinerary.tags, itinerary.is_favorite);
+            }
+            static void finish(Builder& builder, Index& index, const std::string& path, const FileStamp& source) {
+                if (!path.empty()) {
+                    builder.save(path, source);
+                }
+                index = std::move(builder);
+            }
+        };
+
+        // Indexes encoded by a Builder and mapped when opened
+        template <typename MappedIndex>
+        struct MappedIndexKind {
+            using Index = MappedIndex;
+            using Builder = typename MappedIndex::Builder;
+
+            static bool open(Index& index, const std::string& path, const FileStamp& source) {
+                return index.open(path, source);
+            }
+            static void finish(Builder& builder, Index& index, const std::string& path, const FileStamp& source) {
+                std::string bytes = builder.finish(source);
+                if (!path.empty()) {
+                    Builder::save(path, bytes);
+                }
+                index.assign(std::move(bytes));
+            }
+        };
+
+        struct SearchIndexKind : MappedIndexKind<SearchIndex> {
+            static void add(Builder& builder, const Itinerary& itinerary) {
+                builder.add(itinerary.id, itinerary.name, itinerary.description);
+            }
+        };
+
+        struct NameIndexKind : MappedIndexKind<TrigramIndex> {
+            static void add(Builder& builder, const Itinerary& itinerary) {
+                builder.add(itinerary.id, itinerary.name);
+            }
+        };
+
+        struct FuzzyIndexKind : MappedIndexKind<FuzzyIndex> {
+            static void add(Builder& builder, const Itinerary& itinerary) {
+                builder.add(itinerary.id, itinerary.name, itinerary.tags);
+            }
+        };
+
+        // Rewrites an index that is in use for the records just saved
+        template <typename Kind>
+        void refreshIndex(const std::string& path, const std::vector<Itinerary>& itineraries, const FileStamp& source) {
+            if (!std::filesystem::exists(path)) {
+                return;
+            }
+            typename Kind::Builder builder;
+            for (const auto& itinerary : itineraries) {
+                Kind::add(builder, itinerary);
+            }
+            typename Kind::Index index;
+            Kind::finish(builder, index, path, source);
+        }
+
+    } // namespace
+
     // Constructor with default storage path
     StorageManager::StorageManager(const std::string& storage_path)
-        : storage_path_(storage_path.empty() ? "data/itineraries.json" : storage_path) {
+        : storage_path_(storage_path.empty() ? "data/itineraries.json" : storage_path),
+          format_(formatForPath(storage_path_)),
+          json_indent_(jsonIndent(2)),
+          index_(std::filesystem::path(storage_path_).replace_extension(".idx").string()),
+          dates_path_(std::filesystem::path(storage_path_).replace_extension(".dates").string()),
+          search_path_(std::filesystem::path(storage_path_).replace_extension(".search").string()),
+          names_path_(std::filesystem::path(storage_path_).replace_extension(".trigrams").string()),
+          tags_path_(std::filesystem::path(storage_path_).replace_extension(".tags").string()),
+          fuzzy_path_(std::filesystem::path(storage_path_).replace_extension(".fuzzy").string()) {
     }
 
     std::vector<Itinerary> StorageManager::loadAll() const {
+        TraceSpan span("StorageManager::loadAll", storage_path_);
         std::vector<Itinerary> itineraries;
 
         // Check if storage directory exists, create if needed
@@ -26,49 +150,317 @@ namespace travel_planner {
             }
         }
 
-        // Check if file exists
-        if (!std::filesystem::exists(storage_path_)) {
-            // File doesn't exist, return empty list
-            return itineraries;
+        forEach([&itineraries](const Itinerary& itinerary) {
+            itineraries.push_back(itinerary);
+            return true;
+        });
+
+        return itineraries;
+    }
+
+    std::pmr::vector<pmr::Itinerary> StorageManager::loadAll(std::pmr::memory_resource* resource) const {
+        TraceSpan span("StorageManager::loadAll", storage_path_);
+        std::pmr::vector<pmr::Itinerary> itineraries(resource);
+        forEach([&itineraries](const Itinerary& itinerary) {
+            itineraries.emplace_back(itinerary);
+            return true;
+        });
+        return itineraries;
+    }
+
+    bool StorageManager::forEach(const std::function<bool(const Itinerary&)>& visitor) const {
+        TraceSpan span("StorageManager::forEach", storage_path_);
+        convertIfNeeded();
+        return scanFile(storage_path_, format_, visitor);
+    }
+
+    bool StorageManager::find(const std::string& id, Itinerary& itinerary) const {
+        TraceSpan span("StorageManager::find", id);
+        ProfileScope profile(ProfilePhase::Load);
+        if (ensureIndex()) {
+            RecordLocation location;
+            bool found = findIndexed(index_, id, itinerary, location,
+                [](const RecordLocation& at, Itinerary& record) {
+                    return readRecordAt(at.file, { at.offset, at.length }, record);
+                },
+                [this]() { return rebuildIndex(); });
+            if (found || index_.isOpen()) {
+                return found;
+            }
         }
 
-        // Open and read file
-        try {
-            std::ifstream file(storage_path_);
-            if (!file.is_open()) {
-                std::cerr << "Error opening file: " << storage_path_ << std::endl;
-                return itineraries; // Return empty list on error
+        // No usable index; fall back to a scan
+        bool found = false;
+        forEach([&id, &itinerary, &found](const Itinerary& candidate) {
+            if (candidate.id == id) {
+                itinerary = candidate;
+                found = true;
+            }
+            return !found;
+        });
+        return found;
+    }
+
+    std::vector<Itinerary> StorageManager::activeOn(Date day) const {
+        TraceSpan span("StorageManager::activeOn", storage_path_);
+        DateIndex dates;
+        if (!openIndex<DateIndexKind>(dates_path_, dates)) {
+            return {};
+        }
+        return fetch(dates.overlapping(day, day), true);
+    }
+
+    std::vector<Itinerary> StorageManager::search(const SearchQuery& query) const {
+        TraceSpan span("StorageManager::search", storage_path_);
+        SearchIndex index;
+        if (query.empty() || !openIndex<SearchIndexKind>(search_path_, index)) {
+            return {};
+        }
+
+        std::vector<std::string_view> ids;
+        {
+            ProfileScope profile(ProfilePhase::Filter);
+            for (const auto& hit : index.search(query)) {
+                ids.push_back(hit.id);
             }
+        }
+        return fetch(ids, true);
+    }
+
+    std::vector<Itinerary> StorageManager::listTagged(const TagQuery& query) const {
+        TraceSpan span("StorageManager::listTagged", storage_path_);
+        TagIndex index;
+        if (!openIndex<TagIndexKind>(tags_path_, index)) {
+            return {};
+        }
 
-            nlohmann::json j;
-            file >> j;
-
-            // Parse JSON into Itinerary objects
-            if (j.is_array()) {
-                for (const auto& item : j) {
-                    try {
-                        Itinerary itinerary = item.get<Itinerary>();
-                        itineraries.push_back(itinerary);
-                    }
-                    catch (const std::exception& e) {
-                        std::cerr << "Error parsing itinerary: " << e.what() << std::endl;
-                        // Skip invalid entries but continue processing
-                    }
+        std::vector<std::string_view> ids;
+        {
+            ProfileScope profile(ProfilePhase::Filter);
+            index.evaluate(query).forEach([&index, &ids](std::uint32_t ordinal) {
+                ids.push_back(index.id(ordinal));
+            });
+        }
+        // Fetch a few matches through the ID index; read many in one pass
+        return fetch(ids, ids.size() * 8 <= index.size());
+    }
+
+    bool StorageManager::searchNames(const std::string& pattern,
+        const std::function<void(std::string_view id, std::string_view name)>& visitor) const {
+        TraceSpan span("StorageManager::searchNames", pattern);
+        TrigramIndex index;
+        if (!openIndex<NameIndexKind>(names_path_, index)) {
+            return false;
+        }
+
+        ProfileScope profile(ProfilePhase::Filter);
+        for (const auto& match : index.search(pattern)) {
+            visitor(match.id, match.text);
+        }
+        return true;
+    }
+
+    bool StorageManager::searchFuzzy(const std::string& term, std::uint32_t max_distance,
+        const std::function<void(const FuzzyIndex::Match& match)>& visitor) const {
+        TraceSpan span("StorageManager::searchFuzzy", term);
+        FuzzyIndex index;
+        if (!openIndex<FuzzyIndexKind>(fuzzy_path_, index)) {
+            return false;
+        }
+
+        ProfileScope profile(ProfilePhase::Filter);
+        for (const auto& match : index.search(term, max_distance)) {
+            visitor(match);
+        }
+        return true;
+    }
+
+    template <typename Kind>
+    bool StorageManager::openIndex(const std::string& path, typename Kind::Index& index) const {
+        // While rewrites are held the file is behind what readers see, and
+        // so is any index of it: build one from the held records, unsaved
+        FileStamp source;
+        if (!deferredWrites()) {
+            convertIfNeeded();
+            source = fileStamp(storage_path_);
+            ProfileScope profile(ProfilePhase::Load);
+            if (Kind::open(index, path, source)) {
+                return true;
+            }
+        }
+
+        // Missing or out of date: rebuild from the store
+        TraceSpan span("StorageManager::rebuildIndex", path);
+        typename Kind::Builder builder;
+        bool read = forEach([&builder](const Itinerary& itinerary) {
+            Kind::add(builder, itinerary);
+            return true;
+        });
+        if (!read && source != FileStamp()) {
+            return false;
+        }
+        Kind::finish(builder, index, source != FileStamp() ? path : std::string(), source);
+        return true;
+    }
+
+    std::vector<Itinerary> StorageManager::fetch(const std::vector<std::string_view>& ids, bool few) const {
+        std::vector<Itinerary> itineraries;
+        if (few && ensureIndex()) {
+            for (std::string_view id : ids) {
+                Itinerary itinerary;
+                if (find(std::string(id), itinerary)) {
+                    itineraries.push_back(std::move(itinerary));
                 }
             }
-            else {
-                std::cerr << "Invalid JSON format: expected array" << std::endl;
+            return itineraries;
+        }
+
+        // One pass over the store, keeping the wanted records in ID order
+        std::unordered_map<std::string_view, std::size_t> positions;
+        for (std::size_t i = 0; i < ids.size(); ++i) {
+            positions.emplace(ids[i], i);
+        }
+        std::vector<std::optional<Itinerary>> found(ids.size());
+        forEach([&positions, &found](const Itinerary& itinerary) {
+            auto it = positions.find(itinerary.id);
+            if (it != positions.end()) {
+                found[it->second] = itinerary;
+            }
+            return true;
+        });
+        for (auto& itinerary : found) {
+            if (itinerary) {
+                itineraries.push_back(std::move(*itinerary));
+            }
+        }
+        return itineraries;
+    }
+
+    bool StorageManager::ensureIndex() const {
+        if (deferredWrites()) {
+            return false;  // Positions on disk are out of date while rewrites are held
+        }
+        if (index_checked_) {
+            return index_.isOpen();
+        }
+        index_checked_ = true;
+        convertIfNeeded();
+
+        std::vector<std::string> files;
+        if (std::filesystem::exists(storage_path_)) {
+            files.push_back(storage_path_);
+        }
+        if (index_.open() && index_.matches(files)) {
+            return true;
+        }
+        return rebuildIndex();
+    }
+
+    bool StorageManager::rebuildIndex() const {
+        TraceSpan span("StorageManager::rebuildIndex");
+        MappedFile file;
+        bool exists = std::filesystem::exists(storage_path_);
+        if (exists && !file.open(storage_path_)) {
+            return false;
+        }
+
+        if (!index_.create(file.size() / 128)) {
+            return false;
+        }
+
+        std::string error;
+        const char* data = reinterpret_cast<const char*>(file.data());
+        bool ok = file.size() == 0 || scanRecordSpans<Itinerary>(data, file.size(), format_,
+            [this](const Itinerary& itinerary, const RecordSpan& span) {
+                return index_.put(itinerary.id, storage_path_, span.offset, span.length);
+            }, error);
+        if (!ok) {
+            std::cerr << "Error indexing " << storage_path_ << ": " << error << std::endl;
+            index_.close();
+            return false;
+        }
+
+        index_.stampFile(storage_path_);
+        return true;
+    }
+
+    bool StorageManager::scanFile(const std::string& path, StorageFormat format,
+        const std::function<bool(const Itinerary&)>& visitor) const {
+        // Check if file exists
+        if (!std::filesystem::exists(path)) {
+            // File doesn't exist, nothing to visit
+            return true;
+        }
+
+        // Open and stream the file (or its cached records)
+        try {
+            std::string error;
+            bool ok = readRecordFile<Itinerary>(path, visitor, error, format);
+            if (!error.empty()) {
+                // Invalid entries are skipped but the rest is still processed
+                std::cerr << "Error reading itineraries from " << path << ": " << error << std::endl;
             }
+            return ok;
         }
         catch (const std::exception& e) {
-            std::cerr << "Error reading itineraries from " << storage_path_ << ": " << e.what() << std::endl;
-            // Return empty list on error
+            std::cerr << "Error reading itineraries from " << path << ": " << e.what() << std::endl;
         }
 
-        return itineraries;
+        return false;
+    }
+
+    void StorageManager::convertIfNeeded() const {
+        if (std::filesystem::exists(storage_path_)) {
+            return;
+        }
+
+        for (StorageFormat other : { StorageFormat::Json, StorageFormat::Cbor, StorageFormat::MsgPack }) {
+            std::string old_path = std::filesystem::path(storage_path_)
+                .replace_extension(formatExtension(other)).string();
+            if (other == format_ || !std::filesystem::exists(old_path)) {
+                continue;
+            }
+
+            std::vector<Itinerary> itineraries;
+            bool ok = scanFile(old_path, other, [&itineraries](const Itinerary& itinerary) {
+                itineraries.push_back(itinerary);
+                return true;
+            });
+
+            // Keep the old file unless the new one was written completely
+            if (ok && writeRecords(storage_path_, itineraries, format_, json_indent_)) {
+                std::error_code ec;
+                std::filesystem::remove(old_path, ec);
+            }
+            else {
+                std::cerr << "Error converting " << old_path << " to " << storage_path_ << std::endl;
+            }
+            return;
+        }
     }
 
-    void StorageManager::saveAll(const std::vector<Itinerary>& itineraries) const {
+    bool StorageManager::saveAll(const std::vector<Itinerary>& itineraries) const {
+        return save(itineraries, nullptr);
+    }
+
+    bool StorageManager::saveTagChange(const std::vector<Itinerary>& itineraries, std::size_t changed) const {
+        // Update the tag index in place if it is current, before the store
+        // changes under it
+        TagIndex tags;
+        const TagIndex* updated = nullptr;
+        if (!deferredWrites() && changed < itineraries.size() && std::filesystem::exists(tags_path_)) {
+            ProfileScope profile(ProfilePhase::Load);
+            if (tags.open(tags_path_, fileStamp(storage_path_)) && tags.size() == itineraries.size()
+                && tags.id(static_cast<std::uint32_t>(changed)) == itineraries[changed].id) {
+                tags.update(static_cast<std::uint32_t>(changed), itineraries[changed].tags, itineraries[changed].is_favorite);
+                updated = &tags;
+            }
+        }
+        return save(itineraries, updated);
+    }
+
+    bool StorageManager::save(const std::vector<Itinerary>& itineraries, const TagIndex* tags) const {
+        TraceSpan span("StorageManager::saveAll", storage_path_);
         // Ensure directory exists
         std::filesystem::path dir_path = std::filesystem::path(storage_path_).parent_path();
         if (!std::filesystem::exists(dir_path)) {
@@ -77,27 +469,52 @@ namespace travel_planner {
             }
             catch (const std::exception& e) {
                 std::cerr << "Error creating directory " << dir_path.string() << ": " << e.what() << std::endl;
-                return; // Exit on error
+                return false; // Exit on error
             }
         }
 
-        try {
-            // Convert itineraries to JSON
-            nlohmann::json j = itineraries;
+        // Batch runs hold the rewrite in memory until their next checkpoint
+        if (deferWrite(storage_path_, itineraries, format_, json_indent_)) {
+            return true;
+        }
 
-            // Write to file with pretty formatting
-            std::ofstream file(storage_path_);
-            if (!file.is_open()) {
-                std::cerr << "Error opening file for writing: " << storage_path_ << std::endl;
-                return;
+        try {
+            // Serialize straight into the file, no intermediate JSON tree
+            std::vector<RecordSpan> spans;
+            if (!writeRecords(storage_path_, itineraries, format_, json_indent_, &spans)) {
+                return false;
             }
+            cacheRecords(storage_path_, itineraries);
 
-            file << j.dump(2); // Use indent of 2 spaces for pretty formatting
+            // The whole file was replaced, so its index entries are too
+            if (index_.isOpen() || index_.open() || index_.create(itineraries.size())) {
+                index_.replaceFile(storage_path_, itineraries, spans);
+            }
 
+            // So are the secondary indexes kept for it
+            refreshIndexes(itineraries, tags);
+            return true;
         }
         catch (const std::exception& e) {
             std::cerr << "Error saving itineraries to " << storage_path_ << ": " << e.what() << std::endl;
         }
+        return false;
+    }
+
+    void StorageManager::refreshIndexes(const std::vector<Itinerary>& itineraries, const TagIndex* tags) const {
+        // Only indexes that are in use are kept; the others are built on
+        // their first query
+        const FileStamp source = fileStamp(storage_path_);
+        refreshIndex<DateIndexKind>(dates_path_, itineraries, source);
+        refreshIndex<SearchIndexKind>(search_path_, itineraries, source);
+        refreshIndex<NameIndexKind>(names_path_, itineraries, source);
+        if (tags != nullptr) {
+            tags->save(tags_path_, source);
+        }
+        else {
+            refreshIndex<TagIndexKind>(tags_path_, itineraries, source);
+        }
+        refreshIndex<FuzzyIndexKind>(fuzzy_path_, itineraries, source);
     }
 
 } // namespace travel_planner
\ No newline at end of file
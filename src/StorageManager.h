@@ -1,7 +1,17 @@
 #ifndef TRAVEL_PLANNER_STORAGE_MANAGER_H
 #define TRAVEL_PLANNER_STORAGE_MANAGER_H
 
+#include "../include/Date.h"
 #include "../include/Itinerary.h"
+#include "DateIndex.h"
+#include "FuzzyIndex.h"
+#include "SearchIndex.h"
+#include "TagIndex.h"
+#include "TrigramIndex.h"
+#include "StorageFormat.h"
+#include "RecordIndex.h"
+#include <functional>
+#include <memory_resource>
 #include <vector>
 #include <string>
 
@@ -13,7 +23,9 @@ namespace travel_planner {
     class StorageManager {
     public:
         /**
-         * Constructor
+         * Constructor. The file's extension selects its format (see
+         * StorageFormat); a store found under another format's extension is
+         * converted on first use.
          * @param storage_path Path to the storage file
          */
         explicit StorageManager(const std::string& storage_path);
@@ -24,14 +36,177 @@ namespace travel_planner {
          */
         std::vector<Itinerary> loadAll() const;
 
+        /**
+         * Loads all itineraries into a memory resource, usually the
+         * command's arena (currentArena()), for read-only use
+         * @param resource Resource the itineraries and their strings are
+         *                 allocated from
+         * @return Vector containing all stored itineraries
+         */
+        std::pmr::vector<pmr::Itinerary> loadAll(std::pmr::memory_resource* resource) const;
+
+        /**
+         * Streams itineraries from storage one at a time without loading
+         * the whole file
+         * @param visitor Called for each itinerary; return false to stop
+         * @return False if the file could not be read
+         */
+        bool forEach(const std::function<bool(const Itinerary&)>& visitor) const;
+
+        /**
+         * Looks up one itinerary through the ID index ("<store>.idx"), reading
+         * only that record from the file
+         * @param id Itinerary ID
+         * @param itinerary Receives the itinerary when found
+         * @return True if the itinerary exists
+         */
+        bool find(const std::string& id, Itinerary& itinerary) const;
+
+        /**
+         * Finds the itineraries under way on a day, through the date index
+         * ("<store>.dates") rather than by parsing every itinerary's dates
+         * @param day Day that must lie between the start and end dates
+         * @return Matching itineraries, by start date
+         */
+        std::vector<Itinerary> activeOn(Date day) const;
+
+        /**
+         * Finds the itineraries whose name or description matches a keyword
+         * query, through the inverted index ("<store>.search")
+         * @param query Parsed query (see SearchQuery::parse())
+         * @return Matching itineraries, best match first
+         */
+        std::vector<Itinerary> search(const SearchQuery& query) const;
+
+        /**
+         * Finds the itineraries matching a tag query through the tag index
+         * ("<store>.tags"), reading only the itineraries it selects
+         * @param query Tags required, alternatives and exclusions
+         * @return Matching itineraries, in store order
+         */
+        std::vector<Itinerary> listTagged(const TagQuery& query) const;
+
+        /**
+         * Finds the itineraries whose name contains a pattern, ignoring
+         * ASCII case, through the trigram index ("<store>.trigrams"). Names
+         * are read from the index, not the store.
+         * @param pattern Substring to look for
+         * @param visitor Called with the ID and name of each match, in store order
+         * @return False if no index is available
+         */
+        bool searchNames(const std::string& pattern,
+            const std::function<void(std::string_view id, std::string_view name)>& visitor) const;
+
+        /**
+         * Finds the itineraries with a name, name word or tag within an edit
+         * distance of a term, through the fuzzy index ("<store>.fuzzy")
+         * @param term Possibly mistyped term
+         * @param max_distance Largest edit distance accepted
+         * @param visitor Called with each match, closest first
+         * @return False if no index is available
+         */
+        bool searchFuzzy(const std::string& term, std::uint32_t max_distance,
+            const std::function<void(const FuzzyIndex::Match& match)>& visitor) const;
+
         /**
          * Saves all itineraries to storage
          * @param itineraries Vector of itineraries to save
+         * @return False if the store was not written, e.g. because its
+         *         current contents could not be read
+         */
+        bool saveAll(const std::vector<Itinerary>& itineraries) const;
+
+        /**
+         * Saves all itineraries after only the tags or the favorite flag of
+         * one of them changed. The tag index, if in use and current, is
+         * updated for that itinerary instead of rebuilt.
+         * @param itineraries Vector of itineraries to save, in store order
+         * @param changed Position of the changed itinerary
+         * @return False if the store was not written
          */
-        void saveAll(const std::vector<Itinerary>& itineraries) const;
+        bool saveTagChange(const std::vector<Itinerary>& itineraries, std::size_t changed) const;
+
+        /**
+         * Sets the indentation of the saved file
+         * @param indent Spaces per level; 0 writes compact JSON
+         */
+        void setJsonIndent(int indent) { json_indent_ = indent; }
 
     private:
+        /**
+         * Rewrites a store saved in another format (same path, other
+         * extension) into this store's format and removes the old file
+         */
+        void convertIfNeeded() const;
+
+        /**
+         * Streams one store file to a visitor
+         * @param path File to read
+         * @param format Format the file is expected to be in
+         * @param visitor Called for each itinerary; return false to stop
+         * @return False if the file could not be read
+         */
+        bool scanFile(const std::string& path, StorageFormat format,
+            const std::function<bool(const Itinerary&)>& visitor) const;
+
+        /**
+         * Opens the ID index, rebuilding it if it is missing or out of date
+         * @return False if no index is available
+         */
+        bool ensureIndex() const;
+
+        /**
+         * Opens a secondary index, rebuilding it from the store if it is
+         * missing or out of date. While writes are deferred it is built from
+         * the held records instead, and not saved.
+         * @param path Index file
+         * @param index Receives the index
+         * @return False if no index is available
+         */
+        template <typename Kind>
+        bool openIndex(const std::string& path, typename Kind::Index& index) const;
+
+        /**
+         * Reads itineraries by ID
+         * @param ids IDs to read
+         * @param few True to look each one up through the ID index, false
+         *            to read them in one pass over the store
+         * @return Itineraries found, in the order of ids
+         */
+        std::vector<Itinerary> fetch(const std::vector<std::string_view>& ids, bool few) const;
+
+        /**
+         * Writes the store and brings its indexes up to date
+         * @param itineraries Itineraries to save
+         * @param tags Tag index already updated for them, or null to
+         *             rebuild it (see refreshIndexes())
+         * @return False if the store was not written
+         */
+        bool save(const std::vector<Itinerary>& itineraries, const TagIndex* tags) const;
+
+        /**
+         * Rewrites the secondary indexes that exist after the store was saved
+         * @param itineraries Itineraries just written
+         * @param tags Tag index to save as it is instead of rebuilding it, or null
+         */
+        void refreshIndexes(const std::vector<Itinerary>& itineraries, const TagIndex* tags) const;
+
+        /**
+         * Rebuilds the ID index from the storage file
+         * @return True on success
+         */
+        bool rebuildIndex() const;
+
         std::string storage_path_; // Path to the storage file
+        StorageFormat format_;     // Encoding of the storage file
+        int json_indent_;          // Indentation of the saved file
+        mutable RecordIndex index_;         // ID -> position in the storage file
+        std::string dates_path_;            // Itinerary IDs by start and end date
+        std::string search_path_;           // Inverted index of names and descriptions
+        std::string names_path_;            // Trigram index of names
+        std::string tags_path_;             // Itinerary ordinals by tag, and favorites
+        std::string fuzzy_path_;            // BK-tree of name and tag terms
+        mutable bool index_checked_ = false;
     };
 
 } // namespace travel_planner
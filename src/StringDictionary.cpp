@@ -0,0 +1,21 @@
+#include "StringDictionary.h"
+
+namespace travel_planner {
+
+    Symbol StringDictionary::intern(std::string_view value) {
+        auto it = symbols_.find(value);
+        if (it != symbols_.end()) {
+            return it->second;
+        }
+        Symbol symbol = static_cast<Symbol>(strings_.size());
+        const std::string& stored = strings_.emplace_back(value);
+        symbols_.emplace(stored, symbol);
+        return symbol;
+    }
+
+    Symbol StringDictionary::find(std::string_view value) const {
+        auto it = symbols_.find(value);
+        return it == symbols_.end() ? kNoSymbol : it->second;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,63 @@
+#ifndef TRAVEL_PLANNER_STRING_DICTIONARY_H
+#define TRAVEL_PLANNER_STRING_DICTIONARY_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace travel_planner {
+
+    /**
+     * Small integer handle of an interned string
+     */
+    using Symbol = std::uint32_t;
+
+    /**
+     * Handle of no string, e.g. for a view whose source has no dictionary
+     */
+    constexpr Symbol kNoSymbol = std::numeric_limits<Symbol>::max();
+
+    /**
+     * Interning table: each distinct string is stored once and handed out
+     * as a dense Symbol (0, 1, 2, ...) in order of first appearance, so
+     * values repeated across many records can be grouped and compared as
+     * integers. Symbols stay valid for the dictionary's lifetime.
+     *
+     * Only ExpenseRollup uses it, for its category, day and month groups.
+     * The record structs keep their category, itinerary ID and tag fields
+     * as std::string. Columnar shards dictionary-encode category and
+     * itinerary ID on disk with their own table (see ExpenseColumnStore).
+     */
+    class StringDictionary {
+    public:
+        /**
+         * @return Symbol of the string, adding it if it is new
+         */
+        Symbol intern(std::string_view value);
+
+        /**
+         * @return Symbol of the string, or kNoSymbol if it was never interned
+         */
+        Symbol find(std::string_view value) const;
+
+        /**
+         * @return The string of a symbol handed out by this dictionary
+         */
+        std::string_view name(Symbol symbol) const { return strings_[symbol]; }
+
+        /**
+         * @return Number of distinct strings; every symbol is below it
+         */
+        std::size_t size() const { return strings_.size(); }
+
+    private:
+        std::deque<std::string> strings_;  // A deque never moves its strings, so the views stay valid
+        std::unordered_map<std::string_view, Symbol> symbols_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_STRING_DICTIONARY_H
@@ -0,0 +1,287 @@
+#include "TagIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[4] = { 'T', 'P', 'T', 'I' };
+        const std::uint32_t kVersion = 2;  // 2: byte length before each tag bitmap
+
+        struct FileHeader {
+            char magic[4];
+            std::uint32_t version;
+            std::uint64_t source_size;
+            std::int64_t source_mtime;
+            std::uint32_t entry_count;
+            std::uint32_t ids_bytes;
+            std::uint32_t tag_count;
+            std::uint32_t reserved;
+        };
+
+        template <typename T>
+        void append(std::string& out, const T* values, std::size_t count) {
+            out.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+        }
+
+        template <typename T>
+        bool consume(std::string_view& in, T* values, std::size_t count) {
+            const std::size_t bytes = count * sizeof(T);
+            if (in.size() < bytes) {
+                return false;
+            }
+            std::memcpy(values, in.data(), bytes);
+            in.remove_prefix(bytes);
+            return true;
+        }
+
+        void appendBytes(std::string& out, std::string_view bytes) {
+            const std::uint32_t length = static_cast<std::uint32_t>(bytes.size());
+            append(out, &length, 1);
+            out += bytes;
+        }
+
+        // Length-prefixed bytes written by appendBytes()
+        bool consumeBytes(std::string_view& in, std::string_view& bytes) {
+            std::uint32_t length = 0;
+            if (!consume(in, &length, 1) || in.size() < length) {
+                return false;
+            }
+            bytes = in.substr(0, length);
+            in.remove_prefix(length);
+            return true;
+        }
+
+    } // namespace
+
+    void TagIndex::add(std::string_view id, const std::vector<std::string>& tags, bool favorite) {
+        materialize();
+        const std::uint32_t ordinal = static_cast<std::uint32_t>(entries_.size());
+        entries_.push_back({ static_cast<std::uint32_t>(ids_.size()), static_cast<std::uint32_t>(id.size()) });
+        ids_.append(id);
+        for (const auto& tag : tags) {
+            tags_[tag].add(ordinal);
+        }
+        if (favorite) {
+            favorites_.add(ordinal);
+        }
+    }
+
+    void TagIndex::update(std::uint32_t ordinal, const std::vector<std::string>& tags, bool favorite) {
+        materialize();
+        for (auto it = tags_.begin(); it != tags_.end();) {
+            if (std::find(tags.begin(), tags.end(), it->first) == tags.end() && it->second.remove(ordinal)
+                && it->second.empty()) {
+                it = tags_.erase(it);  // No record has the tag any more
+            }
+            else {
+                ++it;
+            }
+        }
+        for (const auto& tag : tags) {
+            tags_[tag].add(ordinal);
+        }
+        if (favorite) {
+            favorites_.add(ordinal);
+        }
+        else {
+            favorites_.remove(ordinal);
+        }
+    }
+
+    std::string_view TagIndex::id(std::uint32_t ordinal) const {
+        if (file_.isOpen()) {
+            const Entry& entry = mapped_entries_[ordinal];
+            return mapped_ids_.substr(entry.id_offset, entry.id_length);
+        }
+        const Entry& entry = entries_[ordinal];
+        return std::string_view(ids_).substr(entry.id_offset, entry.id_length);
+    }
+
+    const Bitmap* TagIndex::find(std::string_view tag) const {
+        auto decoded = tags_.find(tag);
+        if (decoded != tags_.end()) {
+            return &decoded->second;
+        }
+        auto encoded = std::lower_bound(encoded_.begin(), encoded_.end(), tag,
+            [](const Encoded& entry, std::string_view value) { return entry.tag < value; });
+        if (encoded == encoded_.end() || encoded->tag != tag) {
+            return nullptr;
+        }
+        std::string_view in = encoded->bitmap;
+        Bitmap bitmap;
+        if (!bitmap.deserialize(in)) {
+            std::cerr << "Warning: Damaged tag index entry for \"" << tag << "\"" << std::endl;
+        }
+        return &tags_.emplace(std::string(tag), std::move(bitmap)).first->second;
+    }
+
+    Bitmap TagIndex::tagged(const std::vector<std::string>& tags) const {
+        Bitmap result;
+        for (const auto& tag : tags) {
+            if (const Bitmap* ordinals = find(tag)) {
+                result |= *ordinals;
+            }
+        }
+        return result;
+    }
+
+    Bitmap TagIndex::evaluate(const TagQuery& query) const {
+        // Start from the smallest required set, so each AND shrinks it
+        std::vector<const Bitmap*> required;
+        static const Bitmap none;
+        for (const auto& tag : query.all) {
+            const Bitmap* ordinals = find(tag);
+            required.push_back(ordinals != nullptr ? ordinals : &none);
+        }
+        if (query.favorites) {
+            required.push_back(&favorites_);
+        }
+        Bitmap either;
+        if (!query.any.empty()) {
+            either = tagged(query.any);
+            required.push_back(&either);
+        }
+        std::sort(required.begin(), required.end(), [](const Bitmap* a, const Bitmap* b) {
+            return a->cardinality() < b->cardinality();
+        });
+
+        Bitmap result = required.empty() ? Bitmap::range(static_cast<std::uint32_t>(size())) : *required.front();
+        for (std::size_t i = 1; i < required.size() && !result.empty(); ++i) {
+            result &= *required[i];
+        }
+        if (!query.none.empty() && !result.empty()) {
+            result.andNot(tagged(query.none));
+        }
+        return result;
+    }
+
+    void TagIndex::materialize() {
+        if (!file_.isOpen()) {
+            return;
+        }
+        entries_.assign(mapped_entries_, mapped_entries_ + mapped_count_);
+        ids_.assign(mapped_ids_);
+        for (const Encoded& encoded : encoded_) {
+            find(encoded.tag);
+        }
+        encoded_.clear();
+        mapped_entries_ = nullptr;
+        mapped_count_ = 0;
+        mapped_ids_ = {};
+        file_.close();
+    }
+
+    bool TagIndex::open(const std::string& path, const FileStamp& source) {
+        *this = TagIndex();
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        std::string_view in(reinterpret_cast<const char*>(file.data()), file.size());
+
+        FileHeader header;
+        if (!consume(in, &header, 1) || std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+            || header.version != kVersion) {
+            return false;
+        }
+        if (header.source_size != source.size || header.source_mtime != source.mtime) {
+            return false;  // Written for other contents of the store
+        }
+
+        // Entries and IDs are used where they are mapped
+        const std::size_t entry_bytes = std::size_t(header.entry_count) * sizeof(Entry);
+        if (in.size() < entry_bytes || in.size() - entry_bytes < header.ids_bytes) {
+            return false;
+        }
+        const Entry* entries = reinterpret_cast<const Entry*>(in.data());
+        std::string_view ids = in.substr(entry_bytes, header.ids_bytes);
+        in.remove_prefix(entry_bytes + header.ids_bytes);
+        for (std::uint32_t i = 0; i < header.entry_count; ++i) {
+            if (static_cast<std::uint64_t>(entries[i].id_offset) + entries[i].id_length > ids.size()) {
+                return false;
+            }
+        }
+
+        Bitmap favorites;
+        if (!favorites.deserialize(in)) {
+            return false;
+        }
+
+        // Only the tag directory is read; bitmaps are decoded when queried
+        std::vector<Encoded> encoded(header.tag_count);
+        for (Encoded& tag : encoded) {
+            if (!consumeBytes(in, tag.tag) || !consumeBytes(in, tag.bitmap)) {
+                return false;
+            }
+        }
+
+        file_ = std::move(file);
+        mapped_entries_ = entries;
+        mapped_count_ = header.entry_count;
+        mapped_ids_ = ids;
+        encoded_ = std::move(encoded);
+        favorites_ = std::move(favorites);
+        return true;
+    }
+
+    bool TagIndex::save(const std::string& path, const FileStamp& source) const {
+        const bool mapped = file_.isOpen();
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+        header.entry_count = static_cast<std::uint32_t>(size());
+        header.ids_bytes = static_cast<std::uint32_t>(mapped ? mapped_ids_.size() : ids_.size());
+        header.tag_count = static_cast<std::uint32_t>(mapped ? encoded_.size() : tags_.size());
+
+        std::string bytes;
+        append(bytes, &header, 1);
+        if (mapped) {
+            // Unchanged since it was mapped: copy the encoded parts
+            append(bytes, mapped_entries_, mapped_count_);
+            bytes += mapped_ids_;
+            favorites_.serialize(bytes);
+            for (const Encoded& tag : encoded_) {
+                appendBytes(bytes, tag.tag);
+                appendBytes(bytes, tag.bitmap);
+            }
+        }
+        else {
+            append(bytes, entries_.data(), entries_.size());
+            bytes += ids_;
+            favorites_.serialize(bytes);
+            std::string encoded;
+            for (const auto& [tag, ordinals] : tags_) {
+                appendBytes(bytes, tag);
+                encoded.clear();
+                ordinals.serialize(encoded);
+                appendBytes(bytes, encoded);
+            }
+        }
+
+        // Replace atomically so a reader never sees half an index
+        const std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Warning: Could not write tag index " << path << std::endl;
+                return false;
+            }
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!file) {
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, path, ec);
+        return !ec;
+    }
+
+} // namespace travel_planner
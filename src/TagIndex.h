@@ -0,0 +1,123 @@
+#ifndef TRAVEL_PLANNER_TAG_INDEX_H
+#define TRAVEL_PLANNER_TAG_INDEX_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Bitmap.h"
+#include "MappedFile.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    /**
+     * Boolean query over tags: records carrying every tag of all, at least
+     * one tag of any (when not empty) and none of the tags of none,
+     * optionally restricted to favorites
+     */
+    struct TagQuery {
+        std::vector<std::string> all;
+        std::vector<std::string> any;
+        std::vector<std::string> none;
+        bool favorites = false;
+    };
+
+    /**
+     * Bitmaps of record ordinals (positions in store order): one per tag,
+     * and one of the favorites. A query is answered with bitmap AND, OR and
+     * AND NOT; only the records it selects are read.
+     *
+     * Persisted as "<store>.tags" next to the store and tagged with its
+     * stamp, so an index that missed a change is detected and rebuilt. The
+     * file is written in native byte order and memory-mapped when read; a
+     * tag's bitmap is decoded on its first use, so a query reads only the
+     * bitmaps it names.
+     */
+    class TagIndex {
+    public:
+        /**
+         * Adds the next record in store order
+         * @param id Record ID
+         * @param tags Its tags
+         * @param favorite True if it is a favorite
+         */
+        void add(std::string_view id, const std::vector<std::string>& tags, bool favorite);
+
+        /**
+         * Replaces the tags of a record already indexed
+         * @param ordinal Position of the record
+         * @param tags Its tags now
+         * @param favorite True if it is a favorite now
+         */
+        void update(std::uint32_t ordinal, const std::vector<std::string>& tags, bool favorite);
+
+        /**
+         * @return Ordinals of the records matching a query
+         */
+        Bitmap evaluate(const TagQuery& query) const;
+
+        /**
+         * @return ID of the record at an ordinal
+         */
+        std::string_view id(std::uint32_t ordinal) const;
+
+        /**
+         * @return Number of indexed records
+         */
+        std::size_t size() const { return file_.isOpen() ? mapped_count_ : entries_.size(); }
+
+        /**
+         * Maps an index file
+         * @param path Index file
+         * @param source Current stamp of the indexed store
+         * @return False if the file is missing, unreadable or was written
+         *         for another version of the store
+         */
+        bool open(const std::string& path, const FileStamp& source);
+
+        /**
+         * Writes the index, tagged with the stamp of the store it reflects
+         * @return True on success
+         */
+        bool save(const std::string& path, const FileStamp& source) const;
+
+    private:
+        struct Entry {
+            std::uint32_t id_offset;  // Into ids_
+            std::uint32_t id_length;
+        };
+
+        struct Encoded {
+            std::string_view tag;
+            std::string_view bitmap;  // Serialized ordinals
+        };
+
+        // Ordinals of a tag, decoded from the file on first use; null if
+        // no record has it
+        const Bitmap* find(std::string_view tag) const;
+
+        // Union of the bitmaps of some tags
+        Bitmap tagged(const std::vector<std::string>& tags) const;
+
+        // Copies the mapped entries and IDs and decodes every tag, so the
+        // index can change, and releases the file
+        void materialize();
+
+        MappedFile file_;                         // Open until materialized
+        const Entry* mapped_entries_ = nullptr;
+        std::size_t mapped_count_ = 0;
+        std::string_view mapped_ids_;
+        std::vector<Encoded> encoded_;            // Mapped tags, by tag
+
+        std::vector<Entry> entries_;                              // By ordinal, once materialized
+        std::string ids_;                                         // IDs back to back
+        mutable std::map<std::string, Bitmap, std::less<>> tags_; // Tag -> ordinals (decoded)
+        Bitmap favorites_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_TAG_INDEX_H
@@ -0,0 +1,185 @@
+#include "TextKernels.h"
+#include <cstdint>
+
+// The vector kernels are compiled for their target only and picked at run
+// time, so the binary still runs on CPUs without them. Other compilers and
+// architectures use the scalar loop.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TRAVEL_PLANNER_X86_TEXT_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace travel_planner {
+
+    namespace {
+
+        const std::size_t npos = std::string_view::npos;
+
+        char lowerAscii(char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        bool equalIgnoreCase(const char* text, const char* pattern, std::size_t length) {
+            for (std::size_t i = 0; i < length; ++i) {
+                if (lowerAscii(text[i]) != lowerAscii(pattern[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // First match starting at or after from
+        std::size_t findScalar(const char* text, std::size_t size, std::size_t from, std::string_view pattern) {
+            const char first = lowerAscii(pattern[0]);
+            for (std::size_t start = from; start + pattern.size() <= size; ++start) {
+                if (lowerAscii(text[start]) == first
+                    && equalIgnoreCase(text + start + 1, pattern.data() + 1, pattern.size() - 1)) {
+                    return start;
+                }
+            }
+            return npos;
+        }
+
+#ifdef TRAVEL_PLANNER_X86_TEXT_KERNELS
+        bool cpuHasSse2() {
+            static const bool has_sse2 = __builtin_cpu_supports("sse2");
+            return has_sse2;
+        }
+
+        bool cpuHasAvx2() {
+            static const bool has_avx2 = __builtin_cpu_supports("avx2");
+            return has_avx2;
+        }
+
+        // Checks the candidate starts set in a mask, lowest first; bit i
+        // stands for position block + i
+        std::size_t verifyCandidates(const char* text, std::size_t block, std::uint32_t mask, std::string_view pattern) {
+            while (mask != 0) {
+                const std::size_t start = block + static_cast<std::size_t>(__builtin_ctz(mask));
+                if (equalIgnoreCase(text + start + 1, pattern.data() + 1, pattern.size() - 1)) {
+                    return start;
+                }
+                mask &= mask - 1;
+            }
+            return npos;
+        }
+
+        // Lowercases 'A'-'Z': a byte is upper case when byte - 'A' is at
+        // most 25 unsigned
+        __attribute__((target("sse2"), always_inline))
+        inline __m128i lower16(__m128i bytes) {
+            const __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8('A'));
+            const __m128i upper = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(25)), offset);
+            return _mm_or_si128(bytes, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        }
+
+        // Bit i set where the pattern's first byte is at at[i] and its last
+        // byte at at[i + last]
+        __attribute__((target("sse2"), always_inline))
+        inline std::uint32_t candidates16(const char* at, std::size_t last, __m128i first, __m128i final) {
+            const __m128i heads = lower16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(at)));
+            const __m128i tails = lower16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(at + last)));
+            return static_cast<std::uint32_t>(_mm_movemask_epi8(
+                _mm_and_si128(_mm_cmpeq_epi8(heads, first), _mm_cmpeq_epi8(tails, final))));
+        }
+
+        // Finds the pattern 16 starts at a time from block on; inlined into
+        // each kernel, so the AVX2 one keeps VEX encoding and avoids SSE
+        // transition stalls
+        __attribute__((target("sse2"), always_inline))
+        inline std::size_t find16(const char* text, std::size_t size, std::size_t block, std::string_view pattern) {
+            const std::size_t last = pattern.size() - 1;
+            if (size < last + 16) {
+                return findScalar(text, size, block, pattern);
+            }
+            const __m128i first = _mm_set1_epi8(lowerAscii(pattern[0]));
+            const __m128i final = _mm_set1_epi8(lowerAscii(pattern[last]));
+            for (; block + last + 16 <= size; block += 16) {
+                std::uint32_t mask = candidates16(text + block, last, first, final);
+                if (mask != 0) {
+                    std::size_t start = verifyCandidates(text, block, mask, pattern);
+                    if (start != npos) {
+                        return start;
+                    }
+                }
+            }
+            if (block + last >= size) {
+                return npos;
+            }
+            // Fewer than 16 starts are left: reload the final 16, which
+            // overlap the last block, and drop the starts already checked
+            const std::size_t tail = size - last - 16;
+            const std::uint32_t mask = candidates16(text + tail, last, first, final) & (~0u << (block - tail));
+            return verifyCandidates(text, tail, mask, pattern);
+        }
+
+        __attribute__((target("sse2")))
+        std::size_t findSse2(const char* text, std::size_t size, std::string_view pattern) {
+            return find16(text, size, 0, pattern);
+        }
+
+        __attribute__((target("avx2")))
+        inline __m256i lower32(__m256i bytes) {
+            const __m256i offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8('A'));
+            const __m256i upper = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(25)), offset);
+            return _mm256_or_si256(bytes, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+        }
+
+        __attribute__((target("avx2")))
+        std::size_t findAvx2(const char* text, std::size_t size, std::string_view pattern) {
+            const std::size_t last = pattern.size() - 1;
+            const __m256i first = _mm256_set1_epi8(lowerAscii(pattern[0]));
+            const __m256i final = _mm256_set1_epi8(lowerAscii(pattern[last]));
+            std::size_t block = 0;
+            for (; block + last + 32 <= size; block += 32) {
+                const __m256i heads = lower32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + block)));
+                const __m256i tails = lower32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + block + last)));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(heads, first), _mm256_cmpeq_epi8(tails, final))));
+                if (mask != 0) {
+                    std::size_t start = verifyCandidates(text, block, mask, pattern);
+                    if (start != npos) {
+                        return start;
+                    }
+                }
+            }
+            // Short texts, such as most names, are handled 16 bytes at a time
+            return find16(text, size, block, pattern);
+        }
+#endif
+
+    } // namespace
+
+    bool textKernelAvailable(TextKernel kernel) {
+        if (kernel == TextKernel::Auto || kernel == TextKernel::Scalar) {
+            return true;
+        }
+#ifdef TRAVEL_PLANNER_X86_TEXT_KERNELS
+        return kernel == TextKernel::Sse2 ? cpuHasSse2() : cpuHasSse2() && cpuHasAvx2();
+#else
+        return false;
+#endif
+    }
+
+    std::size_t findIgnoreCase(std::string_view text, std::string_view pattern, TextKernel kernel) {
+        if (pattern.empty()) {
+            return 0;
+        }
+        if (pattern.size() > text.size()) {
+            return npos;
+        }
+#ifdef TRAVEL_PLANNER_X86_TEXT_KERNELS
+        // Texts without a full 32-byte block, such as most names, gain
+        // nothing from AVX2 and pay for its wider setup
+        if ((kernel == TextKernel::Auto || kernel == TextKernel::Avx2) && text.size() >= pattern.size() + 31
+            && textKernelAvailable(TextKernel::Avx2)) {
+            return findAvx2(text.data(), text.size(), pattern);
+        }
+        if (kernel != TextKernel::Scalar && textKernelAvailable(TextKernel::Sse2)) {
+            return findSse2(text.data(), text.size(), pattern);
+        }
+#endif
+        return findScalar(text.data(), text.size(), 0, pattern);
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,44 @@
+#ifndef TRAVEL_PLANNER_TEXT_KERNELS_H
+#define TRAVEL_PLANNER_TEXT_KERNELS_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace travel_planner {
+
+    /**
+     * Implementation of the text kernels. Auto picks AVX2 when the CPU has
+     * it (checked once at run time) and the text spans at least one 32-byte
+     * block, else SSE2 on x86, else the scalar loop; forcing one is meant
+     * for benchmarks and comparisons.
+     */
+    enum class TextKernel { Auto, Scalar, Sse2, Avx2 };
+
+    /**
+     * @return True if the kernel can run on this machine and build
+     */
+    bool textKernelAvailable(TextKernel kernel);
+
+    /**
+     * Finds a pattern in a text, ignoring ASCII case; other bytes must match
+     * exactly. Neither string is copied: the vector kernels compare the
+     * lowercased first and last pattern bytes against 16 or 32 positions at
+     * once and check the rest of the pattern only where both match.
+     * @param text Text to search
+     * @param pattern Pattern to find, in any case
+     * @return Position of the first match, or std::string_view::npos
+     */
+    std::size_t findIgnoreCase(std::string_view text, std::string_view pattern,
+        TextKernel kernel = TextKernel::Auto);
+
+    /**
+     * @return True if the text contains the pattern, ignoring ASCII case
+     */
+    inline bool containsIgnoreCase(std::string_view text, std::string_view pattern,
+        TextKernel kernel = TextKernel::Auto) {
+        return findIgnoreCase(text, pattern, kernel) != std::string_view::npos;
+    }
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_TEXT_KERNELS_H
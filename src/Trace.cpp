@@ -0,0 +1,95 @@
+#include "Trace.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace travel_planner {
+
+    namespace {
+
+        struct TraceEvent {
+            const char* name;
+            std::string detail;
+            std::int64_t start_us;
+            std::int64_t duration_us;
+        };
+
+        struct TraceState {
+            std::string path;
+            std::chrono::steady_clock::time_point origin;
+            std::vector<TraceEvent> events;
+        };
+
+        TraceState& state() {
+            static TraceState trace;
+            return trace;
+        }
+
+        std::int64_t nowUs() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - state().origin).count();
+        }
+
+    } // namespace
+
+    void startTrace(const std::string& path) {
+        TraceState& trace = state();
+        trace.path = path;
+        trace.origin = std::chrono::steady_clock::now();
+        trace.events.clear();
+        trace.events.reserve(1024);
+        detail::trace_enabled = true;
+    }
+
+    bool finishTrace() {
+        if (!detail::trace_enabled) {
+            return true;
+        }
+        detail::trace_enabled = false;
+
+        // Complete ("X") events; nesting is implied by their time ranges
+        TraceState& trace = state();
+        nlohmann::json events = nlohmann::json::array();
+        for (const auto& event : trace.events) {
+            nlohmann::json entry = {
+                {"name", event.name},
+                {"cat", "travel_planner"},
+                {"ph", "X"},
+                {"ts", event.start_us},
+                {"dur", event.duration_us},
+                {"pid", 1},
+                {"tid", 1}
+            };
+            if (!event.detail.empty()) {
+                entry["args"] = { {"detail", event.detail} };
+            }
+            events.push_back(std::move(entry));
+        }
+
+        std::ofstream file(trace.path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Unable to write trace file: " << trace.path << std::endl;
+            return false;
+        }
+        file << nlohmann::json{ {"traceEvents", events}, {"displayTimeUnit", "ms"} }.dump() << std::endl;
+        trace.events.clear();
+        return static_cast<bool>(file);
+    }
+
+    void TraceSpan::begin(const char* name, std::string_view detail) {
+        std::vector<TraceEvent>& events = state().events;
+        event_ = static_cast<std::int64_t>(events.size());
+        events.push_back({ name, std::string(detail), nowUs(), 0 });
+    }
+
+    void TraceSpan::end() {
+        std::vector<TraceEvent>& events = state().events;
+        if (static_cast<std::size_t>(event_) < events.size()) {
+            TraceEvent& event = events[static_cast<std::size_t>(event_)];
+            event.duration_us = nowUs() - event.start_us;
+        }
+    }
+
+} // namespace travel_planner
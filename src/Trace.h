@@ -0,0 +1,69 @@
+#ifndef TRAVEL_PLANNER_TRACE_H
+#define TRAVEL_PLANNER_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace travel_planner {
+
+    namespace detail {
+        // Checked inline by every span, so disabled tracing costs one branch
+        inline bool trace_enabled = false;
+    }
+
+    /**
+     * Starts recording trace spans, to be written to a file by
+     * finishTrace()
+     * @param path File to write the trace to
+     */
+    void startTrace(const std::string& path);
+
+    /**
+     * Writes the recorded spans as Chrome trace-event JSON, which loads in
+     * Perfetto and chrome://tracing, and stops recording
+     * @return False if the file could not be written
+     */
+    bool finishTrace();
+
+    /**
+     * @return True if spans are being recorded
+     */
+    inline bool traceEnabled() { return detail::trace_enabled; }
+
+    /**
+     * Records the time from its construction to its destruction as one
+     * span, when tracing is enabled:
+     *
+     *     TraceSpan span("StorageManager::loadAll", storage_path_);
+     *
+     * Spans nest by scope. Names must be string literals; the detail is
+     * copied only while tracing.
+     */
+    class TraceSpan {
+    public:
+        explicit TraceSpan(const char* name, std::string_view detail = {}) {
+            if (detail::trace_enabled) {
+                begin(name, detail);
+            }
+        }
+
+        ~TraceSpan() {
+            if (event_ >= 0) {
+                end();
+            }
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+
+    private:
+        void begin(const char* name, std::string_view detail);
+        void end();
+
+        std::int64_t event_ = -1;  // Index of the recorded event
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_TRACE_H
@@ -0,0 +1,263 @@
+#include "TrigramIndex.h"
+#include "TextKernels.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace travel_planner {
+
+    namespace {
+
+        const char kMagic[4] = { 'T', 'P', 'T', 'G' };
+        const std::uint32_t kVersion = 1;
+
+        char lowerAscii(char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        // Three bytes from text[i], lowercased and packed
+        std::uint32_t trigramAt(std::string_view text, std::size_t i) {
+            return (std::uint32_t(static_cast<unsigned char>(lowerAscii(text[i]))) << 16)
+                | (std::uint32_t(static_cast<unsigned char>(lowerAscii(text[i + 1]))) << 8)
+                | std::uint32_t(static_cast<unsigned char>(lowerAscii(text[i + 2])));
+        }
+
+        // Distinct trigrams of a text, lowercased
+        void trigramsOf(std::string_view text, std::vector<std::uint32_t>& trigrams) {
+            trigrams.clear();
+            for (std::size_t i = 0; i + 3 <= text.size(); ++i) {
+                trigrams.push_back(trigramAt(text, i));
+            }
+            std::sort(trigrams.begin(), trigrams.end());
+            trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        }
+
+        std::uint64_t align8(std::uint64_t offset) {
+            return (offset + 7) & ~std::uint64_t(7);
+        }
+
+    } // namespace
+
+    struct TrigramIndex::Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t source_size;
+        std::int64_t source_mtime;
+        std::uint32_t doc_count;
+        std::uint32_t trigram_count;
+        std::uint64_t docs_offset;      // DocEntry[doc_count]
+        std::uint64_t trigrams_offset;  // TrigramEntry[trigram_count], sorted by trigram
+        std::uint64_t postings_offset;  // uint32 document numbers
+        std::uint64_t strings_offset;   // IDs and texts
+        std::uint64_t strings_size;
+    };
+
+    struct TrigramIndex::DocEntry {
+        std::uint32_t id_offset;
+        std::uint32_t id_length;
+        std::uint32_t text_offset;
+        std::uint32_t text_length;
+    };
+
+    struct TrigramIndex::TrigramEntry {
+        std::uint32_t trigram;
+        std::uint32_t doc_count;
+        std::uint32_t postings;  // First document number, in postings_offset units
+        std::uint32_t reserved;
+    };
+
+    const TrigramIndex::Header* TrigramIndex::header() const {
+        return reinterpret_cast<const Header*>(image_.data());
+    }
+
+    const TrigramIndex::DocEntry* TrigramIndex::docs() const {
+        return reinterpret_cast<const DocEntry*>(image_.data() + header()->docs_offset);
+    }
+
+    std::string_view TrigramIndex::text(std::uint32_t offset, std::uint32_t length) const {
+        return std::string_view(image_.data() + header()->strings_offset + offset, length);
+    }
+
+    TrigramIndex::Match TrigramIndex::match(std::uint32_t doc) const {
+        const DocEntry& entry = docs()[doc];
+        const std::uint64_t strings_size = header()->strings_size;
+        if (std::uint64_t(entry.id_offset) + entry.id_length > strings_size
+            || std::uint64_t(entry.text_offset) + entry.text_length > strings_size) {
+            return {};  // Corrupt entry; matches nothing
+        }
+        return { text(entry.id_offset, entry.id_length), text(entry.text_offset, entry.text_length) };
+    }
+
+    bool TrigramIndex::validate() const {
+        if (image_.size() < sizeof(Header)) {
+            return false;
+        }
+        const Header* h = header();
+        if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion) {
+            return false;
+        }
+        return h->docs_offset + std::uint64_t(h->doc_count) * sizeof(DocEntry) <= h->trigrams_offset
+            && h->trigrams_offset + std::uint64_t(h->trigram_count) * sizeof(TrigramEntry) <= h->postings_offset
+            && h->postings_offset <= h->strings_offset
+            && h->strings_offset + h->strings_size <= image_.size()
+            && h->docs_offset % 8 == 0 && h->trigrams_offset % 8 == 0 && h->postings_offset % 8 == 0;
+    }
+
+    bool TrigramIndex::open(const std::string& path, const FileStamp& source) {
+        return image_.open(path, [this, &source]() {
+            return validate() && header()->source_size == source.size && header()->source_mtime == source.mtime;
+        });
+    }
+
+    void TrigramIndex::assign(std::string bytes) {
+        image_.assign(std::move(bytes), [this]() { return validate(); });
+    }
+
+    std::size_t TrigramIndex::size() const {
+        return image_.data() ? header()->doc_count : 0;
+    }
+
+    std::vector<TrigramIndex::Match> TrigramIndex::search(std::string_view pattern) const {
+        std::vector<Match> matches;
+        if (!image_.data()) {
+            return matches;
+        }
+        const Header* h = header();
+        std::vector<std::uint32_t> trigrams;
+        trigramsOf(pattern, trigrams);
+        if (trigrams.empty()) {
+            // Too short to have a trigram: check every text
+            for (std::uint32_t doc = 0; doc < h->doc_count; ++doc) {
+                Match candidate = match(doc);
+                if (containsIgnoreCase(candidate.text, pattern)) {
+                    matches.push_back(candidate);
+                }
+            }
+            return matches;
+        }
+
+        // Posting lists of the pattern's trigrams, shortest first
+        const TrigramEntry* table = reinterpret_cast<const TrigramEntry*>(image_.data() + h->trigrams_offset);
+        const TrigramEntry* table_end = table + h->trigram_count;
+        const std::uint64_t values = (h->strings_offset - h->postings_offset) / sizeof(std::uint32_t);
+        const std::uint32_t* postings = reinterpret_cast<const std::uint32_t*>(image_.data() + h->postings_offset);
+        std::vector<const TrigramEntry*> lists;
+        for (std::uint32_t trigram : trigrams) {
+            const TrigramEntry* it = std::lower_bound(table, table_end, trigram, [](const TrigramEntry& entry, std::uint32_t value) {
+                return entry.trigram < value;
+            });
+            if (it == table_end || it->trigram != trigram || std::uint64_t(it->postings) + it->doc_count > values) {
+                return matches;  // No document has this trigram
+            }
+            lists.push_back(it);
+        }
+        std::sort(lists.begin(), lists.end(), [](const TrigramEntry* a, const TrigramEntry* b) {
+            return a->doc_count < b->doc_count;
+        });
+
+        // Intersect, narrowing the shortest list by each longer one
+        std::vector<std::uint32_t> candidates(postings + lists[0]->postings,
+            postings + lists[0]->postings + lists[0]->doc_count);
+        for (std::size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+            const std::uint32_t* begin = postings + lists[l]->postings;
+            const std::uint32_t* end = begin + lists[l]->doc_count;
+            std::size_t kept = 0;
+            for (std::uint32_t doc : candidates) {
+                begin = std::lower_bound(begin, end, doc);
+                if (begin == end) {
+                    break;
+                }
+                if (*begin == doc) {
+                    candidates[kept++] = doc;
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        // Holding every trigram does not make it a substring; check
+        for (std::uint32_t doc : candidates) {
+            if (doc >= h->doc_count) {
+                continue;
+            }
+            Match candidate = match(doc);
+            if (containsIgnoreCase(candidate.text, pattern)) {
+                matches.push_back(candidate);
+            }
+        }
+        return matches;
+    }
+
+    void TrigramIndex::Builder::add(std::string_view id, std::string_view text) {
+        const std::uint32_t doc = static_cast<std::uint32_t>(ids_.size());
+        ids_.emplace_back(id);
+        texts_.emplace_back(text);
+        trigramsOf(text, scratch_);
+        for (std::uint32_t trigram : scratch_) {
+            postings_[trigram].push_back(doc);
+        }
+    }
+
+    std::string TrigramIndex::Builder::finish(const FileStamp& source) const {
+        std::vector<std::uint32_t> trigrams;
+        trigrams.reserve(postings_.size());
+        for (const auto& entry : postings_) {
+            trigrams.push_back(entry.first);
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+
+        std::string strings;
+        std::vector<DocEntry> doc_entries;
+        doc_entries.reserve(ids_.size());
+        for (std::size_t doc = 0; doc < ids_.size(); ++doc) {
+            DocEntry entry;
+            entry.id_offset = static_cast<std::uint32_t>(strings.size());
+            entry.id_length = static_cast<std::uint32_t>(ids_[doc].size());
+            strings += ids_[doc];
+            entry.text_offset = static_cast<std::uint32_t>(strings.size());
+            entry.text_length = static_cast<std::uint32_t>(texts_[doc].size());
+            strings += texts_[doc];
+            doc_entries.push_back(entry);
+        }
+
+        std::vector<TrigramEntry> trigram_entries;
+        trigram_entries.reserve(trigrams.size());
+        std::vector<std::uint32_t> values;
+        for (std::uint32_t trigram : trigrams) {
+            const std::vector<std::uint32_t>& docs = postings_.at(trigram);
+            trigram_entries.push_back({ trigram, static_cast<std::uint32_t>(docs.size()),
+                static_cast<std::uint32_t>(values.size()), 0 });
+            values.insert(values.end(), docs.begin(), docs.end());
+        }
+
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.source_size = source.size;
+        header.source_mtime = source.mtime;
+        header.doc_count = static_cast<std::uint32_t>(doc_entries.size());
+        header.trigram_count = static_cast<std::uint32_t>(trigram_entries.size());
+        header.docs_offset = align8(sizeof(Header));
+        header.trigrams_offset = align8(header.docs_offset + doc_entries.size() * sizeof(DocEntry));
+        header.postings_offset = align8(header.trigrams_offset + trigram_entries.size() * sizeof(TrigramEntry));
+        header.strings_offset = header.postings_offset + values.size() * sizeof(std::uint32_t);
+        header.strings_size = strings.size();
+
+        std::string bytes(header.strings_offset + strings.size(), '\0');
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + header.docs_offset, doc_entries.data(), doc_entries.size() * sizeof(DocEntry));
+        std::memcpy(bytes.data() + header.trigrams_offset, trigram_entries.data(), trigram_entries.size() * sizeof(TrigramEntry));
+        std::memcpy(bytes.data() + header.postings_offset, values.data(), values.size() * sizeof(std::uint32_t));
+        std::memcpy(bytes.data() + header.strings_offset, strings.data(), strings.size());
+        return bytes;
+    }
+
+    bool TrigramIndex::Builder::save(const std::string& path, const std::string& bytes) {
+        if (!replaceFile(path, bytes)) {
+            std::cerr << "Warning: Could not write trigram index " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,113 @@
+#ifndef TRAVEL_PLANNER_TRIGRAM_INDEX_H
+#define TRAVEL_PLANNER_TRIGRAM_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    /**
+     * Substring index over short texts (itinerary names): every
+     * three-byte sequence of a lowercased text maps to the documents
+     * containing it. A pattern's candidates are the documents holding all
+     * of its trigrams; one case-insensitive substring check against the
+     * stored text then drops the false positives. Patterns shorter than
+     * three bytes check every stored text instead.
+     *
+     * Persisted as one file, memory-mapped when searched and tagged with the
+     * stamp of the store it indexes. Texts are stored alongside their IDs,
+     * so a search reads no records. The file is written in native byte
+     * order.
+     */
+    class TrigramIndex {
+    public:
+        /**
+         * Document whose text contains the pattern; the views are valid
+         * while the index is open
+         */
+        struct Match {
+            std::string_view id;
+            std::string_view text;
+        };
+
+        class Builder;
+
+        /**
+         * Maps an index file
+         * @param path Index file
+         * @param source Current stamp of the indexed store
+         * @return False if the file is missing, unreadable or was built from
+         *         another version of the store
+         */
+        bool open(const std::string& path, const FileStamp& source);
+
+        /**
+         * Uses an index built in memory (see Builder::finish())
+         */
+        void assign(std::string bytes);
+
+        /**
+         * Finds the documents whose text contains a pattern, ignoring ASCII case
+         * @return Matches in the order the documents were added
+         */
+        std::vector<Match> search(std::string_view pattern) const;
+
+        /**
+         * @return Number of indexed documents
+         */
+        std::size_t size() const;
+
+    private:
+        struct Header;
+        struct DocEntry;
+        struct TrigramEntry;
+
+        bool validate() const;
+        const Header* header() const;
+        const DocEntry* docs() const;
+        std::string_view text(std::uint32_t offset, std::uint32_t length) const;
+        Match match(std::uint32_t doc) const;
+
+        IndexImage image_;
+    };
+
+    /**
+     * Collects documents and encodes them into a TrigramIndex
+     */
+    class TrigramIndex::Builder {
+    public:
+        /**
+         * Adds a document
+         * @param id Document ID
+         * @param text Text to search, such as the name
+         */
+        void add(std::string_view id, std::string_view text);
+
+        /**
+         * Encodes the index
+         * @param source Stamp of the store the documents came from
+         * @return Index contents, for TrigramIndex::assign() or save()
+         */
+        std::string finish(const FileStamp& source) const;
+
+        /**
+         * Writes encoded index contents to a file
+         * @return True on success
+         */
+        static bool save(const std::string& path, const std::string& bytes);
+
+    private:
+        std::vector<std::string> ids_;
+        std::vector<std::string> texts_;
+        std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings_;  // Trigram -> documents
+        std::vector<std::uint32_t> scratch_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_TRIGRAM_INDEX_H
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Bitmap.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        std::vector<std::uint32_t> values(const Bitmap& bitmap) {
+            std::vector<std::uint32_t> result;
+            bitmap.forEach([&result](std::uint32_t value) { result.push_back(value); });
+            return result;
+        }
+
+        std::vector<std::uint32_t> values(const std::set<std::uint32_t>& set) {
+            return std::vector<std::uint32_t>(set.begin(), set.end());
+        }
+
+        // Sparse, mixed or dense sets, so array and bitmap containers and
+        // the conversions between them are all exercised
+        void fill(std::mt19937& random, Bitmap& bitmap, std::set<std::uint32_t>& expected) {
+            const std::uint32_t sizes[] = { 100, 10000, 80000 };
+            const std::uint32_t count = random() % sizes[random() % 3];
+            const std::uint32_t span = random() % 2 ? 200000 : 70000;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                const std::uint32_t value = random() % span;
+                bitmap.add(value);
+                expected.insert(value);
+            }
+        }
+
+    } // namespace
+
+    TEST(BitmapTest, AddRemoveContains) {
+        Bitmap bitmap;
+        EXPECT_TRUE(bitmap.empty());
+        bitmap.add(3);
+        bitmap.add(70000);
+        bitmap.add(3);
+        EXPECT_EQ(bitmap.cardinality(), 2u);
+        EXPECT_TRUE(bitmap.contains(3));
+        EXPECT_TRUE(bitmap.contains(70000));
+        EXPECT_FALSE(bitmap.contains(4));
+        EXPECT_TRUE(bitmap.remove(3));
+        EXPECT_FALSE(bitmap.remove(3));
+        EXPECT_EQ(values(bitmap), std::vector<std::uint32_t>{ 70000 });
+        EXPECT_TRUE(bitmap.remove(70000));
+        EXPECT_TRUE(bitmap.empty());
+    }
+
+    TEST(BitmapTest, Range) {
+        for (std::uint32_t count : { 0u, 1u, 4096u, 4097u, 65536u, 65537u, 200000u }) {
+            const Bitmap range = Bitmap::range(count);
+            EXPECT_EQ(range.cardinality(), count);
+            EXPECT_FALSE(range.contains(count));
+            if (count > 0) {
+                EXPECT_TRUE(range.contains(count - 1));
+            }
+        }
+    }
+
+    TEST(BitmapTest, SetOperationsMatchStdSet) {
+        std::mt19937 random(7);
+        for (int round = 0; round < 25; ++round) {
+            Bitmap a;
+            Bitmap b;
+            std::set<std::uint32_t> expected_a;
+            std::set<std::uint32_t> expected_b;
+            fill(random, a, expected_a);
+            fill(random, b, expected_b);
+            for (int i = 0; i < 2000; ++i) {
+                const std::uint32_t value = random() % 200000;
+                EXPECT_EQ(a.remove(value), expected_a.erase(value) == 1);
+            }
+            ASSERT_EQ(values(a), values(expected_a));
+            ASSERT_EQ(a.cardinality(), expected_a.size());
+
+            std::set<std::uint32_t> expected;
+            Bitmap result = a;
+            result &= b;
+            std::set_intersection(expected_a.begin(), expected_a.end(), expected_b.begin(), expected_b.end(),
+                std::inserter(expected, expected.end()));
+            ASSERT_EQ(values(result), values(expected));
+            ASSERT_EQ(result.cardinality(), expected.size());
+
+            expected.clear();
+            result = a;
+            result |= b;
+            std::set_union(expected_a.begin(), expected_a.end(), expected_b.begin(), expected_b.end(),
+                std::inserter(expected, expected.end()));
+            ASSERT_EQ(values(result), values(expected));
+            ASSERT_EQ(result.cardinality(), expected.size());
+
+            expected.clear();
+            result = a;
+            result.andNot(b);
+            std::set_difference(expected_a.begin(), expected_a.end(), expected_b.begin(), expected_b.end(),
+                std::inserter(expected, expected.end()));
+            ASSERT_EQ(values(result), values(expected));
+            ASSERT_EQ(result.cardinality(), expected.size());
+        }
+    }
+
+    TEST(BitmapTest, OperationsWithItself) {
+        Bitmap bitmap = Bitmap::range(5000);
+        bitmap |= bitmap;
+        EXPECT_EQ(bitmap.cardinality(), 5000u);
+        bitmap &= bitmap;
+        EXPECT_EQ(bitmap.cardinality(), 5000u);
+        bitmap.andNot(bitmap);
+        EXPECT_TRUE(bitmap.empty());
+    }
+
+    TEST(BitmapTest, SerializeRoundTrip) {
+        Bitmap bitmap;
+        for (std::uint32_t value = 0; value < 300000; value += 7) {
+            bitmap.add(value);
+        }
+        bitmap.add(1u << 31);
+
+        std::string bytes;
+        bitmap.serialize(bytes);
+        bytes += "next";
+        std::string_view in(bytes);
+        Bitmap copy;
+        ASSERT_TRUE(copy.deserialize(in));
+        EXPECT_EQ(in, "next");
+        EXPECT_EQ(values(copy), values(bitmap));
+
+        std::string_view truncated = std::string_view(bytes).substr(0, bytes.size() / 2);
+        EXPECT_FALSE(Bitmap().deserialize(truncated));
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,122 @@
+#ifndef _WIN32
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "TestSupport.h"
+#include "CommandServer.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        // Sends raw bytes to a socket and hangs up
+        void sendRaw(const std::string& socket_path, const std::string& bytes) {
+            int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            ASSERT_GE(fd, 0);
+            sockaddr_un address;
+            std::memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+            ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+            ASSERT_EQ(::write(fd, bytes.data(), bytes.size()), static_cast<ssize_t>(bytes.size()));
+            ::close(fd);
+        }
+
+        std::string u32(std::uint32_t value) {
+            return std::string(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+
+        // Runs a server in a child process; its commands print their
+        // argument count and exit with it
+        pid_t startServer(const std::string& socket_path) {
+            pid_t pid = ::fork();
+            if (pid == 0) {
+                {
+                    CommandServer server(socket_path);
+                    if (server.listen()) {
+                        server.run([](int argc, char*[]) {
+                            std::cout << "args " << argc << std::endl;
+                            return argc;
+                        });
+                    }
+                }
+                ::_exit(0);  // Skips the test runner's own exit handling
+            }
+            for (int i = 0; i < 200 && ::access(socket_path.c_str(), F_OK) != 0; ++i) {
+                ::usleep(10000);
+            }
+            return pid;
+        }
+
+        // Forwards a command, capturing what it printed
+        bool forward(const std::string& socket_path, std::vector<std::string> args, int& exit_code,
+            std::string& output) {
+            std::vector<char*> argv;
+            for (auto& arg : args) {
+                argv.push_back(&arg[0]);
+            }
+            std::ostringstream out;
+            std::streambuf* saved = std::cout.rdbuf(out.rdbuf());
+            bool forwarded = forwardCommand(socket_path, static_cast<int>(argv.size()), argv.data(), exit_code);
+            std::cout.rdbuf(saved);
+            output = out.str();
+            return forwarded;
+        }
+
+    } // namespace
+
+    TEST(CommandServerTest, OversizedRequestsAreDroppedAndServingGoesOn) {
+        ScratchDirectory directory;
+        const std::string socket_path = directory.file("server.sock");
+        pid_t server = startServer(socket_path);
+        ASSERT_GT(server, 0);
+
+        // Counts and lengths far past the limits, with nothing behind them
+        sendRaw(socket_path, u32(0x7fffffff));
+        sendRaw(socket_path, u32(1) + u32(0x7fffffff));
+        sendRaw(socket_path, u32(1) + u32(1) + "x" + u32(0x7fffffff));
+        sendRaw(socket_path, u32(1) + u32(1) + "x" + u32(0) + u32(0xffffffff));
+        sendRaw(socket_path, "");
+
+        int exit_code = -1;
+        std::string output;
+        ASSERT_TRUE(forward(socket_path, { "travel_planner", "list", "now" }, exit_code, output));
+        EXPECT_EQ(exit_code, 3);
+        EXPECT_EQ(output, "args 3\n");
+
+        ASSERT_TRUE(forward(socket_path, { "travel_planner", "serve", "stop" }, exit_code, output));
+        EXPECT_EQ(exit_code, 0);
+        int status = 0;
+        ASSERT_EQ(::waitpid(server, &status, 0), server);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+        EXPECT_FALSE(std::filesystem::exists(socket_path));
+    }
+
+    TEST(CommandServerTest, TooLargeCommandRunsLocally) {
+        ScratchDirectory directory;
+        const std::string socket_path = directory.file("server.sock");
+        pid_t server = startServer(socket_path);
+        ASSERT_GT(server, 0);
+
+        int exit_code = -1;
+        std::string output;
+        EXPECT_FALSE(forward(socket_path, { "travel_planner", std::string((1 << 20) + 1, 'x') }, exit_code, output));
+
+        ASSERT_TRUE(forward(socket_path, { "travel_planner", "serve", "stop" }, exit_code, output));
+        ::waitpid(server, nullptr, 0);
+    }
+
+} // namespace travel_planner
+
+#endif
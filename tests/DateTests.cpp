@@ -0,0 +1,56 @@
+#include <string>
+#include <gtest/gtest.h>
+#include "Date.h"
+
+namespace travel_planner {
+
+    TEST(DateTest, ParsesValidDays) {
+        EXPECT_EQ(Date::parse("1970-01-01"), Date(0));
+        EXPECT_EQ(Date::parse("1969-12-31"), Date(-1));
+        EXPECT_EQ(Date::parse("2024-02-29"), Date::fromCivil(2024, 2, 29));
+        EXPECT_EQ(Date::parse("2000-02-29"), Date::fromCivil(2000, 2, 29));
+        EXPECT_EQ(Date::parse("0000-03-01")->toString(), "0000-03-01");
+        EXPECT_EQ(Date::parse("9999-12-31")->toString(), "9999-12-31");
+    }
+
+    TEST(DateTest, ParseRejectsOtherForms) {
+        for (const char* text : {
+            "", "2024-01", "2024-1-01", "2024-01-1", "24-01-01", "2024-01-011", " 2024-01-01", "2024-01-01 ",
+            "2024/01/01", "2024-01/01", "20240-1-01", "-024-01-01", "+024-01-01", "2024-0a-01", "2024-01-0x",
+            "2024-01--1",
+        }) {
+            EXPECT_FALSE(Date::parse(text).has_value()) << '"' << text << '"';
+        }
+    }
+
+    TEST(DateTest, ParseRejectsDaysThatDoNotExist) {
+        for (const char* text : {
+            "2024-00-10", "2024-13-01", "2024-01-00", "2024-01-32", "2024-04-31", "2024-06-31",
+            "2023-02-29", "1900-02-29", "2100-02-29", "2024-02-30", "2024-99-99",
+        }) {
+            EXPECT_FALSE(Date::parse(text).has_value()) << '"' << text << '"';
+        }
+    }
+
+    TEST(DateTest, EveryDayRoundTrips) {
+        // Consecutive days across leap years and the 1900, 2000 and 2100
+        // century rules, checked against a plain calendar walk
+        int year = 1899;
+        unsigned month = 1;
+        unsigned day = 1;
+        for (Date date = Date::fromCivil(1899, 1, 1); date <= Date::fromCivil(2101, 12, 31);
+            date = Date(date.days() + 1)) {
+            const std::string text = date.toString();
+            ASSERT_EQ(Date::parse(text), date) << text;
+            ASSERT_EQ(Date::fromCivil(year, month, day), date) << text;
+            if (++day > Date::daysInMonth(year, month)) {
+                day = 1;
+                if (++month > 12) {
+                    month = 1;
+                    ++year;
+                }
+            }
+        }
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "ExpenseManager.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        // "id:amount" of each expense, sorted, so stores can be compared
+        // whatever order their shards and journals yield them in
+        std::vector<std::string> contents(const std::vector<Expense>& expenses) {
+            std::vector<std::string> result;
+            for (const auto& expense : expenses) {
+                result.push_back(expense.id + ":" + std::to_string(expense.amount));
+            }
+            std::sort(result.begin(), result.end());
+            return result;
+        }
+
+        // The same, through the streaming path
+        std::vector<std::string> scanned(ExpenseManager& manager, const std::string& itinerary_id) {
+            std::vector<Expense> expenses;
+            manager.forEachExpense(itinerary_id, [&expenses](const ExpenseView& view) {
+                expenses.push_back(view.toExpense());
+            });
+            return contents(expenses);
+        }
+
+        bool exists(const std::string& path) {
+            return std::filesystem::exists(path);
+        }
+
+    } // namespace
+
+    TEST(ExpenseManagerTest, SummaryTotalsEachCategory) {
+        ScratchDirectory directory;
+        ExpenseManager manager(directory.file("expenses.json"));
+        ASSERT_TRUE(manager.addExpense("trip", 12.50, "Food", "2024-05-01", "Lunch"));
+        ASSERT_TRUE(manager.addExpense("trip", 7.25, "Food", "2024-05-02", "Dinner"));
+        ASSERT_TRUE(manager.addExpense("trip", 300.00, "Lodging", "2024-05-01", "Hotel"));
+        ASSERT_TRUE(manager.addExpense("other", 99.00, "Food", "2024-05-01", "Not this trip"));
+
+        const std::map<std::string, double> expected = { { "Food", 19.75 }, { "Lodging", 300.00 } };
+        EXPECT_EQ(manager.summary("trip"), expected);
+        // Again, now read off the rollup written by the first summary
+        EXPECT_EQ(manager.summary("trip"), expected);
+        EXPECT_EQ(ExpenseManager(directory.file("expenses.json")).summary("trip"), expected);
+    }
+
+    TEST(ExpenseManagerTest, SummaryOfUnknownItineraryIsEmpty) {
+        ScratchDirectory directory;
+        ExpenseManager manager(directory.file("expenses.json"));
+        EXPECT_TRUE(manager.summary("missing").empty());
+    }
+
+    TEST(ExpenseManagerTest, DateRangeListsOverlappingExpensesByDate) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        // One expense a day through May, stored out of date order
+        std::vector<Expense> expenses;
+        for (int day = 31; day >= 1; --day) {
+            const std::string date = Date::fromCivil(2024, 5, static_cast<unsigned>(day)).toString();
+            expenses.emplace_back("e" + std::to_string(day), "trip", 1.0, "Food", date, "");
+        }
+        expenses.emplace_back("other", "elsewhere", 1.0, "Food", "2024-05-10", "");
+        ASSERT_TRUE(ExpenseManager(store).saveAll(expenses));
+
+        auto ids = [](const std::vector<Expense>& listed) {
+            std::vector<std::string> result;
+            for (const auto& expense : listed) {
+                result.push_back(expense.id);
+            }
+            return result;
+        };
+        auto day = [](unsigned d) { return Date::fromCivil(2024, 5, d); };
+
+        ExpenseManager manager(store);
+        // Both ends are included; a narrow range reads through the ID
+        // index, a wide one scans the shard
+        EXPECT_EQ(ids(manager.listExpenses("trip", day(10), day(12))),
+            (std::vector<std::string>{ "e10", "e11", "e12" }));
+        EXPECT_EQ(ids(manager.listExpenses("trip", day(10), day(10))), std::vector<std::string>{ "e10" });
+        EXPECT_EQ(manager.listExpenses("trip", day(2), day(30)).size(), 29u);
+        EXPECT_EQ(ids(manager.listExpenses("trip", Date::earliest(), day(2))),
+            (std::vector<std::string>{ "e1", "e2" }));
+        EXPECT_EQ(ids(manager.listExpenses("trip", day(31), Date::latest())), std::vector<std::string>{ "e31" });
+        EXPECT_TRUE(manager.listExpenses("trip", day(12), day(10)).empty());
+        EXPECT_TRUE(manager.listExpenses("trip", Date::fromCivil(2024, 6, 1), Date::latest()).empty());
+        EXPECT_TRUE(manager.listExpenses("missing", Date::earliest(), Date::latest()).empty());
+
+        // Journaled changes show up in the index
+        ASSERT_TRUE(manager.removeExpense("e11"));
+        ASSERT_TRUE(manager.addExpense("trip", 2.0, "Food", "2024-06-01", ""));
+        EXPECT_EQ(ids(manager.listExpenses("trip", day(10), day(12))), (std::vector<std::string>{ "e10", "e12" }));
+        EXPECT_EQ(manager.listExpenses("trip", Date::fromCivil(2024, 6, 1), Date::latest()).size(), 1u);
+        EXPECT_EQ(ExpenseManager(store).listExpenses("trip", day(1), Date::latest()).size(), 31u);
+    }
+
+    TEST(ExpenseManagerTest, JournalKeepsAddsAndRemovesAcrossReopen) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        const std::string shard = directory.file("expenses/trip.json");
+        std::vector<std::string> expected;
+        {
+            ExpenseManager manager(store);
+            ASSERT_TRUE(manager.addExpense("trip", 10.0, "Food", "2024-05-01", "Lunch"));
+            ASSERT_TRUE(manager.addExpense("trip", 20.0, "Food", "2024-05-02", "Dinner"));
+            ASSERT_TRUE(manager.addExpense("trip", 30.0, "Lodging", "2024-05-02", "Hotel"));
+            std::vector<Expense> expenses = manager.listExpenses("trip");
+            ASSERT_EQ(expenses.size(), 3u);
+            EXPECT_TRUE(exists(shard + ".journal"));
+            EXPECT_TRUE(ExpenseManager(store, false).loadAll().empty());  // Snapshot untouched
+
+            ASSERT_TRUE(manager.removeExpense(expenses[1].id));
+            EXPECT_FALSE(manager.removeExpense(expenses[1].id));
+            expenses.erase(expenses.begin() + 1);
+            expected = contents(expenses);
+            EXPECT_EQ(contents(manager.listExpenses("trip")), expected);
+            EXPECT_EQ(scanned(manager, "trip"), expected);
+        }
+        ExpenseManager reopened(store);
+        EXPECT_EQ(contents(reopened.loadAll()), expected);
+        EXPECT_EQ(scanned(reopened, "trip"), expected);
+    }
+
+    TEST(ExpenseManagerTest, JournalRemovesSnapshotRows) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        ExpenseManager manager(store);
+        ASSERT_TRUE(manager.saveAll({
+            Expense("e1", "trip", 1.0, "Food", "2024-05-01", ""),
+            Expense("e2", "trip", 2.0, "Food", "2024-05-01", ""),
+            Expense("e3", "other", 3.0, "Food", "2024-05-01", "") }));
+        ASSERT_TRUE(manager.removeExpense("e2"));
+        ASSERT_TRUE(manager.addExpense("trip", 4.0, "Food", "2024-05-03", ""));
+
+        const std::vector<Expense> expenses = manager.listExpenses("trip");
+        ASSERT_EQ(expenses.size(), 2u);
+        EXPECT_EQ(expenses[0].id, "e1");  // Snapshot rows first, then journaled adds
+        EXPECT_EQ(expenses[1].amount, 4.0);
+        EXPECT_EQ(scanned(manager, "trip"), contents(expenses));
+        EXPECT_EQ(contents(ExpenseManager(store).listExpenses("other")), std::vector<std::string>{ "e3:3.000000" });
+    }
+
+    TEST(ExpenseManagerTest, CompactFoldsJournalIntoSnapshot) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        const std::string shard = directory.file("expenses/trip.json");
+        ExpenseManager manager(store);
+        ASSERT_TRUE(manager.saveAll({ Expense("e1", "trip", 1.0, "Food", "2024-05-01", "") }));
+        ASSERT_TRUE(manager.addExpense("trip", 2.0, "Food", "2024-05-02", ""));
+        ASSERT_TRUE(manager.removeExpense("e1"));
+        const std::vector<std::string> expected = contents(manager.loadAll());
+        ASSERT_EQ(expected.size(), 1u);
+
+        ASSERT_TRUE(manager.compact());
+        EXPECT_FALSE(exists(shard + ".journal"));
+        EXPECT_EQ(contents(manager.loadAll()), expected);
+        // With the journal gone the snapshot alone holds the result
+        EXPECT_EQ(contents(ExpenseManager(store, false).loadAll()), expected);
+    }
+
+    TEST(ExpenseManagerTest, JournalPastThresholdIsCompacted) {
+        ScratchDirectory directory;
+        const std::string shard = directory.file("expenses/trip.json");
+        ExpenseManager manager(directory.file("expenses.json"));
+        manager.setCompactionThreshold(1);
+        ASSERT_TRUE(manager.addExpense("trip", 5.0, "Food", "2024-05-01", ""));
+        EXPECT_FALSE(exists(shard + ".journal"));
+        EXPECT_EQ(ExpenseManager(directory.file("expenses.json"), false).loadAll().size(), 1u);
+    }
+
+    TEST(ExpenseManagerTest, JournalOverUnreadableSnapshotIsNotCompacted) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        const std::string shard = directory.file("expenses/trip.json");
+        ASSERT_TRUE(ExpenseManager(store).saveAll({ Expense("e1", "trip", 1.0, "Food", "2024-05-01", "") }));
+        std::ofstream(shard, std::ios::binary | std::ios::trunc) << R"([{"id":"e1","amount":)";
+
+        ExpenseManager manager(store);
+        manager.setCompactionThreshold(1);
+        ASSERT_TRUE(manager.addExpense("trip", 5.0, "Food", "2024-05-02", ""));
+        ASSERT_TRUE(manager.addExpense("trip", 6.0, "Food", "2024-05-03", ""));
+        EXPECT_FALSE(manager.compact());
+
+        // Both adds wait in the journal; once the snapshot is repaired they
+        // are compacted into it
+        std::ifstream in(shard, std::ios::binary);
+        EXPECT_EQ(std::string(std::istreambuf_iterator<char>(in), {}), R"([{"id":"e1","amount":)");
+        in.close();
+        std::ofstream(shard, std::ios::binary | std::ios::trunc) << "[]";
+        EXPECT_EQ(manager.listExpenses("trip").size(), 2u);
+        EXPECT_TRUE(manager.compact());
+        EXPECT_FALSE(exists(shard + ".journal"));
+        EXPECT_EQ(ExpenseManager(store, false).listExpenses("trip").size(), 2u);
+    }
+
+    TEST(ExpenseManagerTest, UnreadableColumnarSnapshotIsNotCompactedOver) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.col");
+        const std::string shard = directory.file("expenses/trip.col");
+        ASSERT_TRUE(ExpenseManager(store).saveAll({ Expense("e1", "trip", 1.0, "Food", "2024-05-01", "") }));
+        std::ofstream(shard, std::ios::binary | std::ios::trunc) << "not a columnar file";
+
+        ExpenseManager manager(store);
+        manager.setCompactionThreshold(1);
+        ASSERT_TRUE(manager.addExpense("trip", 5.0, "Food", "2024-05-02", ""));
+        EXPECT_FALSE(manager.compact());
+
+        // Neither the compaction after the add nor compact() replaced the
+        // snapshot, and the add is still in the journal
+        std::ifstream in(shard, std::ios::binary);
+        EXPECT_EQ(std::string(std::istreambuf_iterator<char>(in), {}), "not a columnar file");
+        EXPECT_TRUE(exists(shard + ".journal"));
+    }
+
+    TEST(ExpenseManagerTest, JournalLeftByInterruptedCompactionReplaysHarmlessly) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        const std::string shard = directory.file("expenses/trip.json");
+        {
+            ExpenseManager manager(store);
+            ASSERT_TRUE(manager.saveAll({ Expense("e1", "trip", 1.0, "Food", "2024-05-01", "") }));
+        }
+        // The snapshot was written but the journal that produced it was not
+        // removed; its add of e1 must not duplicate or replace the row
+        {
+            std::ofstream journal(shard + ".journal");
+            journal << R"({"expense":{"amount":9.0,"category":"Food","date":"2024-05-01","description":"",)"
+                       R"("id":"e1","itinerary_id":"trip"},"op":"add"})" << "\n";
+            journal << R"({"expense":{"amount":2.0,"category":"Food","date":"2024-05-02","description":"",)"
+                       R"("id":"e2","itinerary_id":"trip"},"op":"add"})" << "\n";
+        }
+        ExpenseManager manager(store);
+        const std::vector<std::string> expected = { "e1:1.000000", "e2:2.000000" };
+        EXPECT_EQ(contents(manager.listExpenses("trip")), expected);
+        EXPECT_EQ(scanned(manager, "trip"), expected);
+        ASSERT_TRUE(manager.compact());
+        EXPECT_EQ(contents(ExpenseManager(store, false).loadAll()), expected);
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "FuzzyIndex.h"
+#include "SearchIndex.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        std::string lower(std::string_view text) {
+            std::string result(text);
+            for (char& c : result) {
+                if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>(c + ('a' - 'A'));
+                }
+            }
+            return result;
+        }
+
+        // Textbook full-matrix Levenshtein distance
+        std::size_t referenceDistance(std::string_view a, std::string_view b) {
+            std::vector<std::vector<std::size_t>> d(a.size() + 1, std::vector<std::size_t>(b.size() + 1));
+            for (std::size_t i = 0; i <= a.size(); ++i) {
+                d[i][0] = i;
+            }
+            for (std::size_t j = 0; j <= b.size(); ++j) {
+                d[0][j] = j;
+            }
+            for (std::size_t i = 1; i <= a.size(); ++i) {
+                for (std::size_t j = 1; j <= b.size(); ++j) {
+                    d[i][j] = std::min({ d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (a[i - 1] != b[j - 1]) });
+                }
+            }
+            return d[a.size()][b.size()];
+        }
+
+        struct Document {
+            std::string id;
+            std::string name;
+            std::vector<std::string> tags;
+
+            // The terms the index defines for it: the whole name, its words
+            // and the tags, lowercased
+            std::vector<std::string> terms() const {
+                std::vector<std::string> result = searchTerms(name);
+                result.push_back(lower(name));
+                for (const auto& tag : tags) {
+                    result.push_back(lower(tag));
+                }
+                return result;
+            }
+        };
+
+        // "id:distance" of every document with a term within max_distance
+        // of the query, closest first, found by comparing every term.
+        // editDistance() itself is checked against referenceDistance().
+        std::vector<std::string> bruteForce(const std::vector<Document>& documents,
+            const std::vector<std::vector<std::string>>& terms, std::string_view query, std::uint32_t max_distance) {
+            const std::string lowered = lower(query);
+            std::vector<std::pair<std::size_t, std::size_t>> hits;  // Distance, document
+            for (std::size_t doc = 0; doc < documents.size(); ++doc) {
+                std::size_t best = max_distance + 1;
+                for (const auto& term : terms[doc]) {
+                    if (!term.empty()) {
+                        best = std::min(best, editDistance(lowered, term));
+                    }
+                }
+                if (best <= max_distance) {
+                    hits.emplace_back(best, doc);
+                }
+            }
+            std::sort(hits.begin(), hits.end());
+            std::vector<std::string> result;
+            for (const auto& [distance, doc] : hits) {
+                result.push_back(documents[doc].id + ":" + std::to_string(distance));
+            }
+            return result;
+        }
+
+        std::vector<std::string> search(const FuzzyIndex& index, std::string_view query, std::uint32_t max_distance,
+            std::size_t* compared = nullptr) {
+            std::vector<std::string> result;
+            for (const auto& match : index.search(query, max_distance, compared)) {
+                result.push_back(std::string(match.id) + ":" + std::to_string(match.distance));
+            }
+            return result;
+        }
+
+        std::string randomWord(std::mt19937& random, std::size_t min_size, std::size_t max_size) {
+            const char alphabet[] = "abcdeABE";
+            std::string word;
+            const std::size_t size = min_size + random() % (max_size - min_size + 1);
+            for (std::size_t i = 0; i < size; ++i) {
+                word += alphabet[random() % (sizeof(alphabet) - 1)];
+            }
+            return word;
+        }
+
+    } // namespace
+
+    TEST(FuzzyIndexTest, EditDistanceMatchesReference) {
+        EXPECT_EQ(editDistance("", ""), 0u);
+        EXPECT_EQ(editDistance("kitten", "sitting"), 3u);
+        EXPECT_EQ(editDistance("", "abc"), 3u);
+        EXPECT_EQ(editDistance("flaw", "lawn"), 2u);
+        std::mt19937 random(17);
+        for (int round = 0; round < 2000; ++round) {
+            const std::string a = randomWord(random, 0, 9);
+            const std::string b = randomWord(random, 0, 9);
+            ASSERT_EQ(editDistance(a, b), referenceDistance(a, b)) << a << " / " << b;
+        }
+    }
+
+    TEST(FuzzyIndexTest, TreeAgreesWithBruteForce) {
+        std::mt19937 random(23);
+        std::vector<Document> documents;
+        std::vector<std::vector<std::string>> terms;
+        FuzzyIndex::Builder builder;
+        for (std::size_t doc = 0; doc < 200; ++doc) {
+            Document document{ "d" + std::to_string(doc), randomWord(random, 1, 7), {} };
+            if (random() % 2) {
+                document.name += " " + randomWord(random, 1, 7);
+            }
+            for (std::size_t tag = random() % 3; tag > 0; --tag) {
+                document.tags.push_back(randomWord(random, 2, 6));
+            }
+            builder.add(document.id, document.name, document.tags);
+            terms.push_back(document.terms());
+            documents.push_back(std::move(document));
+        }
+        FuzzyIndex index;
+        index.assign(builder.finish({}));
+        ASSERT_GT(index.terms(), 0u);
+
+        std::size_t compared_total = 0;
+        for (int round = 0; round < 150; ++round) {
+            const std::string query = randomWord(random, 1, 8);
+            for (std::uint32_t max_distance : { 0u, 1u, 2u, 3u }) {
+                std::size_t compared = 0;
+                ASSERT_EQ(search(index, query, max_distance, &compared), bruteForce(documents, terms, query, max_distance))
+                    << '"' << query << "\" within " << max_distance;
+                EXPECT_LE(compared, index.terms());
+                if (max_distance == 1) {
+                    compared_total += compared;
+                }
+            }
+        }
+        // The tree prunes: close queries compare a fraction of the terms
+        EXPECT_LT(compared_total, 150 * index.terms() / 2);
+    }
+
+    TEST(FuzzyIndexTest, SavedIndexOpensOnlyForItsStamp) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("store.fuzzy");
+        const FileStamp stamp{ 7, 8 };
+        FuzzyIndex::Builder builder;
+        builder.add("d0", "Barcelona trip", { "beach" });
+        builder.add("d1", "Berlin", {});
+        ASSERT_TRUE(FuzzyIndex::Builder::save(path, builder.finish(stamp)));
+
+        FuzzyIndex index;
+        ASSERT_TRUE(index.open(path, stamp));
+        EXPECT_EQ(search(index, "barcelna", 1), std::vector<std::string>{ "d0:1" });
+        EXPECT_EQ(search(index, "Berln", 2), (std::vector<std::string>{ "d1:1" }));
+        EXPECT_FALSE(FuzzyIndex().open(path, FileStamp{ 8, 8 }));
+        ASSERT_TRUE(replaceFile(path, "not an index"));
+        EXPECT_FALSE(FuzzyIndex().open(path, stamp));
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+#include "Money.h"
+#include "MoneyKernels.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        const MoneyKernel kKernels[] = { MoneyKernel::Auto, MoneyKernel::Scalar, MoneyKernel::Avx2 };
+
+        // Straightforward stats of the amounts whose code matches (every
+        // amount when codes is empty), to check the kernels against
+        MoneyStats reference(const std::vector<std::int64_t>& cents, const std::vector<std::uint32_t>& codes,
+            std::uint32_t code) {
+            MoneyStats stats;
+            for (std::size_t i = 0; i < cents.size(); ++i) {
+                if (codes.empty() || codes[i] == code) {
+                    stats.sum += cents[i];
+                    ++stats.count;
+                    stats.min = std::min(stats.min, cents[i]);
+                    stats.max = std::max(stats.max, cents[i]);
+                }
+            }
+            return stats;
+        }
+
+        void expectStats(const MoneyStats& actual, const MoneyStats& expected) {
+            EXPECT_EQ(actual.sum, expected.sum);
+            EXPECT_EQ(actual.count, expected.count);
+            EXPECT_EQ(actual.min, expected.min);
+            EXPECT_EQ(actual.max, expected.max);
+        }
+
+        // Amounts of up to +-10000.00, a third of them on a half cent. Every
+        // length up to a few vector blocks is tried, so the tails are too.
+        struct Sample {
+            std::vector<double> amounts;
+            std::vector<std::int64_t> cents;
+            std::vector<std::uint32_t> codes;
+        };
+
+        Sample sample(std::mt19937_64& random, std::size_t count, std::uint32_t groups) {
+            Sample s;
+            for (std::size_t i = 0; i < count; ++i) {
+                double amount = static_cast<double>(static_cast<std::int64_t>(random() % 2000001) - 1000000) / 100.0;
+                if (random() % 3 == 0) {
+                    amount += 0.005;
+                }
+                s.amounts.push_back(amount);
+                s.cents.push_back(Money::fromAmount(amount).cents());
+                s.codes.push_back(static_cast<std::uint32_t>(random() % groups));
+            }
+            return s;
+        }
+
+    } // namespace
+
+    TEST(MoneyKernelsTest, AmountsToCentsMatchesMoney) {
+        std::mt19937_64 random(7);
+        for (MoneyKernel kernel : kKernels) {
+            if (!moneyKernelAvailable(kernel)) {
+                continue;
+            }
+            for (std::size_t count = 0; count <= 40; ++count) {
+                Sample s = sample(random, count, 1);
+                std::vector<std::int64_t> cents(count, -1);
+                amountsToCents(s.amounts.data(), count, cents.data(), kernel);
+                EXPECT_EQ(cents, s.cents) << "kernel " << static_cast<int>(kernel) << ", count " << count;
+            }
+        }
+    }
+
+    TEST(MoneyKernelsTest, StatsAgreeWithReference) {
+        std::mt19937_64 random(11);
+        for (MoneyKernel kernel : kKernels) {
+            if (!moneyKernelAvailable(kernel)) {
+                continue;
+            }
+            for (std::size_t count = 0; count <= 40; ++count) {
+                SCOPED_TRACE(count);
+                Sample s = sample(random, count, 3);
+                expectStats(moneyStats(s.cents.data(), count, kernel), reference(s.cents, {}, 0));
+                for (std::uint32_t code = 0; code < 4; ++code) {  // Code 3 matches nothing
+                    expectStats(moneyStatsWhere(s.cents.data(), s.codes.data(), count, code, kernel),
+                        reference(s.cents, s.codes, code));
+                }
+            }
+        }
+    }
+
+    TEST(MoneyKernelsTest, StatsByCodeAgreeForFewAndManyGroups) {
+        std::mt19937_64 random(13);
+        // One and two groups take the filtered vector passes, more the
+        // interleaved scalar pass
+        for (std::uint32_t groups : { 1u, 2u, 5u }) {
+            Sample s = sample(random, 1003, groups);
+            for (MoneyKernel kernel : kKernels) {
+                if (!moneyKernelAvailable(kernel)) {
+                    continue;
+                }
+                std::vector<MoneyStats> stats(groups);
+                moneyStatsByCode(s.cents.data(), s.codes.data(), s.cents.size(), stats, kernel);
+                for (std::uint32_t code = 0; code < groups; ++code) {
+                    SCOPED_TRACE(code);
+                    expectStats(stats[code], reference(s.cents, s.codes, code));
+                }
+            }
+        }
+    }
+
+    TEST(MoneyKernelsTest, ExtremesSurviveVectorLanes) {
+        // Min and max compare 64-bit lanes; values past 2^32 and of both
+        // signs catch a comparison done on the wrong width
+        const std::vector<std::int64_t> cents = {
+            5, -(std::int64_t(1) << 40), 3, (std::int64_t(1) << 40) + 1, -1, 0, 7, 2, 9,
+        };
+        const std::vector<std::uint32_t> codes = { 0, 1, 0, 1, 0, 1, 0, 1, 0 };
+        for (MoneyKernel kernel : kKernels) {
+            if (!moneyKernelAvailable(kernel)) {
+                continue;
+            }
+            expectStats(moneyStats(cents.data(), cents.size(), kernel), reference(cents, {}, 0));
+            expectStats(moneyStatsWhere(cents.data(), codes.data(), cents.size(), 1, kernel),
+                reference(cents, codes, 1));
+        }
+    }
+
+} // namespace travel_planner
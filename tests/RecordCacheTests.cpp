@@ -0,0 +1,84 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "ExpenseManager.h"
+#include "RecordCache.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        // Enters a directory and turns the record cache on, as the server
+        // does for each command; both are undone on destruction
+        class ServedCommand {
+        public:
+            explicit ServedCommand(const std::string& directory)
+                : saved_(std::filesystem::current_path()) {
+                std::filesystem::current_path(directory);
+                setRecordCacheEnabled(true);
+            }
+
+            ~ServedCommand() {
+                setRecordCacheEnabled(false);
+                std::filesystem::current_path(saved_);
+            }
+
+        private:
+            std::filesystem::path saved_;
+        };
+
+        void writeFile(const std::string& path, const std::string& contents) {
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+            std::ofstream(path, std::ios::binary) << contents;
+            // Same size and time in both directories, so only the path tells them apart
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type(std::chrono::hours(1)));
+        }
+
+        std::string expense(const std::string& id, const std::string& description) {
+            return R"({"amount":1.0,"category":"Food","date":"2024-05-01","description":")" + description
+                + R"(","id":")" + id + R"(","itinerary_id":"trip"})";
+        }
+
+        std::vector<std::string> descriptions(const std::vector<Expense>& expenses) {
+            std::vector<std::string> result;
+            for (const auto& e : expenses) {
+                result.push_back(e.description);
+            }
+            return result;
+        }
+
+    } // namespace
+
+    TEST(RecordCacheTest, SameRelativePathInAnotherDirectoryIsNotShared) {
+        ScratchDirectory first;
+        ScratchDirectory second;
+        for (const auto* directory : { &first, &second }) {
+            const std::string tag = directory == &first ? "A" : "B";
+            writeFile(directory->file("data/expenses/trip.json"), "[" + expense("s", "snapshot " + tag) + "]");
+            writeFile(directory->file("data/expenses/trip.json.journal"),
+                R"({"expense":)" + expense("j", "journal " + tag) + R"(,"op":"add"})" + "\n");
+        }
+
+        for (int round = 0; round < 2; ++round) {
+            for (const auto* directory : { &first, &second }) {
+                const std::string tag = directory == &first ? "A" : "B";
+                ServedCommand command(directory->file(""));
+                ExpenseManager manager("data/expenses.json");
+                EXPECT_EQ(descriptions(manager.listExpenses("trip")),
+                    (std::vector<std::string>{ "snapshot " + tag, "journal " + tag }));
+            }
+        }
+    }
+
+    TEST(RecordCacheTest, KeyIsTheCanonicalPath) {
+        ScratchDirectory directory;
+        writeFile(directory.file("store.json"), "[]");
+        EXPECT_EQ(cacheKey(directory.file("sub/../store.json")), cacheKey(directory.file("store.json")));
+        EXPECT_TRUE(std::filesystem::path(cacheKey("relative.json")).is_absolute());
+    }
+
+} // namespace travel_planner
@@ -0,0 +1,270 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "ExpenseManager.h"
+#include "PackingManager.h"
+#include "RecordIndex.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        void writeFile(const std::string& path, const std::string& contents) {
+            std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+            std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+        }
+
+        std::string packingItem(const std::string& id, const std::string& name) {
+            return R"({"id":")" + id + R"(","itinerary_id":"trip","name":")" + name
+                + R"(","packed":false,"quantity":1})";
+        }
+
+        std::string expense(const std::string& id, double amount) {
+            return R"({"amount":)" + std::to_string(amount) + R"(,"category":"Food","date":"2024-05-01",)"
+                R"("description":"","id":")" + id + R"(","itinerary_id":"trip"})";
+        }
+
+        // Where an ID is indexed, as "file@offset", or "" if it is not
+        std::string located(const RecordIndex& index, const std::string& id) {
+            RecordLocation location;
+            if (!index.find(id, location)) {
+                return "";
+            }
+            return std::filesystem::path(location.file).filename().string() + "@" + std::to_string(location.offset);
+        }
+
+    } // namespace
+
+    TEST(RecordIndexTest, LookupFollowsPutsAndErasesAcrossReopen) {
+        ScratchDirectory directory;
+        const std::string shard = directory.file("trip.json");
+        writeFile(shard, "[]");
+        {
+            RecordIndex index(directory.file(".index"));
+            ASSERT_TRUE(index.create(4));
+            // Far past the initial table and heap, so the index grows
+            for (int i = 0; i < 1000; ++i) {
+                ASSERT_TRUE(index.put("id" + std::to_string(i), shard, i * 10, 10));
+            }
+            ASSERT_TRUE(index.put("id5", shard, 9999, 10));  // Moved
+            index.erase("id7");
+            index.erase("missing");
+            index.stampFile(shard);
+            EXPECT_EQ(index.size(), 999u);
+        }
+
+        RecordIndex index(directory.file(".index"));
+        ASSERT_TRUE(index.open());
+        EXPECT_EQ(index.size(), 999u);
+        EXPECT_EQ(located(index, "id0"), "trip.json@0");
+        EXPECT_EQ(located(index, "id5"), "trip.json@9999");
+        EXPECT_EQ(located(index, "id7"), "");
+        EXPECT_EQ(located(index, "id999"), "trip.json@9990");
+        EXPECT_EQ(located(index, "id1000"), "");
+        EXPECT_TRUE(index.matches({ shard }));
+    }
+
+    TEST(RecordIndexTest, DroppingAFileRetiresOnlyItsRecords) {
+        ScratchDirectory directory;
+        RecordIndex index(directory.file(".index"));
+        ASSERT_TRUE(index.create(4));
+        ASSERT_TRUE(index.put("a", directory.file("one.json"), 1, 1));
+        ASSERT_TRUE(index.put("b", directory.file("two.json"), 2, 1));
+        index.dropFile(directory.file("one.json"));
+        EXPECT_EQ(located(index, "a"), "");
+        EXPECT_EQ(located(index, "b"), "two.json@2");
+        EXPECT_EQ(index.size(), 1u);
+
+        // Records put after the drop belong to the new contents
+        ASSERT_TRUE(index.put("a", directory.file("one.json"), 3, 1));
+        EXPECT_EQ(located(index, "a"), "one.json@3");
+    }
+
+    TEST(RecordIndexTest, MatchesOnlyTheStampedFiles) {
+        ScratchDirectory directory;
+        const std::string one = directory.file("one.json");
+        const std::string two = directory.file("two.json");
+        writeFile(one, "[]");
+        writeFile(two, "[]");
+        RecordIndex index(directory.file(".index"));
+        ASSERT_TRUE(index.create(4));
+        ASSERT_TRUE(index.put("a", one, 1, 1));
+        index.stampFile(one);
+        EXPECT_TRUE(index.matches({ one }));
+        EXPECT_FALSE(index.matches({ one, two }));  // Never seen
+        EXPECT_FALSE(index.matches({}));            // Still holds records of one
+
+        writeFile(one, "[ ]");
+        EXPECT_FALSE(index.matches({ one }));       // Changed since it was stamped
+        index.stampFile(one);
+        EXPECT_TRUE(index.matches({ one }));
+    }
+
+    TEST(RecordIndexTest, CorruptFileDoesNotOpen) {
+        ScratchDirectory directory;
+        const std::string path = directory.file(".index");
+        RecordIndex index(path);
+        ASSERT_TRUE(index.create(4));
+        ASSERT_TRUE(index.put("a", directory.file("one.json"), 1, 1));
+        index.close();
+
+        // Cut short, then the right size with a wrong magic number
+        const std::uintmax_t size = std::filesystem::file_size(path);
+        std::filesystem::resize_file(path, size / 2);
+        EXPECT_FALSE(index.open());
+        writeFile(path, std::string(size, 'x'));
+        EXPECT_FALSE(index.open());
+        EXPECT_FALSE(index.isOpen());
+        EXPECT_EQ(located(index, "a"), "");
+        EXPECT_FALSE(RecordIndex(directory.file("missing.index")).open());
+    }
+
+    TEST(RecordIndexTest, StaleLocationIsRebuiltOnce) {
+        ScratchDirectory directory;
+        RecordIndex index(directory.file(".index"));
+        ASSERT_TRUE(index.create(4));
+        ASSERT_TRUE(index.put("a", directory.file("one.json"), 1, 1));
+
+        // The record at the indexed place is no longer "a"; the rebuild
+        // finds where it went
+        struct Named {
+            std::string id;
+        };
+        auto read = [](const RecordLocation& at, Named& record) {
+            record.id = at.offset == 2 ? "a" : "b";
+            return true;
+        };
+        int rebuilds = 0;
+        Named record;
+        RecordLocation location;
+        EXPECT_TRUE(findIndexed(index, "a", record, location, read, [&]() {
+            ++rebuilds;
+            return index.put("a", directory.file("one.json"), 2, 1);
+        }));
+        EXPECT_EQ(rebuilds, 1);
+        EXPECT_EQ(location.offset, 2u);
+
+        // A rebuild that does not help is not repeated
+        rebuilds = 0;
+        EXPECT_FALSE(findIndexed(index, "a", record, location,
+            [](const RecordLocation&, Named& wrong) { wrong.id = "b"; return true; },
+            [&]() { ++rebuilds; return true; }));
+        EXPECT_EQ(rebuilds, 1);
+    }
+
+    TEST(RecordIndexTest, PackingLookupFollowsAddAndRemove) {
+        ScratchDirectory directory;
+        PackingManager manager(directory.file("packing.json"));
+        const std::string passport = manager.addItem("trip", "Passport");
+        const std::string socks = manager.addItem("other", "Socks", 3);
+        ASSERT_FALSE(passport.empty());
+        ASSERT_FALSE(socks.empty());
+
+        PackingItem item;
+        ASSERT_TRUE(manager.findItem(socks, item));
+        EXPECT_EQ(item.name, "Socks");
+        ASSERT_TRUE(manager.removeItem(passport));
+        EXPECT_FALSE(manager.findItem(passport, item));
+        EXPECT_TRUE(PackingManager(directory.file("packing.json")).findItem(socks, item));
+        EXPECT_TRUE(std::filesystem::exists(directory.file("packing/.index")));
+    }
+
+    TEST(RecordIndexTest, PackingIndexIsRebuiltWhenAShardChanges) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("packing.json");
+        ASSERT_TRUE(PackingManager(store).saveAll({ PackingItem("p1", "trip", "Passport", 1, false) }));
+
+        // Rewritten behind the index's back: p1 moved, p2 is new
+        writeFile(directory.file("packing/trip.json"),
+            "[" + packingItem("p2", "Umbrella") + "," + packingItem("p1", "Passport") + "]");
+        PackingManager manager(store);
+        PackingItem item;
+        ASSERT_TRUE(manager.findItem("p2", item));
+        EXPECT_EQ(item.name, "Umbrella");
+        ASSERT_TRUE(manager.findItem("p1", item));
+        EXPECT_EQ(item.name, "Passport");
+    }
+
+    TEST(RecordIndexTest, PackingLookupSurvivesACorruptIndex) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("packing.json");
+        ASSERT_TRUE(PackingManager(store).saveAll({ PackingItem("p1", "trip", "Passport", 1, false) }));
+        const std::string index_path = directory.file("packing/.index");
+
+        // Garbage is replaced by a rebuilt index
+        writeFile(index_path, "not an index");
+        PackingItem item;
+        EXPECT_TRUE(PackingManager(store).findItem("p1", item));
+        EXPECT_NE(std::filesystem::file_size(index_path), std::string("not an index").size());
+
+        // One that cannot be replaced leaves the shards to be scanned
+        std::filesystem::remove(index_path);
+        std::filesystem::create_directory(index_path);
+        PackingManager manager(store);
+        EXPECT_TRUE(manager.findItem("p1", item));
+        EXPECT_EQ(item.name, "Passport");
+        ASSERT_TRUE(manager.markPacked("p1"));
+        ASSERT_TRUE(manager.findItem("p1", item));
+        EXPECT_TRUE(item.packed);
+    }
+
+    TEST(RecordIndexTest, ExpenseLookupFollowsAddAndRemove) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        ExpenseManager manager(store);
+        ASSERT_TRUE(manager.saveAll({
+            Expense("e1", "trip", 1.0, "Food", "2024-05-01", ""),
+            Expense("e2", "other", 2.0, "Food", "2024-05-01", ""),
+        }));
+        ASSERT_TRUE(manager.addExpense("trip", 3.0, "Food", "2024-05-02", ""));
+
+        // Removals find the shard through the index, the journal's too
+        std::string added;
+        for (const auto& e : manager.listExpenses("trip")) {
+            if (e.id != "e1") {
+                added = e.id;
+            }
+        }
+        ASSERT_FALSE(added.empty());
+        EXPECT_TRUE(manager.removeExpense(added));
+        EXPECT_TRUE(manager.removeExpense("e2"));
+        EXPECT_FALSE(manager.removeExpense("e2"));
+        EXPECT_FALSE(ExpenseManager(store).removeExpense("missing"));
+        EXPECT_TRUE(ExpenseManager(store).removeExpense("e1"));
+        EXPECT_TRUE(ExpenseManager(store).loadAll().empty());
+    }
+
+    TEST(RecordIndexTest, ExpenseIndexIsRebuiltWhenAShardChanges) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        ASSERT_TRUE(ExpenseManager(store).saveAll({ Expense("e1", "trip", 1.0, "Food", "2024-05-01", "") }));
+
+        writeFile(directory.file("expenses/trip.json"), "[" + expense("e2", 2.0) + "," + expense("e1", 1.0) + "]");
+        ExpenseManager manager(store);
+        EXPECT_TRUE(manager.removeExpense("e2"));
+        EXPECT_TRUE(manager.removeExpense("e1"));
+        EXPECT_TRUE(manager.listExpenses("trip").empty());
+    }
+
+    TEST(RecordIndexTest, ExpenseLookupSurvivesACorruptIndex) {
+        ScratchDirectory directory;
+        const std::string store = directory.file("expenses.json");
+        ASSERT_TRUE(ExpenseManager(store).saveAll({
+            Expense("e1", "trip", 1.0, "Food", "2024-05-01", ""),
+            Expense("e2", "trip", 2.0, "Food", "2024-05-01", ""),
+        }));
+        const std::string index_path = directory.file("expenses/.index");
+
+        writeFile(index_path, "not an index");
+        EXPECT_TRUE(ExpenseManager(store).removeExpense("e1"));
+
+        std::filesystem::remove(index_path);
+        std::filesystem::create_directory(index_path);
+        EXPECT_TRUE(ExpenseManager(store).removeExpense("e2"));
+        EXPECT_TRUE(ExpenseManager(store).listExpenses("trip").empty());
+    }
+
+} // namespace travel_planner
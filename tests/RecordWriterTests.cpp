@@ -0,0 +1,81 @@
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "RecordCache.h"
+#include "RecordWriter.h"
+#include "Itinerary.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        std::string contents(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        }
+
+        std::vector<Itinerary> readBack(const std::string& path, bool& ok) {
+            std::vector<Itinerary> itineraries;
+            std::string error;
+            ok = readRecordFile<Itinerary>(path, [&itineraries](const Itinerary& itinerary) {
+                itineraries.push_back(itinerary);
+                return true;
+            }, error, StorageFormat::Json);
+            return itineraries;
+        }
+
+    } // namespace
+
+    TEST(RecordWriterTest, JsonKeepsMultiByteCharacters) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("itineraries.json");
+        const std::string name = "Z\xC3\xBCrich \xE2\x82\xAC \xF0\x9F\x97\xBA";  // Zürich € 🗺
+        ASSERT_TRUE(writeRecords(path, std::vector<Itinerary>{ Itinerary("a", name, "2024-01-01", "2024-01-02", "") },
+            StorageFormat::Json, 2));
+
+        bool ok = false;
+        std::vector<Itinerary> itineraries = readBack(path, ok);
+        ASSERT_TRUE(ok);
+        ASSERT_EQ(itineraries.size(), 1u);
+        EXPECT_EQ(itineraries[0].name, name);
+    }
+
+    TEST(RecordWriterTest, JsonRejectsInvalidUtf8AndKeepsTheFile) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("itineraries.json");
+        ASSERT_TRUE(writeRecords(path, std::vector<Itinerary>{ Itinerary("a", "Good", "2024-01-01", "2024-01-02", "") },
+            StorageFormat::Json, 2));
+        const std::string before = contents(path);
+
+        for (const char* bad : { "Bad\xFFName", "\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "cut \xE2\x82" }) {
+            EXPECT_FALSE(writeRecords(path, std::vector<Itinerary>{ Itinerary("b", bad, "2024-01-01", "2024-01-02", "") },
+                StorageFormat::Json, 2)) << bad;
+            EXPECT_EQ(contents(path), before);
+        }
+    }
+
+    TEST(RecordWriterTest, UnparsableFileIsNotOverwritten) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("itineraries.json");
+        const std::string corrupt = "[{\"id\":\"x\",\"name\":\"Bad\xFFName\"}]";
+        std::ofstream(path, std::ios::binary) << corrupt;
+
+        bool ok = true;
+        EXPECT_TRUE(readBack(path, ok).empty());
+        EXPECT_FALSE(ok);
+        EXPECT_TRUE(isUnreadable(path));
+        EXPECT_FALSE(writeRecords(path, std::vector<Itinerary>{ Itinerary("y", "New", "2024-01-01", "2024-01-02", "") },
+            StorageFormat::Json, 2));
+        EXPECT_EQ(contents(path), corrupt);
+
+        // Once repaired, the file may be written again
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << "[]";
+        EXPECT_FALSE(isUnreadable(path));
+        EXPECT_TRUE(writeRecords(path, std::vector<Itinerary>{ Itinerary("y", "New", "2024-01-01", "2024-01-02", "") },
+            StorageFormat::Json, 2));
+    }
+
+} // namespace travel_planner
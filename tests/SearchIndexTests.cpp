@@ -0,0 +1,182 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "SearchIndex.h"
+#include "StorageManager.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        using Clauses = std::vector<SearchQuery::Clause>;
+
+        struct Document {
+            const char* id;
+            const char* name;
+            const char* description;
+        };
+
+        SearchIndex build(const std::vector<Document>& documents, const FileStamp& source = {}) {
+            SearchIndex::Builder builder;
+            for (const auto& document : documents) {
+                builder.add(document.id, document.name, document.description);
+            }
+            SearchIndex index;
+            index.assign(builder.finish(source));
+            return index;
+        }
+
+        // IDs of the hits of a command-line query, best first
+        std::vector<std::string> search(const SearchIndex& index, const std::vector<std::string>& words) {
+            std::vector<std::string> ids;
+            for (const auto& hit : index.search(SearchQuery::parse(words))) {
+                ids.emplace_back(hit.id);
+            }
+            return ids;
+        }
+
+        const std::vector<Document> kTrips = {
+            { "paris", "Paris city break", "Museums and cafes" },
+            { "beach", "Beach week", "Sun, sand and sea" },
+            { "lights", "City of lights", "Paris at night, then a break for dinner" },
+            { "hike", "Mountain hike", "A break from the city" },
+            { "split", "Old city", "Break away for a day" },
+        };
+
+    } // namespace
+
+    TEST(SearchIndexTest, TermsAreLowercasedWordRuns) {
+        EXPECT_EQ(searchTerms("Rock'n'Roll, 2024 TOUR!"),
+            (std::vector<std::string>{ "rock", "n", "roll", "2024", "tour" }));
+        EXPECT_EQ(searchTerms("Caf\xC3\xA9 cr\xC3\xA8me"), (std::vector<std::string>{ "caf\xC3\xA9", "cr\xC3\xA8me" }));
+        EXPECT_TRUE(searchTerms(" -- ").empty());
+    }
+
+    TEST(SearchIndexTest, ParseSplitsAlternativesAndPhrases) {
+        // Quotes inside one argument, e.g. kept by single quotes in the shell
+        SearchQuery query = SearchQuery::parse({ "paris AND \"city break\" OR", "beach" });
+        ASSERT_EQ(query.alternatives.size(), 2u);
+        EXPECT_EQ(query.alternatives[0], (Clauses{ { "paris" }, { "city", "break" } }));
+        EXPECT_EQ(query.alternatives[1], (Clauses{ { "beach" } }));
+
+        // An argument the shell kept together is a phrase
+        query = SearchQuery::parse({ "city break", "Paris" });
+        ASSERT_EQ(query.alternatives.size(), 1u);
+        EXPECT_EQ(query.alternatives[0], (Clauses{ { "city", "break" }, { "paris" } }));
+
+        // Stray operators and punctuation leave nothing behind
+        EXPECT_EQ(SearchQuery::parse({ "OR", "beach", "OR" }).alternatives.size(), 1u);
+        EXPECT_TRUE(SearchQuery::parse({ "OR", "AND", "--" }).empty());
+    }
+
+    TEST(SearchIndexTest, WordsAreAnded) {
+        SearchIndex index = build(kTrips);
+        EXPECT_EQ(search(index, { "paris" }), (std::vector<std::string>{ "paris", "lights" }));
+        EXPECT_EQ(search(index, { "PARIS", "dinner" }), (std::vector<std::string>{ "lights" }));
+        EXPECT_TRUE(search(index, { "paris", "beach" }).empty());
+        EXPECT_TRUE(search(index, { "nowhere" }).empty());
+    }
+
+    TEST(SearchIndexTest, PhraseNeedsAdjacentTermsInOneField) {
+        SearchIndex index = build(kTrips);
+        // "lights" and "hike" have both words, apart; "split" has them
+        // adjacent only across the name and the description
+        EXPECT_EQ(search(index, { "\"city break\"" }), (std::vector<std::string>{ "paris" }));
+        EXPECT_EQ(search(index, { "\"break city\"" }), std::vector<std::string>{});
+        EXPECT_EQ(search(index, { "city", "break" }).size(), 4u);
+    }
+
+    TEST(SearchIndexTest, AlternativesAreOredAndCountedOnce) {
+        SearchIndex index = build(kTrips);
+        std::vector<std::string> ids = search(index, { "beach", "OR", "mountain", "OR", "hike" });
+        ASSERT_EQ(ids.size(), 2u);
+        EXPECT_EQ(ids[0], "hike");  // Matches two alternatives, so scores both
+        EXPECT_EQ(ids[1], "beach");
+    }
+
+    TEST(SearchIndexTest, RanksNameHitsAndRepeatsHigher) {
+        SearchIndex index = build({
+            { "desc", "Holiday", "Rome" },
+            { "name", "Rome", "Holiday" },
+            { "twice", "Rome", "Rome again" },
+            { "other", "Holiday", "Florence" },
+        });
+        EXPECT_EQ(search(index, { "rome" }), (std::vector<std::string>{ "twice", "name", "desc" }));
+
+        // Equal scores keep store order
+        SearchIndex same = build({ { "b", "Lisbon", "" }, { "a", "Lisbon", "" }, { "c", "Lisbon", "" } });
+        EXPECT_EQ(search(same, { "lisbon" }), (std::vector<std::string>{ "b", "a", "c" }));
+    }
+
+    TEST(SearchIndexTest, SavedIndexOpensOnlyForItsStamp) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("store.search");
+        const FileStamp stamp{ 123, 456 };
+        SearchIndex::Builder builder;
+        for (const auto& trip : kTrips) {
+            builder.add(trip.id, trip.name, trip.description);
+        }
+        ASSERT_TRUE(SearchIndex::Builder::save(path, builder.finish(stamp)));
+
+        SearchIndex index;
+        ASSERT_TRUE(index.open(path, stamp));
+        EXPECT_EQ(index.size(), kTrips.size());
+        EXPECT_EQ(search(index, { "paris", "dinner" }), (std::vector<std::string>{ "lights" }));
+        EXPECT_FALSE(SearchIndex().open(path, FileStamp{ 124, 456 }));
+        EXPECT_FALSE(SearchIndex().open(directory.file("missing.search"), stamp));
+    }
+
+    TEST(SearchIndexTest, OpenIndexOutlivesItsReplacement) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("store.search");
+        const FileStamp stamp{ 123, 456 };
+        SearchIndex::Builder builder;
+        for (const auto& trip : kTrips) {
+            builder.add(trip.id, trip.name, trip.description);
+        }
+        ASSERT_TRUE(SearchIndex::Builder::save(path, builder.finish(stamp)));
+        SearchIndex index;
+        ASSERT_TRUE(index.open(path, stamp));
+
+        // The reader keeps the file it mapped; a new reader sees the new one
+        SearchIndex::Builder other;
+        other.add("rome", "Rome", "");
+        ASSERT_TRUE(SearchIndex::Builder::save(path, other.finish(stamp)));
+        EXPECT_EQ(search(index, { "paris", "dinner" }), (std::vector<std::string>{ "lights" }));
+        SearchIndex reopened;
+        ASSERT_TRUE(reopened.open(path, stamp));
+        EXPECT_EQ(search(reopened, { "rome" }), (std::vector<std::string>{ "rome" }));
+        EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+        // A corrupt file does not open
+        EXPECT_TRUE(replaceFile(path, "not an index"));
+        EXPECT_FALSE(SearchIndex().open(path, stamp));
+    }
+
+    TEST(SearchIndexTest, StoreSearchFollowsSaves) {
+        ScratchDirectory directory;
+        StorageManager store(directory.file("itineraries.json"));
+        std::vector<Itinerary> itineraries = {
+            Itinerary("it1", "Paris city break", "2024-05-01", "2024-05-04", "Museums"),
+            Itinerary("it2", "Beach week", "2024-07-01", "2024-07-08", "Sun and sea"),
+        };
+        ASSERT_TRUE(store.saveAll(itineraries));
+
+        auto ids = [&store](const std::vector<std::string>& words) {
+            std::vector<std::string> result;
+            for (const auto& itinerary : store.search(SearchQuery::parse(words))) {
+                result.push_back(itinerary.id);
+            }
+            return result;
+        };
+        EXPECT_EQ(ids({ "sea", "OR", "museums" }), (std::vector<std::string>{ "it1", "it2" }));
+
+        itineraries[1].description = "Museums by the sea";
+        ASSERT_TRUE(store.saveAll(itineraries));
+        EXPECT_EQ(ids({ "museums", "sea" }), (std::vector<std::string>{ "it2" }));
+        EXPECT_EQ(StorageManager(directory.file("itineraries.json")).search(SearchQuery::parse({ "paris" })).size(), 1u);
+    }
+
+} // namespace travel_planner
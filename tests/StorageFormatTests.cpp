@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "ExpenseManager.h"
+#include "PackingManager.h"
+#include "StorageManager.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        const StorageFormat kFormats[] = { StorageFormat::Json, StorageFormat::Cbor, StorageFormat::MsgPack };
+
+        // Store path for a format: same name, the format's extension
+        std::string storePath(const ScratchDirectory& directory, const std::string& name, StorageFormat format) {
+            return directory.file(name + formatExtension(format));
+        }
+
+        // Format the contents of a file look like
+        StorageFormat contentFormat(const std::string& path) {
+            std::ifstream in(path, std::ios::binary);
+            return sniffFormat(in, formatForPath(path));
+        }
+
+        // One line per record with every field, sorted where the store does
+        // not promise an order
+        std::vector<std::string> describe(const std::vector<Itinerary>& itineraries) {
+            std::vector<std::string> lines;
+            for (const auto& itinerary : itineraries) {
+                std::ostringstream line;
+                line << itinerary.id << '|' << itinerary.name << '|' << itinerary.start_date << '|'
+                    << itinerary.end_date << '|' << itinerary.description << '|' << itinerary.is_favorite;
+                for (const auto& tag : itinerary.tags) {
+                    line << '|' << tag;
+                }
+                lines.push_back(line.str());
+            }
+            return lines;
+        }
+
+        std::vector<std::string> describe(const std::vector<PackingItem>& items) {
+            std::vector<std::string> lines;
+            for (const auto& item : items) {
+                std::ostringstream line;
+                line << item.id << '|' << item.itinerary_id << '|' << item.name << '|' << item.quantity << '|'
+                    << item.packed;
+                lines.push_back(line.str());
+            }
+            std::sort(lines.begin(), lines.end());
+            return lines;
+        }
+
+        std::vector<std::string> describe(const std::vector<Expense>& expenses) {
+            std::vector<std::string> lines;
+            for (const auto& expense : expenses) {
+                std::ostringstream line;
+                line << expense.id << '|' << expense.itinerary_id << '|' << expense.amount << '|' << expense.category
+                    << '|' << expense.date << '|' << expense.description;
+                lines.push_back(line.str());
+            }
+            std::sort(lines.begin(), lines.end());
+            return lines;
+        }
+
+        std::vector<Itinerary> sampleItineraries() {
+            Itinerary paris("it1", "Paris \xC3\xA0 deux", "2024-05-01", "2024-05-09", "Caf\xC3\xA9s \"and\" museums",
+                { "europe", "food" });
+            paris.is_favorite = true;
+            return {
+                paris,
+                Itinerary("it2", "Tokyo \xE6\x9D\xB1\xE4\xBA\xAC", "2024-10-01", "2024-10-14", "Line one\nline two"),
+                Itinerary("it3", "", "2025-01-01", "2025-01-02", "", { "work" }),
+            };
+        }
+
+    } // namespace
+
+    TEST(StorageFormatTest, ItinerariesSurviveEveryConversion) {
+        ScratchDirectory directory;
+        const std::vector<Itinerary> itineraries = sampleItineraries();
+        ASSERT_TRUE(StorageManager(storePath(directory, "itineraries", StorageFormat::Json)).saveAll(itineraries));
+        const std::vector<std::string> expected = describe(itineraries);
+
+        // JSON -> CBOR -> MessagePack -> JSON, each by opening the store under
+        // the next extension
+        StorageFormat previous = StorageFormat::Json;
+        for (StorageFormat format : { StorageFormat::Cbor, StorageFormat::MsgPack, StorageFormat::Json }) {
+            SCOPED_TRACE(formatName(format));
+            const std::string path = storePath(directory, "itineraries", format);
+            StorageManager store(path);
+            EXPECT_EQ(describe(store.loadAll()), expected);
+            EXPECT_EQ(contentFormat(path), format);
+            EXPECT_FALSE(std::filesystem::exists(storePath(directory, "itineraries", previous)));
+
+            Itinerary found;
+            ASSERT_TRUE(store.find("it2", found));
+            EXPECT_EQ(found.name, itineraries[1].name);
+            previous = format;
+        }
+    }
+
+    TEST(StorageFormatTest, PackingItemsSurviveEveryConversion) {
+        ScratchDirectory directory;
+        const std::vector<PackingItem> items = {
+            PackingItem("p1", "it1", "Passport", 1, true),
+            PackingItem("p2", "it1", "Socks \xE2\x9C\x93", 7, false),
+            PackingItem("p3", "it2", "Umbrella", 2, false),
+        };
+        PackingManager(storePath(directory, "packing", StorageFormat::Json)).saveAll(items);
+        const std::vector<std::string> expected = describe(items);
+
+        for (StorageFormat format : { StorageFormat::Cbor, StorageFormat::MsgPack, StorageFormat::Json }) {
+            SCOPED_TRACE(formatName(format));
+            PackingManager store(storePath(directory, "packing", format));
+            EXPECT_EQ(describe(store.loadAll()), expected);
+            EXPECT_EQ(describe(store.listItems("it2")), describe(std::vector<PackingItem>{ items[2] }));
+            EXPECT_EQ(contentFormat(directory.file(std::string("packing/it1") + formatExtension(format))), format);
+        }
+    }
+
+    TEST(StorageFormatTest, ExpensesSurviveEveryConversion) {
+        ScratchDirectory directory;
+        const std::vector<Expense> expenses = {
+            Expense("e1", "it1", 12.34, "Food", "2024-05-01", "Cr\xC3\xAApes"),
+            Expense("e2", "it1", 0.01, "Misc", "2024-05-02", ""),
+            Expense("e3", "it2", 1999.99, "Lodging", "2024-10-01", "Hotel"),
+        };
+        {
+            ExpenseManager store(storePath(directory, "expenses", StorageFormat::Json));
+            ASSERT_TRUE(store.saveAll(expenses));
+            ASSERT_TRUE(store.removeExpense("e2"));  // Left in the journal
+        }
+        const std::vector<std::string> expected = describe(std::vector<Expense>{ expenses[0], expenses[2] });
+
+        for (StorageFormat format : { StorageFormat::Cbor, StorageFormat::MsgPack, StorageFormat::Json }) {
+            SCOPED_TRACE(formatName(format));
+            ExpenseManager store(storePath(directory, "expenses", format));
+            EXPECT_EQ(describe(store.loadAll()), expected);
+            EXPECT_EQ(store.summary("it1").at("Food"), 12.34);
+            EXPECT_EQ(contentFormat(directory.file(std::string("expenses/it1") + formatExtension(format))), format);
+        }
+    }
+
+    TEST(StorageFormatTest, ContentsWinOverExtension) {
+        ScratchDirectory directory;
+        const std::vector<Itinerary> itineraries = sampleItineraries();
+        for (StorageFormat format : kFormats) {
+            SCOPED_TRACE(formatName(format));
+            const std::string path = storePath(directory, "itineraries", format);
+            ASSERT_TRUE(StorageManager(path).saveAll(itineraries));
+
+            // Same bytes under a name that claims another format
+            const std::string misnamed = directory.file("misnamed.json");
+            std::filesystem::copy_file(path, misnamed, std::filesystem::copy_options::overwrite_existing);
+            std::filesystem::remove(misnamed + ".idx");
+            EXPECT_EQ(describe(StorageManager(misnamed).loadAll()), describe(itineraries));
+            std::filesystem::remove(path);
+        }
+    }
+
+} // namespace travel_planner
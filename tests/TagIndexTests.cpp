@@ -0,0 +1,129 @@
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "StorageManager.h"
+#include "TagIndex.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        std::vector<std::string> ids(const TagIndex& index, const TagQuery& query) {
+            std::vector<std::string> result;
+            index.evaluate(query).forEach([&index, &result](std::uint32_t ordinal) {
+                result.emplace_back(index.id(ordinal));
+            });
+            return result;
+        }
+
+        TagIndex sampleIndex() {
+            TagIndex index;
+            index.add("a", { "beach", "family" }, true);
+            index.add("b", { "beach" }, false);
+            index.add("c", { "city", "family" }, false);
+            index.add("d", {}, true);
+            return index;
+        }
+
+        std::vector<std::string> ids(const std::vector<Itinerary>& itineraries) {
+            std::vector<std::string> result;
+            for (const auto& itinerary : itineraries) {
+                result.push_back(itinerary.id);
+            }
+            return result;
+        }
+
+    } // namespace
+
+    TEST(TagIndexTest, QuerySemantics) {
+        const TagIndex index = sampleIndex();
+        using Ids = std::vector<std::string>;
+        EXPECT_EQ(ids(index, TagQuery{}), (Ids{ "a", "b", "c", "d" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "beach" }, {}, {}, false }), (Ids{ "a", "b" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "beach", "family" }, {}, {}, false }), (Ids{ "a" }));
+        EXPECT_EQ(ids(index, TagQuery{ {}, { "beach", "city" }, {}, false }), (Ids{ "a", "b", "c" }));
+        EXPECT_EQ(ids(index, TagQuery{ {}, {}, { "family" }, false }), (Ids{ "b", "d" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "family" }, {}, { "beach" }, false }), (Ids{ "c" }));
+        EXPECT_EQ(ids(index, TagQuery{ {}, {}, {}, true }), (Ids{ "a", "d" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "beach" }, {}, {}, true }), (Ids{ "a" }));
+        EXPECT_TRUE(ids(index, TagQuery{ { "beach", "missing" }, {}, {}, false }).empty());
+        EXPECT_TRUE(ids(index, TagQuery{ {}, { "missing" }, {}, false }).empty());
+    }
+
+    TEST(TagIndexTest, SavedIndexOpensOnlyForItsStore) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("itineraries.tags");
+        const FileStamp stamp{ 1234, 5678 };
+        ASSERT_TRUE(sampleIndex().save(path, stamp));
+
+        TagIndex stale;
+        EXPECT_FALSE(stale.open(path, FileStamp{ 1234, 5679 }));
+        EXPECT_FALSE(stale.open(directory.file("missing.tags"), stamp));
+
+        TagIndex index;
+        ASSERT_TRUE(index.open(path, stamp));
+        EXPECT_EQ(index.size(), 4u);
+        EXPECT_EQ(ids(index, TagQuery{ { "family" }, {}, {}, false }), (std::vector<std::string>{ "a", "c" }));
+        EXPECT_EQ(ids(index, TagQuery{ {}, {}, {}, true }), (std::vector<std::string>{ "a", "d" }));
+
+        // Saving a mapped index copies it unchanged
+        const std::string copy = directory.file("copy.tags");
+        ASSERT_TRUE(index.save(copy, stamp));
+        TagIndex reopened;
+        ASSERT_TRUE(reopened.open(copy, stamp));
+        EXPECT_EQ(ids(reopened, TagQuery{ {}, { "city", "beach" }, {}, false }), (std::vector<std::string>{ "a", "b", "c" }));
+    }
+
+    TEST(TagIndexTest, UpdateReplacesTagsOfOneRecord) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("itineraries.tags");
+        ASSERT_TRUE(sampleIndex().save(path, FileStamp{ 1, 1 }));
+        TagIndex index;
+        ASSERT_TRUE(index.open(path, FileStamp{ 1, 1 }));
+
+        index.update(2, { "beach", "city" }, true);  // c loses family, gains beach
+        index.update(3, { "ski" }, false);
+        using Ids = std::vector<std::string>;
+        EXPECT_EQ(ids(index, TagQuery{ { "beach" }, {}, {}, false }), (Ids{ "a", "b", "c" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "family" }, {}, {}, false }), (Ids{ "a" }));
+        EXPECT_EQ(ids(index, TagQuery{ { "ski" }, {}, {}, false }), (Ids{ "d" }));
+        EXPECT_EQ(ids(index, TagQuery{ {}, {}, {}, true }), (Ids{ "a", "c" }));
+
+        index.update(1, {}, false);
+        ASSERT_TRUE(index.save(path, FileStamp{ 2, 2 }));
+        TagIndex reopened;
+        ASSERT_TRUE(reopened.open(path, FileStamp{ 2, 2 }));
+        EXPECT_EQ(ids(reopened, TagQuery{ { "beach" }, {}, {}, false }), (Ids{ "a", "c" }));
+        EXPECT_EQ(reopened.id(3), "d");
+    }
+
+    TEST(TagIndexTest, StoreKeepsTagIndexInStepWithTagChanges) {
+        ScratchDirectory directory;
+        StorageManager storage(directory.file("itineraries.json"));
+        std::vector<Itinerary> itineraries = {
+            Itinerary("a", "Lisbon", "2024-01-01", "2024-01-05", ""),
+            Itinerary("b", "Porto", "2024-02-01", "2024-02-05", ""),
+            Itinerary("c", "Faro", "2024-03-01", "2024-03-05", ""),
+        };
+        itineraries[0].tags = { "beach" };
+        itineraries[2].tags = { "beach", "food" };
+        ASSERT_TRUE(storage.saveAll(itineraries));
+        EXPECT_EQ(ids(storage.listTagged(TagQuery{ { "beach" }, {}, {}, false })), (std::vector<std::string>{ "a", "c" }));
+
+        itineraries[1].tags.push_back("beach");
+        ASSERT_TRUE(storage.saveTagChange(itineraries, 1));
+        itineraries[2].tags = { "food" };
+        itineraries[2].is_favorite = true;
+        ASSERT_TRUE(storage.saveTagChange(itineraries, 2));
+
+        EXPECT_EQ(ids(storage.listTagged(TagQuery{ { "beach" }, {}, {}, false })), (std::vector<std::string>{ "a", "b" }));
+        EXPECT_EQ(ids(storage.listTagged(TagQuery{ {}, {}, {}, true })), (std::vector<std::string>{ "c" }));
+
+        // Same answers from an index rebuilt from the store
+        std::filesystem::remove(directory.file("itineraries.tags"));
+        EXPECT_EQ(ids(storage.listTagged(TagQuery{ { "beach" }, {}, {}, false })), (std::vector<std::string>{ "a", "b" }));
+        EXPECT_EQ(ids(storage.listTagged(TagQuery{ { "food" }, {}, { "beach" }, true })), (std::vector<std::string>{ "c" }));
+    }
+
+} // namespace travel_planner
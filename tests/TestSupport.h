@@ -0,0 +1,51 @@
+#ifndef TRAVEL_PLANNER_TEST_SUPPORT_H
+#define TRAVEL_PLANNER_TEST_SUPPORT_H
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace travel_planner {
+
+    /**
+     * Fresh, empty directory under the system temp directory for the stores
+     * of one test, removed with everything in it when it goes out of scope
+     */
+    class ScratchDirectory {
+    public:
+        ScratchDirectory() {
+            static std::atomic<int> counter{ 0 };
+            path_ = std::filesystem::temp_directory_path()
+                / ("travel_planner_tests-" + std::to_string(getpid()) + "-" + std::to_string(counter++));
+            std::filesystem::remove_all(path_);
+            std::filesystem::create_directories(path_);
+        }
+
+        ~ScratchDirectory() {
+            std::error_code ec;
+            std::filesystem::remove_all(path_, ec);
+        }
+
+        ScratchDirectory(const ScratchDirectory&) = delete;
+        ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+
+        /**
+         * @return Path of a file in the directory
+         */
+        std::string file(const std::string& name) const {
+            return (path_ / name).string();
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+} // namespace travel_planner
+
+#endif // TRAVEL_PLANNER_TEST_SUPPORT_H
@@ -0,0 +1,110 @@
+#include <random>
+#include <string>
+#include <string_view>
+#include <gtest/gtest.h>
+#include "TextKernels.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        const TextKernel kKernels[] = { TextKernel::Auto, TextKernel::Scalar, TextKernel::Sse2, TextKernel::Avx2 };
+
+        char lower(char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        // Byte-by-byte search to check the kernels against
+        std::size_t reference(std::string_view text, std::string_view pattern) {
+            for (std::size_t start = 0; start + pattern.size() <= text.size(); ++start) {
+                std::size_t i = 0;
+                while (i < pattern.size() && lower(text[start + i]) == lower(pattern[i])) {
+                    ++i;
+                }
+                if (i == pattern.size()) {
+                    return start;
+                }
+            }
+            return std::string_view::npos;
+        }
+
+        // Runs a search on every available kernel and expects the reference
+        void expectFind(std::string_view text, std::string_view pattern) {
+            const std::size_t expected = reference(text, pattern);
+            for (TextKernel kernel : kKernels) {
+                if (textKernelAvailable(kernel)) {
+                    EXPECT_EQ(findIgnoreCase(text, pattern, kernel), expected)
+                        << "kernel " << static_cast<int>(kernel) << ", text \"" << text << "\", pattern \""
+                        << pattern << "\"";
+                }
+            }
+        }
+
+    } // namespace
+
+    TEST(TextKernelsTest, EdgeCases) {
+        expectFind("", "");
+        expectFind("abc", "");
+        expectFind("", "a");
+        expectFind("ab", "abc");
+        expectFind("abc", "ABC");
+        expectFind("Hello World", "o w");
+        // Bytes 0x20 away from letters are not letters
+        expectFind("[@`{", "{`@[");
+        expectFind("a@b", "A`B");
+        expectFind("x{y", "X[Y");
+        // Non-ASCII bytes must match exactly: "é" is not "É"
+        expectFind("caf\xC3\xA9", "CAF\xC3\x89");
+        expectFind("CAF\xC3\xA9", "caf\xC3\xA9");
+    }
+
+    TEST(TextKernelsTest, MatchesAtEveryBlockPosition) {
+        // "qq..Z" in a text of "Q" with one "z", at each offset of a 100-byte
+        // text, so the match falls at the start, middle and end of the 16-
+        // and 32-byte blocks of the vector kernels and across them. Every
+        // earlier position matches all but the last byte.
+        for (std::size_t length : { 1u, 2u, 3u, 17u, 33u }) {
+            const std::string pattern = std::string(length - 1, 'q') + "Z";
+            for (std::size_t at = 0; at + length <= 100; ++at) {
+                std::string text(100, 'Q');
+                text[at + length - 1] = 'z';
+                expectFind(text, pattern);
+                expectFind(text.substr(0, at + length - 1), pattern);  // No match
+            }
+        }
+    }
+
+    TEST(TextKernelsTest, AgreeWithReferenceOnRandomText) {
+        // A small alphabet of letters in both cases, their non-letter
+        // neighbours and a multibyte character makes partial matches common
+        const char alphabet[] = "aAbB[@`{ \xC3\xA9Zz";
+        const std::size_t letters = sizeof(alphabet) - 1;
+        std::mt19937 random(3);
+        for (int round = 0; round < 20000; ++round) {
+            std::string text;
+            std::string pattern;
+            const std::size_t text_size = random() % 100;
+            const std::size_t pattern_size = 1 + random() % (round % 7 == 0 ? 40 : 5);
+            for (std::size_t i = 0; i < text_size; ++i) {
+                text += alphabet[random() % letters];
+            }
+            for (std::size_t i = 0; i < pattern_size; ++i) {
+                pattern += alphabet[random() % letters];
+            }
+            // Plant a copy in mixed case a third of the time
+            if (random() % 3 == 0 && text_size >= pattern_size) {
+                const std::size_t at = random() % (text_size - pattern_size + 1);
+                for (std::size_t i = 0; i < pattern_size; ++i) {
+                    const char c = text[at + i];
+                    const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                    pattern[i] = letter && random() % 2 ? static_cast<char>(c ^ 0x20) : c;
+                }
+            }
+            expectFind(text, pattern);
+            if (HasFailure()) {
+                return;
+            }
+        }
+    }
+
+} // namespace travel_planner
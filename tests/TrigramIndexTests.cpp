@@ -0,0 +1,126 @@
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <gtest/gtest.h>
+#include "TestSupport.h"
+#include "StorageManager.h"
+#include "TrigramIndex.h"
+
+namespace travel_planner {
+
+    namespace {
+
+        char lower(char c) {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+        }
+
+        // Plain case-insensitive substring test to check the index against
+        bool contains(std::string_view text, std::string_view pattern) {
+            for (std::size_t start = 0; start + pattern.size() <= text.size(); ++start) {
+                std::size_t i = 0;
+                while (i < pattern.size() && lower(text[start + i]) == lower(pattern[i])) {
+                    ++i;
+                }
+                if (i == pattern.size()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::vector<std::string> reference(const std::vector<std::string>& texts, std::string_view pattern) {
+            std::vector<std::string> ids;
+            for (std::size_t doc = 0; doc < texts.size(); ++doc) {
+                if (contains(texts[doc], pattern)) {
+                    ids.push_back("d" + std::to_string(doc));
+                }
+            }
+            return ids;
+        }
+
+        std::vector<std::string> search(const TrigramIndex& index, std::string_view pattern) {
+            std::vector<std::string> ids;
+            for (const auto& match : index.search(pattern)) {
+                ids.emplace_back(match.id);
+            }
+            return ids;
+        }
+
+        // Texts over a small alphabet in both cases, so short patterns
+        // match often and trigrams repeat
+        std::string randomText(std::mt19937& random, std::size_t max_size) {
+            const char alphabet[] = "aAbBc -\xC3\xA9";
+            std::string text;
+            const std::size_t size = random() % (max_size + 1);
+            for (std::size_t i = 0; i < size; ++i) {
+                text += alphabet[random() % (sizeof(alphabet) - 1)];
+            }
+            return text;
+        }
+
+    } // namespace
+
+    TEST(TrigramIndexTest, AgreesWithSubstringSearchForEveryPatternLength) {
+        std::mt19937 random(5);
+        std::vector<std::string> texts;
+        TrigramIndex::Builder builder;
+        for (std::size_t doc = 0; doc < 300; ++doc) {
+            texts.push_back(randomText(random, 12));
+            builder.add("d" + std::to_string(doc), texts.back());
+        }
+        TrigramIndex index;
+        index.assign(builder.finish({}));
+        ASSERT_EQ(index.size(), texts.size());
+
+        // Lengths 0-2 have no trigram and take the full check; longer ones
+        // go through the postings
+        for (int round = 0; round < 2000; ++round) {
+            const std::string pattern = randomText(random, 5);
+            ASSERT_EQ(search(index, pattern), reference(texts, pattern)) << '"' << pattern << '"';
+        }
+        for (const char* pattern : { "", "a", "A", "b ", "-", "\xC3", "\xC3\xA9", "z", "zz" }) {
+            EXPECT_EQ(search(index, pattern), reference(texts, pattern)) << '"' << pattern << '"';
+        }
+    }
+
+    TEST(TrigramIndexTest, StoreNameSearchMatchesSubstringSearch) {
+        ScratchDirectory directory;
+        StorageManager store(directory.file("itineraries.json"));
+        const std::vector<std::string> names = {
+            "Paris city break", "Beach week", "Rome", "PA", "", "Lisbon in spring", "Spa days", "ab",
+        };
+        std::vector<Itinerary> itineraries;
+        for (std::size_t i = 0; i < names.size(); ++i) {
+            itineraries.emplace_back("d" + std::to_string(i), names[i], "2024-05-01", "2024-05-02", "");
+        }
+        ASSERT_TRUE(store.saveAll(itineraries));
+
+        for (const char* pattern : { "", "a", "P", "pa", "Pa", "s", "sp", "in", "x", "ab", "ee", "spa", "reak" }) {
+            std::vector<std::string> ids;
+            ASSERT_TRUE(store.searchNames(pattern, [&ids](std::string_view id, std::string_view) {
+                ids.emplace_back(id);
+            }));
+            EXPECT_EQ(ids, reference(names, pattern)) << '"' << pattern << '"';
+        }
+    }
+
+    TEST(TrigramIndexTest, SavedIndexOpensOnlyForItsStamp) {
+        ScratchDirectory directory;
+        const std::string path = directory.file("store.names");
+        const FileStamp stamp{ 10, 20 };
+        TrigramIndex::Builder builder;
+        builder.add("d0", "Kyoto");
+        builder.add("d1", "Tokyo");
+        ASSERT_TRUE(TrigramIndex::Builder::save(path, builder.finish(stamp)));
+
+        TrigramIndex index;
+        ASSERT_TRUE(index.open(path, stamp));
+        EXPECT_EQ(search(index, "kyo"), (std::vector<std::string>{ "d0", "d1" }));
+        EXPECT_EQ(search(index, "to"), (std::vector<std::string>{ "d0", "d1" }));
+        EXPECT_FALSE(TrigramIndex().open(path, FileStamp{ 10, 21 }));
+        ASSERT_TRUE(replaceFile(path, "not an index"));
+        EXPECT_FALSE(TrigramIndex().open(path, stamp));
+    }
+
+} // namespace travel_planner